@@ -6,17 +6,21 @@
 
 layout(location = 0) in vec3 vertexPosition;
 layout(location = 3) in float VERTEX_ATTRIBUTE;
+// Radius of level of detail representatives (0 for original points, i.e., use the global point radius)
+layout(location = 4) in float vertexPointRadius;
 
 out VertexData
 {
     vec3 pointPosition;
     float pointAttribute;
+    float pointRadius;
 };
 
 void main()
 {
     pointPosition = vertexPosition;
     pointAttribute = VERTEX_ATTRIBUTE;
+    pointRadius = vertexPointRadius;
 }
 
 
@@ -35,6 +39,7 @@ in VertexData
 {
     vec3 pointPosition;
     float pointAttribute;
+    float pointRadius;
 } v_in[];
 
 out vec3 fragmentNormal;
@@ -43,9 +48,11 @@ out vec3 worldSpaceSplatCenter;
 out vec3 screenSpacePosition;
 out vec2 fragmentTextureCoords;
 out float fragmentAttribute;
+out float fragmentRadius;
 
 void main()
 {
+    float splatRadius = max(radius, v_in[0].pointRadius);
     vec3 pointCoords = (mMatrix * vec4(v_in[0].pointPosition, 1.0)).xyz;
     float attribueValue = v_in[0].pointAttribute;
 
@@ -63,40 +70,44 @@ void main()
     vec3 right = (vMatrixInv * vec4(vec3(1, 0, 0), 0.0)).xyz;
     vec3 top = (vMatrixInv * vec4(vec3(0, 1, 0), 0.0)).xyz;
 
-    vec3 splatCenter = pointCoords + quadNormal * radius;
+    vec3 splatCenter = pointCoords + quadNormal * splatRadius;
 
-    vertexPosition = splatCenter + radius * (right - top);
+    vertexPosition = splatCenter + splatRadius * (right - top);
     fragmentNormal = quadNormal;
     fragmentPositionWorld = vertexPosition;
     screenSpacePosition = (vMatrix * vec4(vertexPosition, 1.0)).xyz;
     fragmentTextureCoords = vec2(1, 0);
     fragmentAttribute = attribueValue;
+    fragmentRadius = splatRadius;
     gl_Position = pMatrix * vMatrix * vec4(vertexPosition, 1.0);
     EmitVertex();
 
-    vertexPosition = splatCenter + radius* 2 * (right + top);
+    vertexPosition = splatCenter + splatRadius * 2 * (right + top);
     fragmentNormal = quadNormal;
     fragmentPositionWorld = vertexPosition;
     screenSpacePosition = (vMatrix * vec4(vertexPosition, 1.0)).xyz;
     fragmentTextureCoords = vec2(1, 1);
+    fragmentRadius = splatRadius;
     gl_Position = pMatrix * vMatrix * vec4(vertexPosition, 1.0);
     EmitVertex();
 
-    vertexPosition = splatCenter + radius* 2 * (-right - top);
+    vertexPosition = splatCenter + splatRadius * 2 * (-right - top);
     fragmentNormal = quadNormal;
     fragmentPositionWorld = vertexPosition;
     screenSpacePosition = (vMatrix * vec4(vertexPosition, 1.0)).xyz;
     fragmentTextureCoords = vec2(0, 0);
     fragmentAttribute = attribueValue;
+    fragmentRadius = splatRadius;
     gl_Position = pMatrix * vMatrix * vec4(vertexPosition, 1.0);
     EmitVertex();
 
-    vertexPosition = splatCenter + radius * 2 * (-right + top);
+    vertexPosition = splatCenter + splatRadius * 2 * (-right + top);
     fragmentNormal = quadNormal;
     fragmentPositionWorld = vertexPosition;
     screenSpacePosition = (vMatrix * vec4(vertexPosition, 1.0)).xyz;
     fragmentTextureCoords = vec2(0, 1);
     fragmentAttribute = attribueValue;
+    fragmentRadius = splatRadius;
     gl_Position = pMatrix * vMatrix * vec4(vertexPosition, 1.0);
     EmitVertex();
 
@@ -119,6 +130,7 @@ in vec3 fragmentNormal;
 in vec3 fragmentPositionWorld;
 in vec2 fragmentTextureCoords;
 in float fragmentAttribute;
+in float fragmentRadius;
 
 #ifdef DIRECT_BLIT_GATHER
 out vec4 fragColor;
@@ -208,7 +220,7 @@ void main()
     vec3 center = worldSpaceSplatCenter;
     float tRay = 0;
 
-    bool isIntersect = raySphereIntersection(origin, dir, center, radius, tRay);
+    bool isIntersect = raySphereIntersection(origin, dir, center, fragmentRadius, tRay);
     vec3 spherePos = fragmentPositionWorld;
     vec3 sphereNormal = fragmentNormal;
 
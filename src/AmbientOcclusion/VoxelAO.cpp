@@ -7,10 +7,12 @@
 
 #include <Utils/File/FileUtils.hpp>
 #include <Utils/File/Logfile.hpp>
+#include <Utils/Convert.hpp>
 #include <Math/Geometry/MatrixUtil.hpp>
 
 #include "../VoxelRaytracing/VoxelData.hpp"
 #include "../VoxelRaytracing/VoxelCurveDiscretizer.hpp"
+#include "../Utils/AssetCache.hpp"
 
 #include "VoxelAO.hpp"
 
@@ -20,8 +22,6 @@ void VoxelAOHelper::loadAOFactorsFromVoxelFile(const std::string &filename, Traj
     // Pure filename without extension (to create compressed .voxel filename)
     std::string modelFilenamePure = sgl::FileUtils::get()->removeExtension(filename);
 
-    std::string modelFilenameVoxelGrid = modelFilenamePure + ".voxel";
-
     // Can be either hair dataset or trajectory dataset
     bool isHairDataset = boost::starts_with(modelFilenamePure, "Data/Hair");
     bool isRings = boost::starts_with(modelFilenamePure, "Data/Rings");
@@ -39,25 +39,31 @@ void VoxelAOHelper::loadAOFactorsFromVoxelFile(const std::string &filename, Traj
         voxelRes = 128;
     }
 
+    int maxNumLinesPerVoxel = 32;
+    if (boost::starts_with(filename, "Data/WCB")) {
+        maxNumLinesPerVoxel = 128;
+    } else if (boost::starts_with(filename, "Data/ConvectionRolls/turbulence20000")){
+        maxNumLinesPerVoxel = 64;
+    }
+
+    // The voxel ray tracer uses other grid settings, so the grid parameters are part of the cache key
+    std::string modelFilenameSource = modelFilenamePure + (isHairDataset ? ".hair" : ".obj");
+    std::string modelFilenameVoxelGrid = AssetCache::get()->getCachedFilename(modelFilenameSource,
+            "voxelAO;voxelRes=" + sgl::toString(voxelRes) + ";quantizationRes=64;maxNumLinesPerVoxel="
+            + sgl::toString(maxNumLinesPerVoxel) + ";trajectoryType=" + sgl::toString(int(trajectoryType)), "voxel");
+
     VoxelGridDataCompressed compressedData;
     if (!sgl::FileUtils::get()->exists(modelFilenameVoxelGrid)) {
         VoxelCurveDiscretizer discretizer(glm::ivec3(voxelRes), glm::ivec3(64));
 
-        int maxNumLinesPerVoxel = 32;
-        if (boost::starts_with(filename, "Data/WCB")) {
-            maxNumLinesPerVoxel = 128;
-        } else if (boost::starts_with(filename, "Data/ConvectionRolls/turbulence20000")){
-            maxNumLinesPerVoxel = 64;
-        }
-
         if (isHairDataset) {
-            std::string modelFilenameHair = modelFilenamePure + ".hair";
+            std::string modelFilenameHair = modelFilenameSource;
             float lineRadius;
             glm::vec4 hairStrandColor;
             compressedData = discretizer.createFromHairDataset(modelFilenameHair, lineRadius, hairStrandColor,
                     maxNumLinesPerVoxel);
         } else {
-            std::string modelFilenameObj = modelFilenamePure + ".obj";
+            std::string modelFilenameObj = modelFilenameSource;
             std::vector<float> attributes;
             float maxVorticity;
             compressedData = discretizer.createFromTrajectoryDataset(modelFilenameObj, trajectoryType,
@@ -70,7 +76,9 @@ void VoxelAOHelper::loadAOFactorsFromVoxelFile(const std::string &filename, Traj
         sgl::Logfile::get()->writeInfo(std::string() + "Computational time to create voxel density for AO: "
                                        + std::to_string(elapsed.count()));
 
-        saveToFile(modelFilenameVoxelGrid, compressedData);
+        AssetCache::get()->convert(modelFilenameVoxelGrid, [&compressedData](const std::string &outputFilename) {
+            return saveToFile(outputFilename, compressedData);
+        });
     } else {
         loadFromFile(modelFilenameVoxelGrid, compressedData);
     }
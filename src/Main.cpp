@@ -11,6 +11,10 @@
 #include <Graphics/Window.hpp>
 
 #include "MainApp.hpp"
+#include "Tests/CpuBenchmarks.hpp"
+#ifdef USE_RAYTRACING
+#include "Raytracing/RTBatchRenderer.hpp"
+#endif
 
 using namespace std;
 using namespace sgl;
@@ -19,6 +23,17 @@ int main(int argc, char *argv[]) {
     // Initialize the filesystem utilities
     FileUtils::get()->initialize("pixel-sync-oit", argc, argv);
 
+    // Headless CPU micro-benchmarks, e.g. "--benchmark importance-criteria"
+    if (argc > 1 && string(argv[1]) == "--benchmark") {
+        return runCpuBenchmark(vector<string>(argv + 2, argv + argc));
+    }
+#ifdef USE_RAYTRACING
+    // Headless ray tracing of the camera paths, e.g. "--rt-batch 16 25 Aneurysm"
+    if (argc > 1 && string(argv[1]) == "--rt-batch") {
+        return runRayTracingBatch(vector<string>(argv + 2, argv + argc));
+    }
+#endif
+
     // Load the file containing the app settings
     string settingsFile = FileUtils::get()->getConfigDirectory() + "settings.txt";
     AppSettings::get()->loadSettings(settingsFile.c_str());
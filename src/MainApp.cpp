@@ -28,6 +28,7 @@
 #include <Utils/Events/EventManager.hpp>
 #include <Utils/Random/Xorshift.hpp>
 #include <Utils/Timer.hpp>
+#include <Utils/Convert.hpp>
 #include <Utils/File/FileUtils.hpp>
 #include <Input/Mouse.hpp>
 #include <Input/Keyboard.hpp>
@@ -50,6 +51,8 @@
 #include "Utils/PointRendering/PointFileLoader.hpp"
 #include "Utils/TrajectoryLoader.hpp"
 #include "Utils/HairLoader.hpp"
+#include "Utils/AssetCache.hpp"
+#include "Utils/OfflineRendering.hpp"
 #include "OIT/BufferSizeWatch.hpp"
 #include "OIT/OIT_Dummy.hpp"
 #include "OIT/OIT_KBuffer.hpp"
@@ -130,7 +133,7 @@ PixelSyncApp::PixelSyncApp() : camera(new Camera()), measurer(NULL), videoWriter
     camera->setNearClipDistance(0.01f);
     camera->setFarClipDistance(100.0f);
     camera->setOrientation(glm::quat(1.0f, 0.0f, 0.0f, 0.0f));
-    fovy = atanf(1.0f / 2.0f) * 2.0f; // 90.0f / 180.0f * sgl::PI;//
+    fovy = getDefaultCameraFovy(); // 90.0f / 180.0f * sgl::PI;//
     camera->setFOVy(fovy);
     //camera->setPosition(glm::vec3(0.5f, 0.5f, 20.0f));
     camera->setPosition(glm::vec3(0.0f, -0.1f, 2.4f));
@@ -244,6 +247,7 @@ void PixelSyncApp::resolutionChanged(EventPtr event)
     if (perfMeasurementMode && measurer != NULL) {
         measurer->resolutionChanged(sceneFramebuffer);
     }
+    pointLODSelectionDirty = true;
     reRender = true;
 }
 
@@ -454,55 +458,201 @@ void PixelSyncApp::loadCameraPositionFromFile(const std::string& filename)
 
 
 
-void PixelSyncApp::loadModel(const std::string &filename, bool resetCamera)
+float PixelSyncApp::getModelLineRadius(const std::string &modelFilenamePure) const
 {
-    // Pure filename without extension (to create compressed .binmesh filename)
-    modelFilenamePure = FileUtils::get()->removeExtension(filename);
-
-    if (oitRenderer->isTestingMode()) {
-        return;
-    }
-
-    lineRadius = 0.001;
+    float radius = 0.001f;
 
     if (timeCoherence)
     {
         if (boost::starts_with(modelFilenamePure, "Data/Rings")) {
-            lineRadius = 0.002;
+            radius = 0.002;
         } else if (boost::starts_with(modelFilenamePure, "Data/ConvectionRolls/output")) {
-            lineRadius = 0.001;
+            radius = 0.001;
         } else if (boost::starts_with(modelFilenamePure, "Data/Trajectories")) {
-            lineRadius = 0.0005;
+            radius = 0.0005;
         } else  if (boost::starts_with(modelFilenamePure, "Data/UCLA")) {
-            if (timeCoherence) { lineRadius = 0.0005; }
-            else { lineRadius = 0.0008; }
+            if (timeCoherence) { radius = 0.0005; }
+            else { radius = 0.0008; }
         }
     }
 
     if (recording || testCameraFlight) {
 //        if (boost::starts_with(modelFilenamePure, "Data/Rings")) {
-//            lineRadius = 0.002;
+//            radius = 0.002;
 //        } else if (boost::starts_with(modelFilenamePure, "Data/ConvectionRolls/output")) {
-//            lineRadius = 0.001;
+//            radius = 0.001;
 //        } else if (boost::starts_with(modelFilenamePure, "Data/Trajectories")) {
-//            lineRadius = 0.0005;
+//            radius = 0.0005;
 //        } else  if (boost::starts_with(modelFilenamePure, "Data/UCLA")) {
-//            lineRadius = 0.0008;
+//            radius = 0.0008;
         if (boost::starts_with(modelFilenamePure, "Data/CFD/driven_cavity")) {
-            lineRadius = 0.0045;
+            radius = 0.0045;
         } else if (boost::starts_with(modelFilenamePure, "Data/CFD/rayleigh")) {
-            lineRadius = 0.002;
+            radius = 0.002;
         } //else {
-//            lineRadius = 0.0007;
+//            radius = 0.0007;
 //        }
     } else {
         if (boost::starts_with(modelFilenamePure, "Data/CFD/driven_cavity")) {
-            lineRadius = 0.0045;
+            radius = 0.0045;
         } else if (boost::starts_with(modelFilenamePure, "Data/CFD/rayleigh")) {
-            lineRadius = 0.002;
+            radius = 0.002;
+        }
+    }
+
+    return radius;
+}
+
+ModelType PixelSyncApp::getModelTypeFromFilename(const std::string &modelFilenamePure)
+{
+    ModelType modelType = MODEL_TYPE_TRIANGLE_MESH_NORMAL;
+
+    bool modelContainsTrajectories = boost::starts_with(modelFilenamePure, "Data/Trajectories")
+            || boost::starts_with(modelFilenamePure, "Data/Rings")
+            || boost::starts_with(modelFilenamePure, "Data/Turbulence")
+            || boost::starts_with(modelFilenamePure, "Data/WCB")
+            || boost::starts_with(modelFilenamePure, "Data/ConvectionRolls")
+            || boost::starts_with(modelFilenamePure, "Data/UCLA")
+            || boost::starts_with(modelFilenamePure, "Data/CFD");
+    if (modelContainsTrajectories) {
+        modelType = MODEL_TYPE_TRAJECTORIES;
+    }
+
+    if (boost::starts_with(modelFilenamePure, "Data/Hair")) {
+        modelType = MODEL_TYPE_HAIR;
+    }
+
+    if (boost::starts_with(modelFilenamePure, "Data/Models")
+            || boost::starts_with(modelFilenamePure, "Data/IsoSurfaces")) {
+        modelType = MODEL_TYPE_TRIANGLE_MESH_NORMAL;
+    }
+
+    if (boost::starts_with(modelFilenamePure, "Data/IsoSurfaces")) {
+        modelType = MODEL_TYPE_TRIANGLE_MESH_SCIENTIFIC;
+    }
+
+    if (boost::starts_with(modelFilenamePure, "Data/PointDatasets")) {
+        modelType = MODEL_TYPE_POINTS;
+    }
+
+    return modelType;
+}
+
+TrajectoryType PixelSyncApp::getTrajectoryTypeFromFilename(const std::string &modelFilenamePure)
+{
+    if (boost::starts_with(modelFilenamePure, "Data/Trajectories")) {
+        return TRAJECTORY_TYPE_ANEURYSM;
+    } else if (boost::starts_with(modelFilenamePure, "Data/WCB"))
+    {
+        return TRAJECTORY_TYPE_WCB;
+    } else if (boost::starts_with(modelFilenamePure, "Data/Rings")) {
+        return TRAJECTORY_TYPE_RINGS;
+    } else if (boost::starts_with(modelFilenamePure, "Data/UCLA")) {
+        return TRAJECTORY_TYPE_UCLA;
+    } else if (boost::starts_with(modelFilenamePure, "Data/ConvectionRolls/output")) {
+        return TRAJECTORY_TYPE_CONVECTION_ROLLS_NEW;
+    } else if (boost::starts_with(modelFilenamePure, "Data/CFD")) {
+        return TRAJECTORY_TYPE_CFD;
+    } else {
+        return TRAJECTORY_TYPE_CONVECTION_ROLLS;
+    }
+}
+
+std::string PixelSyncApp::getConvertedModelFilename(
+        const std::string &filename, ModelType modelType, TrajectoryType trajectoryType, float lineRadius,
+        AssetCache::ConversionFunction &conversionFunction) const
+{
+    // All parameters the converted file depends on are part of the cache key
+    std::string conversionParameters;
+    std::string extension = "binmesh";
+    if (modelType == MODEL_TYPE_TRIANGLE_MESH_NORMAL) {
+        conversionParameters = "obj";
+        conversionFunction = [filename](const std::string &outputFilename) {
+            return convertObjMeshToBinary(filename, outputFilename);
+        };
+    } else if (modelType == MODEL_TYPE_TRAJECTORIES) {
+        conversionParameters = "trajectoryType=" + sgl::toString(int(trajectoryType));
+        if (lineRenderingTechnique == LINE_RENDERING_TECHNIQUE_LINES
+                || lineRenderingTechnique == LINE_RENDERING_TECHNIQUE_FETCH) {
+            // MeshRenderer and the programmable fetch code check for the "_lines" suffix
+            extension = "binmesh_lines";
+            conversionFunction = [filename, trajectoryType](const std::string &outputFilename) {
+                return convertTrajectoryDataToBinaryLineMesh(trajectoryType, filename, outputFilename);
+            };
+        } else {
+            TubeMeshEncodings encodings = tubeMeshEncodings;
+            conversionParameters += ";lineRadius=" + sgl::toString(lineRadius) + ";circleSegments=3;"
+                    + encodings.toString();
+            conversionFunction = [filename, trajectoryType, lineRadius, encodings](const std::string &outputFilename) {
+                return convertTrajectoryDataToBinaryTriangleMesh(
+                        trajectoryType, filename, outputFilename, lineRadius, encodings);
+            };
         }
+    } else if (modelType == MODEL_TYPE_HAIR) {
+        TubeMeshEncodings encodings = tubeMeshEncodings;
+        conversionParameters = "circleSegments=" + sgl::toString(HAIR_TUBE_NUM_CIRCLE_SEGMENTS)
+                + ";scaling=" + sgl::toString(HAIR_MODEL_SCALING_FACTOR) + ";" + encodings.toString();
+        conversionFunction = [filename, encodings](const std::string &outputFilename) {
+            return convertHairDataToBinaryTriangleMesh(filename, outputFilename, encodings);
+        };
+    } else if (modelType == MODEL_TYPE_TRIANGLE_MESH_SCIENTIFIC) {
+        conversionParameters = "bobj";
+        conversionFunction = [filename](const std::string &outputFilename) {
+            return convertBinaryObjMeshToBinmesh(filename, outputFilename);
+        };
+    } else if (modelType == MODEL_TYPE_POINTS) {
+        conversionParameters = "points";
+        conversionFunction = [filename](const std::string &outputFilename) {
+            return convertPointDataSetToBinmesh(filename, outputFilename);
+        };
+    }
+
+    return AssetCache::get()->getCachedFilename(filename, conversionParameters, extension);
+}
+
+void PixelSyncApp::loadModel(const std::string &filename, bool resetCamera)
+{
+    // Convert models not yet in the asset cache in the background while the current model stays visible (see update).
+    // The first model, measurement runs and the ray tracing modes (which need the model immediately) load synchronously.
+    if (convertModelsInBackground && transparentObject.isLoaded() && !perfMeasurementMode && !recording
+            && !testCameraFlight && mode != RENDER_MODE_VOXEL_RAYTRACING_LINES && mode != RENDER_MODE_RAYTRACING
+            && !oitRenderer->isTestingMode()) {
+        if (!AssetCache::get()->isContentHashCached(filename)) {
+            // The cached file name depends on the content hash of the model, which is computed in the background, too
+            AssetCache::get()->requestContentHash(filename);
+            pendingModelFilename = filename;
+            pendingConvertedModelFilename = filename;
+            pendingModelResetCamera = resetCamera;
+            return;
+        }
+        std::string newModelFilenamePure = FileUtils::get()->removeExtension(filename);
+        ModelType newModelType = getModelTypeFromFilename(newModelFilenamePure);
+        TrajectoryType newTrajectoryType = newModelType == MODEL_TYPE_TRAJECTORIES
+                ? getTrajectoryTypeFromFilename(newModelFilenamePure) : trajectoryType;
+        AssetCache::ConversionFunction conversionFunction;
+        std::string convertedFilename = getConvertedModelFilename(filename, newModelType, newTrajectoryType,
+                getModelLineRadius(newModelFilenamePure), conversionFunction);
+        if (!FileUtils::get()->exists(convertedFilename)) {
+            std::cout << "Converting " << filename << " in the background..." << std::endl;
+            AssetCache::get()->requestConversion(convertedFilename, conversionFunction);
+            pendingModelFilename = filename;
+            pendingConvertedModelFilename = convertedFilename;
+            pendingModelResetCamera = resetCamera;
+            return;
+        }
+    }
+    pendingModelFilename.clear();
+    pendingConvertedModelFilename.clear();
+
+    // Pure filename without extension (to create compressed .binmesh filename)
+    modelFilenamePure = FileUtils::get()->removeExtension(filename);
+
+    if (oitRenderer->isTestingMode()) {
+        return;
     }
 
+    lineRadius = getModelLineRadius(modelFilenamePure);
+
 //    lineRadius = 0.001;
 
     std::cout << "Line radius = " << lineRadius << std::endl << std::flush;
@@ -563,60 +713,17 @@ void PixelSyncApp::loadModel(const std::string &filename, bool resetCamera)
         sgl::ShaderManager->removePreprocessorDefine("CONVECTION_ROLLS");
     }
 
-    modelType = MODEL_TYPE_TRIANGLE_MESH_NORMAL;
-
-    bool modelContainsTrajectories = boost::starts_with(modelFilenamePure, "Data/Trajectories")
-            || boost::starts_with(modelFilenamePure, "Data/Rings")
-            || boost::starts_with(modelFilenamePure, "Data/Turbulence")
-            || boost::starts_with(modelFilenamePure, "Data/WCB")
-            || boost::starts_with(modelFilenamePure, "Data/ConvectionRolls")
-            || boost::starts_with(modelFilenamePure, "Data/UCLA")
-            || boost::starts_with(modelFilenamePure, "Data/CFD");
-    if (modelContainsTrajectories) {
-        modelType = MODEL_TYPE_TRAJECTORIES;
-    }
-
-    if (boost::starts_with(modelFilenamePure, "Data/Hair")) {
-        modelType = MODEL_TYPE_HAIR;
-    }
-
-    if (boost::starts_with(modelFilenamePure, "Data/Models")
-            || boost::starts_with(modelFilenamePure, "Data/IsoSurfaces")) {
-        modelType = MODEL_TYPE_TRIANGLE_MESH_NORMAL;
-    }
-
-    if (boost::starts_with(modelFilenamePure, "Data/IsoSurfaces")) {
-        modelType = MODEL_TYPE_TRIANGLE_MESH_SCIENTIFIC;
-    }
-
-    if (boost::starts_with(modelFilenamePure, "Data/PointDatasets")) {
-        modelType = MODEL_TYPE_POINTS;
-    }
-
+    modelType = getModelTypeFromFilename(modelFilenamePure);
     if (modelType == MODEL_TYPE_TRAJECTORIES) {
-        if (boost::starts_with(modelFilenamePure, "Data/Trajectories")) {
-            trajectoryType = TRAJECTORY_TYPE_ANEURYSM;
-        } else if (boost::starts_with(modelFilenamePure, "Data/WCB"))
-        {
-            trajectoryType = TRAJECTORY_TYPE_WCB;
-        } else if (boost::starts_with(modelFilenamePure, "Data/Rings")) {
-            trajectoryType = TRAJECTORY_TYPE_RINGS;
-        } else if (boost::starts_with(modelFilenamePure, "Data/UCLA")) {
-            trajectoryType = TRAJECTORY_TYPE_UCLA;
-        } else if (boost::starts_with(modelFilenamePure, "Data/ConvectionRolls/output")) {
-            trajectoryType = TRAJECTORY_TYPE_CONVECTION_ROLLS_NEW;
-        } else if (boost::starts_with(modelFilenamePure, "Data/CFD")) {
-            trajectoryType = TRAJECTORY_TYPE_CFD;
-        } else {
-            trajectoryType = TRAJECTORY_TYPE_CONVECTION_ROLLS;
-        }
+        trajectoryType = getTrajectoryTypeFromFilename(modelFilenamePure);
         changeImportanceCriterionType();
     }
 
-    std::string modelFilenameOptimized = modelFilenamePure + ".binmesh";
+    AssetCache::ConversionFunction conversionFunction;
+    std::string modelFilenameOptimized = getConvertedModelFilename(
+            filename, modelType, trajectoryType, lineRadius, conversionFunction);
     // Special mode for line trajectories: Trajectories loaded as line set or as triangle mesh
     if (modelType == MODEL_TYPE_TRAJECTORIES && lineRenderingTechnique == LINE_RENDERING_TECHNIQUE_LINES) {
-        modelFilenameOptimized += "_lines";
         if (useBillboardLines) {
             sgl::ShaderManager->addPreprocessorDefine("BILLBOARD_LINES", "");
         }
@@ -629,7 +736,6 @@ void PixelSyncApp::loadModel(const std::string &filename, bool resetCamera)
         useGeometryShader = false;
     }
     if (modelType == MODEL_TYPE_TRAJECTORIES && lineRenderingTechnique == LINE_RENDERING_TECHNIQUE_FETCH) {
-        modelFilenameOptimized += "_lines";
         useProgrammableFetch = true;
         sgl::ShaderManager->addPreprocessorDefine("USE_PROGRAMMABLE_FETCH", "");
         if (programmableFetchUseAoS) {
@@ -643,24 +749,7 @@ void PixelSyncApp::loadModel(const std::string &filename, bool resetCamera)
     }
 
     if (!FileUtils::get()->exists(modelFilenameOptimized)) {
-        if (modelType == MODEL_TYPE_TRIANGLE_MESH_NORMAL) {
-            convertObjMeshToBinary(filename, modelFilenameOptimized);
-        } else if (modelType == MODEL_TYPE_TRAJECTORIES) {
-            if (boost::ends_with(modelFilenameOptimized, "_lines")) {
-                convertTrajectoryDataToBinaryLineMesh(trajectoryType, filename, modelFilenameOptimized);
-            } else {
-                convertTrajectoryDataToBinaryTriangleMesh(trajectoryType, filename,
-                        modelFilenameOptimized, lineRadius);
-//                convertTrajectoryDataToBinaryTriangleMeshGPU(trajectoryType, filename,
-//                        modelFilenameOptimized, lineRadius);
-            }
-        } else if (boost::starts_with(modelFilenamePure, "Data/Hair")) {
-            convertHairDataToBinaryTriangleMesh(filename, modelFilenameOptimized);
-        } else if (boost::starts_with(modelFilenamePure, "Data/IsoSurfaces")) {
-            convertBinaryObjMeshToBinmesh(filename, modelFilenameOptimized);
-        } else if (boost::starts_with(modelFilenamePure, "Data/PointDatasets")) {
-            convertPointDataSetToBinmesh(filename, modelFilenameOptimized);
-        }
+        AssetCache::get()->convert(modelFilenameOptimized, conversionFunction);
     }
 
     if (boost::starts_with(modelFilenamePure, "Data/IsoSurfaces")) {
@@ -700,12 +789,22 @@ void PixelSyncApp::loadModel(const std::string &filename, bool resetCamera)
 
     if (mode != RENDER_MODE_VOXEL_RAYTRACING_LINES && mode != RENDER_MODE_RAYTRACING) {
         transparentObject = parseMesh3D(modelFilenameOptimized, transparencyShader, shuffleGeometry,
-                useProgrammableFetch, programmableFetchUseAoS, lineRadius);
+                useProgrammableFetch, programmableFetchUseAoS, lineRadius, sortPrimitivesForCulling);
         if (shaderMode == SHADER_MODE_SCIENTIFIC_ATTRIBUTE) {
             recomputeHistogramForMesh();
         }
         boundingBox = transparentObject.boundingBox;
 
+        pointLOD = PointLODHierarchy();
+        if (modelType == MODEL_TYPE_POINTS && !transparentObject.submeshUniforms.empty()) {
+            pointLOD.loadFromUniforms(transparentObject.submeshUniforms.front());
+        }
+        pointLODSelectionDirty = true;
+        pointLODSelectionEmpty = false;
+        pointLODIndexBuffer = GeometryBufferPtr(); // Belongs to the old render data
+        pointLODIndexBufferCapacity = 0;
+        pointLODNumIndices = 0;
+
         if (boost::starts_with(modelFilenamePure, "Data/Hair")) {
             bool changed = false;
             bool hasColorArray = transparentObject.hasAttributeWithName("vertexColor");
@@ -851,7 +950,7 @@ void PixelSyncApp::loadModel(const std::string &filename, bool resetCamera)
 
     boundingBox = boundingBox.transformed(rotation * scaling);
     updateAOMode();
-    shadowTechnique->newModelLoaded(modelFilenamePure, modelContainsTrajectories);
+    shadowTechnique->newModelLoaded(modelFilenamePure, modelType == MODEL_TYPE_TRAJECTORIES);
     shadowTechnique->setLightDirection(lightDirection, boundingBox);
 
     if (testCameraFlight) {
@@ -886,14 +985,88 @@ void PixelSyncApp::changeImportanceCriterionType()
 
 void PixelSyncApp::recomputeHistogramForMesh()
 {
-    ImportanceCriterionAttribute importanceCriterionAttribute =
+    ImportanceCriterionAttribute &importanceCriterionAttribute =
             transparentObject.importanceCriterionAttributes.at(importanceCriterionIndex);
     minCriterionValue = importanceCriterionAttribute.minAttribute;
     maxCriterionValue = importanceCriterionAttribute.maxAttribute;
-    transferFunctionWindow.computeHistogram(importanceCriterionAttribute.attributes,
+
+    // Only unpack the attribute data if the histogram is actually displayed.
+    histogramDirty = !transferFunctionWindow.getShowTransferFunctionWindow();
+    if (histogramDirty) {
+        return;
+    }
+    for (ImportanceCriterionAttribute &attribute : transparentObject.importanceCriterionAttributes) {
+        if (&attribute != &importanceCriterionAttribute) {
+            attribute.releaseAttributes();
+        }
+    }
+    transferFunctionWindow.computeHistogram(importanceCriterionAttribute.getAttributes(),
             minCriterionValue, maxCriterionValue);
 }
 
+void PixelSyncApp::updatePointLODSelection()
+{
+    ShaderAttributesPtr &renderData = transparentObject.shaderAttributes.front();
+
+    // The representatives are stored after the original points, thus an index buffer is also needed without LOD.
+    // It doesn't depend on the camera and is only rebuilt when the model is loaded or LOD is toggled.
+    if (!usePointLOD) {
+        if (!pointLODSelectionDirty) {
+            return;
+        }
+        pointLODSelectionDirty = false;
+        std::vector<uint32_t> indices(pointLOD.getNumOriginalPoints());
+        for (uint32_t i = 0; i < uint32_t(indices.size()); i++) {
+            indices.at(i) = i;
+        }
+        pointLODStatistics = PointLODSelectionStatistics();
+        pointLODStatistics.numEmittedPoints = indices.size();
+        pointLODSelectionEmpty = indices.empty();
+        if (!indices.empty()) {
+            GeometryBufferPtr indexBuffer = Renderer->createGeometryBuffer(
+                    sizeof(uint32_t)*indices.size(), (void*)&indices.front(), INDEX_BUFFER);
+            renderData->setIndexGeometryBuffer(indexBuffer, ATTRIB_UNSIGNED_INT);
+        }
+        transparentObject.setDrawnIndexCount(0, -1);
+        pointLODIndexBuffer = GeometryBufferPtr();
+        pointLODIndexBufferCapacity = 0;
+        pointLODNumIndices = 0;
+        return;
+    }
+
+    glm::mat4 modelMatrix = rotation * scaling;
+    glm::mat4 mvMatrix = camera->getViewMatrix() * modelMatrix;
+    glm::mat4 mvpMatrix = camera->getProjectionMatrix() * mvMatrix;
+    if (!pointLODSelectionDirty && mvpMatrix == pointLODLastMvpMatrix) {
+        return;
+    }
+    pointLODSelectionDirty = false;
+    pointLODLastMvpMatrix = mvpMatrix;
+
+    std::vector<uint32_t> indices;
+    float modelScale = glm::length(glm::vec3(modelMatrix[0]));
+    Window *window = AppSettings::get()->getMainWindow();
+    float pixelsPerUnit = camera->getProjectionMatrix()[1][1] * window->getHeight() * 0.5f * modelScale;
+    pointLODStatistics = pointLOD.selectPoints(
+            mvpMatrix, mvMatrix, pixelsPerUnit, size_t(pointBudget), pointLODMaxScreenError, indices);
+    pointLODSelectionEmpty = indices.empty();
+
+    // One index buffer with room for the whole point budget is updated in place. Only the selected indices at its
+    // start are drawn, thus the rest of the buffer never needs to be cleared.
+    const size_t capacity = std::max(size_t(pointBudget), size_t(1));
+    if (!pointLODIndexBuffer || pointLODIndexBufferCapacity != capacity) {
+        pointLODIndexBuffer = Renderer->createGeometryBuffer(sizeof(uint32_t)*capacity, NULL, INDEX_BUFFER);
+        renderData->setIndexGeometryBuffer(pointLODIndexBuffer, ATTRIB_UNSIGNED_INT);
+        pointLODIndexBufferCapacity = capacity;
+    }
+    const size_t numIndices = std::min(indices.size(), capacity);
+    if (numIndices > 0) {
+        pointLODIndexBuffer->subData(0, sizeof(uint32_t)*numIndices, (void*)&indices.front());
+    }
+    pointLODNumIndices = numIndices;
+    transparentObject.setDrawnIndexCount(0, int(numIndices));
+}
+
 void PixelSyncApp::setRenderMode(RenderModeOIT newMode, bool forceReset)
 {
     if (mode == newMode && !forceReset) {
@@ -1417,21 +1590,41 @@ void PixelSyncApp::render()
 }
 
 
+AABB3 PixelSyncApp::computeScreenSpaceBoundingBox()
+{
+    // The bounding box is already in world space, the chunk boxes are in model space.
+    AABB3 screenSpaceBoundingBox = boundingBox.transformed(camera->getViewMatrix());
+    glm::mat4 mvMatrix = camera->getViewMatrix() * rotation * scaling;
+
+    // Only the visible chunks determine the depth range (view space z is negative in front of the camera).
+    float minDepth, maxDepth;
+    if (transparentObject.chunkBVH.computeViewDepthRange(
+            mvMatrix, camera->getProjectionMatrix(), camera->getNearClipDistance(), camera->getFarClipDistance(),
+            minDepth, maxDepth)) {
+        screenSpaceBoundingBox.min.z = std::max(screenSpaceBoundingBox.min.z, -maxDepth);
+        screenSpaceBoundingBox.max.z = std::min(screenSpaceBoundingBox.max.z, -minDepth);
+    }
+    return screenSpaceBoundingBox;
+}
+
 void PixelSyncApp::renderOIT()
 {
     bool wireframe = false;
 
     if (mode == RENDER_MODE_OIT_MBOIT) {
-        AABB3 screenSpaceBoundingBox = boundingBox.transformed(camera->getViewMatrix());
+        AABB3 screenSpaceBoundingBox = computeScreenSpaceBoundingBox();
         static_cast<OIT_MBOIT*>(oitRenderer.get())->setScreenSpaceBoundingBox(screenSpaceBoundingBox, camera);
     }
     if (mode == RENDER_MODE_OIT_MLAB_BUCKET) {
-        AABB3 screenSpaceBoundingBox = boundingBox.transformed(camera->getViewMatrix());
+        AABB3 screenSpaceBoundingBox = computeScreenSpaceBoundingBox();
         static_cast<OIT_MLABBucket*>(oitRenderer.get())->setScreenSpaceBoundingBox(screenSpaceBoundingBox, camera);
     }
     if (currentShadowTechnique == MOMENT_SHADOW_MAPPING) {
         static_cast<MomentShadowMapping*>(shadowTechnique.get())->setSceneBoundingBox(boundingBox);
     }
+    if (modelType == MODEL_TYPE_POINTS && pointLOD.isLoaded() && transparentObject.isLoaded()) {
+        updatePointLODSelection();
+    }
 
     if (mode == RENDER_MODE_VOXEL_RAYTRACING_LINES) {
         if (currentAOTechnique == AO_TECHNIQUE_VOXEL_AO) {
@@ -1587,12 +1780,38 @@ void PixelSyncApp::renderGUI()
             if (ImGui::Combo("Model Name", &usedModelIndex, MODEL_DISPLAYNAMES, IM_ARRAYSIZE(MODEL_DISPLAYNAMES))) {
                 loadModel(MODEL_FILENAMES[usedModelIndex]);
             }
+            ImGui::Checkbox("Convert Models in Background", &convertModelsInBackground);
+            if (!pendingModelFilename.empty()) {
+                ImGui::SameLine();
+                ImGui::Text("(converting...)");
+            }
 
             if (ImGui::Combo("Rendering Mode", (int*)&lineRenderingTechnique, LINE_RENDERING_TECHNIQUE_DISPLAYNAMES,
                     IM_ARRAYSIZE(LINE_RENDERING_TECHNIQUE_DISPLAYNAMES))) {
                 loadModel(MODEL_FILENAMES[usedModelIndex], false);
             }
 
+            // Encodings of converted tube meshes (changing them converts the model again if not yet in the cache)
+            bool quantizedPositions = tubeMeshEncodings.positionEncoding != BINARY_MESH_ENCODING_NONE;
+            bool octahedralNormals = tubeMeshEncodings.normalEncoding != BINARY_MESH_ENCODING_NONE;
+            bool deltaCodedIndices = tubeMeshEncodings.indexEncoding != BINARY_MESH_ENCODING_NONE;
+            bool tubeMeshEncodingsChanged = ImGui::Checkbox("Quantized Tube Positions", &quantizedPositions);
+            tubeMeshEncodingsChanged |= ImGui::Checkbox("Octahedral Tube Normals", &octahedralNormals);
+            tubeMeshEncodingsChanged |= ImGui::Checkbox("Delta-Coded Tube Indices", &deltaCodedIndices);
+            if (tubeMeshEncodingsChanged) {
+                tubeMeshEncodings.positionEncoding = quantizedPositions
+                        ? BINARY_MESH_ENCODING_QUANTIZED_POSITIONS : BINARY_MESH_ENCODING_NONE;
+                tubeMeshEncodings.normalEncoding = octahedralNormals
+                        ? BINARY_MESH_ENCODING_OCTAHEDRAL_NORMALS : BINARY_MESH_ENCODING_NONE;
+                tubeMeshEncodings.indexEncoding = deltaCodedIndices
+                        ? BINARY_MESH_ENCODING_DELTA_VARINT : BINARY_MESH_ENCODING_NONE;
+                if (modelType == MODEL_TYPE_HAIR || (modelType == MODEL_TYPE_TRAJECTORIES
+                        && lineRenderingTechnique != LINE_RENDERING_TECHNIQUE_LINES
+                        && lineRenderingTechnique != LINE_RENDERING_TECHNIQUE_FETCH)) {
+                    loadModel(MODEL_FILENAMES[usedModelIndex], false);
+                }
+            }
+
             ImGui::Separator();
 
             static bool showSceneSettings = true;
@@ -1605,6 +1824,10 @@ void PixelSyncApp::renderGUI()
         ImGui::End();
     }
 
+    if (histogramDirty && transferFunctionWindow.getShowTransferFunctionWindow()
+            && importanceCriterionIndex < int(transparentObject.importanceCriterionAttributes.size())) {
+        recomputeHistogramForMesh();
+    }
     if (transferFunctionWindow.renderGUI()) {
         reRender = true;
         if (transferFunctionWindow.getTransferFunctionMapRebuilt()) {
@@ -1756,6 +1979,37 @@ void PixelSyncApp::renderSceneSettingsGUI()
             && ImGui::SliderFloat("Point radius", &pointRadius, 0.00005f, 0.005f, "%.5f")) {
             reRender = true;
         }
+        if (transparentObject.isDrawnInChunks()) {
+            if (ImGui::Checkbox("Frustum culling", &useFrustumCulling)) {
+                reRender = true;
+            }
+            if (useFrustumCulling) {
+                ImGui::SameLine();
+                ImGui::Text("(%zu of %zu chunks)", numVisibleChunks, transparentObject.chunkVisibility.size());
+            }
+            if (ImGui::Checkbox("Sort primitives for culling", &sortPrimitivesForCulling)) {
+                loadModel(MODEL_FILENAMES[usedModelIndex], false);
+                reRender = true;
+            }
+        }
+        if (modelType == MODEL_TYPE_POINTS && pointLOD.isLoaded()) {
+            if (ImGui::Checkbox("Point LOD", &usePointLOD)) {
+                pointLODSelectionDirty = true;
+                reRender = true;
+            }
+            if (usePointLOD) {
+                if (ImGui::SliderInt("Point budget", &pointBudget, 10000, 20000000)) {
+                    pointLODSelectionDirty = true;
+                    reRender = true;
+                }
+                if (ImGui::SliderFloat("LOD pixel error", &pointLODMaxScreenError, 0.25f, 16.0f, "%.2f")) {
+                    pointLODSelectionDirty = true;
+                    reRender = true;
+                }
+            }
+            ImGui::Text("Points: %zu (%zu representatives)", pointLODStatistics.numEmittedPoints,
+                    pointLODStatistics.numRepresentatives);
+        }
     }
 
     if (shaderMode == SHADER_MODE_SCIENTIFIC_ATTRIBUTE) {
@@ -1990,6 +2244,19 @@ void PixelSyncApp::renderScene()
     }
     Renderer->setModelMatrix(rotation * scaling);
 
+    // The shadow map pass needs all geometry, not only the one visible from the camera.
+    if (useFrustumCulling && !shadowTechnique->isShadowMapCreatePass()) {
+        numVisibleChunks = transparentObject.cullChunks(
+                camera->getProjectionMatrix() * camera->getViewMatrix() * rotation * scaling);
+    } else {
+        transparentObject.resetChunkCulling();
+    }
+
+    // Nothing of the point data set is visible with the current level of detail selection.
+    if (modelType == MODEL_TYPE_POINTS && pointLOD.isLoaded() && pointLODSelectionEmpty) {
+        return;
+    }
+
     bool isGBufferPass = currentAOTechnique == AO_TECHNIQUE_SSAO && ssaoHelper->isPreRenderPass();
     transparentObject.render(transparencyShader, isGBufferPass, importanceCriterionIndex);
 }
@@ -2017,6 +2284,24 @@ void PixelSyncApp::update(float dt)
 
     recordingTimeLast = recordingTime;
 
+    // Switch to the model converted in the background as soon as its conversion has finished. All finished jobs are
+    // processed, as loading the model may request a further job (e.g., the conversion after hashing the model).
+    for (const AssetCache::FinishedConversion &conversion : AssetCache::get()->popFinishedConversions()) {
+        if (pendingModelFilename.empty() || conversion.cachedFilename != pendingConvertedModelFilename) {
+            continue;
+        }
+        std::string modelFilename = pendingModelFilename;
+        pendingModelFilename.clear();
+        pendingConvertedModelFilename.clear();
+        if (conversion.succeeded) {
+            loadModel(modelFilename, pendingModelResetCamera);
+        } else {
+            sgl::Logfile::get()->writeError(std::string() + "ERROR: PixelSyncApp::update: Converting \""
+                    + modelFilename + "\" failed.");
+        }
+        reRender = true;
+    }
+
     if (perfMeasurementMode && !measurer->update(recordingTime)) {
         // All modes were tested -> quit
         quit();
@@ -22,7 +22,9 @@
 #include "Utils/VideoWriter.hpp"
 #include "Utils/MeshSerializer.hpp"
 #include "Utils/CameraPath.hpp"
+#include "Utils/AssetCache.hpp"
 #include "Utils/ImportanceCriteria.hpp"
+#include "Utils/PointRendering/PointLODHierarchy.hpp"
 #include "OIT/OIT_Renderer.hpp"
 #include "AmbientOcclusion/SSAO.hpp"
 #include "AmbientOcclusion/VoxelAO.hpp"
@@ -68,10 +70,15 @@ public:
     void render(); // Calls renderOIT and renderGUI
     void renderOIT(); // Uses renderScene and "oitRenderer" to render the scene
     void renderScene(); // Renders lighted scene
+    AABB3 computeScreenSpaceBoundingBox(); // View space bounding box of the visible parts of the model
     void update(float dt);
     void resolutionChanged(EventPtr event);
     void processSDLEvent(const SDL_Event &event);
 
+    // Also used by the batch renderer and the benchmarks to load models like the application
+    static ModelType getModelTypeFromFilename(const std::string &modelFilenamePure);
+    static TrajectoryType getTrajectoryTypeFromFilename(const std::string &modelFilenamePure);
+
 protected:
     // State changes
     void setRenderMode(RenderModeOIT newMode, bool forceReset = false);
@@ -129,6 +136,19 @@ private:
     RenderModeOIT oldMode = mode;
     ShaderMode shaderMode = SHADER_MODE_PSEUDO_PHONG;
     std::string modelFilenamePure;
+    float getModelLineRadius(const std::string &modelFilenamePure) const;
+    /// Returns the name of the converted model in the asset cache and the function converting the model to it.
+    std::string getConvertedModelFilename(
+            const std::string &filename, ModelType modelType, TrajectoryType trajectoryType, float lineRadius,
+            AssetCache::ConversionFunction &conversionFunction) const;
+
+    // Models are converted in the background on a model switch (the current model is rendered until it's finished)
+    bool convertModelsInBackground = true;
+    std::string pendingModelFilename;
+    std::string pendingConvertedModelFilename;
+    bool pendingModelResetCamera = true;
+    // Encodings of the tube meshes of line and hair data sets (part of the asset cache key)
+    TubeMeshEncodings tubeMeshEncodings;
     bool shuffleGeometry = false; // For testing order dependency of OIT algorithms on triangle order
     std::list<std::string> gatherShaderIDs;
 
@@ -140,6 +160,9 @@ private:
     // Objects in the scene
     boost::shared_ptr<OIT_Renderer> oitRenderer;
     MeshRenderer transparentObject;
+    bool useFrustumCulling = true; // CPU frustum culling of the mesh chunks
+    bool sortPrimitivesForCulling = false; // Reorders the mesh primitives spatially for tighter chunks on loading
+    size_t numVisibleChunks = 0;
     glm::mat4 rotation;
     glm::mat4 scaling;
     sgl::AABB3 boundingBox;
@@ -188,12 +211,27 @@ private:
             = IMPORTANCE_CRITERION_UCLA_MAGNITUDE;
     int importanceCriterionIndex = 0;
     float minCriterionValue = 0.0f, maxCriterionValue = 1.0f;
+    bool histogramDirty = false; // Histogram is only computed when the transfer function window is shown
     bool useGeometryShader = false;
     bool useProgrammableFetch = false;
     bool programmableFetchUseAoS = true; // Array of structs
     void changeImportanceCriterionType();
     void recomputeHistogramForMesh();
 
+    // Point rendering level of detail
+    void updatePointLODSelection();
+    PointLODHierarchy pointLOD;
+    bool usePointLOD = true;
+    int pointBudget = 2000000;
+    float pointLODMaxScreenError = 1.0f; // In pixels
+    bool pointLODSelectionDirty = true;
+    glm::mat4 pointLODLastMvpMatrix;
+    PointLODSelectionStatistics pointLODStatistics;
+    bool pointLODSelectionEmpty = false;
+    sgl::GeometryBufferPtr pointLODIndexBuffer; ///< Only used with LOD, holds pointBudget indices.
+    size_t pointLODIndexBufferCapacity = 0;
+    size_t pointLODNumIndices = 0;
+
     // Hair rendering
     bool colorArrayMode = false;
 
@@ -15,6 +15,13 @@ void setCurrentAlgorithmBufferSizeBytes(size_t numBytes)
     }
 }
 
+void setCurrentAlgorithmTimeToConvergedMS(double timeMS)
+{
+    if (g_Measurer != NULL) {
+        g_Measurer->setCurrentAlgorithmTimeToConvergedMS(timeMS);
+    }
+}
+
 void setPerformanceMeasurer(AutoPerfMeasurer *measurer)
 {
     g_Measurer = measurer;
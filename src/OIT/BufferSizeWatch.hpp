@@ -11,6 +11,8 @@
 class AutoPerfMeasurer;
 
 extern void setCurrentAlgorithmBufferSizeBytes(size_t numBytes);
+// Time until a progressive algorithm reached converged quality (negative if it didn't converge).
+extern void setCurrentAlgorithmTimeToConvergedMS(double timeMS);
 extern void setPerformanceMeasurer(AutoPerfMeasurer *measurer);
 
 #endif //PIXELSYNCOIT_BUFFERSIZEWATCH_HPP
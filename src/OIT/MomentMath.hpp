@@ -0,0 +1,1265 @@
+/**
+ * This file is part of a C++ port of the GLSL code in Data/Shaders/MBOIT (MomentMath.glsl,
+ * TrigonometricMomentMath.glsl, ComplexAlgebra.glsl and the moment generation in MomentOIT.glsl), which itself is a
+ * port of the HLSL code accompanying the paper "Moment-Based Order-Independent Transparency" by Münstermann, Krumpen,
+ * Klein, and Peters (http://momentsingraphics.de/?page_id=210).
+ * The original code was released in accordance to CC0 (https://creativecommons.org/publicdomain/zero/1.0/).
+ *
+ * This port is released under the terms of GNU General Public License v3. For more details please see the LICENSE
+ * file in the root directory of this project.
+ *
+ * Changes for the C++ port: Copyright 2026 Christoph Neuhauser
+ */
+
+#ifndef PIXELSYNCOIT_MOMENTMATH_HPP
+#define PIXELSYNCOIT_MOMENTMATH_HPP
+
+#include <cmath>
+#include <algorithm>
+#include <glm/glm.hpp>
+
+#include "OIT_MBOIT_Utils.hpp"
+
+/**
+ * Per-pixel moment generation and transmittance reconstruction. All functions are defined inline, such that they can
+ * be vectorized across pixels by the loops calling them (see MomentResolverCPU). The function names and the order
+ * of the operations match the shader code, i.e., differences in the results are only caused by the floating point
+ * arithmetic of the CPU and the GPU.
+ *
+ * Differences to the shader code: The moments b_1, ..., b_n are passed as one array in this order (i.e., the odd and
+ * even power moments are interleaved, and trigonometric moment k is stored as real and imaginary part in b[2k-2] and
+ * b[2k-1]). The shader code stores them in different textures depending on the number of moments.
+ */
+namespace MomentMath {
+
+/// Absorbance would be infinite for zero transmittance (see MomentOIT.glsl).
+const float ABSORBANCE_MAX_VALUE = 10.0f;
+/// The zeroth moment below which a pixel is treated as empty by resolveMoments (see MomentOIT.glsl).
+const float MIN_ZEROTH_MOMENT = 0.00100050033f;
+
+// ------------------------------------------- DXHelper.glsl -------------------------------------------
+
+inline float fma(float a, float b, float c) { return a * b + c; }
+inline float saturate(float x) { return std::min(std::max(x, 0.0f), 1.0f); }
+inline float mix(float x, float y, float a) { return x + (y - x) * a; }
+
+/// GLSL mul(v, m) with m given in the column-major order of the GLSL matrix constructor (i.e., m * v).
+template<int N>
+inline void mulVectorMatrix(float *out, const float *v, const float *m)
+{
+    for (int i = 0; i < N; i++) {
+        out[i] = 0.0f;
+        for (int j = 0; j < N; j++) {
+            out[i] += m[j*N + i] * v[j];
+        }
+    }
+}
+
+/// GLSL mul(m, v) with m given in the column-major order of the GLSL matrix constructor (i.e., v * m).
+template<int N>
+inline void mulMatrixVector(float *out, const float *m, const float *v)
+{
+    for (int i = 0; i < N; i++) {
+        out[i] = 0.0f;
+        for (int j = 0; j < N; j++) {
+            out[i] += m[i*N + j] * v[j];
+        }
+    }
+}
+
+// ------------------------------------------- ComplexAlgebra.glsl -------------------------------------------
+
+/*! Returns the complex conjugate of the given complex number (i.e. it changes
+    the sign of the y-component).*/
+inline glm::vec2 Conjugate(const glm::vec2 &Z) {
+    return glm::vec2(Z.x, -Z.y);
+}
+/*! This function implements complex multiplication.*/
+inline glm::vec2 Multiply(const glm::vec2 &LHS, const glm::vec2 &RHS) {
+    return glm::vec2(LHS.x*RHS.x - LHS.y*RHS.y, LHS.x*RHS.y + LHS.y*RHS.x);
+}
+/*! This function computes the quotient of two complex numbers. The denominator
+    must not be zero.*/
+inline glm::vec2 Divide(const glm::vec2 &Numerator, const glm::vec2 &Denominator) {
+    return glm::vec2(Numerator.x*Denominator.x + Numerator.y*Denominator.y,
+            -Numerator.x*Denominator.y + Numerator.y*Denominator.x) / glm::dot(Denominator, Denominator);
+}
+/*! This function divides a real number by a complex number. The denominator
+    must not be zero.*/
+inline glm::vec2 Divide(float Numerator, const glm::vec2 &Denominator) {
+    return glm::vec2(Numerator*Denominator.x, -Numerator*Denominator.y) / glm::dot(Denominator, Denominator);
+}
+/*! This function implements computation of the reciprocal of the given non-
+    zero complex number.*/
+inline glm::vec2 Reciprocal(const glm::vec2 &Z) {
+    return glm::vec2(Z.x, -Z.y) / glm::dot(Z, Z);
+}
+/*! This utility function implements complex squaring.*/
+inline glm::vec2 Square(const glm::vec2 &Z) {
+    return glm::vec2(Z.x*Z.x - Z.y*Z.y, 2.0f*Z.x*Z.y);
+}
+/*! This utility function computes one square root of the given complex value.
+    The other one can be found using the unary minus operator.
+  \warning This function is continuous but not defined on the negative real
+            axis (and cannot be continued continuously there).*/
+inline glm::vec2 SquareRootUnsafe(const glm::vec2 &Z) {
+    float ZLengthSq = glm::dot(Z, Z);
+    float ZLengthInv = 1.0f / std::sqrt(ZLengthSq);
+    glm::vec2 UnnormalizedRoot = Z*ZLengthInv + glm::vec2(1.0f, 0.0f);
+    float UnnormalizedRootLengthSq = glm::dot(UnnormalizedRoot, UnnormalizedRoot);
+    float NormalizationFactorInvSq = UnnormalizedRootLengthSq*ZLengthInv;
+    float NormalizationFactor = 1.0f / std::sqrt(NormalizationFactorInvSq);
+    return NormalizationFactor*UnnormalizedRoot;
+}
+/*! This utility function computes one square root of the given complex value.
+    The other one can be found using the unary minus operator.
+  \note This function has discontinuities for values with real part zero.*/
+inline glm::vec2 SquareRoot(const glm::vec2 &Z) {
+    glm::vec2 ZPositiveRealPart = glm::vec2(std::abs(Z.x), Z.y);
+    glm::vec2 ComputedRoot = SquareRootUnsafe(ZPositiveRealPart);
+    return (Z.x >= 0.0f) ? ComputedRoot : glm::vec2(ComputedRoot.y, ComputedRoot.x);
+}
+/*! This utility function computes one cubic root of the given complex value. The
+   other roots can be found by multiplication by cubic roots of unity.
+  \note This function has various discontinuities.*/
+inline glm::vec2 CubicRoot(const glm::vec2 &Z) {
+    float Argument = std::atan2(Z.y, Z.x);
+    float NewArgument = Argument / 3.0f;
+    glm::vec2 NormalizedRoot = glm::vec2(std::cos(NewArgument), std::sin(NewArgument));
+    return NormalizedRoot*std::pow(glm::dot(Z, Z), 1.0f / 6.0f);
+}
+/*! Returns the real part of a complex number as real.*/
+inline float RealPart(const glm::vec2 &Z) {
+    return Z.x;
+}
+
+/*! Given coefficients of a quadratic polynomial A*x^2+B*x+C, this function
+    outputs its two complex roots.*/
+inline void SolveQuadratic(glm::vec2 pOutRoot[2], glm::vec2 A, glm::vec2 B, glm::vec2 C)
+{
+    // Normalize the coefficients
+    glm::vec2 InvA = Reciprocal(A);
+    B = Multiply(B, InvA);
+    C = Multiply(C, InvA);
+    // Divide the middle coefficient by two
+    B *= 0.5f;
+    // Apply the quadratic formula
+    glm::vec2 DiscriminantRoot = SquareRoot(Square(B) - C);
+    pOutRoot[0] = -B - DiscriminantRoot;
+    pOutRoot[1] = -B + DiscriminantRoot;
+}
+
+/*! Given coefficients of a cubic polynomial A*x^3+B*x^2+C*x+D, this function
+    outputs its three complex roots.*/
+inline void SolveCubicBlinn(glm::vec2 pOutRoot[3], glm::vec2 A, glm::vec2 B, glm::vec2 C, glm::vec2 D)
+{
+    const float SQRT_3 = std::sqrt(3.0f);
+    // Normalize the polynomial
+    glm::vec2 InvA = Reciprocal(A);
+    B = Multiply(B, InvA);
+    C = Multiply(C, InvA);
+    D = Multiply(D, InvA);
+    // Divide middle coefficients by three
+    B /= 3.0f;
+    C /= 3.0f;
+    // Compute the Hessian and the discriminant
+    glm::vec2 Delta00 = -Square(B) + C;
+    glm::vec2 Delta01 = -Multiply(C, B) + D;
+    glm::vec2 Delta11 = Multiply(B, D) - Square(C);
+    glm::vec2 Discriminant = 4.0f*Multiply(Delta00, Delta11) - Square(Delta01);
+    // Compute coefficients of the depressed cubic
+    // (third is zero, fourth is one)
+    glm::vec2 DepressedD = -2.0f*Multiply(B, Delta00) + Delta01;
+    glm::vec2 DepressedC = Delta00;
+    // Take the cubic root of a complex number avoiding cancellation
+    glm::vec2 DiscriminantRoot = SquareRoot(-Discriminant);
+    // faceforward(DiscriminantRoot, DiscriminantRoot, DepressedD)
+    DiscriminantRoot = glm::dot(DepressedD, DiscriminantRoot) < 0.0f ? DiscriminantRoot : -DiscriminantRoot;
+    glm::vec2 CubedRoot = DiscriminantRoot - DepressedD;
+    glm::vec2 FirstRoot = CubicRoot(0.5f*CubedRoot);
+    glm::vec2 pCubicRoot[3] = {
+        FirstRoot,
+        Multiply(glm::vec2(-0.5f, -0.5f*SQRT_3), FirstRoot),
+        Multiply(glm::vec2(-0.5f, 0.5f*SQRT_3), FirstRoot)
+    };
+    // Also compute the reciprocal cubic roots
+    glm::vec2 InvFirstRoot = Reciprocal(FirstRoot);
+    glm::vec2 pInvCubicRoot[3] = {
+        InvFirstRoot,
+        Multiply(glm::vec2(-0.5f, 0.5f*SQRT_3), InvFirstRoot),
+        Multiply(glm::vec2(-0.5f, -0.5f*SQRT_3), InvFirstRoot)
+    };
+    // Turn them into roots of the depressed cubic and revert the depression
+    // transform
+    for (int i = 0; i != 3; ++i) {
+        pOutRoot[i] = pCubicRoot[i] - Multiply(DepressedC, pInvCubicRoot[i]) - B;
+    }
+}
+
+/*! Given coefficients of a quartic polynomial A*x^4+B*x^3+C*x^2+D*x+E, this
+    function outputs its four complex roots.*/
+inline void SolveQuarticNeumark(
+        glm::vec2 pOutRoot[4], glm::vec2 A, glm::vec2 B, glm::vec2 C, glm::vec2 D, glm::vec2 E)
+{
+    // Normalize the polynomial
+    glm::vec2 InvA = Reciprocal(A);
+    B = Multiply(B, InvA);
+    C = Multiply(C, InvA);
+    D = Multiply(D, InvA);
+    E = Multiply(E, InvA);
+    // Construct a normalized cubic
+    glm::vec2 P = -2.0f*C;
+    glm::vec2 Q = Square(C) + Multiply(B, D) - 4.0f*E;
+    glm::vec2 R = Square(D) + Multiply(Square(B), E) - Multiply(Multiply(B, C), D);
+    // Compute a root that is not the smallest of the cubic
+    glm::vec2 pCubicRoot[3];
+    SolveCubicBlinn(pCubicRoot, glm::vec2(1.0f, 0.0f), P, Q, R);
+    glm::vec2 y = (glm::dot(pCubicRoot[1], pCubicRoot[1]) > glm::dot(pCubicRoot[0], pCubicRoot[0]))
+            ? pCubicRoot[1] : pCubicRoot[0];
+
+    // Solve a quadratic to obtain linear coefficients for quadratic polynomials
+    glm::vec2 BB = Square(B);
+    glm::vec2 fy = 4.0f*y;
+    glm::vec2 BB_fy = BB - fy;
+    glm::vec2 tmp = SquareRoot(BB_fy);
+    glm::vec2 G = (B + tmp)*0.5f;
+    glm::vec2 g = (B - tmp)*0.5f;
+    // Construct the corresponding constant coefficients
+    glm::vec2 Z = C - y;
+    tmp = Divide(0.5f*Multiply(B, Z) - D, tmp);
+    glm::vec2 H = Z*0.5f + tmp;
+    glm::vec2 h = Z*0.5f - tmp;
+
+    // Compute the roots
+    glm::vec2 pQuadraticRoot[2];
+    SolveQuadratic(pQuadraticRoot, glm::vec2(1.0f, 0.0f), G, H);
+    pOutRoot[0] = pQuadraticRoot[0];
+    pOutRoot[1] = pQuadraticRoot[1];
+    SolveQuadratic(pQuadraticRoot, glm::vec2(1.0f, 0.0f), g, h);
+    pOutRoot[2] = pQuadraticRoot[0];
+    pOutRoot[3] = pQuadraticRoot[1];
+}
+
+// ------------------------------------------- TrigonometricMomentMath.glsl -------------------------------------------
+
+/*! This utility function turns a point on the unit circle into a scalar
+    parameter. It is guaranteed to grow monotonically for (cos(phi),sin(phi))
+    with phi in 0 to 2*pi. There are no other guarantees. In particular it is
+    not an arclength parametrization. It must match circleToParameter(float) in
+    OIT_MBOIT_Utils.cpp.*/
+inline float circleToParameter(const glm::vec2 &circle_point) {
+    float result = std::abs(circle_point.y) - std::abs(circle_point.x);
+    result = (circle_point.x < 0.0f) ? (2.0f - result) : result;
+    return (circle_point.y < 0.0f) ? (6.0f - result) : result;
+}
+
+/*! This utility function returns the appropriate weight factor for a root at
+    the given location. Both inputs are supposed to be unit vectors. If a
+    circular arc going counter clockwise from (1.0,0.0) meets root first, it
+    returns 1.0, otherwise 0.0 or a linear ramp in the wrapping zone.*/
+inline float getRootWeightFactor(
+        float reference_parameter, float root_parameter, const glm::vec4 &wrapping_zone_parameters) {
+    float binary_weigth_factor = (root_parameter < reference_parameter) ? 1.0f : 0.0f;
+    float linear_weigth_factor = saturate(fma(root_parameter, wrapping_zone_parameters.z, wrapping_zone_parameters.w));
+    return binary_weigth_factor + linear_weigth_factor;
+}
+
+/*! This function reconstructs the transmittance at the given depth from two
+    normalized trigonometric moments.*/
+inline float computeTransmittanceAtDepthFrom2TrigonometricMoments(
+        float b_0, const glm::vec2 trig_b[2], float depth, float bias, float overestimation,
+        const glm::vec4 &wrapping_zone_parameters)
+{
+    // Apply biasing and reformat the inputs a little bit
+    float moment_scale = 1.0f - bias;
+    glm::vec2 b[3] = {
+        glm::vec2(1.0f, 0.0f),
+        trig_b[0] * moment_scale,
+        trig_b[1] * moment_scale
+    };
+    // Compute a Cholesky factorization of the Toeplitz matrix
+    float D00 = RealPart(b[0]);
+    float InvD00 = 1.0f / D00;
+    glm::vec2 L10 = (b[1])*InvD00;
+    float D11 = RealPart(b[0] - D00*Multiply(L10, Conjugate(L10)));
+    float InvD11 = 1.0f / D11;
+    glm::vec2 L20 = (b[2])*InvD00;
+    glm::vec2 L21 = (b[1] - D00*Multiply(L20, Conjugate(L10)))*InvD11;
+    float D22 = RealPart(b[0] - D00*Multiply(L20, Conjugate(L20)) - D11*Multiply(L21, Conjugate(L21)));
+    float InvD22 = 1.0f / D22;
+    // Solve a linear system to get the relevant polynomial
+    float phase = fma(depth, wrapping_zone_parameters.y, wrapping_zone_parameters.y);
+    glm::vec2 circle_point = glm::vec2(std::cos(phase), std::sin(phase));
+    glm::vec2 c[3] = {
+        glm::vec2(1.0f, 0.0f),
+        circle_point,
+        Multiply(circle_point, circle_point)
+    };
+    c[1] -= Multiply(L10, c[0]);
+    c[2] -= Multiply(L20, c[0]) + Multiply(L21, c[1]);
+    c[0] *= InvD00;
+    c[1] *= InvD11;
+    c[2] *= InvD22;
+    c[1] -= Multiply(Conjugate(L21), c[2]);
+    c[0] -= Multiply(Conjugate(L10), c[1]) + Multiply(Conjugate(L20), c[2]);
+    // Compute roots of the polynomial
+    glm::vec2 pRoot[2];
+    SolveQuadratic(pRoot, Conjugate(c[2]), Conjugate(c[1]), Conjugate(c[0]));
+    // Figure out how to weight the weights
+    float depth_parameter = circleToParameter(circle_point);
+    float weigth_factor[3];
+    weigth_factor[0] = overestimation;
+    for (int i = 0; i != 2; ++i) {
+        float root_parameter = circleToParameter(pRoot[i]);
+        weigth_factor[i+1] = getRootWeightFactor(depth_parameter, root_parameter, wrapping_zone_parameters);
+    }
+    // Compute the appropriate linear combination of weights
+    glm::vec2 z[3] = { circle_point, pRoot[0], pRoot[1] };
+    float f0 = weigth_factor[0];
+    float f1 = weigth_factor[1];
+    float f2 = weigth_factor[2];
+    glm::vec2 f01 = Divide(f1 - f0, z[1] - z[0]);
+    glm::vec2 f12 = Divide(f2 - f1, z[2] - z[1]);
+    glm::vec2 f012 = Divide(f12 - f01, z[2] - z[0]);
+    glm::vec2 polynomial[3];
+    polynomial[0] = f012;
+    polynomial[1] = polynomial[0];
+    polynomial[0] = f01 - Multiply(polynomial[0], z[1]);
+    polynomial[2] = polynomial[1];
+    polynomial[1] = polynomial[0] - Multiply(polynomial[1], z[0]);
+    polynomial[0] = glm::vec2(f0, 0.0f) - Multiply(polynomial[0], z[0]);
+    float weight_sum = 0.0f;
+    weight_sum += RealPart(Multiply(b[0], polynomial[0]));
+    weight_sum += RealPart(Multiply(b[1], polynomial[1]));
+    weight_sum += RealPart(Multiply(b[2], polynomial[2]));
+    // Turn the normalized absorbance into transmittance
+    return std::exp(-b_0 * weight_sum);
+}
+
+/*! This function reconstructs the transmittance at the given depth from three
+    normalized trigonometric moments. */
+inline float computeTransmittanceAtDepthFrom3TrigonometricMoments(
+        float b_0, const glm::vec2 trig_b[3], float depth, float bias, float overestimation,
+        const glm::vec4 &wrapping_zone_parameters)
+{
+    // Apply biasing and reformat the inputs a little bit
+    float moment_scale = 1.0f - bias;
+    glm::vec2 b[4] = {
+        glm::vec2(1.0f, 0.0f),
+        trig_b[0] * moment_scale,
+        trig_b[1] * moment_scale,
+        trig_b[2] * moment_scale
+    };
+    // Compute a Cholesky factorization of the Toeplitz matrix
+    float D00 = RealPart(b[0]);
+    float InvD00 = 1.0f / D00;
+    glm::vec2 L10 = (b[1])*InvD00;
+    float D11 = RealPart(b[0] - D00*Multiply(L10, Conjugate(L10)));
+    float InvD11 = 1.0f / D11;
+    glm::vec2 L20 = (b[2])*InvD00;
+    glm::vec2 L21 = (b[1] - D00*Multiply(L20, Conjugate(L10)))*InvD11;
+    float D22 = RealPart(b[0] - D00*Multiply(L20, Conjugate(L20)) - D11*Multiply(L21, Conjugate(L21)));
+    float InvD22 = 1.0f / D22;
+    glm::vec2 L30 = (b[3])*InvD00;
+    glm::vec2 L31 = (b[2] - D00*Multiply(L30, Conjugate(L10)))*InvD11;
+    glm::vec2 L32 = (b[1] - D00*Multiply(L30, Conjugate(L20)) - D11*Multiply(L31, Conjugate(L21)))*InvD22;
+    float D33 = RealPart(b[0] - D00*Multiply(L30, Conjugate(L30)) - D11*Multiply(L31, Conjugate(L31))
+            - D22*Multiply(L32, Conjugate(L32)));
+    float InvD33 = 1.0f / D33;
+    // Solve a linear system to get the relevant polynomial
+    float phase = fma(depth, wrapping_zone_parameters.y, wrapping_zone_parameters.y);
+    glm::vec2 circle_point = glm::vec2(std::cos(phase), std::sin(phase));
+    glm::vec2 circle_point_pow2 = Multiply(circle_point, circle_point);
+    glm::vec2 c[4] = {
+        glm::vec2(1.0f, 0.0f),
+        circle_point,
+        circle_point_pow2,
+        Multiply(circle_point, circle_point_pow2)
+    };
+    c[1] -= Multiply(L10, c[0]);
+    c[2] -= Multiply(L20, c[0]) + Multiply(L21, c[1]);
+    c[3] -= Multiply(L30, c[0]) + Multiply(L31, c[1]) + Multiply(L32, c[2]);
+    c[0] *= InvD00;
+    c[1] *= InvD11;
+    c[2] *= InvD22;
+    c[3] *= InvD33;
+    c[2] -= Multiply(Conjugate(L32), c[3]);
+    c[1] -= Multiply(Conjugate(L21), c[2]) + Multiply(Conjugate(L31), c[3]);
+    c[0] -= Multiply(Conjugate(L10), c[1]) + Multiply(Conjugate(L20), c[2]) + Multiply(Conjugate(L30), c[3]);
+    // Compute roots of the polynomial
+    glm::vec2 pRoot[3];
+    SolveCubicBlinn(pRoot, Conjugate(c[3]), Conjugate(c[2]), Conjugate(c[1]), Conjugate(c[0]));
+    // Figure out how to weight the weights
+    float depth_parameter = circleToParameter(circle_point);
+    float weigth_factor[4];
+    weigth_factor[0] = overestimation;
+    for (int i = 0; i != 3; ++i) {
+        float root_parameter = circleToParameter(pRoot[i]);
+        weigth_factor[i+1] = getRootWeightFactor(depth_parameter, root_parameter, wrapping_zone_parameters);
+    }
+    // Compute the appropriate linear combination of weights
+    glm::vec2 z[4] = { circle_point, pRoot[0], pRoot[1], pRoot[2] };
+    float f0 = weigth_factor[0];
+    float f1 = weigth_factor[1];
+    float f2 = weigth_factor[2];
+    float f3 = weigth_factor[3];
+    glm::vec2 f01 = Divide(f1 - f0, z[1] - z[0]);
+    glm::vec2 f12 = Divide(f2 - f1, z[2] - z[1]);
+    glm::vec2 f23 = Divide(f3 - f2, z[3] - z[2]);
+    glm::vec2 f012 = Divide(f12 - f01, z[2] - z[0]);
+    glm::vec2 f123 = Divide(f23 - f12, z[3] - z[1]);
+    glm::vec2 f0123 = Divide(f123 - f012, z[3] - z[0]);
+    glm::vec2 polynomial[4];
+    polynomial[0] = f0123;
+    polynomial[1] = polynomial[0];
+    polynomial[0] = f012 - Multiply(polynomial[0], z[2]);
+    polynomial[2] = polynomial[1];
+    polynomial[1] = polynomial[0] - Multiply(polynomial[1], z[1]);
+    polynomial[0] = f01 - Multiply(polynomial[0], z[1]);
+    polynomial[3] = polynomial[2];
+    polynomial[2] = polynomial[1] - Multiply(polynomial[2], z[0]);
+    polynomial[1] = polynomial[0] - Multiply(polynomial[1], z[0]);
+    polynomial[0] = glm::vec2(f0, 0.0f) - Multiply(polynomial[0], z[0]);
+    float weight_sum = 0.0f;
+    weight_sum += RealPart(Multiply(b[0], polynomial[0]));
+    weight_sum += RealPart(Multiply(b[1], polynomial[1]));
+    weight_sum += RealPart(Multiply(b[2], polynomial[2]));
+    weight_sum += RealPart(Multiply(b[3], polynomial[3]));
+    // Turn the normalized absorbance into transmittance
+    return std::exp(-b_0 * weight_sum);
+}
+
+/*! This function reconstructs the transmittance at the given depth from four
+    normalized trigonometric moments.*/
+inline float computeTransmittanceAtDepthFrom4TrigonometricMoments(
+        float b_0, const glm::vec2 trig_b[4], float depth, float bias, float overestimation,
+        const glm::vec4 &wrapping_zone_parameters)
+{
+    // Apply biasing and reformat the inputs a little bit
+    float moment_scale = 1.0f - bias;
+    glm::vec2 b[5] = {
+        glm::vec2(1.0f, 0.0f),
+        trig_b[0] * moment_scale,
+        trig_b[1] * moment_scale,
+        trig_b[2] * moment_scale,
+        trig_b[3] * moment_scale
+    };
+    // Compute a Cholesky factorization of the Toeplitz matrix
+    float D00 = RealPart(b[0]);
+    float InvD00 = 1.0f / D00;
+    glm::vec2 L10 = (b[1])*InvD00;
+    float D11 = RealPart(b[0] - D00*Multiply(L10, Conjugate(L10)));
+    float InvD11 = 1.0f / D11;
+    glm::vec2 L20 = (b[2])*InvD00;
+    glm::vec2 L21 = (b[1] - D00*Multiply(L20, Conjugate(L10)))*InvD11;
+    float D22 = RealPart(b[0] - D00*Multiply(L20, Conjugate(L20)) - D11*Multiply(L21, Conjugate(L21)));
+    float InvD22 = 1.0f / D22;
+    glm::vec2 L30 = (b[3])*InvD00;
+    glm::vec2 L31 = (b[2] - D00*Multiply(L30, Conjugate(L10)))*InvD11;
+    glm::vec2 L32 = (b[1] - D00*Multiply(L30, Conjugate(L20)) - D11*Multiply(L31, Conjugate(L21)))*InvD22;
+    float D33 = RealPart(b[0] - D00*Multiply(L30, Conjugate(L30)) - D11*Multiply(L31, Conjugate(L31))
+            - D22*Multiply(L32, Conjugate(L32)));
+    float InvD33 = 1.0f / D33;
+    glm::vec2 L40 = (b[4])*InvD00;
+    glm::vec2 L41 = (b[3] - D00*Multiply(L40, Conjugate(L10)))*InvD11;
+    glm::vec2 L42 = (b[2] - D00*Multiply(L40, Conjugate(L20)) - D11*Multiply(L41, Conjugate(L21)))*InvD22;
+    glm::vec2 L43 = (b[1] - D00*Multiply(L40, Conjugate(L30)) - D11*Multiply(L41, Conjugate(L31))
+            - D22*Multiply(L42, Conjugate(L32)))*InvD33;
+    float D44 = RealPart(b[0] - D00*Multiply(L40, Conjugate(L40)) - D11*Multiply(L41, Conjugate(L41))
+            - D22*Multiply(L42, Conjugate(L42)) - D33*Multiply(L43, Conjugate(L43)));
+    float InvD44 = 1.0f / D44;
+    // Solve a linear system to get the relevant polynomial
+    float phase = fma(depth, wrapping_zone_parameters.y, wrapping_zone_parameters.y);
+    glm::vec2 circle_point = glm::vec2(std::cos(phase), std::sin(phase));
+    glm::vec2 circle_point_pow2 = Multiply(circle_point, circle_point);
+    glm::vec2 c[5] = {
+        glm::vec2(1.0f, 0.0f),
+        circle_point,
+        circle_point_pow2,
+        Multiply(circle_point, circle_point_pow2),
+        Multiply(circle_point_pow2, circle_point_pow2)
+    };
+    c[1] -= Multiply(L10, c[0]);
+    c[2] -= Multiply(L20, c[0]) + Multiply(L21, c[1]);
+    c[3] -= Multiply(L30, c[0]) + Multiply(L31, c[1]) + Multiply(L32, c[2]);
+    c[4] -= Multiply(L40, c[0]) + Multiply(L41, c[1]) + Multiply(L42, c[2]) + Multiply(L43, c[3]);
+    c[0] *= InvD00;
+    c[1] *= InvD11;
+    c[2] *= InvD22;
+    c[3] *= InvD33;
+    c[4] *= InvD44;
+    c[3] -= Multiply(Conjugate(L43), c[4]);
+    c[2] -= Multiply(Conjugate(L32), c[3]) + Multiply(Conjugate(L42), c[4]);
+    c[1] -= Multiply(Conjugate(L21), c[2]) + Multiply(Conjugate(L31), c[3]) + Multiply(Conjugate(L41), c[4]);
+    c[0] -= Multiply(Conjugate(L10), c[1]) + Multiply(Conjugate(L20), c[2]) + Multiply(Conjugate(L30), c[3])
+            + Multiply(Conjugate(L40), c[4]);
+    // Compute roots of the polynomial
+    glm::vec2 pRoot[4];
+    SolveQuarticNeumark(pRoot, Conjugate(c[4]), Conjugate(c[3]), Conjugate(c[2]), Conjugate(c[1]), Conjugate(c[0]));
+    // Figure out how to weight the weights
+    float depth_parameter = circleToParameter(circle_point);
+    float weigth_factor[5];
+    weigth_factor[0] = overestimation;
+    for (int i = 0; i != 4; ++i) {
+        float root_parameter = circleToParameter(pRoot[i]);
+        weigth_factor[i+1] = getRootWeightFactor(depth_parameter, root_parameter, wrapping_zone_parameters);
+    }
+    // Compute the appropriate linear combination of weights
+    glm::vec2 z[5] = { circle_point, pRoot[0], pRoot[1], pRoot[2], pRoot[3] };
+    float f0 = weigth_factor[0];
+    float f1 = weigth_factor[1];
+    float f2 = weigth_factor[2];
+    float f3 = weigth_factor[3];
+    float f4 = weigth_factor[4];
+    glm::vec2 f01 = Divide(f1 - f0, z[1] - z[0]);
+    glm::vec2 f12 = Divide(f2 - f1, z[2] - z[1]);
+    glm::vec2 f23 = Divide(f3 - f2, z[3] - z[2]);
+    glm::vec2 f34 = Divide(f4 - f3, z[4] - z[3]);
+    glm::vec2 f012 = Divide(f12 - f01, z[2] - z[0]);
+    glm::vec2 f123 = Divide(f23 - f12, z[3] - z[1]);
+    glm::vec2 f234 = Divide(f34 - f23, z[4] - z[2]);
+    glm::vec2 f0123 = Divide(f123 - f012, z[3] - z[0]);
+    glm::vec2 f1234 = Divide(f234 - f123, z[4] - z[1]);
+    glm::vec2 f01234 = Divide(f1234 - f0123, z[4] - z[0]);
+    glm::vec2 polynomial[5];
+    polynomial[0] = f01234;
+    polynomial[1] = polynomial[0];
+    polynomial[0] = f0123 - Multiply(polynomial[0], z[3]);
+    polynomial[2] = polynomial[1];
+    polynomial[1] = polynomial[0] - Multiply(polynomial[1], z[2]);
+    polynomial[0] = f012 - Multiply(polynomial[0], z[2]);
+    polynomial[3] = polynomial[2];
+    polynomial[2] = polynomial[1] - Multiply(polynomial[2], z[1]);
+    polynomial[1] = polynomial[0] - Multiply(polynomial[1], z[1]);
+    polynomial[0] = f01 - Multiply(polynomial[0], z[1]);
+    polynomial[4] = polynomial[3];
+    polynomial[3] = polynomial[2] - Multiply(polynomial[3], z[0]);
+    polynomial[2] = polynomial[1] - Multiply(polynomial[2], z[0]);
+    polynomial[1] = polynomial[0] - Multiply(polynomial[1], z[0]);
+    polynomial[0] = glm::vec2(f0, 0.0f) - Multiply(polynomial[0], z[0]);
+    float weight_sum = 0.0f;
+    weight_sum += RealPart(Multiply(b[0], polynomial[0]));
+    weight_sum += RealPart(Multiply(b[1], polynomial[1]));
+    weight_sum += RealPart(Multiply(b[2], polynomial[2]));
+    weight_sum += RealPart(Multiply(b[3], polynomial[3]));
+    weight_sum += RealPart(Multiply(b[4], polynomial[4]));
+    // Turn the normalized absorbance into transmittance
+    return std::exp(-b_0 * weight_sum);
+}
+
+// ------------------------------------------- MomentMath.glsl -------------------------------------------
+
+/*! Given coefficients of a quadratic polynomial A*x^2+B*x+C, this function
+    outputs its two real roots.*/
+inline glm::vec2 solveQuadratic(glm::vec3 coeffs)
+{
+    coeffs[1] *= 0.5f;
+
+    float x1, x2, tmp;
+
+    tmp = (coeffs[1] * coeffs[1] - coeffs[0] * coeffs[2]);
+    if (coeffs[1] >= 0) {
+        tmp = std::sqrt(tmp);
+        x1 = (-coeffs[2]) / (coeffs[1] + tmp);
+        x2 = (-coeffs[1] - tmp) / coeffs[0];
+    } else {
+        tmp = std::sqrt(tmp);
+        x1 = (-coeffs[1] + tmp) / coeffs[0];
+        x2 = coeffs[2] / (-coeffs[1] + tmp);
+    }
+    return glm::vec2(x1, x2);
+}
+
+/*! Code taken from the blog "Moments in Graphics" by Christoph Peters.
+    http://momentsingraphics.de/?p=105
+    This function computes the three real roots of a cubic polynomial
+    Coefficient[0]+Coefficient[1]*x+Coefficient[2]*x^2+Coefficient[3]*x^3.*/
+inline glm::vec3 SolveCubic(glm::vec4 Coefficient) {
+    const float SQRT_3 = std::sqrt(3.0f);
+    // Normalize the polynomial
+    Coefficient.x /= Coefficient.w;
+    Coefficient.y /= Coefficient.w;
+    Coefficient.z /= Coefficient.w;
+    // Divide middle coefficients by three
+    Coefficient.y /= 3.0f;
+    Coefficient.z /= 3.0f;
+    // Compute the Hessian and the discrimant
+    glm::vec3 Delta = glm::vec3(
+        fma(-Coefficient.z, Coefficient.z, Coefficient.y),
+        fma(-Coefficient.y, Coefficient.z, Coefficient.x),
+        glm::dot(glm::vec2(Coefficient.z, -Coefficient.y), glm::vec2(Coefficient.x, Coefficient.y))
+        );
+    float Discriminant = glm::dot(glm::vec2(4.0f*Delta.x, -Delta.y), glm::vec2(Delta.z, Delta.y));
+    // Compute coefficients of the depressed cubic
+    // (third is zero, fourth is one)
+    glm::vec2 Depressed = glm::vec2(
+        fma(-2.0f*Coefficient.z, Delta.x, Delta.y),
+        Delta.x
+        );
+    // Take the cubic root of a normalized complex number
+    float Theta = std::atan2(std::sqrt(Discriminant), -Depressed.x) / 3.0f;
+    glm::vec2 CubicRootOfUnity = glm::vec2(std::cos(Theta), std::sin(Theta));
+    // Compute the three roots, scale appropriately and
+    // revert the depression transform
+    glm::vec3 Root = glm::vec3(
+        CubicRootOfUnity.x,
+        glm::dot(glm::vec2(-0.5f, -0.5f*SQRT_3), CubicRootOfUnity),
+        glm::dot(glm::vec2(-0.5f, 0.5f*SQRT_3), CubicRootOfUnity)
+        );
+    Root = glm::vec3(2.0f*std::sqrt(-Depressed.y)) * Root - glm::vec3(Coefficient.z);
+    return Root;
+}
+
+/*! Given coefficients of a cubic polynomial
+    coeffs[0]+coeffs[1]*x+coeffs[2]*x^2+coeffs[3]*x^3 with three real roots,
+    this function returns the root of least magnitude.*/
+inline float solveCubicBlinnSmallest(glm::vec4 coeffs)
+{
+    const float SQRT_3 = std::sqrt(3.0f);
+    coeffs.x /= coeffs.w;
+    coeffs.y /= coeffs.w;
+    coeffs.z /= coeffs.w;
+    coeffs.y /= 3.0f;
+    coeffs.z /= 3.0f;
+
+    glm::vec3 delta = glm::vec3(
+            fma(-coeffs.z, coeffs.z, coeffs.y), fma(-coeffs.z, coeffs.y, coeffs.x),
+            coeffs.z * coeffs.x - coeffs.y * coeffs.y);
+    float discriminant = 4.0f * delta.x * delta.z - delta.y * delta.y;
+
+    glm::vec2 depressed = glm::vec2(delta.z, -coeffs.x * delta.y + 2.0f * coeffs.y * delta.z);
+    float theta = std::abs(std::atan2(coeffs.x * std::sqrt(discriminant), -depressed.y)) / 3.0f;
+    glm::vec2 sin_cos = glm::vec2(std::sin(theta), std::cos(theta));
+    float tmp = 2.0f * std::sqrt(-depressed.x);
+    glm::vec2 x = glm::vec2(tmp * sin_cos.y, tmp * (-0.5f * sin_cos.y - 0.5f * SQRT_3 * sin_cos.x));
+    glm::vec2 s = (x.x + x.y < 2.0f * coeffs.y)
+            ? glm::vec2(-coeffs.x, x.x + coeffs.y) : glm::vec2(-coeffs.x, x.y + coeffs.y);
+
+    return s.x / s.y;
+}
+
+/*! Given coefficients of a quartic polynomial
+    coeffs[0]+coeffs[1]*x+coeffs[2]*x^2+coeffs[3]*x^3+coeffs[4]*x^4 with four
+    real roots, this function returns all roots.*/
+inline glm::vec4 solveQuarticNeumark(const float coeffs[5])
+{
+    // Normalization
+    float B = coeffs[3] / coeffs[4];
+    float C = coeffs[2] / coeffs[4];
+    float D = coeffs[1] / coeffs[4];
+    float E = coeffs[0] / coeffs[4];
+
+    // Compute coefficients of the cubic resolvent
+    float P = -2.0f*C;
+    float Q = C*C + B*D - 4.0f*E;
+    float R = D*D + B*B*E - B*C*D;
+
+    // Obtain the smallest cubic root
+    float y = solveCubicBlinnSmallest(glm::vec4(R, Q, P, 1.0f));
+
+    float BB = B*B;
+    float fy = 4.0f * y;
+    float BB_fy = BB - fy;
+
+    float Z = C - y;
+    float ZZ = Z*Z;
+    float fE = 4.0f * E;
+    float ZZ_fE = ZZ - fE;
+
+    float G, g, H, h;
+    // Compute the coefficients of the quadratics adaptively using the two
+    // proposed factorizations by Neumark. Choose the appropriate
+    // factorizations using the heuristic proposed by Herbison-Evans.
+    if (y < 0 || (ZZ + fE) * BB_fy > ZZ_fE * (BB + fy)) {
+        float tmp = std::sqrt(BB_fy);
+        G = (B + tmp) * 0.5f;
+        g = (B - tmp) * 0.5f;
+
+        tmp = (B*Z - 2.0f*D) / (2.0f*tmp);
+        H = fma(Z, 0.5f, tmp);
+        h = fma(Z, 0.5f, -tmp);
+    } else {
+        float tmp = std::sqrt(ZZ_fE);
+        H = (Z + tmp) * 0.5f;
+        h = (Z - tmp) * 0.5f;
+
+        tmp = (B*Z - 2.0f*D) / (2.0f*tmp);
+        G = fma(B, 0.5f, tmp);
+        g = fma(B, 0.5f, -tmp);
+    }
+    // Solve the quadratics
+    glm::vec2 roots0 = solveQuadratic(glm::vec3(1.0f, G, H));
+    glm::vec2 roots1 = solveQuadratic(glm::vec3(1.0f, g, h));
+    return glm::vec4(roots0.x, roots0.y, roots1.x, roots1.y);
+}
+
+/*! Definition of utility functions for quantization and dequantization of
+    power moments stored in 16 bits per moment. NUM_MOMENTS/2 even and odd
+    moments are passed to each function. */
+template<int NUM_MOMENTS>
+inline void offsetMoments(float *b_even, float *b_odd, float sign);
+template<int NUM_MOMENTS>
+inline void quantizeMoments(float *b_even_q, float *b_odd_q, const float *b_even, const float *b_odd);
+template<int NUM_MOMENTS>
+inline void offsetAndDequantizeMoments(float *b_even, float *b_odd, float *b_even_q, float *b_odd_q);
+
+template<>
+inline void offsetMoments<4>(float *b_even, float *b_odd, float sign)
+{
+    b_odd[0] += 0.5f * sign;
+    b_odd[1] += 0.5f * sign;
+}
+
+template<>
+inline void quantizeMoments<4>(float *b_even_q, float *b_odd_q, const float *b_even, const float *b_odd)
+{
+    const float SQRT_3 = std::sqrt(3.0f);
+    const float QuantizationMatrixOdd[4] = { 1.5f, SQRT_3*0.5f, -2.0f, -SQRT_3*2.0f / 9.0f };
+    const float QuantizationMatrixEven[4] = { 4.0f, 0.5f, -4.0f, 0.5f };
+    mulVectorMatrix<2>(b_odd_q, b_odd, QuantizationMatrixOdd);
+    mulVectorMatrix<2>(b_even_q, b_even, QuantizationMatrixEven);
+}
+
+template<>
+inline void offsetAndDequantizeMoments<4>(float *b_even, float *b_odd, float *b_even_q, float *b_odd_q)
+{
+    const float SQRT_3 = std::sqrt(3.0f);
+    const float QuantizationMatrixOdd[4] = { -1.0f / 3.0f, -0.75f, SQRT_3, 0.75f*SQRT_3 };
+    const float QuantizationMatrixEven[4] = { 0.125f, -0.125f, 1.0f, 1.0f };
+    offsetMoments<4>(b_even_q, b_odd_q, -1.0f);
+    mulVectorMatrix<2>(b_odd, b_odd_q, QuantizationMatrixOdd);
+    mulVectorMatrix<2>(b_even, b_even_q, QuantizationMatrixEven);
+}
+
+template<>
+inline void offsetMoments<6>(float *b_even, float *b_odd, float sign)
+{
+    for (int i = 0; i < 3; i++) {
+        b_odd[i] += 0.5f * sign;
+    }
+    b_even[2] += 0.018888946f * sign;
+}
+
+template<>
+inline void quantizeMoments<6>(float *b_even_q, float *b_odd_q, const float *b_even, const float *b_odd)
+{
+    const float QuantizationMatrixOdd[9] = {
+        2.5f, -1.87499864450f, 1.26583039016f,
+        -10.0f, 4.20757543111f, -1.47644882902f,
+        8.0f, -1.83257678661f, 0.71061660238f };
+    const float QuantizationMatrixEven[9] = {
+        4.0f, 9.0f, -0.57759806484f,
+        -4.0f, -24.0f, 4.61936647543f,
+        0.0f, 16.0f, -3.07953906655f };
+    mulVectorMatrix<3>(b_odd_q, b_odd, QuantizationMatrixOdd);
+    mulVectorMatrix<3>(b_even_q, b_even, QuantizationMatrixEven);
+}
+
+template<>
+inline void offsetAndDequantizeMoments<6>(float *b_even, float *b_odd, float *b_even_q, float *b_odd_q)
+{
+    const float QuantizationMatrixOdd[9] = {
+        -0.02877789192f, 0.09995235706f, 0.25893353755f,
+        0.47635550422f, 0.84532580931f, 0.90779616657f,
+        1.55242808973f, 1.05472570761f, 0.83327335647f };
+    const float QuantizationMatrixEven[9] = {
+        0.00001253044f, -0.24998746956f, -0.37498825271f,
+        0.16668494186f, 0.16668494186f, 0.21876713299f,
+        0.86602540579f, 0.86602540579f, 0.81189881793f };
+    offsetMoments<6>(b_even_q, b_odd_q, -1.0f);
+    mulVectorMatrix<3>(b_odd, b_odd_q, QuantizationMatrixOdd);
+    mulVectorMatrix<3>(b_even, b_even_q, QuantizationMatrixEven);
+}
+
+template<>
+inline void offsetMoments<8>(float *b_even, float *b_odd, float sign)
+{
+    const float EvenOffset[4] = { 0.972481993925964f, 1.0f, 0.999179192513328f, 0.991778293073131f };
+    for (int i = 0; i < 4; i++) {
+        b_odd[i] += 0.5f * sign;
+        b_even[i] += EvenOffset[i] * sign;
+    }
+}
+
+template<>
+inline void quantizeMoments<8>(float *b_even_q, float *b_odd_q, const float *b_even, const float *b_odd)
+{
+    const float mat_odd[16] = {
+        3.48044635732474f, -27.5760737514826f, 55.1267384344761f, -31.5311110403183f,
+        1.26797185782836f, -0.928755808743913f, -2.07520453231032f, 1.23598848322588f,
+        -2.1671560004294f, 6.17950199592966f, -0.276515571579297f, -4.23583042392097f,
+        0.974332879165755f, -0.443426830933027f, -0.360491648368785f, 0.310149466050223f };
+    const float mat_even[16] = {
+        0.280504133158527f, -0.757633844606942f, 0.392179589334688f, -0.887531871812237f,
+        -2.01362265883247f, 0.221551373038988f, -1.06107954265125f, 2.83887201588367f,
+        -7.31010494985321f, 13.9855979699139f, -0.114305766176437f, -7.4361899359832f,
+        -15.8954215629556f, 79.6186327084103f, -127.457278992502f, 63.7349456687829f };
+    mulMatrixVector<4>(b_odd_q, mat_odd, b_odd);
+    mulMatrixVector<4>(b_even_q, mat_even, b_even);
+}
+
+template<>
+inline void offsetAndDequantizeMoments<8>(float *b_even, float *b_odd, float *b_even_q, float *b_odd_q)
+{
+    const float mat_odd[16] = {
+        -0.00482399708502382f, -0.423201508674231f, 0.0348312382605129f, 1.67179208266592f,
+        -0.0233402218644408f, -0.832829097046478f, 0.0193406040499625f, 1.21021509068975f,
+        -0.010888537031885f, -0.926393772997063f, -0.11723394414779f, 0.983723301818275f,
+        -0.0308713357806732f, -0.937989172670245f, -0.218033377677099f, 0.845991731322996f };
+    const float mat_even[16] = {
+        -0.976220278891035f, -0.456139260269401f, -0.0504335521016742f, 0.000838800390651085f,
+        -1.04828341778299f, -0.229726640510149f, 0.0259608334616091f, -0.00133632693205861f,
+        -1.03115268628604f, -0.077844420809897f, 0.00443408851014257f, -0.0103744938457406f,
+        -0.996038443434636f, 0.0175438624416783f, -0.0361414253243963f, -0.00317839994022725f };
+    offsetMoments<8>(b_even_q, b_odd_q, -1.0f);
+    mulMatrixVector<4>(b_odd, mat_odd, b_odd_q);
+    mulMatrixVector<4>(b_even, mat_even, b_even_q);
+}
+
+/*! This function reconstructs the transmittance at the given depth from four
+    normalized power moments and the given zeroth moment.*/
+inline float computeTransmittanceAtDepthFrom4PowerMoments(
+        float b_0, const float b_in[4], float depth, float bias, float overestimation, const float bias_vector[4])
+{
+    float b[4];
+    // Bias input data to avoid artifacts
+    for (int i = 0; i != 4; ++i) {
+        b[i] = mix(b_in[i], bias_vector[i], bias);
+    }
+    float z[3];
+    z[0] = depth;
+
+    // Compute a Cholesky factorization of the Hankel matrix B storing only non-
+    // trivial entries or related products
+    float L21D11 = fma(-b[0], b[1], b[2]);
+    float D11 = fma(-b[0], b[0], b[1]);
+    float InvD11 = 1.0f / D11;
+    float L21 = L21D11*InvD11;
+    float SquaredDepthVariance = fma(-b[1], b[1], b[3]);
+    float D22 = fma(-L21D11, L21, SquaredDepthVariance);
+
+    // Obtain a scaled inverse image of bz=(1,z[0],z[0]*z[0])^T
+    float c[3] = { 1.0f, z[0], z[0]*z[0] };
+    // Forward substitution to solve L*c1=bz
+    c[1] -= b[0];
+    c[2] -= b[1] + L21*c[1];
+    // Scaling to solve D*c2=c1
+    c[1] *= InvD11;
+    c[2] /= D22;
+    // Backward substitution to solve L^T*c3=c2
+    c[1] -= L21*c[2];
+    c[0] -= c[1]*b[0] + c[2]*b[1];
+    // Solve the quadratic equation c[0]+c[1]*z+c[2]*z^2 to obtain solutions
+    // z[1] and z[2]
+    float InvC2 = 1.0f / c[2];
+    float p = c[1]*InvC2;
+    float q = c[0]*InvC2;
+    float D = (p*p*0.25f) - q;
+    float r = std::sqrt(D);
+    z[1] = -p*0.5f - r;
+    z[2] = -p*0.5f + r;
+    // Compute the absorbance by summing the appropriate weights
+    float polynomial[3];
+    float f0 = overestimation;
+    float f1 = (z[1] < z[0]) ? 1.0f : 0.0f;
+    float f2 = (z[2] < z[0]) ? 1.0f : 0.0f;
+    float f01 = (f1-f0)/(z[1]-z[0]);
+    float f12 = (f2-f1)/(z[2]-z[1]);
+    float f012 = (f12-f01)/(z[2]-z[0]);
+    polynomial[0] = f012;
+    polynomial[1] = polynomial[0];
+    polynomial[0] = f01 - polynomial[0]*z[1];
+    polynomial[2] = polynomial[1];
+    polynomial[1] = polynomial[0] - polynomial[1]*z[0];
+    polynomial[0] = f0 - polynomial[0]*z[0];
+    float absorbance = polynomial[0] + b[0]*polynomial[1] + b[1]*polynomial[2];
+    // Turn the normalized absorbance into transmittance
+    return saturate(std::exp(-b_0 * absorbance));
+}
+
+/*! This function reconstructs the transmittance at the given depth from six
+    normalized power moments and the given zeroth moment.*/
+inline float computeTransmittanceAtDepthFrom6PowerMoments(
+        float b_0, const float b_in[6], float depth, float bias, float overestimation, const float bias_vector[6])
+{
+    float b[6];
+    // Bias input data to avoid artifacts
+    for (int i = 0; i != 6; ++i) {
+        b[i] = mix(b_in[i], bias_vector[i], bias);
+    }
+
+    float z[4];
+    z[0] = depth;
+
+    // Compute a Cholesky factorization of the Hankel matrix B storing only non-
+    // trivial entries or related products
+    float InvD11 = 1.0f / fma(-b[0], b[0], b[1]);
+    float L21D11 = fma(-b[0], b[1], b[2]);
+    float L21 = L21D11*InvD11;
+    float D22 = fma(-L21D11, L21, fma(-b[1], b[1], b[3]));
+    float L31D11 = fma(-b[0], b[2], b[3]);
+    float L31 = L31D11*InvD11;
+    float InvD22 = 1.0f / D22;
+    float L32D22 = fma(-L21D11, L31, fma(-b[1], b[2], b[4]));
+    float L32 = L32D22*InvD22;
+    float D33 = fma(-b[2], b[2], b[5]) - (L31D11*L31 + L32D22*L32);
+    float InvD33 = 1.0f / D33;
+
+    // Construct the polynomial whose roots have to be points of support of the
+    // canonical distribution: bz=(1,z[0],z[0]*z[0],z[0]*z[0]*z[0])^T
+    glm::vec4 c;
+    c[0] = 1.0f;
+    c[1] = z[0];
+    c[2] = c[1] * z[0];
+    c[3] = c[2] * z[0];
+    // Forward substitution to solve L*c1=bz
+    c[1] -= b[0];
+    c[2] -= fma(L21, c[1], b[1]);
+    c[3] -= b[2] + (L31*c[1] + L32*c[2]);
+    // Scaling to solve D*c2=c1
+    c[1] *= InvD11;
+    c[2] *= InvD22;
+    c[3] *= InvD33;
+    // Backward substitution to solve L^T*c3=c2
+    c[2] -= L32*c[3];
+    c[1] -= L21*c[2] + L31*c[3];
+    c[0] -= b[0]*c[1] + b[1]*c[2] + b[2]*c[3];
+
+    // Solve the cubic equation
+    glm::vec3 roots = SolveCubic(c);
+    z[1] = roots.x;
+    z[2] = roots.y;
+    z[3] = roots.z;
+
+    // Compute the absorbance by summing the appropriate weights
+    // Construct an interpolation polynomial
+    float f0 = overestimation;
+    float f1 = (z[1] > z[0]) ? 0.0f : 1.0f;
+    float f2 = (z[2] > z[0]) ? 0.0f : 1.0f;
+    float f3 = (z[3] > z[0]) ? 0.0f : 1.0f;
+    float f01 = (f1 - f0) / (z[1] - z[0]);
+    float f12 = (f2 - f1) / (z[2] - z[1]);
+    float f23 = (f3 - f2) / (z[3] - z[2]);
+    float f012 = (f12 - f01) / (z[2] - z[0]);
+    float f123 = (f23 - f12) / (z[3] - z[1]);
+    float f0123 = (f123 - f012) / (z[3] - z[0]);
+    float polynomial[4];
+    // f012+f0123 *(z-z2)
+    polynomial[0] = fma(-f0123, z[2], f012);
+    polynomial[1] = f0123;
+    // *(z-z1) +f01
+    polynomial[2] = polynomial[1];
+    polynomial[1] = fma(polynomial[1], -z[1], polynomial[0]);
+    polynomial[0] = fma(polynomial[0], -z[1], f01);
+    // *(z-z0) +f0
+    polynomial[3] = polynomial[2];
+    polynomial[2] = fma(polynomial[2], -z[0], polynomial[1]);
+    polynomial[1] = fma(polynomial[1], -z[0], polynomial[0]);
+    polynomial[0] = fma(polynomial[0], -z[0], f0);
+    float absorbance = polynomial[0] + polynomial[1]*b[0] + polynomial[2]*b[1] + polynomial[3]*b[2];
+    // Turn the normalized absorbance into transmittance
+    return saturate(std::exp(-b_0 * absorbance));
+}
+
+/*! This function reconstructs the transmittance at the given depth from eight
+    normalized power moments and the given zeroth moment.*/
+inline float computeTransmittanceAtDepthFrom8PowerMoments(
+        float b_0, const float b_in[8], float depth, float bias, float overestimation, const float bias_vector[8])
+{
+    float b[8];
+    // Bias input data to avoid artifacts
+    for (int i = 0; i != 8; ++i) {
+        b[i] = mix(b_in[i], bias_vector[i], bias);
+    }
+
+    float z[5];
+    z[0] = depth;
+
+    // Compute a Cholesky factorization of the Hankel matrix B storing only non-trivial entries or related products
+    float D22 = fma(-b[0], b[0], b[1]);
+    float InvD22 = 1.0f / D22;
+    float L32D22 = fma(-b[1], b[0], b[2]);
+    float L32 = L32D22 * InvD22;
+    float L42D22 = fma(-b[2], b[0], b[3]);
+    float L42 = L42D22 * InvD22;
+    float L52D22 = fma(-b[3], b[0], b[4]);
+    float L52 = L52D22 * InvD22;
+
+    float D33 = fma(-L32, L32D22, fma(-b[1], b[1], b[3]));
+    float InvD33 = 1.0f / D33;
+    float L43D33 = fma(-L42, L32D22, fma(-b[2], b[1], b[4]));
+    float L43 = L43D33 * InvD33;
+    float L53D33 = fma(-L52, L32D22, fma(-b[3], b[1], b[5]));
+    float L53 = L53D33 * InvD33;
+
+    float D44 = fma(-b[2], b[2], b[5]) - (L42*L42D22 + L43*L43D33);
+    float InvD44 = 1.0f / D44;
+    float L54D44 = fma(-b[3], b[2], b[6]) - (L52*L42D22 + L53*L43D33);
+    float L54 = L54D44 * InvD44;
+
+    float D55 = fma(-b[3], b[3], b[7]) - (L52*L52D22 + L53*L53D33 + L54*L54D44);
+    float InvD55 = 1.0f / D55;
+
+    // Construct the polynomial whose roots have to be points of support of the
+    // Canonical distribution:
+    // bz = (1,z[0],z[0]^2,z[0]^3,z[0]^4)^T
+    float c[5];
+    c[0] = 1.0f;
+    c[1] = z[0];
+    c[2] = c[1] * z[0];
+    c[3] = c[2] * z[0];
+    c[4] = c[3] * z[0];
+
+    // Forward substitution to solve L*c1 = bz
+    c[1] -= b[0];
+    c[2] -= fma(L32, c[1], b[1]);
+    c[3] -= b[2] + (L42*c[1] + L43*c[2]);
+    c[4] -= b[3] + (L52*c[1] + L53*c[2] + L54*c[3]);
+
+    // Scaling to solve D*c2 = c1
+    c[1] *= InvD22;
+    c[2] *= InvD33;
+    c[3] *= InvD44;
+    c[4] *= InvD55;
+
+    // Backward substitution to solve L^T*c3 = c2
+    c[3] -= L54 * c[4];
+    c[2] -= L53*c[4] + L43*c[3];
+    c[1] -= L52*c[4] + L42*c[3] + L32*c[2];
+    c[0] -= b[3]*c[4] + b[2]*c[3] + b[1]*c[2] + b[0]*c[1];
+
+    // Solve the quartic equation
+    glm::vec4 zz = solveQuarticNeumark(c);
+    z[1] = zz[0];
+    z[2] = zz[1];
+    z[3] = zz[2];
+    z[4] = zz[3];
+
+    // Compute the absorbance by summing the appropriate weights
+    // Construct an interpolation polynomial
+    float f0 = overestimation;
+    float f1 = (z[1] <= z[0]) ? 1.0f : 0.0f;
+    float f2 = (z[2] <= z[0]) ? 1.0f : 0.0f;
+    float f3 = (z[3] <= z[0]) ? 1.0f : 0.0f;
+    float f4 = (z[4] <= z[0]) ? 1.0f : 0.0f;
+    float f01 = (f1 - f0) / (z[1] - z[0]);
+    float f12 = (f2 - f1) / (z[2] - z[1]);
+    float f23 = (f3 - f2) / (z[3] - z[2]);
+    float f34 = (f4 - f3) / (z[4] - z[3]);
+    float f012 = (f12 - f01) / (z[2] - z[0]);
+    float f123 = (f23 - f12) / (z[3] - z[1]);
+    float f234 = (f34 - f23) / (z[4] - z[2]);
+    float f0123 = (f123 - f012) / (z[3] - z[0]);
+    float f1234 = (f234 - f123) / (z[4] - z[1]);
+    float f01234 = (f1234 - f0123) / (z[4] - z[0]);
+
+    float Polynomial_0;
+    float Polynomial[4];
+    // f0123 + f01234 * (z - z3)
+    Polynomial_0 = fma(-f01234, z[3], f0123);
+    Polynomial[0] = f01234;
+    // * (z - z2) + f012
+    Polynomial[1] = Polynomial[0];
+    Polynomial[0] = fma(-Polynomial[0], z[2], Polynomial_0);
+    Polynomial_0 = fma(-Polynomial_0, z[2], f012);
+    // * (z - z1) + f01
+    Polynomial[2] = Polynomial[1];
+    Polynomial[1] = fma(-Polynomial[1], z[1], Polynomial[0]);
+    Polynomial[0] = fma(-Polynomial[0], z[1], Polynomial_0);
+    Polynomial_0 = fma(-Polynomial_0, z[1], f01);
+    // * (z - z0) + f1
+    Polynomial[3] = Polynomial[2];
+    Polynomial[2] = fma(-Polynomial[2], z[0], Polynomial[1]);
+    Polynomial[1] = fma(-Polynomial[1], z[0], Polynomial[0]);
+    Polynomial[0] = fma(-Polynomial[0], z[0], Polynomial_0);
+    Polynomial_0 = fma(-Polynomial_0, z[0], f0);
+    float absorbance = Polynomial_0 + Polynomial[0]*b[0] + Polynomial[1]*b[1] + Polynomial[2]*b[2]
+            + Polynomial[3]*b[3];
+    // Turn the normalized absorbance into transmittance
+    return saturate(std::exp(-b_0 * absorbance));
+}
+
+// ------------------------------------------- MomentOIT.glsl -------------------------------------------
+
+/**
+ * Adds a fragment to the power moments b_1, ..., b_n of a pixel (generatePowerMoments with rasterizer ordered
+ * views). If quantized is true, the moments are stored normalized and quantized like in the UNORM_16 textures
+ * (the caller is responsible for rounding them to 16 bits), otherwise they are accumulated like in the
+ * single-precision textures.
+ */
+template<int NUM_MOMENTS>
+inline void generatePowerMoments(float &b_0, float *b, float depth, float transmittance, bool quantized)
+{
+    const int NUM_MOMENTS_HALF = NUM_MOMENTS / 2;
+    // Absorbance would be infinite for zero transmittance. Thus, make sure transittance is never close to zero.
+    float absorbance = std::min(-std::log(transmittance), ABSORBANCE_MAX_VALUE);
+
+    // (depth, depth^3, ...) and (depth^2, depth^4, ...) computed in the same order as in the shader.
+    float depth_pow2 = depth * depth;
+    float b_even_new[NUM_MOMENTS_HALF], b_odd_new[NUM_MOMENTS_HALF];
+    b_even_new[0] = depth_pow2;
+    b_odd_new[0] = depth;
+    for (int i = 1; i < NUM_MOMENTS_HALF; i++) {
+        b_even_new[i] = b_even_new[i-1] * depth_pow2;
+        b_odd_new[i] = b_even_new[i-1] * depth;
+    }
+
+    if (!quantized) {
+        b_0 += absorbance;
+        for (int i = 0; i < NUM_MOMENTS_HALF; i++) {
+            b[2*i] += b_odd_new[i] * absorbance;
+            b[2*i+1] += b_even_new[i] * absorbance;
+        }
+        return;
+    }
+
+    float b_even[NUM_MOMENTS_HALF], b_odd[NUM_MOMENTS_HALF];
+    for (int i = 0; i < NUM_MOMENTS_HALF; i++) {
+        b_odd[i] = b[2*i];
+        b_even[i] = b[2*i+1];
+    }
+    offsetMoments<NUM_MOMENTS>(b_even, b_odd, -1.0f);
+    for (int i = 0; i < NUM_MOMENTS_HALF; i++) {
+        b_even[i] *= b_0;
+        b_odd[i] *= b_0;
+    }
+
+    //  New Moments
+    float b_even_new_q[NUM_MOMENTS_HALF], b_odd_new_q[NUM_MOMENTS_HALF];
+    quantizeMoments<NUM_MOMENTS>(b_even_new_q, b_odd_new_q, b_even_new, b_odd_new);
+
+    // Combine Moments
+    b_0 += absorbance;
+    for (int i = 0; i < NUM_MOMENTS_HALF; i++) {
+        b_even[i] += b_even_new_q[i] * absorbance;
+        b_odd[i] += b_odd_new_q[i] * absorbance;
+    }
+
+    // Go back to interval [0, 1]
+    for (int i = 0; i < NUM_MOMENTS_HALF; i++) {
+        b_even[i] /= b_0;
+        b_odd[i] /= b_0;
+    }
+    offsetMoments<NUM_MOMENTS>(b_even, b_odd, 1.0f);
+    for (int i = 0; i < NUM_MOMENTS_HALF; i++) {
+        b[2*i] = b_odd[i];
+        b[2*i+1] = b_even[i];
+    }
+}
+
+/**
+ * Adds a fragment to the trigonometric moments of a pixel (generateTrigonometricMoments with rasterizer ordered
+ * views). Trigonometric moment k is stored in b[2k-2] (real part) and b[2k-1] (imaginary part).
+ */
+template<int NUM_MOMENTS>
+inline void generateTrigonometricMoments(
+        float &b_0, float *b, float depth, float transmittance, const glm::vec4 &wrapping_zone_parameters,
+        bool quantized)
+{
+    const int NUM_TRIGONOMETRIC_MOMENTS = NUM_MOMENTS / 2;
+    // Absorbance would be infinite for zero transmittance. Thus, make sure transittance is never close to zero.
+    float absorbance = std::min(-std::log(transmittance), ABSORBANCE_MAX_VALUE);
+
+    float phase = fma(depth, wrapping_zone_parameters.y, wrapping_zone_parameters.y);
+    glm::vec2 circle_point = glm::vec2(std::cos(phase), std::sin(phase));
+    glm::vec2 circle_point_pow2 = Multiply(circle_point, circle_point);
+    glm::vec2 trig_b_new[4] = {
+        circle_point,
+        circle_point_pow2,
+        Multiply(circle_point, circle_point_pow2),
+        Multiply(circle_point_pow2, circle_point_pow2)
+    };
+
+    if (quantized) {
+        for (int i = 0; i < NUM_MOMENTS; i++) {
+            b[i] = fma(b[i], 2.0f, -1.0f) * b_0;
+        }
+    }
+    b_0 += absorbance;
+    for (int i = 0; i < NUM_TRIGONOMETRIC_MOMENTS; i++) {
+        b[2*i] += trig_b_new[i].x * absorbance;
+        b[2*i+1] += trig_b_new[i].y * absorbance;
+    }
+    if (quantized) {
+        for (int i = 0; i < NUM_MOMENTS; i++) {
+            b[i] = fma(b[i] / b_0, 0.5f, 0.5f);
+        }
+    }
+}
+
+/**
+ * Reconstructs the transmittance at the passed depth from the moments of a pixel stored by generatePowerMoments or
+ * generateTrigonometricMoments (resolveMoments in MomentOIT.glsl).
+ * @return The transmittance at the passed depth. Returns 1 for pixels where the shader discards the fragment.
+ */
+template<int NUM_MOMENTS>
+inline float resolveMoments(
+        float b_0, const float *b_stored, float depth, bool usePowerMoments, bool quantized,
+        const MomentOITUniformData &uniformData)
+{
+    const int NUM_MOMENTS_HALF = NUM_MOMENTS / 2;
+    if (b_0 < MIN_ZEROTH_MOMENT) {
+        return 1.0f;
+    }
+
+    if (!usePowerMoments) {
+        glm::vec2 trig_b[NUM_MOMENTS_HALF];
+        for (int i = 0; i < NUM_MOMENTS_HALF; i++) {
+            glm::vec2 moment(b_stored[2*i], b_stored[2*i+1]);
+            trig_b[i] = quantized ? moment * 2.0f - glm::vec2(1.0f) : moment / b_0;
+        }
+        if (NUM_MOMENTS == 4) {
+            return computeTransmittanceAtDepthFrom2TrigonometricMoments(b_0, trig_b, depth,
+                    uniformData.moment_bias, uniformData.overestimation, uniformData.wrapping_zone_parameters);
+        } else if (NUM_MOMENTS == 6) {
+            return computeTransmittanceAtDepthFrom3TrigonometricMoments(b_0, trig_b, depth,
+                    uniformData.moment_bias, uniformData.overestimation, uniformData.wrapping_zone_parameters);
+        } else {
+            return computeTransmittanceAtDepthFrom4TrigonometricMoments(b_0, trig_b, depth,
+                    uniformData.moment_bias, uniformData.overestimation, uniformData.wrapping_zone_parameters);
+        }
+    }
+
+    float b[NUM_MOMENTS];
+    if (quantized) {
+        // Dequantize the moments
+        float b_even_q[NUM_MOMENTS_HALF], b_odd_q[NUM_MOMENTS_HALF];
+        float b_even[NUM_MOMENTS_HALF], b_odd[NUM_MOMENTS_HALF];
+        for (int i = 0; i < NUM_MOMENTS_HALF; i++) {
+            b_odd_q[i] = b_stored[2*i];
+            b_even_q[i] = b_stored[2*i+1];
+        }
+        offsetAndDequantizeMoments<NUM_MOMENTS>(b_even, b_odd, b_even_q, b_odd_q);
+        for (int i = 0; i < NUM_MOMENTS_HALF; i++) {
+            b[2*i] = b_odd[i];
+            b[2*i+1] = b_even[i];
+        }
+    } else {
+        for (int i = 0; i < NUM_MOMENTS; i++) {
+            b[i] = b_stored[i] / b_0;
+        }
+    }
+
+    if (NUM_MOMENTS == 4) {
+        const float bias_vector_float[4] = { 0, 0.375f, 0, 0.375f };
+        const float bias_vector_unorm[4] = { 0, 0.628f, 0, 0.628f };
+        return computeTransmittanceAtDepthFrom4PowerMoments(b_0, b, depth, uniformData.moment_bias,
+                uniformData.overestimation, quantized ? bias_vector_unorm : bias_vector_float);
+    } else if (NUM_MOMENTS == 6) {
+        const float bias_vector_float[6] = { 0, 0.48f, 0, 0.451f, 0, 0.45f };
+        const float bias_vector_unorm[6] = { 0, 0.5566f, 0, 0.489f, 0, 0.47869382f };
+        return computeTransmittanceAtDepthFrom6PowerMoments(b_0, b, depth, uniformData.moment_bias,
+                uniformData.overestimation, quantized ? bias_vector_unorm : bias_vector_float);
+    } else {
+        const float bias_vector_float[8] = {
+                0, 0.75f, 0, 0.67666666666666664f, 0, 0.63f, 0, 0.60030303030303034f };
+        const float bias_vector_unorm[8] = {
+                0, 0.42474916387959866f, 0, 0.22407802675585284f, 0, 0.15369230769230768f, 0, 0.12900440529089119f };
+        return computeTransmittanceAtDepthFrom8PowerMoments(b_0, b, depth, uniformData.moment_bias,
+                uniformData.overestimation, quantized ? bias_vector_unorm : bias_vector_float);
+    }
+}
+
+}
+
+#endif //PIXELSYNCOIT_MOMENTMATH_HPP
@@ -0,0 +1,128 @@
+//
+// Created by christoph on 19.10.26.
+//
+
+#include <cmath>
+#include <Utils/File/Logfile.hpp>
+
+#include "MomentMath.hpp"
+#include "MomentResolverCPU.hpp"
+
+/// Emulates storing a normalized value in a 16-bit UNORM texture.
+static inline float quantizeUnorm16(float value)
+{
+    return std::round(MomentMath::saturate(value) * 65535.0f) / 65535.0f;
+}
+
+MomentResolverCPU::MomentResolverCPU(int numMoments, MBOITPixelFormat pixelFormat, bool usePowerMoments)
+        : numMoments(numMoments), pixelFormat(pixelFormat), usePowerMoments(usePowerMoments)
+{
+    if (numMoments != 4 && numMoments != 6 && numMoments != 8) {
+        sgl::Logfile::get()->writeError(std::string() + "Error in MomentResolverCPU::MomentResolverCPU: "
+                + "Unsupported number of moments. Using 4 moments.");
+        this->numMoments = 4;
+    }
+
+    computeWrappingZoneParameters(uniformData.wrapping_zone_parameters);
+    uniformData.overestimation = 0.1f;
+    uniformData.moment_bias = getMomentBias(this->numMoments, pixelFormat, usePowerMoments);
+}
+
+void MomentResolverCPU::resize(size_t numPixels)
+{
+    this->numPixels = numPixels;
+    zerothMoment.resize(numPixels);
+    moments.resize(numPixels * numMoments);
+    clear();
+}
+
+void MomentResolverCPU::clear()
+{
+    std::fill(zerothMoment.begin(), zerothMoment.end(), 0.0f);
+    std::fill(moments.begin(), moments.end(), 0.0f);
+}
+
+void MomentResolverCPU::generateMoments(const float *depths, const float *transmittances)
+{
+    if (numMoments == 4) {
+        generateMomentsInternal<4>(depths, transmittances);
+    } else if (numMoments == 6) {
+        generateMomentsInternal<6>(depths, transmittances);
+    } else {
+        generateMomentsInternal<8>(depths, transmittances);
+    }
+}
+
+void MomentResolverCPU::resolveMoments(
+        const float *depths, float *transmittanceAtDepth, float *totalTransmittance) const
+{
+    if (numMoments == 4) {
+        resolveMomentsInternal<4>(depths, transmittanceAtDepth, totalTransmittance);
+    } else if (numMoments == 6) {
+        resolveMomentsInternal<6>(depths, transmittanceAtDepth, totalTransmittance);
+    } else {
+        resolveMomentsInternal<8>(depths, transmittanceAtDepth, totalTransmittance);
+    }
+}
+
+template<int NUM_MOMENTS>
+void MomentResolverCPU::generateMomentsInternal(const float *depths, const float *transmittances)
+{
+    const bool quantized = pixelFormat == MBOIT_PIXEL_FORMAT_UNORM_16;
+    const bool powerMoments = usePowerMoments;
+    const glm::vec4 wrappingZoneParameters = uniformData.wrapping_zone_parameters;
+    const size_t n = numPixels;
+    float *b0Data = zerothMoment.data();
+    float *momentData = moments.data();
+
+    #pragma omp parallel for simd
+    for (size_t i = 0; i < n; i++) {
+        // Same as the early out in MBOITPass1.glsl.
+        float transmittance = transmittances[i];
+        if (transmittance > 0.9999999f) {
+            continue;
+        }
+
+        float b_0 = b0Data[i];
+        float b[NUM_MOMENTS];
+        for (int k = 0; k < NUM_MOMENTS; k++) {
+            b[k] = momentData[k * n + i];
+        }
+        if (powerMoments) {
+            MomentMath::generatePowerMoments<NUM_MOMENTS>(b_0, b, depths[i], transmittance, quantized);
+        } else {
+            MomentMath::generateTrigonometricMoments<NUM_MOMENTS>(
+                    b_0, b, depths[i], transmittance, wrappingZoneParameters, quantized);
+        }
+        b0Data[i] = b_0;
+        for (int k = 0; k < NUM_MOMENTS; k++) {
+            momentData[k * n + i] = quantized ? quantizeUnorm16(b[k]) : b[k];
+        }
+    }
+}
+
+template<int NUM_MOMENTS>
+void MomentResolverCPU::resolveMomentsInternal(
+        const float *depths, float *transmittanceAtDepth, float *totalTransmittance) const
+{
+    const bool quantized = pixelFormat == MBOIT_PIXEL_FORMAT_UNORM_16;
+    const bool powerMoments = usePowerMoments;
+    const MomentOITUniformData uniforms = uniformData;
+    const size_t n = numPixels;
+    const float *b0Data = zerothMoment.data();
+    const float *momentData = moments.data();
+
+    #pragma omp parallel for simd
+    for (size_t i = 0; i < n; i++) {
+        float b_0 = b0Data[i];
+        float b[NUM_MOMENTS];
+        for (int k = 0; k < NUM_MOMENTS; k++) {
+            b[k] = momentData[k * n + i];
+        }
+        transmittanceAtDepth[i] = MomentMath::resolveMoments<NUM_MOMENTS>(
+                b_0, b, depths[i], powerMoments, quantized, uniforms);
+        if (totalTransmittance) {
+            totalTransmittance[i] = std::exp(-b_0);
+        }
+    }
+}
@@ -0,0 +1,68 @@
+//
+// Created by christoph on 19.10.26.
+//
+
+#ifndef PIXELSYNCOIT_MOMENTRESOLVERCPU_HPP
+#define PIXELSYNCOIT_MOMENTRESOLVERCPU_HPP
+
+#include <vector>
+#include <cstddef>
+
+#include "OIT_MBOIT_Utils.hpp"
+
+/**
+ * CPU reference implementation of the moment generation and resolve passes of OIT_MBOIT (see MomentMath.hpp).
+ * The moments of all pixels are stored as structure of arrays, such that the per-pixel math is vectorized across
+ * pixels. MBOIT_PIXEL_FORMAT_UNORM_16 is emulated by rounding the stored moments to 16 bit after each fragment, like
+ * the image stores in the shader do. The zeroth moment is always stored with single precision (like the R32F
+ * texture b0).
+ *
+ * Depths are expected in the range [-1, 1] (i.e., after logDepthWarp in MBOITHeader.glsl).
+ */
+class MomentResolverCPU
+{
+public:
+    MomentResolverCPU(int numMoments, MBOITPixelFormat pixelFormat, bool usePowerMoments);
+
+    /// Uses the moment bias of getMomentBias, overestimation 0.1 and the default wrapping zone by default.
+    void setUniformData(const MomentOITUniformData &uniformData) { this->uniformData = uniformData; }
+    inline const MomentOITUniformData &getUniformData() const { return uniformData; }
+    inline int getNumMoments() const { return numMoments; }
+    inline size_t getNumPixels() const { return numPixels; }
+
+    /// Resizes the moment buffers and clears them.
+    void resize(size_t numPixels);
+    /// Sets all moments to zero (i.e., the clear value of the moment textures).
+    void clear();
+
+    /**
+     * Adds one fragment per pixel to the moments (first pass of MBOIT).
+     * @param depths The depth of the fragment of each pixel in [-1, 1].
+     * @param transmittances 1 - alpha of each fragment. Pixels with a transmittance of (nearly) one are skipped.
+     */
+    void generateMoments(const float *depths, const float *transmittances);
+
+    /**
+     * Reconstructs the transmittance at the passed depth for each pixel (second pass of MBOIT).
+     * @param transmittanceAtDepth The estimated transmittance of all fragments in front of the depth.
+     * @param totalTransmittance If not NULL, set to exp(-b_0), i.e., the exact transmittance of all fragments.
+     */
+    void resolveMoments(const float *depths, float *transmittanceAtDepth, float *totalTransmittance = NULL) const;
+
+private:
+    template<int NUM_MOMENTS> void generateMomentsInternal(const float *depths, const float *transmittances);
+    template<int NUM_MOMENTS> void resolveMomentsInternal(
+            const float *depths, float *transmittanceAtDepth, float *totalTransmittance) const;
+
+    int numMoments;
+    MBOITPixelFormat pixelFormat;
+    bool usePowerMoments;
+    MomentOITUniformData uniformData;
+
+    size_t numPixels = 0;
+    // b_0 of pixel i is stored in zerothMoment[i], b_k in moments[(k-1) * numPixels + i].
+    std::vector<float> zerothMoment;
+    std::vector<float> moments;
+};
+
+#endif //PIXELSYNCOIT_MOMENTRESOLVERCPU_HPP
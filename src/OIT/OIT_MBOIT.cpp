@@ -191,35 +191,7 @@ void OIT_MBOIT::updateMomentMode()
 
 
     // Set algorithm-dependent bias
-    if (usePowerMoments) {
-        if (numMoments == 4 && pixelFormat == MBOIT_PIXEL_FORMAT_UNORM_16) {
-            momentUniformData.moment_bias = 6*1e-4; // 6*1e-5
-        } else if (numMoments == 4 && pixelFormat == MBOIT_PIXEL_FORMAT_FLOAT_32) {
-            momentUniformData.moment_bias = 5*1e-7; // 5*1e-7
-        } else if (numMoments == 6 && pixelFormat == MBOIT_PIXEL_FORMAT_UNORM_16) {
-            momentUniformData.moment_bias = 6*1e-3; // 6*1e-4
-        } else if (numMoments == 6 && pixelFormat == MBOIT_PIXEL_FORMAT_FLOAT_32) {
-            momentUniformData.moment_bias = 5*1e-6; // 5*1e-6
-        } else if (numMoments == 8 && pixelFormat == MBOIT_PIXEL_FORMAT_UNORM_16) {
-            momentUniformData.moment_bias = 2.5*1e-2; // 2.5*1e-3
-        } else if (numMoments == 8 && pixelFormat == MBOIT_PIXEL_FORMAT_FLOAT_32) {
-            momentUniformData.moment_bias = 5*1e-5; // 5*1e-5
-        }
-    } else {
-        if (numMoments == 4 && pixelFormat == MBOIT_PIXEL_FORMAT_UNORM_16) {
-            momentUniformData.moment_bias = 4*1e-3; // 4*1e-4
-        } else if (numMoments == 4 && pixelFormat == MBOIT_PIXEL_FORMAT_FLOAT_32) {
-            momentUniformData.moment_bias = 4*1e-7; // 4*1e-7
-        } else if (numMoments == 6 && pixelFormat == MBOIT_PIXEL_FORMAT_UNORM_16) {
-            momentUniformData.moment_bias = 6.5*1e-3; // 6.5*1e-4
-        } else if (numMoments == 6 && pixelFormat == MBOIT_PIXEL_FORMAT_FLOAT_32) {
-            momentUniformData.moment_bias = 8*1e-6; // 8*1e-7
-        } else if (numMoments == 8 && pixelFormat == MBOIT_PIXEL_FORMAT_UNORM_16) {
-            momentUniformData.moment_bias = 8.5*1e-3; // 8.5*1e-4
-        } else if (numMoments == 8 && pixelFormat == MBOIT_PIXEL_FORMAT_FLOAT_32) {
-            momentUniformData.moment_bias = 1.5*1e-5; // 1.5*1e-6;
-        }
-    }
+    momentUniformData.moment_bias = getMomentBias(numMoments, pixelFormat, usePowerMoments);
 
     momentOITUniformBuffer->subData(0, sizeof(MomentOITUniformData), &momentUniformData);
 }
@@ -53,3 +53,37 @@ void computeWrappingZoneParameters(glm::vec4 &p_out_wrapping_zone_parameters,
     }
 }
 
+
+
+float getMomentBias(int numMoments, MBOITPixelFormat pixelFormat, bool usePowerMoments) {
+    if (usePowerMoments) {
+        if (numMoments == 4 && pixelFormat == MBOIT_PIXEL_FORMAT_UNORM_16) {
+            return 6*1e-4; // 6*1e-5
+        } else if (numMoments == 4 && pixelFormat == MBOIT_PIXEL_FORMAT_FLOAT_32) {
+            return 5*1e-7; // 5*1e-7
+        } else if (numMoments == 6 && pixelFormat == MBOIT_PIXEL_FORMAT_UNORM_16) {
+            return 6*1e-3; // 6*1e-4
+        } else if (numMoments == 6 && pixelFormat == MBOIT_PIXEL_FORMAT_FLOAT_32) {
+            return 5*1e-6; // 5*1e-6
+        } else if (numMoments == 8 && pixelFormat == MBOIT_PIXEL_FORMAT_UNORM_16) {
+            return 2.5*1e-2; // 2.5*1e-3
+        } else if (numMoments == 8 && pixelFormat == MBOIT_PIXEL_FORMAT_FLOAT_32) {
+            return 5*1e-5; // 5*1e-5
+        }
+    } else {
+        if (numMoments == 4 && pixelFormat == MBOIT_PIXEL_FORMAT_UNORM_16) {
+            return 4*1e-3; // 4*1e-4
+        } else if (numMoments == 4 && pixelFormat == MBOIT_PIXEL_FORMAT_FLOAT_32) {
+            return 4*1e-7; // 4*1e-7
+        } else if (numMoments == 6 && pixelFormat == MBOIT_PIXEL_FORMAT_UNORM_16) {
+            return 6.5*1e-3; // 6.5*1e-4
+        } else if (numMoments == 6 && pixelFormat == MBOIT_PIXEL_FORMAT_FLOAT_32) {
+            return 8*1e-6; // 8*1e-7
+        } else if (numMoments == 8 && pixelFormat == MBOIT_PIXEL_FORMAT_UNORM_16) {
+            return 8.5*1e-3; // 8.5*1e-4
+        } else if (numMoments == 8 && pixelFormat == MBOIT_PIXEL_FORMAT_FLOAT_32) {
+            return 1.5*1e-5; // 1.5*1e-6;
+        }
+    }
+    return 5*1e-7;
+}
@@ -45,4 +45,10 @@ float circleToParameter(float angle, float* pOutMaxParameter = nullptr);
 void computeWrappingZoneParameters(glm::vec4 &p_out_wrapping_zone_parameters,
         float new_wrapping_zone_angle = 0.1f * M_PI);
 
+/**
+ * Returns the moment bias (MomentOITUniformData::moment_bias) that avoids artifacts for the passed moment
+ * configuration. Used by OIT_MBOIT, MomentShadowMapping and MomentResolverCPU.
+ */
+float getMomentBias(int numMoments, MBOITPixelFormat pixelFormat, bool usePowerMoments);
+
 #endif //PIXELSYNCOIT_OIT_MBOIT_UTILS_HPP
@@ -0,0 +1,136 @@
+//
+// Created by christoph on 19.10.26.
+//
+
+#ifndef PIXELSYNCOIT_PIXELADDRESSING_HPP
+#define PIXELSYNCOIT_PIXELADDRESSING_HPP
+
+#include <cstdint>
+
+/**
+ * CPU versions of the addressing schemes of per-pixel OIT storage in Data/Shaders/Utils/TiledAddress.glsl (selected
+ * with TilingMode.hpp on the GPU). All schemes map the pixel (x, y) to an index in [0, paddedWidth * paddedHeight),
+ * where the viewport size needs to be padded to a multiple of the tile size (see getScreenSizeWithTiling). The screen
+ * is split into tiles stored in row-major order, and the addressing scheme defines the order of the pixels in a tile.
+ *
+ * The tile sizes are template parameters and need to be powers of two (like in the shader code), such that the
+ * compiler can turn all divisions into shifts.
+ */
+namespace PixelAddressing {
+
+template<uint32_t N>
+struct IsPowerOfTwo
+{
+    static const bool value = N != 0 && (N & (N - 1)) == 0;
+};
+
+/// Spreads the lower 16 bits of x to the even bits of the result.
+inline uint32_t spreadBits(uint32_t x)
+{
+    x &= 0x0000FFFFu;
+    x = (x | (x << 8)) & 0x00FF00FFu;
+    x = (x | (x << 4)) & 0x0F0F0F0Fu;
+    x = (x | (x << 2)) & 0x33333333u;
+    x = (x | (x << 1)) & 0x55555555u;
+    return x;
+}
+
+/// No tiling (default of addrGen in TiledAddress.glsl).
+struct LinearAddressing
+{
+    static const uint32_t TILE_WIDTH = 1;
+    static const uint32_t TILE_HEIGHT = 1;
+
+    static inline uint32_t addrGen(uint32_t x, uint32_t y, uint32_t paddedWidth)
+    {
+        return x + paddedWidth * y;
+    }
+};
+
+/// Row-major order of the pixels in a tile (ADDRESSING_TILED_2x2, ADDRESSING_TILED_2x8 and ADDRESSING_TILED_NxM).
+template<uint32_t TILE_N, uint32_t TILE_M>
+struct TiledAddressing
+{
+    static_assert(IsPowerOfTwo<TILE_N>::value && IsPowerOfTwo<TILE_M>::value, "Tile size must be a power of two");
+    static const uint32_t TILE_WIDTH = TILE_N;
+    static const uint32_t TILE_HEIGHT = TILE_M;
+
+    static inline uint32_t addrGen(uint32_t x, uint32_t y, uint32_t paddedWidth)
+    {
+        uint32_t surfaceWidth = paddedWidth / TILE_N;
+        uint32_t tileAddr1D = (x / TILE_N + surfaceWidth * (y / TILE_M)) * (TILE_N * TILE_M);
+        uint32_t pixelAddr1D = (x & (TILE_N - 1)) + (y & (TILE_M - 1)) * TILE_N;
+        return tileAddr1D | pixelAddr1D;
+    }
+};
+
+/**
+ * Morton order (z-order curve) of the pixels in a square tile. For TILE_SIZE = 8, this matches the lookup table of
+ * ADRESSING_MORTON_CODE_8x8.
+ */
+template<uint32_t TILE_SIZE>
+struct MortonAddressing
+{
+    static_assert(IsPowerOfTwo<TILE_SIZE>::value && TILE_SIZE <= 256, "Tile size must be a power of two <= 256");
+    static const uint32_t TILE_WIDTH = TILE_SIZE;
+    static const uint32_t TILE_HEIGHT = TILE_SIZE;
+
+    static inline uint32_t addrGen(uint32_t x, uint32_t y, uint32_t paddedWidth)
+    {
+        uint32_t surfaceWidth = paddedWidth / TILE_SIZE;
+        uint32_t tileAddr1D = (x / TILE_SIZE + surfaceWidth * (y / TILE_SIZE)) * (TILE_SIZE * TILE_SIZE);
+        uint32_t pixelAddr1D = spreadBits(x & (TILE_SIZE - 1)) | (spreadBits(y & (TILE_SIZE - 1)) << 1);
+        return tileAddr1D | pixelAddr1D;
+    }
+};
+
+/**
+ * Hilbert curve order of the pixels in a square tile. Unlike the Morton order, consecutive indices are always
+ * neighboring pixels.
+ */
+template<uint32_t TILE_SIZE>
+struct HilbertAddressing
+{
+    static_assert(IsPowerOfTwo<TILE_SIZE>::value && TILE_SIZE <= 256, "Tile size must be a power of two <= 256");
+    static const uint32_t TILE_WIDTH = TILE_SIZE;
+    static const uint32_t TILE_HEIGHT = TILE_SIZE;
+
+    static inline uint32_t addrGen(uint32_t x, uint32_t y, uint32_t paddedWidth)
+    {
+        uint32_t surfaceWidth = paddedWidth / TILE_SIZE;
+        uint32_t tileAddr1D = (x / TILE_SIZE + surfaceWidth * (y / TILE_SIZE)) * (TILE_SIZE * TILE_SIZE);
+
+        // Hilbert index of (x, y) in the tile (see "xy2d" in https://en.wikipedia.org/wiki/Hilbert_curve).
+        uint32_t px = x & (TILE_SIZE - 1);
+        uint32_t py = y & (TILE_SIZE - 1);
+        uint32_t pixelAddr1D = 0;
+        for (uint32_t s = TILE_SIZE / 2; s > 0; s /= 2) {
+            uint32_t rx = (px & s) > 0 ? 1 : 0;
+            uint32_t ry = (py & s) > 0 ? 1 : 0;
+            pixelAddr1D += s * s * ((3 * rx) ^ ry);
+            // Rotate the quadrant
+            if (ry == 0) {
+                if (rx == 1) {
+                    px = TILE_SIZE - 1 - px;
+                    py = TILE_SIZE - 1 - py;
+                }
+                uint32_t tmp = px;
+                px = py;
+                py = tmp;
+            }
+        }
+        return tileAddr1D | pixelAddr1D;
+    }
+};
+
+/// Pads the screen size to a multiple of the tile size of the addressing scheme (like getScreenSizeWithTiling).
+template<class Addressing>
+inline void getScreenSizeWithTiling(uint32_t &screenWidth, uint32_t &screenHeight)
+{
+    screenWidth = (screenWidth + Addressing::TILE_WIDTH - 1) / Addressing::TILE_WIDTH * Addressing::TILE_WIDTH;
+    screenHeight = (screenHeight + Addressing::TILE_HEIGHT - 1) / Addressing::TILE_HEIGHT * Addressing::TILE_HEIGHT;
+}
+
+}
+
+#endif //PIXELSYNCOIT_PIXELADDRESSING_HPP
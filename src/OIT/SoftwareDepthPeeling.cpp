@@ -0,0 +1,612 @@
+//
+// Created by christoph on 19.10.26.
+//
+
+#include <algorithm>
+#include <cmath>
+#include <cfloat>
+#include <omp.h>
+#include <Utils/File/Logfile.hpp>
+
+#include "../Utils/TrajectoryFile.hpp"
+#include "../Utils/TrajectoryLoader.hpp"
+#include "SoftwareDepthPeeling.hpp"
+
+// Tiles are processed independently. 32x32 pixels keep the fragment array of a tile in the cache for most data sets.
+static const int TILE_SIZE = 32;
+static const int TILE_NUM_PIXELS = TILE_SIZE * TILE_SIZE;
+// Upper bound for the fragment array of a thread (24MiB). A triangle adds at most TILE_NUM_PIXELS fragments more.
+static const size_t MAX_TILE_FRAGMENTS = size_t(1) << 20u;
+// Number of segments of the tubes (NUM_SEGMENTS in the geometry shader).
+static const int NUM_TUBE_SEGMENTS = 5;
+static const int MAX_SEGMENT_VERTICES = NUM_TUBE_SEGMENTS * 6;
+
+/// Converts linear RGB to sRGB (like toSRGB in GammaCorrection.glsl).
+static inline float toSRGB(float u)
+{
+    return u <= 0.0031308f ? u * 12.92f : 1.055f * std::pow(u, 1.0f / 2.4f) - 0.055f;
+}
+
+static inline uint32_t packColorRGBA8(const glm::vec4 &color)
+{
+    uint32_t r = uint32_t(std::round(glm::clamp(color.r, 0.0f, 1.0f) * 255.0f));
+    uint32_t g = uint32_t(std::round(glm::clamp(color.g, 0.0f, 1.0f) * 255.0f));
+    uint32_t b = uint32_t(std::round(glm::clamp(color.b, 0.0f, 1.0f) * 255.0f));
+    uint32_t a = uint32_t(std::round(glm::clamp(color.a, 0.0f, 1.0f) * 255.0f));
+    return r | (g << 8) | (b << 16) | (a << 24);
+}
+
+/// The triangle is skipped if it crosses the near or far plane.
+static inline bool isInClipRange(const glm::vec4 &clipPosition)
+{
+    return clipPosition.w > 0.0f && clipPosition.z >= -clipPosition.w && clipPosition.z <= clipPosition.w;
+}
+
+static inline float edgeFunction(const glm::vec2 &a, const glm::vec2 &b, const glm::vec2 &p)
+{
+    return (b.x - a.x) * (p.y - a.y) - (b.y - a.y) * (p.x - a.x);
+}
+
+/**
+ * Tie-breaking rule for pixel centers exactly on an edge: The two triangles sharing an edge traverse it in opposite
+ * directions, thus exactly one of them owns the edge. This avoids duplicate fragments on the diagonals of the quads.
+ */
+static inline bool isEdgeOwned(const glm::vec2 &a, const glm::vec2 &b)
+{
+    return b.y > a.y || (b.y == a.y && b.x < a.x);
+}
+
+SoftwareDepthPeeling::SoftwareDepthPeeling() : clearColor(255, 255, 255, 255)
+{
+}
+
+void SoftwareDepthPeeling::setViewportSize(int width, int height)
+{
+    this->width = width;
+    this->height = height;
+    numTilesX = (width + TILE_SIZE - 1) / TILE_SIZE;
+    numTilesY = (height + TILE_SIZE - 1) / TILE_SIZE;
+    image.resize(size_t(width) * size_t(height));
+}
+
+void SoftwareDepthPeeling::setTransferFunction(const std::vector<sgl::Color> &tfLookupTable_linearRGB)
+{
+    transferFunction.resize(tfLookupTable_linearRGB.size());
+    for (size_t i = 0; i < tfLookupTable_linearRGB.size(); i++) {
+        transferFunction.at(i) = tfLookupTable_linearRGB.at(i).getFloatColorRGBA();
+    }
+}
+
+void SoftwareDepthPeeling::setTrajectories(const Trajectories &trajectories, int attributeIndex)
+{
+    linePoints.clear();
+    lineTangents.clear();
+    lineNormals.clear();
+    lineAttributes.clear();
+    segmentIndices.clear();
+
+    bool hasAttribute = attributeIndex >= 0 && attributeIndex < int(trajectories.getNumAttributes());
+    if (!hasAttribute) {
+        sgl::Logfile::get()->writeError(std::string() + "Error in SoftwareDepthPeeling::setTrajectories: "
+                + "Invalid attribute index. Using a constant attribute.");
+    }
+
+    for (size_t lineIdx = 0; lineIdx < trajectories.size(); lineIdx++) {
+        if (trajectories.getLineNumPoints(lineIdx) < 2) {
+            continue;
+        }
+        std::vector<glm::vec3> localVertices;
+        std::vector<glm::vec3> localTangents;
+        std::vector<glm::vec3> localNormals;
+        std::vector<uint32_t> localIndices;
+        std::vector<std::vector<float>> importanceCriteriaOut;
+        createTangentAndNormalData(trajectories, lineIdx, localVertices,
+                                   importanceCriteriaOut, localTangents, localNormals, localIndices);
+
+        const uint32_t indexOffset = uint32_t(linePoints.size());
+        for (size_t i = 0; i < localIndices.size(); i += 2) {
+            segmentIndices.push_back(indexOffset + localIndices.at(i));
+        }
+        linePoints.insert(linePoints.end(), localVertices.begin(), localVertices.end());
+        lineTangents.insert(lineTangents.end(), localTangents.begin(), localTangents.end());
+        lineNormals.insert(lineNormals.end(), localNormals.begin(), localNormals.end());
+        if (hasAttribute) {
+            lineAttributes.insert(lineAttributes.end(), importanceCriteriaOut.at(attributeIndex).begin(),
+                                  importanceCriteriaOut.at(attributeIndex).end());
+        } else {
+            lineAttributes.resize(linePoints.size(), 0.0f);
+        }
+    }
+
+    minAttribute = 0.0f;
+    maxAttribute = 1.0f;
+    if (!lineAttributes.empty()) {
+        auto minMax = std::minmax_element(lineAttributes.begin(), lineAttributes.end());
+        minAttribute = *minMax.first;
+        maxAttribute = *minMax.second;
+    }
+}
+
+int SoftwareDepthPeeling::createSegmentTriangles(uint32_t pointIdx, ClipVertex *vertices) const
+{
+    // Same geometry as the geometry shader in PseudoPhongTrajectories.glsl (the vertex shader is a pass-through).
+    const glm::vec3 &currentPoint = linePoints[pointIdx];
+    const glm::vec3 &nextPoint = linePoints[pointIdx + 1];
+    const float attributeCurrent = lineAttributes[pointIdx];
+    const float attributeNext = lineAttributes[pointIdx + 1];
+
+    if (useBillboardLines) {
+        glm::vec3 viewDirectionCurrent = glm::normalize(cameraPosition - currentPoint);
+        glm::vec3 offsetDirectionCurrent = glm::cross(viewDirectionCurrent, lineTangents[pointIdx]);
+        glm::vec3 viewDirectionNext = glm::normalize(cameraPosition - nextPoint);
+        glm::vec3 offsetDirectionNext = glm::cross(viewDirectionNext, lineTangents[pointIdx + 1]);
+
+        // Triangle strip: next - offset, next + offset, current - offset, current + offset
+        ClipVertex strip[4];
+        for (int i = 0; i < 4; i++) {
+            bool isNext = i < 2;
+            float sign = i % 2 == 0 ? -1.0f : 1.0f;
+            const glm::vec3 &viewDirection = isNext ? viewDirectionNext : viewDirectionCurrent;
+            const glm::vec3 &offsetDirection = isNext ? offsetDirectionNext : offsetDirectionCurrent;
+            strip[i].positionWorld = (isNext ? nextPoint : currentPoint) + sign * lineRadius * offsetDirection;
+            strip[i].normalFloat = sign;
+            strip[i].normal = viewDirection;
+            strip[i].normal1 = offsetDirection;
+            strip[i].attribute = isNext ? attributeNext : attributeCurrent;
+        }
+        vertices[0] = strip[0];
+        vertices[1] = strip[1];
+        vertices[2] = strip[2];
+        vertices[3] = strip[1];
+        vertices[4] = strip[2];
+        vertices[5] = strip[3];
+        return 2;
+    }
+
+    glm::vec3 circlePointsCurrent[NUM_TUBE_SEGMENTS];
+    glm::vec3 circlePointsNext[NUM_TUBE_SEGMENTS];
+    glm::vec3 vertexNormalsCurrent[NUM_TUBE_SEGMENTS];
+    glm::vec3 vertexNormalsNext[NUM_TUBE_SEGMENTS];
+
+    const glm::vec3 &normalCurrent = lineNormals[pointIdx];
+    glm::vec3 binormalCurrent = glm::cross(lineTangents[pointIdx], normalCurrent);
+    const glm::vec3 &normalNext = lineNormals[pointIdx + 1];
+    glm::vec3 binormalNext = glm::cross(lineTangents[pointIdx + 1], normalNext);
+
+    const float theta = 2.0f * 3.1415926f / float(NUM_TUBE_SEGMENTS);
+    const float tangetialFactor = std::tan(theta); // opposite / adjacent
+    const float radialFactor = std::cos(theta); // adjacent / hypotenuse
+
+    glm::vec2 position(lineRadius, 0.0f);
+    for (int i = 0; i < NUM_TUBE_SEGMENTS; i++) {
+        circlePointsCurrent[i] = normalCurrent * position.x + binormalCurrent * position.y + currentPoint;
+        circlePointsNext[i] = normalNext * position.x + binormalNext * position.y + nextPoint;
+        vertexNormalsCurrent[i] = glm::normalize(circlePointsCurrent[i] - currentPoint);
+        vertexNormalsNext[i] = glm::normalize(circlePointsNext[i] - nextPoint);
+
+        // Add the tangent vector and correct the position using the radial factor.
+        glm::vec2 circleTangent(-position.y, position.x);
+        position += tangetialFactor * circleTangent;
+        position *= radialFactor;
+    }
+
+    for (int i = 0; i < NUM_TUBE_SEGMENTS; i++) {
+        // Triangle strip: current i, current i+1, next i, next i+1
+        int j = (i + 1) % NUM_TUBE_SEGMENTS;
+        ClipVertex strip[4];
+        strip[0].positionWorld = circlePointsCurrent[i];
+        strip[0].normal = vertexNormalsCurrent[i];
+        strip[0].attribute = attributeCurrent;
+        strip[1].positionWorld = circlePointsCurrent[j];
+        strip[1].normal = vertexNormalsCurrent[j];
+        strip[1].attribute = attributeCurrent;
+        strip[2].positionWorld = circlePointsNext[i];
+        strip[2].normal = vertexNormalsNext[i];
+        strip[2].attribute = attributeNext;
+        strip[3].positionWorld = circlePointsNext[j];
+        strip[3].normal = vertexNormalsNext[j];
+        strip[3].attribute = attributeNext;
+
+        ClipVertex *triangles = vertices + i * 6;
+        triangles[0] = strip[0];
+        triangles[1] = strip[1];
+        triangles[2] = strip[2];
+        triangles[3] = strip[1];
+        triangles[4] = strip[2];
+        triangles[5] = strip[3];
+    }
+    return NUM_TUBE_SEGMENTS * 2;
+}
+
+void SoftwareDepthPeeling::binSegments(const glm::mat4 &mvpMatrix)
+{
+    const size_t numSegments = segmentIndices.size();
+    const int numTiles = numTilesX * numTilesY;
+    segmentPixelBounds.resize(numSegments);
+
+    // Every thread counts the tile overlaps of a contiguous range of segments. The same static schedule is used for
+    // writing the segment indices, such that the segments of a tile are in a deterministic order.
+    const int numThreads = omp_get_max_threads();
+    std::vector<uint32_t> threadTileCounts(size_t(numThreads) * size_t(numTiles), 0);
+
+    #pragma omp parallel num_threads(numThreads)
+    {
+        uint32_t *tileCounts = threadTileCounts.data() + size_t(omp_get_thread_num()) * size_t(numTiles);
+        ClipVertex vertices[MAX_SEGMENT_VERTICES];
+
+        #pragma omp for schedule(static)
+        for (size_t segmentIdx = 0; segmentIdx < numSegments; segmentIdx++) {
+            int numTriangles = createSegmentTriangles(segmentIndices[segmentIdx], vertices);
+            glm::vec2 minPosition(FLT_MAX), maxPosition(-FLT_MAX);
+            for (int t = 0; t < numTriangles; t++) {
+                bool isVisible = true;
+                for (int i = 0; i < 3; i++) {
+                    ClipVertex &vertex = vertices[t * 3 + i];
+                    vertex.clipPosition = mvpMatrix * glm::vec4(vertex.positionWorld, 1.0f);
+                    isVisible = isVisible && isInClipRange(vertex.clipPosition);
+                }
+                if (!isVisible) {
+                    continue;
+                }
+                for (int i = 0; i < 3; i++) {
+                    const glm::vec4 &clipPosition = vertices[t * 3 + i].clipPosition;
+                    glm::vec2 screenPosition(
+                            (clipPosition.x / clipPosition.w * 0.5f + 0.5f) * float(width),
+                            (clipPosition.y / clipPosition.w * 0.5f + 0.5f) * float(height));
+                    minPosition = glm::min(minPosition, screenPosition);
+                    maxPosition = glm::max(maxPosition, screenPosition);
+                }
+            }
+
+            // Pixels with their center inside of the bounding box
+            glm::ivec4 &bounds = segmentPixelBounds[segmentIdx];
+            if (minPosition.x > maxPosition.x) {
+                bounds = glm::ivec4(1, 1, 0, 0);
+                continue;
+            }
+            bounds.x = std::max(int(std::ceil(minPosition.x - 0.5f)), 0);
+            bounds.y = std::max(int(std::ceil(minPosition.y - 0.5f)), 0);
+            bounds.z = std::min(int(std::floor(maxPosition.x - 0.5f)), width - 1);
+            bounds.w = std::min(int(std::floor(maxPosition.y - 0.5f)), height - 1);
+            if (bounds.x > bounds.z || bounds.y > bounds.w) {
+                continue;
+            }
+            for (int tileY = bounds.y / TILE_SIZE; tileY <= bounds.w / TILE_SIZE; tileY++) {
+                for (int tileX = bounds.x / TILE_SIZE; tileX <= bounds.z / TILE_SIZE; tileX++) {
+                    tileCounts[tileX + tileY * numTilesX]++;
+                }
+            }
+        }
+    }
+
+    // Exclusive prefix sum over (tile, thread). Afterwards, the counts store the write offset of each thread.
+    tileSegmentOffsets.resize(numTiles + 1);
+    uint32_t offset = 0;
+    for (int tileIdx = 0; tileIdx < numTiles; tileIdx++) {
+        tileSegmentOffsets[tileIdx] = offset;
+        for (int threadIdx = 0; threadIdx < numThreads; threadIdx++) {
+            uint32_t &count = threadTileCounts[size_t(threadIdx) * size_t(numTiles) + tileIdx];
+            uint32_t threadOffset = offset;
+            offset += count;
+            count = threadOffset;
+        }
+    }
+    tileSegmentOffsets[numTiles] = offset;
+    tileSegments.resize(offset);
+
+    #pragma omp parallel num_threads(numThreads)
+    {
+        uint32_t *tileOffsets = threadTileCounts.data() + size_t(omp_get_thread_num()) * size_t(numTiles);
+
+        #pragma omp for schedule(static)
+        for (size_t segmentIdx = 0; segmentIdx < numSegments; segmentIdx++) {
+            const glm::ivec4 &bounds = segmentPixelBounds[segmentIdx];
+            if (bounds.x > bounds.z || bounds.y > bounds.w) {
+                continue;
+            }
+            for (int tileY = bounds.y / TILE_SIZE; tileY <= bounds.w / TILE_SIZE; tileY++) {
+                for (int tileX = bounds.x / TILE_SIZE; tileX <= bounds.z / TILE_SIZE; tileX++) {
+                    tileSegments[tileOffsets[tileX + tileY * numTilesX]++] = uint32_t(segmentIdx);
+                }
+            }
+        }
+    }
+}
+
+glm::vec4 SoftwareDepthPeeling::shadeFragment(
+        const glm::vec3 &positionWorld, const glm::vec3 &normal, float attribute) const
+{
+    // Transfer function lookup with linear filtering (like the 1D texture lookup in transferFunction).
+    glm::vec4 colorAttribute(1.0f);
+    if (!transferFunction.empty()) {
+        const int numEntries = int(transferFunction.size());
+        float posFloat = maxAttribute > minAttribute
+                ? glm::clamp((attribute - minAttribute) / (maxAttribute - minAttribute), 0.0f, 1.0f) : 0.0f;
+        float texelPosition = posFloat * float(numEntries) - 0.5f;
+        float texelFloor = std::floor(texelPosition);
+        int idx0 = glm::clamp(int(texelFloor), 0, numEntries - 1);
+        int idx1 = glm::clamp(int(texelFloor) + 1, 0, numEntries - 1);
+        colorAttribute = glm::mix(transferFunction[idx0], transferFunction[idx1], texelPosition - texelFloor);
+    }
+    if (colorAttribute.a < 1.0f / 255.0f) {
+        return glm::vec4(0.0f);
+    }
+
+    // PSEUDO_PHONG_LIGHTING without ambient occlusion and shadows
+    const glm::vec3 Ia = 0.2f * glm::vec3(colorAttribute);
+    const float kD = 0.7f;
+    const float kS = 0.1f;
+    const float s = 10.0f;
+
+    const glm::vec3 n = glm::normalize(normal);
+    const glm::vec3 v = glm::normalize(cameraPosition - positionWorld);
+    const glm::vec3 l = v;
+    const glm::vec3 h = glm::normalize(v + l);
+    glm::vec3 t = glm::normalize(glm::cross(glm::vec3(0.0f, 0.0f, 1.0f), n));
+
+    glm::vec3 Id = kD * glm::clamp(std::abs(glm::dot(n, l)), 0.0f, 1.0f) * glm::vec3(colorAttribute);
+    glm::vec3 Is = glm::vec3(kS * std::pow(glm::clamp(std::abs(glm::dot(n, h)), 0.0f, 1.0f), s));
+
+    float halo = std::abs(glm::dot(v, n)) + std::abs(glm::dot(v, t)) * 0.7f;
+    float haloFactor = glm::clamp(halo, 0.0f, 1.0f);
+    glm::vec3 colorShading = (Ia + Id + Is) * (haloFactor * haloFactor);
+
+    // Pre-multiplied alpha (like DepthPeelingGather.glsl)
+    return glm::vec4(colorShading * colorAttribute.a, colorAttribute.a);
+}
+
+void SoftwareDepthPeeling::rasterizeTriangle(
+        const ClipVertex *triangle, int tileX0, int tileY0, int tileX1, int tileY1,
+        std::vector<Fragment> &fragments) const
+{
+    glm::vec2 screenPositions[3];
+    float depths[3], invW[3];
+    for (int i = 0; i < 3; i++) {
+        const glm::vec4 &clipPosition = triangle[i].clipPosition;
+        if (!isInClipRange(clipPosition)) {
+            return;
+        }
+        invW[i] = 1.0f / clipPosition.w;
+        screenPositions[i] = glm::vec2(
+                (clipPosition.x * invW[i] * 0.5f + 0.5f) * float(width),
+                (clipPosition.y * invW[i] * 0.5f + 0.5f) * float(height));
+        depths[i] = clipPosition.z * invW[i] * 0.5f + 0.5f;
+    }
+
+    // Counter-clockwise order, such that all edge functions are positive inside of the triangle.
+    int i0 = 0, i1 = 1, i2 = 2;
+    float area = edgeFunction(screenPositions[0], screenPositions[1], screenPositions[2]);
+    if (area == 0.0f) {
+        return;
+    } else if (area < 0.0f) {
+        std::swap(i1, i2);
+        area = -area;
+    }
+    const glm::vec2 &p0 = screenPositions[i0], &p1 = screenPositions[i1], &p2 = screenPositions[i2];
+    const bool ownsEdge0 = isEdgeOwned(p1, p2), ownsEdge1 = isEdgeOwned(p2, p0), ownsEdge2 = isEdgeOwned(p0, p1);
+
+    glm::vec2 minPosition = glm::min(p0, glm::min(p1, p2));
+    glm::vec2 maxPosition = glm::max(p0, glm::max(p1, p2));
+    int x0 = std::max(int(std::ceil(minPosition.x - 0.5f)), tileX0);
+    int y0 = std::max(int(std::ceil(minPosition.y - 0.5f)), tileY0);
+    int x1 = std::min(int(std::floor(maxPosition.x - 0.5f)), tileX1);
+    int y1 = std::min(int(std::floor(maxPosition.y - 0.5f)), tileY1);
+
+    const ClipVertex &v0 = triangle[i0], &v1 = triangle[i1], &v2 = triangle[i2];
+    const float invArea = 1.0f / area;
+    for (int y = y0; y <= y1; y++) {
+        for (int x = x0; x <= x1; x++) {
+            // Pixel centers at half-integer coordinates
+            glm::vec2 p(float(x) + 0.5f, float(y) + 0.5f);
+            float e0 = edgeFunction(p1, p2, p);
+            float e1 = edgeFunction(p2, p0, p);
+            float e2 = edgeFunction(p0, p1, p);
+            if (e0 < 0.0f || e1 < 0.0f || e2 < 0.0f || (e0 == 0.0f && !ownsEdge0)
+                    || (e1 == 0.0f && !ownsEdge1) || (e2 == 0.0f && !ownsEdge2)) {
+                continue;
+            }
+
+            // The depth is interpolated linearly in screen space, all other attributes perspective-correctly.
+            float l0 = e0 * invArea, l1 = e1 * invArea, l2 = e2 * invArea;
+            float depth = l0 * depths[i0] + l1 * depths[i1] + l2 * depths[i2];
+            float q0 = l0 * invW[i0], q1 = l1 * invW[i1], q2 = l2 * invW[i2];
+            float invSum = 1.0f / (q0 + q1 + q2);
+            q0 *= invSum;
+            q1 *= invSum;
+            q2 *= invSum;
+
+            glm::vec3 positionWorld = q0 * v0.positionWorld + q1 * v1.positionWorld + q2 * v2.positionWorld;
+            float attribute = q0 * v0.attribute + q1 * v1.attribute + q2 * v2.attribute;
+            glm::vec3 normal;
+            if (useBillboardLines) {
+                float interpolationFactor = q0 * v0.normalFloat + q1 * v1.normalFloat + q2 * v2.normalFloat;
+                glm::vec3 normalCos = glm::normalize(q0 * v0.normal + q1 * v1.normal + q2 * v2.normal);
+                glm::vec3 normalSin = glm::normalize(q0 * v0.normal1 + q1 * v1.normal1 + q2 * v2.normal1);
+                if (interpolationFactor < 0.0f) {
+                    normalSin = -normalSin;
+                    interpolationFactor = -interpolationFactor;
+                }
+                float angle = interpolationFactor * float(M_PI) / 2.0f;
+                normal = std::cos(angle) * normalCos + std::sin(angle) * normalSin;
+            } else {
+                normal = q0 * v0.normal + q1 * v1.normal + q2 * v2.normal;
+            }
+
+            glm::vec4 color = shadeFragment(positionWorld, normal, attribute);
+            if (color.a <= 0.0f) {
+                continue; // discard
+            }
+            Fragment fragment;
+            fragment.depth = depth;
+            fragment.localPixelIndex = uint32_t((x % TILE_SIZE) + (y % TILE_SIZE) * TILE_SIZE);
+            fragment.color = color;
+            fragments.push_back(fragment);
+        }
+    }
+}
+
+void SoftwareDepthPeeling::renderTile(
+        int tileIdx, std::vector<Fragment> &fragments, std::vector<uint32_t> &fragmentOffsets,
+        std::vector<Fragment> &sortedFragments, size_t &tileMaxDepthComplexity, size_t &tileNumFragments)
+{
+    const int tileX0 = (tileIdx % numTilesX) * TILE_SIZE;
+    const int tileY0 = (tileIdx / numTilesX) * TILE_SIZE;
+    const int tileX1 = std::min(tileX0 + TILE_SIZE, width) - 1;
+    const int tileY1 = std::min(tileY0 + TILE_SIZE, height) - 1;
+    renderTileRegion(
+            tileIdx, tileX0, tileY0, tileX1, tileY1, fragments, fragmentOffsets, sortedFragments,
+            tileMaxDepthComplexity, tileNumFragments);
+}
+
+bool SoftwareDepthPeeling::gatherTileRegionFragments(
+        int tileIdx, int x0, int y0, int x1, int y1, std::vector<Fragment> &fragments) const
+{
+    const glm::mat4 &mvpMatrix = currentMvpMatrix;
+    const bool isSinglePixel = x0 == x1 && y0 == y1;
+    bool hasDepthCutoff = false;
+    float depthCutoff = 0.0f;
+    auto compareDepth = [](const Fragment &f0, const Fragment &f1) { return f0.depth < f1.depth; };
+
+    fragments.clear();
+    ClipVertex vertices[MAX_SEGMENT_VERTICES];
+    for (uint32_t i = tileSegmentOffsets[tileIdx]; i < tileSegmentOffsets[tileIdx + 1]; i++) {
+        const uint32_t segmentIdx = tileSegments[i];
+        const glm::ivec4 &bounds = segmentPixelBounds[segmentIdx];
+        if (bounds.x > x1 || bounds.y > y1 || bounds.z < x0 || bounds.w < y0) {
+            continue;
+        }
+        int numTriangles = createSegmentTriangles(segmentIndices[segmentIdx], vertices);
+        for (int t = 0; t < numTriangles * 3; t++) {
+            vertices[t].clipPosition = mvpMatrix * glm::vec4(vertices[t].positionWorld, 1.0f);
+        }
+        for (int t = 0; t < numTriangles; t++) {
+            const size_t oldNumFragments = fragments.size();
+            rasterizeTriangle(
+                    vertices + t * 3, std::max(x0, bounds.x), std::max(y0, bounds.y),
+                    std::min(x1, bounds.z), std::min(y1, bounds.w), fragments);
+            if (hasDepthCutoff && fragments.size() > oldNumFragments && fragments.back().depth >= depthCutoff) {
+                // A triangle adds at most one fragment to a single pixel.
+                fragments.pop_back();
+            }
+            if (fragments.size() <= MAX_TILE_FRAGMENTS) {
+                continue;
+            }
+            if (!isSinglePixel) {
+                return false;
+            }
+            // Keep the nearest half of the fragments and drop all further fragments behind them.
+            std::stable_sort(fragments.begin(), fragments.end(), compareDepth);
+            fragments.resize(MAX_TILE_FRAGMENTS / 2);
+            hasDepthCutoff = true;
+            depthCutoff = fragments.back().depth;
+        }
+    }
+    return true;
+}
+
+void SoftwareDepthPeeling::renderTileRegion(
+        int tileIdx, int x0, int y0, int x1, int y1, std::vector<Fragment> &fragments,
+        std::vector<uint32_t> &fragmentOffsets, std::vector<Fragment> &sortedFragments,
+        size_t &tileMaxDepthComplexity, size_t &tileNumFragments)
+{
+    const int tileX0 = (tileIdx % numTilesX) * TILE_SIZE;
+    const int tileY0 = (tileIdx / numTilesX) * TILE_SIZE;
+
+    // Gather all fragments of the region. If there are too many, split the region along its larger side instead.
+    if (!gatherTileRegionFragments(tileIdx, x0, y0, x1, y1, fragments)) {
+        if (x1 - x0 >= y1 - y0) {
+            const int xMid = (x0 + x1) / 2;
+            renderTileRegion(tileIdx, x0, y0, xMid, y1, fragments, fragmentOffsets, sortedFragments,
+                    tileMaxDepthComplexity, tileNumFragments);
+            renderTileRegion(tileIdx, xMid + 1, y0, x1, y1, fragments, fragmentOffsets, sortedFragments,
+                    tileMaxDepthComplexity, tileNumFragments);
+        } else {
+            const int yMid = (y0 + y1) / 2;
+            renderTileRegion(tileIdx, x0, y0, x1, yMid, fragments, fragmentOffsets, sortedFragments,
+                    tileMaxDepthComplexity, tileNumFragments);
+            renderTileRegion(tileIdx, x0, yMid + 1, x1, y1, fragments, fragmentOffsets, sortedFragments,
+                    tileMaxDepthComplexity, tileNumFragments);
+        }
+        return;
+    }
+    tileNumFragments += fragments.size();
+
+    // Counting sort by pixel. The sort is stable, i.e., fragments with equal depth stay in primitive order.
+    fragmentOffsets.assign(TILE_NUM_PIXELS + 1, 0);
+    for (const Fragment &fragment : fragments) {
+        fragmentOffsets[fragment.localPixelIndex + 1]++;
+    }
+    for (int i = 0; i < TILE_NUM_PIXELS; i++) {
+        fragmentOffsets[i + 1] += fragmentOffsets[i];
+    }
+    sortedFragments.resize(fragments.size());
+    for (const Fragment &fragment : fragments) {
+        sortedFragments[fragmentOffsets[fragment.localPixelIndex]++] = fragment;
+    }
+
+    // Sort the fragments of each pixel by depth and blend them front-to-back (like the peel passes).
+    const glm::vec3 backgroundColor = glm::vec3(clearColor.getFloatColorRGBA());
+    auto compareDepth = [](const Fragment &f0, const Fragment &f1) { return f0.depth < f1.depth; };
+    for (int y = y0; y <= y1; y++) {
+        for (int x = x0; x <= x1; x++) {
+            const int localPixelIndex = (x - tileX0) + (y - tileY0) * TILE_SIZE;
+            // After the counting sort, fragmentOffsets[i] is the end of the fragments of pixel i.
+            uint32_t beginOffset = localPixelIndex == 0 ? 0 : fragmentOffsets[localPixelIndex - 1];
+            Fragment *begin = sortedFragments.data() + beginOffset;
+            Fragment *end = sortedFragments.data() + fragmentOffsets[localPixelIndex];
+            const size_t numPixelFragments = size_t(end - begin);
+            tileMaxDepthComplexity = std::max(tileMaxDepthComplexity, numPixelFragments);
+
+            if (numPixelFragments <= 16) {
+                // Insertion sort for the typically short per-pixel lists
+                for (Fragment *it = begin + 1; it < end; it++) {
+                    Fragment fragment = *it;
+                    Fragment *jt = it;
+                    for (; jt > begin && (jt - 1)->depth > fragment.depth; jt--) {
+                        *jt = *(jt - 1);
+                    }
+                    *jt = fragment;
+                }
+            } else {
+                std::stable_sort(begin, end, compareDepth);
+            }
+
+            glm::vec4 accumulatedColor(0.0f);
+            for (Fragment *it = begin; it < end; it++) {
+                accumulatedColor += (1.0f - accumulatedColor.a) * it->color;
+            }
+            glm::vec3 color = glm::vec3(accumulatedColor) + (1.0f - accumulatedColor.a) * backgroundColor;
+            glm::vec4 colorSRGB(toSRGB(color.r), toSRGB(color.g), toSRGB(color.b), 1.0f);
+            image[size_t(x) + size_t(y) * size_t(width)] = packColorRGBA8(colorSRGB);
+        }
+    }
+}
+
+const uint32_t *SoftwareDepthPeeling::render(const glm::mat4 &viewMatrix, const glm::mat4 &projectionMatrix)
+{
+    cameraPosition = glm::vec3(glm::inverse(viewMatrix)[3]);
+    currentMvpMatrix = projectionMatrix * viewMatrix;
+    binSegments(currentMvpMatrix);
+
+    const int numTiles = numTilesX * numTilesY;
+    size_t frameMaxDepthComplexity = 0;
+    size_t frameNumFragments = 0;
+
+    #pragma omp parallel
+    {
+        // The fragment arrays are reused for all tiles of a thread.
+        std::vector<Fragment> fragments;
+        std::vector<Fragment> sortedFragments;
+        std::vector<uint32_t> fragmentOffsets;
+
+        #pragma omp for schedule(dynamic) reduction(max:frameMaxDepthComplexity) reduction(+:frameNumFragments)
+        for (int tileIdx = 0; tileIdx < numTiles; tileIdx++) {
+            renderTile(
+                    tileIdx, fragments, fragmentOffsets, sortedFragments, frameMaxDepthComplexity, frameNumFragments);
+        }
+    }
+
+    maxDepthComplexity = frameMaxDepthComplexity;
+    numFragments = frameNumFragments;
+    return image.data();
+}
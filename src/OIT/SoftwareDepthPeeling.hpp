@@ -0,0 +1,123 @@
+//
+// Created by christoph on 19.10.26.
+//
+
+#ifndef PIXELSYNCOIT_SOFTWAREDEPTHPEELING_HPP
+#define PIXELSYNCOIT_SOFTWAREDEPTHPEELING_HPP
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <glm/glm.hpp>
+#include <Graphics/Color.hpp>
+
+struct Trajectories;
+
+/**
+ * CPU reference for OIT_DepthPeeling. OIT_DepthPeeling needs one depth complexity pass and one geometry pass per
+ * layer (i.e., maxDepthComplexity passes over the whole scene). Instead, this renderer bins the line primitives into
+ * screen tiles and processes the tiles in parallel. For each tile, all fragments are rasterized into one fragment
+ * array (bounded by the fragments of the tile, not of the screen), sorted per pixel and blended front-to-back. Thus,
+ * the result is the exact sorted compositing of all fragments after a single pass per tile, independent of the
+ * depth complexity. Tiles with more than MAX_TILE_FRAGMENTS fragments are split into smaller regions, which are
+ * rasterized again. Only if a single pixel exceeds this limit, its farthest fragments are dropped (like a k-buffer).
+ *
+ * The geometry and shading match the line rendering of the main application (PseudoPhongTrajectories.glsl with
+ * REFLECTION_MODEL 0): The tubes (or billboards) are created from the line data like in the geometry shader, and the
+ * transfer function is applied in linear RGB space followed by gamma correction (i.e., useLinearRGB). Ambient
+ * occlusion and shadows are not supported. Triangles crossing the near or far plane are skipped instead of clipped.
+ */
+class SoftwareDepthPeeling
+{
+public:
+    SoftwareDepthPeeling();
+
+    void setViewportSize(int width, int height);
+    void setLineRadius(float lineRadius) { this->lineRadius = lineRadius; }
+    /// Camera-facing quads instead of tubes (like the shader define BILLBOARD_LINES).
+    void setUseBillboardLines(bool useBillboardLines) { this->useBillboardLines = useBillboardLines; }
+    /// The clear color is blended in linear RGB space (like the clear color of the scene framebuffer).
+    void setClearColor(const sgl::Color &clearColor) { this->clearColor = clearColor; }
+    /// Expects the linear RGB map of TransferFunctionWindow (i.e., the content of the transfer function texture).
+    void setTransferFunction(const std::vector<sgl::Color> &tfLookupTable_linearRGB);
+
+    /**
+     * Creates the line data like convertTrajectoryDataToBinaryLineMesh.
+     * @param attributeIndex The attribute used for the transfer function. Its value range is computed from the data
+     * (like the min/max criterion value of the main application).
+     */
+    void setTrajectories(const Trajectories &trajectories, int attributeIndex);
+
+    /**
+     * Renders the lines with exact per-pixel sorted compositing.
+     * @return The gamma-corrected RGBA8 image with the rows stored bottom-up (like glReadPixels). The image is valid
+     * until the next call of render.
+     */
+    const uint32_t *render(const glm::mat4 &viewMatrix, const glm::mat4 &projectionMatrix);
+
+    /// Statistics of the last frame. The maximum depth complexity is the number of passes OIT_DepthPeeling needs.
+    inline size_t getMaxDepthComplexity() const { return maxDepthComplexity; }
+    inline size_t getNumFragments() const { return numFragments; }
+    inline size_t getNumSegments() const { return segmentIndices.size(); }
+
+private:
+    struct ClipVertex
+    {
+        glm::vec4 clipPosition;
+        glm::vec3 positionWorld;
+        glm::vec3 normal; // normal0 for billboards
+        glm::vec3 normal1; // Only used for billboards
+        float normalFloat; // Only used for billboards
+        float attribute;
+    };
+    struct Fragment
+    {
+        float depth;
+        uint32_t localPixelIndex;
+        glm::vec4 color; // Pre-multiplied alpha
+    };
+
+    void binSegments(const glm::mat4 &mvpMatrix);
+    void renderTile(int tileIdx, std::vector<Fragment> &fragments, std::vector<uint32_t> &fragmentOffsets,
+            std::vector<Fragment> &sortedFragments, size_t &tileMaxDepthComplexity, size_t &tileNumFragments);
+    /// Renders the pixels [x0, x1] x [y0, y1] of the tile. Splits the region if it has too many fragments.
+    void renderTileRegion(int tileIdx, int x0, int y0, int x1, int y1, std::vector<Fragment> &fragments,
+            std::vector<uint32_t> &fragmentOffsets, std::vector<Fragment> &sortedFragments,
+            size_t &tileMaxDepthComplexity, size_t &tileNumFragments);
+    /// Returns false if the region has more than MAX_TILE_FRAGMENTS fragments (except for single pixels).
+    bool gatherTileRegionFragments(int tileIdx, int x0, int y0, int x1, int y1, std::vector<Fragment> &fragments) const;
+    /// Creates the (up to 10) triangles of the line segment starting at the passed line point.
+    int createSegmentTriangles(uint32_t pointIdx, ClipVertex *vertices) const;
+    void rasterizeTriangle(const ClipVertex *triangle, int tileX0, int tileY0, int tileX1, int tileY1,
+            std::vector<Fragment> &fragments) const;
+    glm::vec4 shadeFragment(const glm::vec3 &positionWorld, const glm::vec3 &normal, float attribute) const;
+
+    // Line data (see createTangentAndNormalData)
+    std::vector<glm::vec3> linePoints;
+    std::vector<glm::vec3> lineTangents;
+    std::vector<glm::vec3> lineNormals;
+    std::vector<float> lineAttributes;
+    std::vector<uint32_t> segmentIndices; ///< The first point of each line segment.
+    float minAttribute = 0.0f, maxAttribute = 1.0f;
+
+    // Render settings
+    int width = 0, height = 0;
+    float lineRadius = 0.001f;
+    bool useBillboardLines = false;
+    sgl::Color clearColor;
+    std::vector<glm::vec4> transferFunction;
+    glm::vec3 cameraPosition;
+    glm::mat4 currentMvpMatrix;
+
+    // Binning of the segments into tiles (stored like a compressed sparse row matrix)
+    int numTilesX = 0, numTilesY = 0;
+    std::vector<glm::ivec4> segmentPixelBounds; ///< Empty if x > z or y > w.
+    std::vector<uint32_t> tileSegmentOffsets;
+    std::vector<uint32_t> tileSegments;
+
+    std::vector<uint32_t> image;
+    size_t maxDepthComplexity = 0;
+    size_t numFragments = 0;
+};
+
+#endif //PIXELSYNCOIT_SOFTWAREDEPTHPEELING_HPP
@@ -20,7 +20,8 @@ AutoPerfMeasurer::AutoPerfMeasurer(std::vector<InternalState> _states,
         const std::string &_csvFilename, const std::string &_depthComplexityFilename,
         std::function<void(const InternalState&)> _newStateCallback, bool measureTimeCoherence)
        : states(_states), currentStateIndex(0), newStateCallback(_newStateCallback), file(_csvFilename),
-         depthComplexityFile(_depthComplexityFilename), errorMetricFile("error_metrics.csv"), perfFile("performance_list.csv"), timeCoherence(measureTimeCoherence)
+         depthComplexityFile(_depthComplexityFilename), errorMetricFile("error_metrics.csv"), perfFile("performance_list.csv"),
+         convergenceFile("time_to_converged.csv"), timeCoherence(measureTimeCoherence)
 {
     sgl::FileUtils::get()->ensureDirectoryExists("images/");
 
@@ -31,6 +32,7 @@ AutoPerfMeasurer::AutoPerfMeasurer(std::vector<InternalState> _states,
                                   "Avg Depth Complexity Used", "Avg Depth Complexity All", "Total Number of Fragments"});
     errorMetricFile.writeRow({"Name", "Error measures"});
     perfFile.writeRow({"Name", "Time per frame (ms)"});
+    convergenceFile.writeRow({"Name", "Time to Converged (ms)"});
     setPerformanceMeasurer(this);
 
     // Set initial state
@@ -45,6 +47,7 @@ AutoPerfMeasurer::~AutoPerfMeasurer()
     depthComplexityFile.close();
     errorMetricFile.close();
     perfFile.close();
+    convergenceFile.close();
     //perfTimeProfileFile.close();
 }
 
@@ -84,6 +87,7 @@ void AutoPerfMeasurer::writeCurrentModeData()
     file.writeCell(currentState.name);
     perfFile.writeCell(currentState.name);
     file.writeCell(sgl::toString(timeMS));
+    convergenceFile.writeRow({currentState.name, sgl::toString(currentAlgorithmTimeToConvergedMS)});
 
     // Make screenshot of rendering result with current algorithm
     std::string filename = std::string() + "images/" + currentState.name + ".png";
@@ -231,6 +235,7 @@ void AutoPerfMeasurer::setNextState(bool first)
 
     depthComplexityFrameNumber = 0;
     currentAlgorithmsBufferSizeBytes = 0;
+    currentAlgorithmTimeToConvergedMS = 0.0;
     currentState = states.at(currentStateIndex);
     sgl::Logfile::get()->writeInfo(std::string() + "New state: " + currentState.name);
     newStateCallback(currentState);
@@ -276,6 +281,11 @@ void AutoPerfMeasurer::setCurrentAlgorithmBufferSizeBytes(size_t numBytes)
     currentAlgorithmsBufferSizeBytes = numBytes;
 }
 
+void AutoPerfMeasurer::setCurrentAlgorithmTimeToConvergedMS(double timeMS)
+{
+    currentAlgorithmTimeToConvergedMS = timeMS;
+}
+
 void AutoPerfMeasurer::saveScreenshot(const std::string &filename)
 {
     sgl::Window *window = sgl::AppSettings::get()->getMainWindow();
@@ -41,6 +41,7 @@ public:
 
     // Called by OIT algorithms
     void setCurrentAlgorithmBufferSizeBytes(size_t numBytes);
+    void setCurrentAlgorithmTimeToConvergedMS(double timeMS);
 
 private:
     /// Write out the performance data of "currentState" to "file".
@@ -71,8 +72,10 @@ private:
     CsvWriter depthComplexityFile;
     CsvWriter errorMetricFile;
     CsvWriter perfFile;
+    CsvWriter convergenceFile; // Time to converged quality of progressive algorithms (0 for all others).
     size_t depthComplexityFrameNumber = 0;
     size_t currentAlgorithmsBufferSizeBytes = 0;
+    double currentAlgorithmTimeToConvergedMS = 0.0;
 
     // For making screenshots and computing reference metrics
     sgl::FramebufferObjectPtr sceneFramebuffer;
@@ -517,6 +517,23 @@ void getTestModesRayTracing(std::vector<InternalState> &states, InternalState st
             { "useEmbreeCurves", "true" },
     });
     states.push_back(state);
+
+    // Progressive modes: The time until the image converged is written to the performance file.
+    state.name = std::string() + "Ray Tracing (Tubes, Progressive)";
+    state.oitAlgorithmSettings.set(std::map<std::string, std::string>{
+            { "useEmbreeCurves", "false" },
+            { "progressiveRendering", "true" },
+            { "frameTimeBudget", "33" },
+    });
+    states.push_back(state);
+
+    state.name = std::string() + "Ray Tracing (Embree, Progressive)";
+    state.oitAlgorithmSettings.set(std::map<std::string, std::string>{
+            { "useEmbreeCurves", "true" },
+            { "progressiveRendering", "true" },
+            { "frameTimeBudget", "33" },
+    });
+    states.push_back(state);
 }
 
 void getTestModesDepthComplexity(std::vector<InternalState> &states, InternalState state)
@@ -651,6 +668,32 @@ std::vector<InternalState> getTestModesPaper()
     return states;
 }
 
+std::vector<InternalState> getTestModesRayTracingBatch()
+{
+    std::vector<InternalState> states;
+    std::vector<std::string> modelNames = { "Aneurysm", "Turbulence", "Convection Rolls", "UCLA (400k)" };
+    InternalState state;
+    state.windowResolution = glm::ivec2(1920, 1080);
+
+    for (size_t i = 0; i < modelNames.size(); i++) {
+        state.modelName = modelNames.at(i);
+        std::vector<InternalState> rayTracingStates;
+        getTestModesRayTracing(rayTracingStates, state);
+        for (InternalState &rayTracingState : rayTracingStates) {
+            // The camera moves in every frame, thus progressive rendering would only produce preview images.
+            bool progressiveRendering = false;
+            rayTracingState.oitAlgorithmSettings.getValueOpt("progressiveRendering", progressiveRendering);
+            if (!progressiveRendering) {
+                rayTracingState.name = sgl::toString(state.windowResolution.x) + "x"
+                        + sgl::toString(state.windowResolution.y) + " " + state.modelName + " " + rayTracingState.name;
+                states.push_back(rayTracingState);
+            }
+        }
+    }
+
+    return states;
+}
+
 std::vector<InternalState> getAllTestModes()
 {
     std::vector<InternalState> states;
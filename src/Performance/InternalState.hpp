@@ -220,6 +220,8 @@ struct InternalState
 };
 
 std::vector<InternalState> getTestModesPaper();
+/// The ray tracing modes rendered by the headless batch renderer (see runRayTracingBatch).
+std::vector<InternalState> getTestModesRayTracingBatch();
 std::vector<InternalState> getAllTestModes();
 
 #endif //PIXELSYNCOIT_INTERNALSTATE_HPP
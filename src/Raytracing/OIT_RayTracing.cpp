@@ -36,11 +36,13 @@
 #include <Utils/TrajectoryLoader.hpp>
 
 #include "../Utils/TrajectoryFile.hpp"
+#include "../Utils/AssetCache.hpp"
 #include "OIT_RayTracing.hpp"
 #include "../OIT/BufferSizeWatch.hpp"
 
 #include <Utils/File/FileUtils.hpp>
 #include <Utils/File/Logfile.hpp>
+#include <Utils/Convert.hpp>
 
 #include "ospray/ospray.h"
 
@@ -98,6 +100,26 @@ void OIT_RayTracing::renderGUI()
         loadModel(modelIndex, trajectoryType, useTriangleMesh);
         reRender = true;
     }
+
+    if (ImGui::Checkbox("Progressive rendering", &progressiveRendering)) {
+        renderBackend.setProgressiveRendering(progressiveRendering);
+        reRender = true;
+    }
+    if (progressiveRendering) {
+        if (ImGui::SliderFloat("Frame time budget (ms)", &frameTimeBudgetMS, 5.0f, 200.0f, "%.0f")) {
+            renderBackend.setFrameTimeBudget(frameTimeBudgetMS);
+        }
+        if (ImGui::SliderFloat("Variance threshold", &varianceThreshold, 0.001f, 0.5f, "%.3f")) {
+            renderBackend.setVarianceThreshold(varianceThreshold);
+            reRender = true;
+        }
+        ImGui::Text("Accumulated frames: %d, variance: %.4f, preview scale: 1/%d",
+                renderBackend.getNumAccumulatedFrames(), renderBackend.getVariance(),
+                renderBackend.getLowResolutionScale());
+        if (renderBackend.getIsConverged()) {
+            ImGui::Text("Converged after %.1f ms", renderBackend.getTimeToConvergedMS());
+        }
+    }
 }
 
 void OIT_RayTracing::resolutionChanged(sgl::FramebufferObjectPtr &sceneFramebuffer, sgl::TexturePtr &sceneTexture,
@@ -131,7 +153,10 @@ void OIT_RayTracing::fromFile(
 
     if (useTriangleMesh) {
         std::cout << "---- file name is " << filename << std::endl;
-        std::string modelFilenameBinmesh = sgl::FileUtils::get()->removeExtension(filename) + ".binmesh";
+        // Not the same tube mesh as the one created by the rasterizer (GPU conversion), so use its own cache key
+        std::string modelFilenameBinmesh = AssetCache::get()->getCachedFilename(filename,
+                "gpuTubes;trajectoryType=" + sgl::toString(int(trajectoryType))
+                + ";lineRadius=" + sgl::toString(lineRadius), "binmesh");
         BinaryMesh binmesh;
         if (!sgl::FileUtils::get()->exists(modelFilenameBinmesh)) {
             //convertTrajectoryDataToBinaryTriangleMesh(trajectoryType, filename, modelFilenameBinmesh, lineRadius);
@@ -172,8 +197,7 @@ void OIT_RayTracing::fromFile(
         renderBackend.loadTriangleMesh(filename, indices, vertices, vertexNormals, vertexAttributes);
     } else {
         std::cout << "---- file name is " << filename << std::endl;
-        Trajectories trajectories = loadTrajectoriesFromFile(filename, trajectoryType);
-        renderBackend.loadTrajectories(filename, trajectories);
+        renderBackend.loadTrajectoriesCached(filename, trajectoryType);
         onTransferFunctionMapRebuilt();
         renderBackend.setLineRadius(this->lineRadius);
     }
@@ -215,6 +239,43 @@ void OIT_RayTracing::setNewState(const InternalState &newState)
         renderBackend.setUseEmbreeCurves(useEmbreeCurves);
         loadModel(modelIndex, trajectoryType, useTriangleMesh);
     }
+
+    bool progressiveRenderingNew = false;
+    newState.oitAlgorithmSettings.getValueOpt("progressiveRendering", progressiveRenderingNew);
+    newState.oitAlgorithmSettings.getValueOpt("frameTimeBudget", frameTimeBudgetMS);
+    newState.oitAlgorithmSettings.getValueOpt("varianceThreshold", varianceThreshold);
+    renderBackend.setFrameTimeBudget(frameTimeBudgetMS);
+    renderBackend.setVarianceThreshold(varianceThreshold);
+    if (progressiveRendering != progressiveRenderingNew) {
+        progressiveRendering = progressiveRenderingNew;
+        renderBackend.setProgressiveRendering(progressiveRendering);
+    }
+
+    // The time to converged quality is measured over the next frames (see updateTimeToConvergedMeasurement).
+    measuringTimeToConverged = progressiveRendering;
+    if (measuringTimeToConverged) {
+        renderBackend.resetAccumulation();
+        timeToConvergedMeasurementStart = std::chrono::high_resolution_clock::now();
+        reRender = true;
+    }
+}
+
+void OIT_RayTracing::updateTimeToConvergedMeasurement()
+{
+    // Stays below the time per state of AutoPerfMeasurer, which writes out the result when switching the state.
+    const double MAX_TIME_MS = 30000.0;
+    auto now = std::chrono::high_resolution_clock::now();
+    double elapsedMS = std::chrono::duration<double, std::milli>(now - timeToConvergedMeasurementStart).count();
+    if (!renderBackend.getIsConverged() && elapsedMS < MAX_TIME_MS) {
+        return;
+    }
+
+    measuringTimeToConverged = false;
+    double timeToConvergedMS = renderBackend.getIsConverged() ? renderBackend.getTimeToConvergedMS() : -1.0;
+    sgl::Logfile::get()->writeInfo(std::string() + "Ray tracing time to converged quality: "
+            + sgl::toString(timeToConvergedMS) + "ms (" + sgl::toString(renderBackend.getNumAccumulatedFrames())
+            + " frames, variance " + sgl::toString(renderBackend.getVariance()) + ")");
+    setCurrentAlgorithmTimeToConvergedMS(timeToConvergedMS);
 }
 
 void OIT_RayTracing::renderToScreen()
@@ -235,9 +296,13 @@ void OIT_RayTracing::renderToScreen()
     uint32_t *imageData = renderBackend.renderToImage(pos, lookDir, upDir, camera->getFOVy(), lineRadius, changeTFN);
     changeTFN = false;
     renderImage->uploadPixelData(width, height, imageData);
+    if (measuringTimeToConverged) {
+        updateTimeToConvergedMeasurement();
+    }
 
     blitTexture();
-    reRender = true;
+    // A converged progressive image doesn't change until the camera or scene changes.
+    reRender = !(progressiveRendering && renderBackend.getIsConverged());
 }
 
 void OIT_RayTracing::blitTexture()
@@ -69,6 +69,9 @@ private:
     void fromFile(
             const std::string &filename, TrajectoryType trajectoryType, bool useTriangleMesh
             /*, std::vector<float> &attributes, float &maxAttribute*/);
+    /// Called after each rendered frame while measuring. Reports the time to the performance measurer once the
+    /// image converged (or the measurement timed out).
+    void updateTimeToConvergedMeasurement();
 
     RTRenderBackend renderBackend;
     sgl::TexturePtr renderImage;
@@ -84,6 +87,13 @@ private:
     TrajectoryType trajectoryType;
     bool useTriangleMesh;
     bool changeTFN = false;
+
+    // Progressive rendering settings (see RTRenderBackend::setProgressiveRendering).
+    bool progressiveRendering = false;
+    float frameTimeBudgetMS = 33.0f;
+    float varianceThreshold = 0.02f;
+    bool measuringTimeToConverged = false;
+    std::chrono::high_resolution_clock::time_point timeToConvergedMeasurementStart;
 };
 
 
@@ -0,0 +1,161 @@
+//
+// Created by christoph on 19.10.26.
+//
+
+#include <chrono>
+#include <cmath>
+#include <Utils/File/Logfile.hpp>
+#include <Utils/File/FileUtils.hpp>
+#include <Utils/Convert.hpp>
+
+#include "../Utils/TrajectoryFile.hpp"
+#include "../Utils/CameraPath.hpp"
+#include "../Utils/OfflineRendering.hpp"
+#include "../Performance/InternalState.hpp"
+#include "../Performance/CsvWriter.hpp"
+#include "../TransferFunctionWindow.hpp"
+#include "../MainApp.hpp"
+#include "RTRenderBackend.hpp"
+#include "RTBatchRenderer.hpp"
+
+static bool initializeOSPRay()
+{
+    int argc = sgl::FileUtils::get()->get_argc();
+    const char **argv = const_cast<const char**>(sgl::FileUtils::get()->get_argv());
+    if (ospInit(&argc, argv) != OSP_NO_ERROR) {
+        sgl::Logfile::get()->writeError("Error in runRayTracingBatch: OSPRay initialization failed.");
+        return false;
+    }
+    ospLoadModule("tubes");
+    return true;
+}
+
+/**
+ * Renders all frames of the camera path for one test mode.
+ * @return False if the data set or the camera path could not be loaded.
+ */
+static bool renderState(
+        const InternalState &state, int samplesPerPixel, float framesPerSecond,
+        CsvWriter &file, CsvWriter &perfFile)
+{
+    std::string modelFilename = getModelFilenameFromDisplayName(state.modelName);
+    std::string modelFilenamePure = sgl::FileUtils::get()->removeExtension(modelFilename);
+    if (modelFilename.empty()
+            || PixelSyncApp::getModelTypeFromFilename(modelFilenamePure) != MODEL_TYPE_TRAJECTORIES) {
+        sgl::Logfile::get()->writeError(std::string() + "Error in runRayTracingBatch: \"" + state.modelName
+                + "\" is not a line data set.");
+        return false;
+    }
+
+    CameraPath cameraPath;
+    std::string cameraPathFilename = "Data/CameraPaths/"
+            + sgl::FileUtils::get()->getPathAsList(modelFilenamePure).back() + ".binpath";
+    if (!cameraPath.fromBinaryFile(cameraPathFilename)) {
+        return false;
+    }
+
+    // Same window resolution as the main application in performance measurement mode.
+    const int width = state.windowResolution.x > 0 ? state.windowResolution.x : 1920;
+    const int height = state.windowResolution.y > 0 ? state.windowResolution.y : 1080;
+    const float fovy = getDefaultCameraFovy();
+    const float lineRadius = 0.001f;
+    TransferFunctionWindow transferFunctionWindow(true);
+    if (!state.transferFunctionName.empty()) {
+        transferFunctionWindow.loadFunctionFromFile("Data/TransferFunctions/" + state.transferFunctionName);
+    }
+
+    bool useEmbreeCurves = false;
+    state.oitAlgorithmSettings.getValueOpt("useEmbreeCurves", useEmbreeCurves);
+    RTRenderBackend renderBackend(useEmbreeCurves);
+    renderBackend.setViewportSize(width, height);
+    renderBackend.setLineRadius(lineRadius);
+    TrajectoryType trajectoryType = PixelSyncApp::getTrajectoryTypeFromFilename(modelFilenamePure);
+    if (!renderBackend.loadTrajectoriesCached(modelFilename, trajectoryType)) {
+        return false;
+    }
+    renderBackend.setTransferFunction(transferFunctionWindow.getTransferFunctionMap_sRGB());
+
+    std::vector<double> frameTimesMS;
+    AsyncFrameWriter frameWriter;
+    const int numFrames = int(std::floor(cameraPath.getEndTime() * framesPerSecond)) + 1;
+    for (int frameIdx = 0; frameIdx < numFrames; frameIdx++) {
+        cameraPath.update(float(frameIdx) / framesPerSecond);
+        glm::mat4 invViewMatrix = glm::inverse(cameraPath.getViewMatrix());
+        glm::vec3 upDir = invViewMatrix[1];
+        glm::vec3 lookDir = -invViewMatrix[2];
+        glm::vec3 pos = invViewMatrix[3];
+        if (frameIdx == 0) {
+            renderBackend.commitToOSPRay(pos, lookDir, upDir, fovy);
+        }
+
+        // The accumulation is reset by the camera change in the first call.
+        auto start = std::chrono::high_resolution_clock::now();
+        uint32_t *imageData = NULL;
+        for (int sampleIdx = 0; sampleIdx < samplesPerPixel; sampleIdx++) {
+            imageData = renderBackend.renderToImage(pos, lookDir, upDir, fovy, lineRadius, false);
+        }
+        auto end = std::chrono::high_resolution_clock::now();
+        frameTimesMS.push_back(std::chrono::duration<double, std::milli>(end - start).count());
+
+        // OSPRay stores the rows bottom-up like glReadPixels.
+        frameWriter.writeFrame(imageData, width, height, std::string() + "images/" + state.name + "_frame_"
+                + std::to_string(frameIdx + 1) + ".png");
+    }
+    frameWriter.wait();
+
+    double averageTimeMS = 0.0;
+    for (double frameTimeMS : frameTimesMS) {
+        averageTimeMS += frameTimeMS;
+    }
+    averageTimeMS /= double(frameTimesMS.size());
+    sgl::Logfile::get()->writeInfo(std::string() + "Ray tracing batch: " + state.name + ": "
+            + sgl::toString(numFrames) + " frames, " + sgl::toString(averageTimeMS) + "ms per frame");
+
+    // Same columns as AutoPerfMeasurer. GPU memory, buffer sizes and reference metrics don't apply here.
+    file.writeCell(state.name);
+    perfFile.writeCell(state.name);
+    file.writeCell(sgl::toString(averageTimeMS));
+    file.writeCell(std::string() + "images/" + state.name + "_frame_1.png");
+    for (int i = 0; i < 6; i++) {
+        file.writeCell(sgl::toString(0));
+    }
+    for (double frameTimeMS : frameTimesMS) {
+        file.writeCell(sgl::toString(frameTimeMS));
+        perfFile.writeCell(sgl::toString(frameTimeMS));
+    }
+    file.newRow();
+    perfFile.newRow();
+    return true;
+}
+
+int runRayTracingBatch(const std::vector<std::string> &args)
+{
+    int samplesPerPixel = args.size() > 0 ? sgl::fromString<int>(args.at(0)) : 1;
+    float framesPerSecond = args.size() > 1 ? sgl::fromString<float>(args.at(1)) : 25.0f;
+    std::string modelNameFilter = args.size() > 2 ? args.at(2) : "";
+    samplesPerPixel = std::max(samplesPerPixel, 1);
+
+    if (!initializeOSPRay()) {
+        return 1;
+    }
+    sgl::FileUtils::get()->ensureDirectoryExists("images/");
+
+    CsvWriter file("performance_rt_batch.csv");
+    CsvWriter perfFile("performance_list_rt_batch.csv");
+    file.writeRow({"Name", "Average Time (ms)", "Image Filename", "Memory (GB)", "Buffer Size (GB)",
+                   "Time to Converged (ms)", "SSIM", "RMSE", "PSNR", "Time Stamp (s), Frame Time (ns)"});
+    perfFile.writeRow({"Name", "Time per frame (ms)"});
+
+    bool success = true;
+    for (const InternalState &state : getTestModesRayTracingBatch()) {
+        if (!modelNameFilter.empty() && state.modelName != modelNameFilter) {
+            continue;
+        }
+        sgl::Logfile::get()->writeInfo(std::string() + "New state: " + state.name);
+        success = renderState(state, samplesPerPixel, framesPerSecond, file, perfFile) && success;
+    }
+
+    file.close();
+    perfFile.close();
+    return success ? 0 : 1;
+}
@@ -0,0 +1,23 @@
+//
+// Created by christoph on 19.10.26.
+//
+
+#ifndef PIXELSYNCOIT_RTBATCHRENDERER_HPP
+#define PIXELSYNCOIT_RTBATCHRENDERER_HPP
+
+#include <string>
+#include <vector>
+
+/**
+ * Renders the ray tracing test modes (see getTestModesRayTracingBatch) without creating a window. For every mode, the
+ * data set is loaded, and all frames of the camera path stored in "Data/CameraPaths/<model>.binpath" (written by the
+ * performance measurement mode) are rendered using RTRenderBackend. OSPRay distributes the rendering of each frame
+ * over all cores, and the images are encoded on a separate thread.
+ * Usage: PixelSyncOIT --rt-batch [samplesPerPixel] [framesPerSecond] [modelName]
+ * The images are written to "images/<mode>_frame_<n>.png" and the frame times in the CSV formats of AutoPerfMeasurer
+ * ("performance_rt_batch.csv" and "performance_list_rt_batch.csv").
+ * @return The exit code of the application.
+ */
+int runRayTracingBatch(const std::vector<std::string> &args);
+
+#endif //PIXELSYNCOIT_RTBATCHRENDERER_HPP
@@ -28,13 +28,20 @@
 
 #include "RTRenderBackend.hpp"
 #include <Utils/File/FileUtils.hpp>
+#include <Utils/File/Logfile.hpp>
 #include <Utils/AppSettings.hpp>
+#include <Utils/Convert.hpp>
+#include "../Utils/AssetCache.hpp"
 #include "helper.h"
 
 #include <iterator>
+#include <fstream>
 #include <algorithm>
 #include <cmath>
 #include <random>
+#include <limits>
+#include <chrono>
+#include <cstring>
 
 // See: https://stackoverflow.com/questions/2513505/how-to-get-available-memory-c-g
 #ifdef linux
@@ -86,24 +93,82 @@ void writePPM(const char *fileName,
 void RTRenderBackend::setViewportSize(int width, int height) {
     this->width = width;
     this->height = height;
-    // image.resize(width * height);
+    for (int i = 0; i < 2; i++) {
+        images[i].clear();
+        images[i].resize(width * height, 0);
+    }
     if(framebuffer != NULL){
         ospRelease(framebuffer);
     }
-    framebuffer = ospNewFrameBuffer(osp::vec2i{width, height}, OSP_FB_SRGBA, OSP_FB_COLOR | OSP_FB_ACCUM);
+    framebuffer = ospNewFrameBuffer(
+            osp::vec2i{width, height}, OSP_FB_SRGBA, OSP_FB_COLOR | OSP_FB_ACCUM | OSP_FB_VARIANCE);
+    if (lowResolutionFramebuffer != NULL) {
+        ospRelease(lowResolutionFramebuffer);
+        lowResolutionFramebuffer = NULL;
+    }
+    resetAccumulation();
+}
+
+void RTRenderBackend::setProgressiveRendering(bool progressive) {
+    progressiveRendering = progressive;
+    resetAccumulation();
+}
+
+void RTRenderBackend::setFrameTimeBudget(float budgetMS) {
+    frameTimeBudgetMS = budgetMS;
+}
+
+void RTRenderBackend::setVarianceThreshold(float threshold) {
+    varianceThreshold = threshold;
+    resetAccumulation();
+}
+
+void RTRenderBackend::resetAccumulation() {
+    if (framebuffer != NULL) {
+        ospFrameBufferClear(framebuffer, OSP_FB_COLOR | OSP_FB_ACCUM);
+    }
+    numAccumulatedFrames = 0;
+    currentVariance = std::numeric_limits<float>::infinity();
+    isConverged = false;
+    timeToConvergedMS = 0.0;
+    accumulationStartTime = std::chrono::high_resolution_clock::now();
 }
 
 void RTRenderBackend::clearData() {
     Tube.nodes.clear();
     Tube.links.clear();
     Tube.colors.clear();
+    nodes = ArrayView<Node>();
+    links = ArrayView<const Link>();
+    nodeAttributeIndices = ArrayView<const uint16_t>();
+    sceneCacheFile.close();
+    nodePartitionOffsets = { 0 };
 
     this->triangleMesh.indices.clear();
     this->triangleMesh.vertices.clear();
     this->triangleMesh.vertexNormals.clear();
     this->triangleMesh.vertexColors.clear();
 
-    this->attributes.clear();
+    this->attributeIndices.clear();
+    attributeMin = 0.0f;
+    attributeMax = 0.0f;
+}
+
+void RTRenderBackend::computeAttributeRange(const float *values, size_t numValues)
+{
+    float minValue = std::numeric_limits<float>::max();
+    float maxValue = std::numeric_limits<float>::lowest();
+    #pragma omp parallel for simd reduction(min: minValue) reduction(max: maxValue)
+    for (size_t i = 0; i < numValues; i++) {
+        minValue = std::min(minValue, values[i]);
+        maxValue = std::max(maxValue, values[i]);
+    }
+    attributeMin = numValues > 0 ? minValue : 0.0f;
+    attributeMax = numValues > 0 ? maxValue : 0.0f;
+}
+
+void RTRenderBackend::setTargetPrimitivesPerPartition(size_t numPrimitives) {
+    targetPrimitivesPerPartition = numPrimitives;
 }
 
 void RTRenderBackend::loadTrajectories(const std::string &filename, const Trajectories &trajectories)
@@ -113,53 +178,218 @@ void RTRenderBackend::loadTrajectories(const std::string &filename, const Trajec
 
     // convert trajectories to tubes
     std::cout << "Start convert trajectories to tube primitives..." << std::endl;
-    // std::cout << "node size = " << trajectories.positions.size() << std::endl;
-    // std::cout << "line size = " << trajectories.size() << std::endl;
-    int length = 0;
-    numOfLines = trajectories.size();
-    if(numOfLines > threshold) needSplit = true;
-    for(int i = 0; i < trajectories.size(); i++){
-        // one line 
-        Trajectory trajectory = trajectories[i];
-        // positions and attributes for one line
-        std::vector<glm::vec3> &positions = trajectory.positions;
-        std::vector<std::vector<float>> &attributes = trajectory.attributes;
-        // std::cout << "node size " << trajectory.positions.size() << std::endl;
-        ospcommon::vec4f color;
-        // color.x = 1.0; color.y = 0.0; color.z = 0.0; color.w = 1.0;
-
-        // std::cout << "point size of line #" << i << " is " << positions.size() << std::endl;
-        std::vector<float> &attr = attributes.at(0);
-        // std::cout << "attribute size " << attr.size() << std::endl;
-        for(int k = 0; k < attr.size(); k++){
-            float r = attr[k];
-            this->attributes.push_back(r);
-            glm::vec3 pos = positions[k];
-            // std::cout << "index " << i * length + k << " ";
-            ospcommon::vec3f p(pos.x, pos.y, pos.z);
-            Node node;
-            node.radius = r; node.position = p;
-            Tube.nodes.push_back(node);
-            // Tube.colors.push_back(color);
-            if(k == 0){
-                int first = length + k;
-                int second = first;
-                // std::cout << second << " ";
-                Link link;
-                link.first = first; link.second = second;
-                Tube.links.push_back(link);
-                // std::cout << "length " << length << " first " << first << " second " << second << std::endl;
-            }else{
-                int first = length + k;
-                int second = first - 1;
-                // std::cout << second << " ";
-                Link link;
-                link.first = first; link.second = second;
-                Tube.links.push_back(link);
-            }
+
+    // Store the lines in the order of the Morton codes of their centroids, such that each partition is a contiguous
+    // range of nodes that can be passed to OSPRay without copying.
+    LinePartitioning partitioning;
+    partitionLinesMorton(trajectories, targetPrimitivesPerPartition, partitioning);
+    const size_t numLines = trajectories.size();
+    std::vector<size_t> sortedLineOffsets(numLines + 1);
+    sortedLineOffsets[0] = 0;
+    for (size_t i = 0; i < numLines; i++) {
+        sortedLineOffsets[i + 1] = sortedLineOffsets[i] + trajectories.getLineNumPoints(partitioning.lineOrder[i]);
+    }
+    const size_t numPartitions = partitioning.getNumPartitions();
+    nodePartitionOffsets.resize(numPartitions + 1);
+    for (size_t i = 0; i <= numPartitions; i++) {
+        nodePartitionOffsets[i] = sortedLineOffsets[partitioning.partitionOffsets[i]];
+    }
+    std::vector<size_t> sortedLinePartitionStarts(numLines);
+    for (size_t i = 0; i < numPartitions; i++) {
+        for (size_t j = partitioning.partitionOffsets[i]; j < partitioning.partitionOffsets[i + 1]; j++) {
+            sortedLinePartitionStarts[j] = nodePartitionOffsets[i];
+        }
+    }
+    std::cout << "Split " << numLines << " lines into " << numPartitions << " partitions" << std::endl;
+
+    // All arrays are allocated once and every line writes its range independently of all other lines.
+    const size_t numPoints = trajectories.getNumPoints();
+    Tube.nodes.resize(numPoints);
+    Tube.links.resize(numPoints);
+    Tube.colors.resize(numPoints, ospcommon::vec4f(1.0f, 1.0f, 1.0f, 1.0f));
+    this->attributeIndices.resize(numPoints);
+    const float *lineAttributes = trajectories.attributes.empty() ? nullptr : trajectories.attributes.front().data();
+    computeAttributeRange(lineAttributes, lineAttributes ? numPoints : 0);
+    // Constant attributes are mapped to zero (like in packUnorm16Array).
+    const float attributeScale = attributeMax > attributeMin ? 65535.0f / (attributeMax - attributeMin) : 0.0f;
+
+    const float nodeRadius = lineRadius;
+    #pragma omp parallel for schedule(dynamic, 64)
+    for (size_t sortedLineIdx = 0; sortedLineIdx < numLines; sortedLineIdx++) {
+        const size_t lineIdx = partitioning.lineOrder[sortedLineIdx];
+        const size_t readOffset = trajectories.getLineOffset(lineIdx);
+        const int lineOffset = int(sortedLineOffsets[sortedLineIdx]);
+        const int partitionStart = int(sortedLinePartitionStarts[sortedLineIdx]);
+        ArrayView<const glm::vec3> positions = trajectories.getLinePositions(lineIdx);
+        for (size_t k = 0; k < positions.size(); k++) {
+            const int first = lineOffset + int(k);
+            const glm::vec3 &pos = positions[k];
+            Node &node = Tube.nodes[first];
+            node.position = ospcommon::vec3f(pos.x, pos.y, pos.z);
+            node.radius = nodeRadius;
+            // The first node of each line links to itself, all other nodes link to their predecessor. The links
+            // reference the nodes relative to the start of the partition, such that they can be passed to OSPRay
+            // as they are.
+            Link &link = Tube.links[first];
+            link.first = first - partitionStart;
+            link.second = k == 0 ? link.first : link.first - 1;
+            const float attribute = lineAttributes ? lineAttributes[readOffset + k] : attributeMin;
+            this->attributeIndices[first] = uint16_t(
+                    glm::clamp((attribute - attributeMin) * attributeScale, 0.0f, 65535.0f) + 0.5f);
         }
-        length = length + positions.size();
     }
+
+    nodes = ArrayView<Node>(Tube.nodes.data(), Tube.nodes.size());
+    links = ArrayView<const Link>(Tube.links.data(), Tube.links.size());
+    nodeAttributeIndices = ArrayView<const uint16_t>(this->attributeIndices.data(), this->attributeIndices.size());
+}
+
+/*
+ * Scene cache file layout (little endian): SceneCacheHeader, (numPartitions + 1) uint64 node partition offsets,
+ * padding to a multiple of 16 bytes, numNodes Node, numNodes Link, numNodes uint16 attribute indices.
+ * The nodes are aligned to 16 bytes, such that all arrays can be used directly from the memory-mapped file.
+ */
+const uint32_t SCENE_CACHE_FORMAT_VERSION = 1u;
+
+struct SceneCacheHeader
+{
+    uint32_t versionNumber;
+    uint32_t numPartitions;
+    uint64_t numNodes;
+    float lineRadius;
+    float attributeMin;
+    float attributeMax;
+    uint32_t padding;
+};
+
+static inline size_t getSceneCacheNodesOffset(size_t numPartitions)
+{
+    size_t offset = sizeof(SceneCacheHeader) + (numPartitions + 1) * sizeof(uint64_t);
+    return (offset + 15) & ~size_t(15);
+}
+
+bool RTRenderBackend::writeSceneCache(const std::string &filename) const
+{
+    if (isTriangles) {
+        return false;
+    }
+
+    std::ofstream file(filename.c_str(), std::ofstream::binary);
+    if (!file.is_open()) {
+        sgl::Logfile::get()->writeError(std::string() + "Error in RTRenderBackend::writeSceneCache: File \""
+                + filename + "\" couldn't be opened for writing.");
+        return false;
+    }
+
+    SceneCacheHeader header;
+    header.versionNumber = SCENE_CACHE_FORMAT_VERSION;
+    header.numPartitions = uint32_t(getNumPartitions());
+    header.numNodes = nodes.size();
+    header.lineRadius = lineRadius;
+    header.attributeMin = attributeMin;
+    header.attributeMax = attributeMax;
+    header.padding = 0;
+    std::vector<uint64_t> partitionOffsets(nodePartitionOffsets.begin(), nodePartitionOffsets.end());
+    const size_t headerSize = sizeof(SceneCacheHeader) + partitionOffsets.size() * sizeof(uint64_t);
+    const char padding[16] = {};
+
+    file.write(reinterpret_cast<const char*>(&header), sizeof(SceneCacheHeader));
+    file.write(reinterpret_cast<const char*>(partitionOffsets.data()), partitionOffsets.size() * sizeof(uint64_t));
+    file.write(padding, getSceneCacheNodesOffset(header.numPartitions) - headerSize);
+    file.write(reinterpret_cast<const char*>(nodes.data()), nodes.size() * sizeof(Node));
+    file.write(reinterpret_cast<const char*>(links.data()), links.size() * sizeof(Link));
+    file.write(reinterpret_cast<const char*>(nodeAttributeIndices.data()),
+            nodeAttributeIndices.size() * sizeof(uint16_t));
+    if (!file.good()) {
+        sgl::Logfile::get()->writeError(std::string() + "Error in RTRenderBackend::writeSceneCache: Couldn't write "
+                + "file \"" + filename + "\".");
+        return false;
+    }
+    return true;
+}
+
+bool RTRenderBackend::loadSceneCache(const std::string &filename)
+{
+    isTriangles = false;
+    clearData();
+    if (!sgl::FileUtils::get()->exists(filename)) {
+        return false;
+    }
+
+    // The mapping is writable (copy-on-write), as the node radii and colors are changed in place.
+    if (!sceneCacheFile.open(filename, true)) {
+        return false;
+    }
+    char *data = sceneCacheFile.getWritableData();
+    const size_t fileSize = sceneCacheFile.getSize();
+    SceneCacheHeader header;
+    bool isValid = fileSize >= sizeof(SceneCacheHeader);
+    if (isValid) {
+        memcpy(&header, data, sizeof(SceneCacheHeader));
+        isValid = header.versionNumber == SCENE_CACHE_FORMAT_VERSION
+                && header.numNodes <= uint64_t(std::numeric_limits<int>::max());
+    }
+    size_t nodesOffset = 0;
+    if (isValid) {
+        const size_t numNodes = header.numNodes;
+        nodesOffset = getSceneCacheNodesOffset(header.numPartitions);
+        isValid = fileSize == nodesOffset + numNodes * (sizeof(Node) + sizeof(Link) + sizeof(uint16_t));
+    }
+    if (isValid) {
+        const uint64_t *partitionOffsets = reinterpret_cast<const uint64_t*>(data + sizeof(SceneCacheHeader));
+        nodePartitionOffsets.assign(partitionOffsets, partitionOffsets + header.numPartitions + 1);
+        for (size_t i = 0; i < header.numPartitions; i++) {
+            isValid = isValid && nodePartitionOffsets[i] <= nodePartitionOffsets[i + 1];
+        }
+        isValid = isValid && nodePartitionOffsets.front() == 0 && nodePartitionOffsets.back() == header.numNodes;
+    }
+    if (!isValid) {
+        sgl::Logfile::get()->writeError(std::string() + "Error in RTRenderBackend::loadSceneCache: File \""
+                + filename + "\" is malformed.");
+        clearData();
+        return false;
+    }
+
+    const size_t numNodes = header.numNodes;
+    nodes = ArrayView<Node>(reinterpret_cast<Node*>(data + nodesOffset), numNodes);
+    links = ArrayView<const Link>(reinterpret_cast<const Link*>(
+            data + nodesOffset + numNodes * sizeof(Node)), numNodes);
+    nodeAttributeIndices = ArrayView<const uint16_t>(reinterpret_cast<const uint16_t*>(
+            data + nodesOffset + numNodes * (sizeof(Node) + sizeof(Link))), numNodes);
+    attributeMin = header.attributeMin;
+    attributeMax = header.attributeMax;
+    // The colors are shared with OSPRay and filled by setTransferFunction.
+    Tube.colors.resize(numNodes, ospcommon::vec4f(1.0f, 1.0f, 1.0f, 1.0f));
+
+    if (header.lineRadius != lineRadius) {
+        // Only touches the pages of the node array, all other arrays stay backed by the file.
+        const float radius = lineRadius;
+        lineRadius = header.lineRadius;
+        setLineRadius(radius);
+        radiusChanged = false;
+    }
+    return true;
+}
+
+bool RTRenderBackend::loadTrajectoriesCached(const std::string &filename, TrajectoryType trajectoryType)
+{
+    // The line radius is not part of the key, as it can be changed cheaply after loading.
+    std::string sceneCacheFilename = AssetCache::get()->getCachedFilename(filename,
+            "rtTubes;trajectoryType=" + sgl::toString(int(trajectoryType))
+            + ";primitivesPerPartition=" + sgl::toString(targetPrimitivesPerPartition), "rtscene");
+    if (loadSceneCache(sceneCacheFilename)) {
+        return true;
+    }
+
+    Trajectories trajectories = loadTrajectoriesFromFile(filename, trajectoryType);
+    if (trajectories.empty()) {
+        return false;
+    }
+    loadTrajectories(filename, trajectories);
+    AssetCache::get()->convert(sceneCacheFilename, [this](const std::string &outputFilename) {
+        return writeSceneCache(outputFilename);
+    });
+    return true;
 }
 
 void RTRenderBackend::loadTriangleMesh(
@@ -174,7 +404,13 @@ void RTRenderBackend::loadTriangleMesh(
 
     this->triangleMesh.vertices = vertices;
     this->triangleMesh.vertexNormals = vertexNormals;
-    this->attributes = vertexAttributes;
+    computeAttributeRange(vertexAttributes.data(), vertexAttributes.size());
+    this->attributeIndices.resize(vertexAttributes.size());
+    packUnorm16Array(
+            vertexAttributes.data(), vertexAttributes.size(), attributeMin, attributeMax,
+            this->attributeIndices.data());
+    // The colors are passed to OSPRay as a shared buffer, thus they are allocated once and updated in place.
+    this->triangleMesh.vertexColors.resize(vertices.size(), ospcommon::vec4f(1.0f, 1.0f, 1.0f, 1.0f));
 
     this->triangleMesh.indices.resize(indices.size());
     for (size_t i = 0; i < indices.size(); i++) {
@@ -183,68 +419,63 @@ void RTRenderBackend::loadTriangleMesh(
 }
 
 void RTRenderBackend::setTransferFunction(const std::vector<sgl::Color> &tfLookupTable) {
-    // Interpolate the color points in sRGB space. Then, convert the result to linear RGB for rendering:
-    //TransferFunctionWindow::sRGBToLinearRGB(glm::vec3(...));
-    //! find the min and max
-    const float amin = *std::min_element(this->attributes.begin(), this->attributes.end());
-    const float amax = *std::max_element(this->attributes.begin(), this->attributes.end());
-    // std::cout << "Attribute min " << amin << " max " << amax << std::endl;
-    const float dis = 1.f / (amax - amin);
-    // map attributes to the color
-
-    std::vector<ospcommon::vec4f> newColors;
-    newColors.reserve(this->attributes.size());
-
-    for(int i = 0; i < this->attributes.size(); ++i){
-        float a = this->attributes[i];
-        const float ratio = (a - amin) * dis;
+    if (tfLookupTable.empty()) {
+        return;
+    }
+
+    // Interpolate the color points in sRGB space. Then, convert the result to linear RGB for rendering.
+    // The transfer function is sampled once for every 16-bit attribute index, such that mapping the nodes to colors
+    // only needs one table lookup per node.
+    const int numEntries = 65536;
+    const int maxTfIndex = int(tfLookupTable.size()) - 1;
+    colorLookupTable.resize(numEntries);
+    #pragma omp parallel for
+    for (int i = 0; i < numEntries; i++) {
+        const float position = float(i) / float(numEntries - 1) * float(maxTfIndex);
         // find TFN index and the fraction
-        const int N = int(ratio * (tfLookupTable.size() - 1));
-        const float R = ratio * (tfLookupTable.size() - 1) - N;
-        // std::cout << "a = " << a << " N = " << N << " R " << R << std::endl;
-        if(N < 0){
-            glm::vec4 colorRGBA = tfLookupTable.front().getFloatColorRGBA();
-            glm::vec3 color_sRGB(colorRGBA);
-            glm::vec3 color_linear_rgb = TransferFunctionWindow::sRGBToLinearRGB(color_sRGB);
-            float opacity = colorRGBA.a;
-            ospcommon::vec4f color(color_linear_rgb.r, color_linear_rgb.g , color_linear_rgb.b, colorRGBA.a);
-            newColors.push_back(color);
-        }else if(N >= tfLookupTable.size() - 1){
-            glm::vec4 colorRGBA = tfLookupTable.back().getFloatColorRGBA();
-            glm::vec3 color_sRGB(colorRGBA);
-            glm::vec3 color_linear_rgb = TransferFunctionWindow::sRGBToLinearRGB(color_sRGB);
-            float opacity = colorRGBA.a;
-            ospcommon::vec4f color(color_linear_rgb.r, color_linear_rgb.g , color_linear_rgb.b, opacity);
-            newColors.push_back(color);
-        }else{
-            glm::vec4 colorRGBA_lo = tfLookupTable.at(N).getFloatColorRGBA();
-            glm::vec4 colorRGBA_hi = tfLookupTable.at(N+1).getFloatColorRGBA();
-            glm::vec3 color_sRGB_lo(colorRGBA_lo);
-            glm::vec3 color_sRGB_hi(colorRGBA_hi);
-            glm::vec3 color_sRGB = glm::mix(color_sRGB_lo, color_sRGB_hi, R);
-            float opacity_lo = colorRGBA_lo.a;
-            float opacity_hi = colorRGBA_hi.a;
-            float opacity = glm::mix(opacity_lo, opacity_hi, R);
-            // convert sRGB to linear RGB
-            glm::vec3 color_linear = TransferFunctionWindow::sRGBToLinearRGB(color_sRGB);
-            ospcommon::vec4f color(color_linear.x, color_linear.y, color_linear.z, opacity);
-            newColors.push_back(color);
-        }
+        const int N = std::min(int(position), maxTfIndex);
+        const float R = position - float(N);
+        const glm::vec4 colorRGBA_lo = tfLookupTable.at(N).getFloatColorRGBA();
+        const glm::vec4 colorRGBA_hi = tfLookupTable.at(std::min(N + 1, maxTfIndex)).getFloatColorRGBA();
+        glm::vec3 color_sRGB = glm::mix(glm::vec3(colorRGBA_lo), glm::vec3(colorRGBA_hi), R);
+        float opacity = glm::mix(colorRGBA_lo.a, colorRGBA_hi.a, R);
+        // convert sRGB to linear RGB
+        glm::vec3 color_linear = TransferFunctionWindow::sRGBToLinearRGB(color_sRGB);
+        colorLookupTable[i] = ospcommon::vec4f(color_linear.x, color_linear.y, color_linear.z, opacity);
     }
 
-    if (isTriangles) {
-        this->triangleMesh.vertexColors = newColors;
-    } else {
-        Tube.colors = newColors;
+    // Map the attribute indices to colors in place (the color arrays are shared with OSPRay).
+    std::vector<ospcommon::vec4f> &colors = isTriangles ? this->triangleMesh.vertexColors : Tube.colors;
+    ArrayView<const uint16_t> colorAttributeIndices = isTriangles
+            ? ArrayView<const uint16_t>(this->attributeIndices.data(), this->attributeIndices.size())
+            : nodeAttributeIndices;
+    const size_t numColors = std::min(colors.size(), colorAttributeIndices.size());
+    const uint16_t *indices = colorAttributeIndices.data();
+    const float *lookupTable = &colorLookupTable.front().x;
+    float *colorData = reinterpret_cast<float*>(colors.data());
+    #pragma omp parallel for simd
+    for (size_t i = 0; i < numColors; i++) {
+        const float *color = lookupTable + 4 * size_t(indices[i]);
+        colorData[4*i + 0] = color[0];
+        colorData[4*i + 1] = color[1];
+        colorData[4*i + 2] = color[2];
+        colorData[4*i + 3] = color[3];
     }
 }
 
 void RTRenderBackend::setLineRadius(float lineRadius) {
-    // TODO: Adapt the line radius (and ignore this function call for triangle meshes).
-    // std::cout << "nodes size " << Tube.nodes.size() << "\n";
-    // std::cout << "link size " << Tube.links.size() << "\n";
-    for(int i = 0; i < Tube.nodes.size(); ++i){
-        Tube.nodes[i].radius = lineRadius;
+    // The radius is also remembered for the next call of loadTrajectories (ignored for triangle meshes).
+    if (this->lineRadius == lineRadius) {
+        return;
+    }
+    this->lineRadius = lineRadius;
+    radiusChanged = true;
+
+    const int numNodes = int(nodes.size());
+    Node *nodeData = nodes.data();
+    #pragma omp parallel for
+    for(int i = 0; i < numNodes; ++i){
+        nodeData[i].radius = lineRadius;
     }
 }
 
@@ -264,116 +495,113 @@ void RTRenderBackend::recommitRadius()
     }
 
     if (use_Embree){
-        std::vector<ospcommon::vec4f> points;
-
-        for(int i = 0; i < Tube.nodes.size(); i++){
-            ospcommon::vec4f p;
-            p.x = Tube.nodes[i].position.x;
-            p.y = Tube.nodes[i].position.y;
-            p.z = Tube.nodes[i].position.z;
-            p.w = Tube.nodes[i].radius;
-            points.push_back(p);
+        const int numNodes = int(nodes.size());
+        std::vector<ospcommon::vec4f> points(numNodes);
+        #pragma omp parallel for
+        for(int i = 0; i < numNodes; i++){
+            const Node &node = nodes[i];
+            points[i] = ospcommon::vec4f(node.position.x, node.position.y, node.position.z, node.radius);
         }
         OSPData pointsData  = ospNewData(points.size(), OSP_FLOAT4, points.data());
         ospSetData(tubeGeo, "vertex", pointsData);
         ospCommit(tubeGeo);
         ospCommit(world);
     } else {
-        if (needSplit) {
-            for (int i = 0; i < index.size(); i++) {
-                int start,end;
-                if (i == index.size() - 1) {
-                    start = index[i];
-                    end = Tube.links.size() - 1;
-                } else {
-                    start = index[i];
-                    end = index[i+1] - 1;
-                }
-                auto first_node = Tube.nodes.begin() + start;
-                auto last_node = Tube.nodes.begin() + end + 1;
-                std::vector<Node> sub_nodes(first_node, last_node);  
-                OSPData nodeData   = ospNewData(sub_nodes.size() * sizeof(Node), OSP_RAW, sub_nodes.data());
-                ospCommit(nodeData);
-
-                if (i == 0) {
-                    ospSetData(tubeGeo, "nodeData", nodeData);
-                    ospCommit(tubeGeo);
-                } else {
-                    ospSetData(tubeGeo1, "nodeData", nodeData);
-                    ospCommit(tubeGeo1);
-                }            
-            }
-            ospCommit(world);
-        } else {
-            OSPData nodeData = ospNewData(Tube.nodes.size() * sizeof(Node), OSP_RAW, Tube.nodes.data());
-            ospSetData(tubeGeo, "nodeData", nodeData);
-            ospCommit(tubeGeo);
-            ospCommit(world);
+        // The node arrays are shared with OSPRay and were already updated in place by setLineRadius.
+        for (OSPGeometry partitionGeometry : partitionGeometries) {
+            ospCommit(partitionGeometry);
         }
+        // The radius changes the bounds of the tubes, thus the acceleration structures need to be rebuilt.
+        for (OSPModel partitionModel : partitionModels) {
+            ospCommit(partitionModel);
+        }
+        ospCommit(world);
     }
 }
 
 void RTRenderBackend::recommitColor()
 {
+    // The color arrays are shared with OSPRay and were already updated in place by setTransferFunction. The colors
+    // don't influence the acceleration structures, thus only the geometries need to be committed again.
     if (isTriangles) {
-        OSPData colorsData  = ospNewData(triangleMesh.vertexColors.size(), OSP_FLOAT4, triangleMesh.vertexColors.data());
-        ospSetData(triangleGeo, "vertex.color", colorsData);
         ospCommit(triangleGeo);
-        ospCommit(world);
+    } else if (use_Embree) {
+        ospCommit(tubeGeo);
     } else {
-        if(use_Embree){
-            std::vector<ospcommon::vec4f> colors;
-            for(int i = 0; i < Tube.nodes.size(); i++){
-                ospcommon::vec4f c;
-                c.x = Tube.colors[i].x;
-                c.y = Tube.colors[i].y;
-                c.z = Tube.colors[i].z;
-                c.w = Tube.colors[i].w;
-                colors.push_back(c);
-            }
-            OSPData colorsData  = ospNewData(colors.size(), OSP_FLOAT4, colors.data());
-            ospSetData(tubeGeo, "vertex.color", colorsData);
-            ospCommit(tubeGeo);
-            ospCommit(world);
+        for (OSPGeometry partitionGeometry : partitionGeometries) {
+            ospCommit(partitionGeometry);
+        }
+    }
+}
+
+void RTRenderBackend::releaseTubePartitions()
+{
+    for (OSPGeometry partitionGeometry : partitionGeometries) {
+        ospRelease(partitionGeometry);
+    }
+    for (OSPModel partitionModel : partitionModels) {
+        ospRelease(partitionModel);
+    }
+    partitionGeometries.clear();
+    partitionModels.clear();
+}
+
+void RTRenderBackend::commitTubePartitions()
+{
+    releaseTubePartitions();
+    const size_t numPartitions = getNumPartitions();
+    const osp::affine3f identityTransform = {
+            { { 1.0f, 0.0f, 0.0f }, { 0.0f, 1.0f, 0.0f }, { 0.0f, 0.0f, 1.0f } }, { 0.0f, 0.0f, 0.0f } };
+
+    for (size_t i = 0; i < numPartitions; i++) {
+        const size_t start = nodePartitionOffsets[i];
+        const size_t numNodes = nodePartitionOffsets[i + 1] - start;
+
+        // The links are stored relative to the start of their partition, thus all arrays (possibly memory-mapped
+        // from the scene cache) can be shared with OSPRay without creating a copy.
+        OSPData nodeData = ospNewData(
+                numNodes * sizeof(Node), OSP_RAW, nodes.data() + start, OSP_DATA_SHARED_BUFFER);
+        OSPData linkData = ospNewData(
+                numNodes * sizeof(Link), OSP_RAW, links.data() + start, OSP_DATA_SHARED_BUFFER);
+        OSPData colorData = ospNewData(
+                numNodes * sizeof(ospcommon::vec4f), OSP_RAW, Tube.colors.data() + start, OSP_DATA_SHARED_BUFFER);
+        ospCommit(nodeData);
+        ospCommit(linkData);
+        ospCommit(colorData);
+
+        OSPGeometry partitionGeometry = ospNewGeometry("tubes");
+        ospSetData(partitionGeometry, "nodeData", nodeData);
+        ospSetData(partitionGeometry, "linkData", linkData);
+        ospSetData(partitionGeometry, "colorData", colorData);
+        ospCommit(partitionGeometry);
+        ospRelease(nodeData);
+        ospRelease(linkData);
+        ospRelease(colorData);
+        partitionGeometries.push_back(partitionGeometry);
+
+        if (numPartitions == 1) {
+            ospAddGeometry(world, partitionGeometry);
         } else {
-            if (needSplit) {
-                for (int i = 0; i < index.size(); i++) {
-                    int start,end;
-                    if (i == index.size() - 1) {
-                        start = index[i];
-                        end = Tube.links.size() - 1;
-                    } else {
-                        start = index[i];
-                        end = index[i+1] - 1;
-                    }
-                    auto first_color = Tube.colors.begin() + start;
-                    auto last_color = Tube.colors.begin() + end + 1;
-                    std::vector<ospcommon::vec4f> sub_colors(first_color, last_color);
-                    OSPData colorData   = ospNewData(sub_colors.size() * sizeof(ospcommon::vec4f), OSP_RAW, sub_colors.data());
-                    ospCommit(colorData);
-
-                    if (i == 0) {
-                        ospSetData(tubeGeo, "colorData", colorData);
-                        ospCommit(tubeGeo);
-                    } else {
-                        ospSetData(tubeGeo1, "colorData", colorData);
-                        ospCommit(tubeGeo1);
-                    }
-                }
-                ospCommit(world);
-            } else {
-                OSPData colorData   = ospNewData(Tube.colors.size() * sizeof(ospcommon::vec4f), OSP_RAW, Tube.colors.data());
-                ospSetData(tubeGeo, "colorData", colorData);
-                ospCommit(tubeGeo);
-                ospCommit(world);
-            }
+            // Each partition gets its own acceleration structure, the world only stores the instances.
+            OSPModel partitionModel = ospNewModel();
+            ospAddGeometry(partitionModel, partitionGeometry);
+            ospCommit(partitionModel);
+            partitionModels.push_back(partitionModel);
+            OSPGeometry instance = ospNewInstance(partitionModel, identityTransform);
+            ospCommit(instance);
+            ospAddGeometry(world, instance);
+            ospRelease(instance);
         }
     }
 }
 
-void RTRenderBackend::commitToOSPRay(const glm::vec3 &pos, const glm::vec3 &dir, const glm::vec3 &up, const float fovy)
+void RTRenderBackend::commitWorld()
 {
+    if (world != NULL) {
+        ospRelease(world);
+    }
     world = ospNewModel();
+    radiusChanged = false;
 
     if (isTriangles) {
         std::cout << "Using triangle mesh" << "\n";
@@ -384,7 +612,9 @@ void RTRenderBackend::commitToOSPRay(const glm::vec3 &pos, const glm::vec3 &dir,
 
         OSPData vertexData  = ospNewData(triangleMesh.vertices.size(), OSP_FLOAT3, triangleMesh.vertices.data());
         OSPData normalData  = ospNewData(triangleMesh.vertexNormals.size(), OSP_FLOAT3, triangleMesh.vertexNormals.data());
-        OSPData colorData  = ospNewData(triangleMesh.vertexColors.size(), OSP_FLOAT4, triangleMesh.vertexColors.data());
+        OSPData colorData  = ospNewData(
+                triangleMesh.vertexColors.size(), OSP_FLOAT4, triangleMesh.vertexColors.data(),
+                OSP_DATA_SHARED_BUFFER);
         OSPData indexData  = ospNewData(triangleMesh.indices.size(), OSP_INT, triangleMesh.indices.data());
         ospSetData(triangleGeo, "vertex", vertexData);
         ospSetData(triangleGeo, "vertex.normal", normalData);
@@ -404,160 +634,42 @@ void RTRenderBackend::commitToOSPRay(const glm::vec3 &pos, const glm::vec3 &dir,
         std::cout << "====================================== " << "\n";
     } else {
         if (!use_Embree) {
-            if (needSplit) {
-                // separate into two geometris
-                // Now is hardcoded for turbulence data set
-                // ! tubeGeo
-                tubeGeo = ospNewGeometry("tubes");
-                tubeGeo1 = ospNewGeometry("tubes");
-                //! Construct Links first
-                int count = 0;
-                for(int i = 0; i < Tube.links.size(); i++){
-                    int first = Tube.links[i].first;
-                    int second = Tube.links[i].second;
-                    if(first == second){
-                        count++;
-                    }
-                    if(count == threshold + 1){
-                        index.push_back(i);
-                        count = 1;
-                    }
-                }
-                for(int i = 0; i < index.size(); i++){
-                    int start,end;
-                    if(i == index.size() - 1){
-                        start = index[i];
-                        end = Tube.links.size() - 1;
-                    }else{
-                        start = index[i];
-                        end = index[i+1] - 1;
-                    }
-
-                    auto first_link = Tube.links.begin() + start;
-                    auto last_link = Tube.links.begin() + end + 1;
-                    std::vector<Link> sub_links(first_link, last_link);
-                    for(int j = 0; j < sub_links.size(); j++){
-                        int first = sub_links[j].first;
-                        int second = sub_links[j].second;
-                        if(first == second){
-                            sub_links[j].first = j;
-                            sub_links[j].second = j;
-                        }else{
-                            sub_links[j].first = j;
-                            sub_links[j].second = j - 1;
-                        }
-                    }
-
-                    auto first_node = Tube.nodes.begin() + start;
-                    auto last_node = Tube.nodes.begin() + end + 1;
-                    std::vector<Node> sub_nodes(first_node, last_node);
-                    auto first_color = Tube.colors.begin() + start;
-                    auto last_color = Tube.colors.begin() + end + 1;
-                    std::vector<ospcommon::vec4f> sub_colors(first_color, last_color);
-                    OSPData nodeData = ospNewData(sub_nodes.size() * sizeof(Node), OSP_RAW, sub_nodes.data());
-                    OSPData linkData   = ospNewData(sub_links.size() * sizeof(Link), OSP_RAW, sub_links.data());
-                    OSPData colorData   = ospNewData(sub_colors.size() * sizeof(ospcommon::vec4f), OSP_RAW, sub_colors.data());
-                    ospCommit(nodeData);
-                    ospCommit(linkData);
-                    ospCommit(colorData);
-
-                    // OSPMaterial materialList = ospNewMaterial2("scivis", "OBJMaterial");
-                    // ospCommit(materialList);
-
-                    if(i == 0){
-                        ospSetData(tubeGeo, "nodeData", nodeData);
-                        ospSetData(tubeGeo, "linkData", linkData);
-                        ospSetData(tubeGeo, "colorData", colorData);
-                        // ospSetMaterial(tubeGeo, materialList);
-                        ospCommit(tubeGeo);
-                    }else{
-                        ospSetData(tubeGeo1, "nodeData", nodeData);
-                        ospSetData(tubeGeo1, "linkData", linkData);
-                        ospSetData(tubeGeo1, "colorData", colorData);
-                        // ospSetMaterial(tubeGeo1, materialList);
-                        ospCommit(tubeGeo1);
-                    }
-                }
-                ospAddGeometry(world, tubeGeo);
-                ospAddGeometry(world, tubeGeo1);
-                ospRelease(tubeGeo); // we are done using this handle
-                ospRelease(tubeGeo1);
-                size_t before = getUsedSystemMemoryBytes();
-                ospCommit(world);
-                size_t after = getUsedSystemMemoryBytes();
-                std::cout << "====================================== " << "\n";
-                std::cout << "              MEMORY USAGE             " << std::endl;
-                std::cout << " Before : " << before << " After: " << after << std::endl;
-                std::cout << " Used: " << after - before << std::endl;
-                std::cout << "====================================== " << "\n";
-
-            } else {
-                tubeGeo = ospNewGeometry("tubes");
-                OSPData nodeData = ospNewData(Tube.nodes.size() * sizeof(Node), OSP_RAW, Tube.nodes.data());
-                OSPData linkData   = ospNewData(Tube.links.size() * sizeof(Link), OSP_RAW, Tube.links.data());
-                OSPData colorData   = ospNewData(Tube.colors.size() * sizeof(ospcommon::vec4f), OSP_RAW, Tube.colors.data());
-                ospCommit(nodeData);
-                ospCommit(linkData);
-                ospCommit(colorData);
-
-                // initializedColorData = true;
-
-                OSPMaterial materialList = ospNewMaterial2("scivis", "OBJMaterial");
-                ospCommit(materialList);
-
-                ospSetData(tubeGeo, "nodeData", nodeData);
-                ospSetData(tubeGeo, "linkData", linkData);
-                ospSetData(tubeGeo, "colorData", colorData);
-                // ospSetMaterial(tubeGeo, materialList);
-                ospCommit(tubeGeo);
-
-                // ! Add tubeGeo to the world
-                ospAddGeometry(world, tubeGeo);
-                ospRelease(tubeGeo); // we are done using this handle
-
-                size_t before = getUsedSystemMemoryBytes();
-                ospCommit(world);
-                size_t after = getUsedSystemMemoryBytes();
-                std::cout << "====================================== " << "\n";
-                std::cout << "              MEMORY USAGE             " << std::endl;
-                std::cout << " Before : " << before << " After: " << after << std::endl;
-                std::cout << " Used: " << after - before << std::endl;
-                std::cout << "====================================== " << "\n";
-
-            }
+            commitTubePartitions();
+            size_t before = getUsedSystemMemoryBytes();
+            ospCommit(world);
+            size_t after = getUsedSystemMemoryBytes();
+            std::cout << "====================================== " << "\n";
+            std::cout << "              MEMORY USAGE             " << std::endl;
+            std::cout << " Before : " << before << " After: " << after << std::endl;
+            std::cout << " Used: " << after - before << std::endl;
+            std::cout << "====================================== " << "\n";
         } else {
             std::cout << "Using Embree Streamlines" << "\n";
             tubeGeo = ospNewGeometry("streamlines");
-            std::vector<ospcommon::vec4f> points;
+            const int numNodes = int(nodes.size());
+            std::vector<ospcommon::vec4f> points(numNodes);
             std::vector<int> indices;
-            std::vector<ospcommon::vec4f> colors;
-
-            for (int i = 0; i < Tube.nodes.size(); i++) {
-                ospcommon::vec4f p;
-                p.x = Tube.nodes[i].position.x;
-                p.y = Tube.nodes[i].position.y;
-                p.z = Tube.nodes[i].position.z;
-                p.w = Tube.nodes[i].radius;
-                points.push_back(p);
-                ospcommon::vec4f c;
-                c.x = Tube.colors[i].x;
-                c.y = Tube.colors[i].y;
-                c.z = Tube.colors[i].z;
-                c.w = Tube.colors[i].w;
-                colors.push_back(c);
+            indices.reserve(links.size());
+
+            #pragma omp parallel for
+            for (int i = 0; i < numNodes; i++) {
+                const Node &node = nodes[i];
+                points[i] = ospcommon::vec4f(node.position.x, node.position.y, node.position.z, node.radius);
             }
-            for (int i = 0; i < Tube.links.size() - 1; i++) {
-                int first = Tube.links[i].first;
-                int second = Tube.links[i].second;
+            // Node i is the first node of a line iff it links to itself (the links are relative to the partition).
+            for (int i = 0; i < numNodes - 1; i++) {
+                int first = links[i].first;
+                int second = links[i].second;
                 if(first == second && i != 0){
                     indices.pop_back();
                 }
-                indices.push_back(first);
+                indices.push_back(i);
             }
 
             OSPData pointsData  = ospNewData(points.size(), OSP_FLOAT4, points.data());
             OSPData indicesData = ospNewData(indices.size(), OSP_INT, indices.data());
-            OSPData colorsData  = ospNewData(colors.size(), OSP_FLOAT4, colors.data());
+            OSPData colorsData  = ospNewData(
+                    Tube.colors.size(), OSP_FLOAT4, Tube.colors.data(), OSP_DATA_SHARED_BUFFER);
             ospSetData(tubeGeo, "vertex", pointsData);
             ospSetData(tubeGeo, "index", indicesData);
             ospSetData(tubeGeo, "vertex.color", colorsData);
@@ -575,7 +687,11 @@ void RTRenderBackend::commitToOSPRay(const glm::vec3 &pos, const glm::vec3 &dir,
             std::cout << "====================================== " << "\n";
         }
     }
+}
 
+void RTRenderBackend::commitToOSPRay(const glm::vec3 &pos, const glm::vec3 &dir, const glm::vec3 &up, const float fovy)
+{
+    commitWorld();
 
     renderer = ospNewRenderer("scivis");
     //! lighting
@@ -597,6 +713,8 @@ void RTRenderBackend::commitToOSPRay(const glm::vec3 &pos, const glm::vec3 &dir,
     OSPData lights = ospNewData(light_list.size(), OSP_OBJECT, light_list.data());
     ospCommit(lights);
 
+    resetAccumulation();
+
     camera = ospNewCamera("perspective");
     float camPos[] = {pos.x, pos.y, pos.z};
     float camDir[] = {dir.x, dir.y, dir.z};
@@ -622,27 +740,90 @@ void RTRenderBackend::commitToOSPRay(const glm::vec3 &pos, const glm::vec3 &dir,
     ospCommit(renderer);
 }
 
+void RTRenderBackend::copyFramebufferToImage(OSPFrameBuffer sourceFramebuffer, int sourceScale) {
+    std::vector<uint32_t> &backImage = images[1 - frontImageIndex];
+    const uint32_t *fb = (const uint32_t*)ospMapFrameBuffer(sourceFramebuffer, OSP_FB_COLOR);
+    if (sourceScale <= 1) {
+        memcpy(backImage.data(), fb, sizeof(uint32_t) * width * height);
+    } else {
+        // Nearest-neighbor upscaling of the preview image rendered at a lower resolution.
+        const int sourceWidth = (width + sourceScale - 1) / sourceScale;
+        #pragma omp parallel for
+        for (int y = 0; y < height; y++) {
+            const uint32_t *sourceRow = fb + (y / sourceScale) * sourceWidth;
+            uint32_t *destinationRow = backImage.data() + y * width;
+            for (int x = 0; x < width; x++) {
+                destinationRow[x] = sourceRow[x / sourceScale];
+            }
+        }
+    }
+    ospUnmapFrameBuffer(fb, sourceFramebuffer);
+    frontImageIndex = 1 - frontImageIndex;
+}
+
+void RTRenderBackend::renderLowResolutionPreview() {
+    if (lowResolutionFramebuffer == NULL || lowResolutionFramebufferScale != lowResolutionScale) {
+        if (lowResolutionFramebuffer != NULL) {
+            ospRelease(lowResolutionFramebuffer);
+        }
+        const int lowResolutionWidth = (width + lowResolutionScale - 1) / lowResolutionScale;
+        const int lowResolutionHeight = (height + lowResolutionScale - 1) / lowResolutionScale;
+        lowResolutionFramebuffer = ospNewFrameBuffer(
+                osp::vec2i{lowResolutionWidth, lowResolutionHeight}, OSP_FB_SRGBA, OSP_FB_COLOR);
+        lowResolutionFramebufferScale = lowResolutionScale;
+    }
+
+    auto start = std::chrono::high_resolution_clock::now();
+    ospRenderFrame(lowResolutionFramebuffer, renderer, OSP_FB_COLOR);
+    auto end = std::chrono::high_resolution_clock::now();
+    copyFramebufferToImage(lowResolutionFramebuffer, lowResolutionScale);
+
+    // Adapt the resolution of the next preview frame to the frame time budget. Decreasing the scale by one at least
+    // doubles the number of pixels, thus only do this if there is enough headroom.
+    const double frameTimeMS = std::chrono::duration<double, std::milli>(end - start).count();
+    if (frameTimeMS > frameTimeBudgetMS && lowResolutionScale < MAX_LOW_RESOLUTION_SCALE) {
+        lowResolutionScale++;
+    } else if (frameTimeMS < 0.25 * frameTimeBudgetMS && lowResolutionScale > 1) {
+        lowResolutionScale--;
+    }
+}
+
+void RTRenderBackend::refineProgressively() {
+    auto frameStart = std::chrono::high_resolution_clock::now();
+    double elapsedMS = 0.0, lastPassMS = 0.0;
+    do {
+        auto passStart = std::chrono::high_resolution_clock::now();
+        currentVariance = ospRenderFrame(framebuffer, renderer, OSP_FB_COLOR | OSP_FB_ACCUM | OSP_FB_VARIANCE);
+        numAccumulatedFrames++;
+        auto passEnd = std::chrono::high_resolution_clock::now();
+        lastPassMS = std::chrono::duration<double, std::milli>(passEnd - passStart).count();
+        elapsedMS = std::chrono::duration<double, std::milli>(passEnd - frameStart).count();
+
+        // OSPRay estimates the variance by comparing the even and odd accumulated frames.
+        if (numAccumulatedFrames >= 2 && currentVariance < varianceThreshold) {
+            isConverged = true;
+            timeToConvergedMS = std::chrono::duration<double, std::milli>(passEnd - accumulationStartTime).count();
+            break;
+        }
+    } while (elapsedMS + lastPassMS <= frameTimeBudgetMS);
+    copyFramebufferToImage(framebuffer, 1);
+}
+
 uint32_t *RTRenderBackend::renderToImage(
         const glm::vec3 &pos, const glm::vec3 &dir, const glm::vec3 &up, const float fovy, float radius, bool changeTFN) {
     /**
-     * TODO: Write to the image (RGBA32, pre-multiplied alpha, sRGB).
-     * For internal computations, linear RGB is used. The values need to be converted to sRGB before writing to the
-     * image. For this, the following function can be used:
-     * TransferFunctionWindow::linearRGBTosRGB(glm::vec3(...))
+     * The image is stored in RGBA32 format (pre-multiplied alpha, sRGB). The framebuffer is copied to an image owned
+     * by the backend, as the mapped framebuffer must not be accessed after ospUnmapFrameBuffer. The images are
+     * double-buffered, i.e., the returned pointer stays valid until the next call of this function returns.
      */
-    //  if(changeTFN){
-    //     std::cout << "!!!! Here Here Here Transfer Function Changed !!!! " << "\n";
-    //  }
-
+    bool sceneChanged = false;
     if(changeTFN){
-        ospFrameBufferClear(framebuffer, OSP_FB_COLOR | OSP_FB_ACCUM);
         recommitColor();
+        sceneChanged = true;
     }
 
-
-
-    if(camera_dir != dir || camera_pos != pos || camera_up != up){
-        ospFrameBufferClear(framebuffer, OSP_FB_COLOR | OSP_FB_ACCUM);
+    const bool cameraChanged = camera_dir != dir || camera_pos != pos || camera_up != up;
+    if(cameraChanged){
         float camPos[] = {pos.x, pos.y, pos.z};
         float camDir[] = {dir.x, dir.y, dir.z};
         float camUp[] = {up.x, up.y, up.z};
@@ -653,29 +834,31 @@ uint32_t *RTRenderBackend::renderToImage(
         ospSet3fv(camera, "up", camUp);
         ospCommit(camera);
     }
-    if(lineRadius != radius){
-        ospFrameBufferClear(framebuffer, OSP_FB_COLOR | OSP_FB_ACCUM);
+    setLineRadius(radius);
+    if(radiusChanged){
         recommitRadius();
+        radiusChanged = false;
+        sceneChanged = true;
     }
 
-    // auto t1 = std::chrono::high_resolution_clock::now();
-
-    ospRenderFrame(framebuffer, renderer, OSP_FB_COLOR| OSP_FB_ACCUM);
-    // auto t2 = std::chrono::high_resolution_clock::now();
-    // auto dur = std::chrono::duration<double>(t2 - t1);
-    // std::cout << "fps =  " <<  1 / dur.count()<< " fps" << std::endl;
-
-    uint32_t * fb = (uint32_t*)ospMapFrameBuffer(framebuffer, OSP_FB_COLOR);
-
-    // image.insert(image.begin(), fb, fb + width * height * 4);
-
-    ospUnmapFrameBuffer(fb, framebuffer);
-
     camera_dir = dir;
     camera_up = up;
     camera_pos = pos;
-    lineRadius = radius;
 
+    if (cameraChanged || sceneChanged) {
+        resetAccumulation();
+    }
+
+    if (!progressiveRendering) {
+        ospRenderFrame(framebuffer, renderer, OSP_FB_COLOR | OSP_FB_ACCUM);
+        numAccumulatedFrames++;
+        copyFramebufferToImage(framebuffer, 1);
+    } else if (cameraChanged) {
+        // Interactive preview while the camera moves. Refinement starts once it stops.
+        renderLowResolutionPreview();
+    } else if (!isConverged) {
+        refineProgressively();
+    }
 
-    return fb;
+    return images[frontImageIndex].data();
 }
@@ -32,6 +32,10 @@
 #include "../TransferFunctionWindow.hpp"
 #include "../Utils/ImportanceCriteria.hpp"
 #include "../Utils/TrajectoryFile.hpp"
+#include "../Utils/LinePartitioning.hpp"
+#include "../Utils/MappedFile.hpp"
+
+#include <chrono>
 
 #include "ospray/ospray.h"
 #include "ospray/ospcommon/vec.h"
@@ -43,6 +47,7 @@ struct Node
     float radius;
 };
 
+/// The node indices are relative to the start of the partition the link belongs to.
 struct Link
 {
     int first;
@@ -79,13 +84,36 @@ public:
 
     /**
      * This function loads trajectories (i.e., line datasets) and converts them to an internal representation.
-     * (The internal representation could in theory also be cached in a file.)
      * @param filename The filename of the trajectory dataset.
      * @param trajectories The trajectories to load.
      */
-
     void loadTrajectories(const std::string &filename, const Trajectories &trajectories);
 
+    /**
+     * Like loadTrajectories, but the internal representation is cached in a file in the asset cache (next to the
+     * converted .binmesh files). If the cached file exists, it is memory-mapped and passed to OSPRay without copying,
+     * i.e., neither the trajectory file needs to be loaded nor the conversion needs to be run.
+     * @return False if the trajectory file could not be loaded.
+     */
+    bool loadTrajectoriesCached(const std::string &filename, TrajectoryType trajectoryType);
+
+    /**
+     * Writes the nodes, links, attribute indices and partition boundaries of the loaded trajectories to a file
+     * (format see RTRenderBackend.cpp). The colors are not stored, as they are recomputed from the attribute indices
+     * when setting the transfer function.
+     */
+    bool writeSceneCache(const std::string &filename) const;
+    /// Maps a file written by writeSceneCache. Returns false if it doesn't exist or is malformed.
+    bool loadSceneCache(const std::string &filename);
+
+    /**
+     * The lines are split into spatially coherent partitions (see partitionLinesMorton) with approximately this
+     * number of tube nodes. Each partition is committed as a separate OSPRay geometry in its own instanced model.
+     * Needs to be set before calling loadTrajectories.
+     */
+    void setTargetPrimitivesPerPartition(size_t numPrimitives);
+    inline size_t getNumPartitions() const { return nodePartitionOffsets.size() - 1; }
+
     /**
      * The data is stored as a list of triangles, i.e., the vertices referenced by three consecutive indices form one
      * triangle.
@@ -121,6 +149,9 @@ public:
 
     void commitToOSPRay(const glm::vec3 &pos, const glm::vec3 &dir, const glm::vec3 &up, const float fovy);
 
+    /// Creates and commits the OSPRay model of the loaded data (called by commitToOSPRay).
+    void commitWorld();
+
 
     /**
      * Renders the scene to an image in RGBA32 format.
@@ -136,42 +167,93 @@ public:
             const glm::vec3 &pos, const glm::vec3 &dir, const glm::vec3 &up,
             const float fovy, float radius, bool changeTFN);
 
+    /**
+     * Progressive rendering: While the camera moves, a preview is rendered at a lower resolution that is adapted to
+     * the frame time budget. Afterwards, each call of renderToImage accumulates as many samples per pixel as fit into
+     * the budget until the variance estimate of the accumulated image drops below the threshold.
+     */
+    void setProgressiveRendering(bool progressive);
+    void setFrameTimeBudget(float budgetMS);
+    void setVarianceThreshold(float threshold);
+    /// Restarts the accumulation and the convergence tracking (e.g., for measuring the time to convergence).
+    void resetAccumulation();
+    inline bool getIsConverged() const { return isConverged; }
+    inline float getVariance() const { return currentVariance; }
+    inline int getNumAccumulatedFrames() const { return numAccumulatedFrames; }
+    inline int getLowResolutionScale() const { return lowResolutionScale; }
+    /// Time from the last change of the camera or scene until the variance threshold was reached.
+    inline double getTimeToConvergedMS() const { return timeToConvergedMS; }
+
 private:
     void clearData();
+    void computeAttributeRange(const float *values, size_t numValues);
+    void commitTubePartitions();
+    void releaseTubePartitions();
+    void copyFramebufferToImage(OSPFrameBuffer sourceFramebuffer, int sourceScale);
+    void renderLowResolutionPreview();
+    void refineProgressively();
 
     // Viewport width and height.
-    int width, height;
+    int width = 0, height = 0;
 
     // Constant line radius to use for rendering (ignore for triangle meshes).
-    float lineRadius;
-
-    // The image data.
-    // std::vector<uint32_t> image;
+    float lineRadius = 0.001f;
+    // Whether the node radii changed since they were last committed to OSPRay.
+    bool radiusChanged = false;
+
+    // The image data (double-buffered, see renderToImage).
+    std::vector<uint32_t> images[2];
+    int frontImageIndex = 0;
+
+    // Progressive rendering and convergence tracking.
+    const int MAX_LOW_RESOLUTION_SCALE = 8;
+    bool progressiveRendering = false;
+    float frameTimeBudgetMS = 33.0f;
+    float varianceThreshold = 0.02f;
+    int lowResolutionScale = 2;
+    int lowResolutionFramebufferScale = 0;
+    OSPFrameBuffer lowResolutionFramebuffer = NULL;
+    int numAccumulatedFrames = 0;
+    float currentVariance = 0.0f;
+    bool isConverged = false;
+    double timeToConvergedMS = 0.0;
+    std::chrono::high_resolution_clock::time_point accumulationStartTime;
 
     // hold the data 
-    int threshold = 40000;
-    int numOfLines;
-    bool needSplit = false;
-    std::vector<int> index = {0};
     TubePrimitives Tube;
+    // The nodes, links and attribute indices of the tubes either point to the data in Tube and attributeIndices
+    // (converted by loadTrajectories) or into the writable private mapping of the scene cache (loadSceneCache).
+    ArrayView<Node> nodes;
+    ArrayView<const Link> links;
+    ArrayView<const uint16_t> nodeAttributeIndices;
+    MappedFile sceneCacheFile;
     OSPFrameBuffer framebuffer = NULL;
-    OSPModel world;
+    OSPModel world = NULL;
     OSPRenderer renderer;
     OSPCamera camera;
 
     OSPGeometry tubeGeo;
-    // if data is too large will be separate into two geometries
-    OSPGeometry tubeGeo1;
+
+    // The lines are stored in Morton order. Partition i consists of the nodes and links
+    // [nodePartitionOffsets[i], nodePartitionOffsets[i+1]) and has its own geometry and model.
+    size_t targetPrimitivesPerPartition = size_t(1) << 20;
+    std::vector<size_t> nodePartitionOffsets = { 0 };
+    std::vector<OSPGeometry> partitionGeometries;
+    std::vector<OSPModel> partitionModels;
 
     OSPGeometry triangleGeo;
     TriangleMesh triangleMesh;
 
-    bool tubeGeoUsed = false, tubeGeo1Used = false, triangleGeoUsed = false;
+    bool tubeGeoUsed = false, triangleGeoUsed = false;
 
     OSPData colorData;
     bool initializedColorData = false;
 
-    std::vector<float> attributes;
+    // The per-node attributes quantized to 16 bits relative to the attribute range of the loaded data set.
+    std::vector<uint16_t> attributeIndices;
+    float attributeMin = 0.0f, attributeMax = 0.0f;
+    // The transfer function (linear RGB and opacity) sampled at all 2^16 attribute indices.
+    std::vector<ospcommon::vec4f> colorLookupTable;
 
     glm::vec3 camera_pos;
     glm::vec3 camera_dir;
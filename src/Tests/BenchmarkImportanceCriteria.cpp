@@ -0,0 +1,140 @@
+//
+// Created by christoph on 19.10.26.
+//
+
+#include <chrono>
+#include <functional>
+#include <Utils/File/Logfile.hpp>
+#include <Utils/Convert.hpp>
+
+#include "Utils/TrajectoryFile.hpp"
+#include "Performance/CsvWriter.hpp"
+#include "BenchmarkImportanceCriteria.hpp"
+
+static double measureMilliseconds(int numIterations, std::function<void()> function)
+{
+    auto start = std::chrono::high_resolution_clock::now();
+    for (int i = 0; i < numIterations; i++) {
+        function();
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+    std::chrono::duration<double, std::milli> elapsed = end - start;
+    return elapsed.count() / numIterations;
+}
+
+static void computeReferenceCriteria(
+        std::vector<glm::vec3> &positions, std::vector<float> &attributes, std::vector<std::vector<float>> &criteria)
+{
+    criteria.clear();
+    criteria.push_back(attributes);
+    criteria.push_back(computeCurvature(positions));
+    criteria.push_back(computeSegmentLengths(positions));
+    criteria.push_back(computeSegmentAttributeDifference(positions, attributes));
+    criteria.push_back(computeTotalAttributeDifference(positions, attributes));
+    criteria.push_back(computeAngleOfAscent(positions));
+    criteria.push_back(computeSegmentHeightDifference(positions));
+}
+
+static void computeFusedCriteria(
+        const Trajectories &trajectories, size_t lineIdx, std::vector<std::vector<float>> &criteria)
+{
+    const int numCriteria = getNumImportanceCriteria(IMPORTANCE_CRITERION_BITS_ALL);
+    const size_t numPoints = trajectories.getLineNumPoints(lineIdx);
+    float *outputArrays[8];
+    criteria.resize(numCriteria);
+    for (int i = 0; i < numCriteria; i++) {
+        criteria.at(i).resize(numPoints);
+        outputArrays[i] = criteria.at(i).data();
+    }
+    computeImportanceCriteriaFused(
+            numPoints, trajectories.getLinePositions(lineIdx).data(),
+            trajectories.getLineAttribute(lineIdx, 0).data(), IMPORTANCE_CRITERION_BITS_ALL, outputArrays);
+}
+
+static void benchmarkDataSet(
+        const std::string &dataSetName, Trajectories &trajectories, int numIterations, CsvWriter &csvWriter)
+{
+    // Trajectories with less than two points are invalid for the reference implementations.
+    trajectories.removeShortLines(2);
+    const size_t numVertices = trajectories.getNumPoints();
+    const size_t numTrajectories = trajectories.size();
+
+    // The reference implementations work on one vector per trajectory.
+    std::vector<std::vector<glm::vec3>> referencePositions(numTrajectories);
+    std::vector<std::vector<float>> referenceAttributes(numTrajectories);
+    for (size_t i = 0; i < numTrajectories; i++) {
+        ArrayView<glm::vec3> positions = trajectories.getLinePositions(i);
+        ArrayView<float> attributes = trajectories.getLineAttribute(i, 0);
+        referencePositions.at(i).assign(positions.begin(), positions.end());
+        referenceAttributes.at(i).assign(attributes.begin(), attributes.end());
+    }
+
+    std::vector<std::vector<std::vector<float>>> referenceCriteria(numTrajectories);
+    std::vector<std::vector<std::vector<float>>> fusedCriteria(numTrajectories);
+
+    double timeReference = measureMilliseconds(numIterations, [&]() {
+        for (size_t i = 0; i < numTrajectories; i++) {
+            computeReferenceCriteria(
+                    referencePositions.at(i), referenceAttributes.at(i), referenceCriteria.at(i));
+        }
+    });
+    double timeFusedSerial = measureMilliseconds(numIterations, [&]() {
+        for (size_t i = 0; i < numTrajectories; i++) {
+            computeFusedCriteria(trajectories, i, fusedCriteria.at(i));
+        }
+    });
+    double timeFusedParallel = measureMilliseconds(numIterations, [&]() {
+        #pragma omp parallel for schedule(dynamic, 64)
+        for (size_t i = 0; i < numTrajectories; i++) {
+            computeFusedCriteria(trajectories, i, fusedCriteria.at(i));
+        }
+    });
+
+    // Validate the fused kernel against the reference implementations.
+    float maxError = 0.0f;
+    for (size_t i = 0; i < numTrajectories; i++) {
+        for (size_t c = 0; c < referenceCriteria.at(i).size(); c++) {
+            const std::vector<float> &reference = referenceCriteria.at(i).at(c);
+            const std::vector<float> &fused = fusedCriteria.at(i).at(c);
+            for (size_t j = 0; j < reference.size(); j++) {
+                maxError = std::max(maxError, std::abs(reference.at(j) - fused.at(j)));
+            }
+        }
+    }
+
+    sgl::Logfile::get()->writeInfo(std::string() + "Importance criteria benchmark (" + dataSetName + ", "
+            + sgl::toString(numTrajectories) + " trajectories, " + sgl::toString(numVertices) + " vertices): "
+            + "reference " + sgl::toString(timeReference) + "ms, "
+            + "fused serial " + sgl::toString(timeFusedSerial) + "ms, "
+            + "fused parallel " + sgl::toString(timeFusedParallel) + "ms, "
+            + "max. error " + sgl::toString(maxError));
+    csvWriter.writeRow({
+            dataSetName, sgl::toString(numTrajectories), sgl::toString(numVertices), sgl::toString(timeReference),
+            sgl::toString(timeFusedSerial), sgl::toString(timeFusedParallel), sgl::toString(maxError)});
+}
+
+int benchmarkImportanceCriteria(const std::vector<std::string> &args)
+{
+    int numIterations = args.size() > 0 ? sgl::fromString<int>(args.at(0)) : 10;
+    std::string aneurysmFilename = args.size() > 1 ? args.at(1) : "Data/Trajectories/9213_streamlines.obj";
+    std::string wcbFilename = args.size() > 2 ? args.at(2)
+            : "Data/WCB/EUR_LL10/20121015_00_lagranto_ensemble_forecast__START_20121017_06.nc";
+
+    CsvWriter csvWriter("benchmark_importance_criteria.csv");
+    csvWriter.writeRow({"Data Set", "Trajectories", "Vertices", "Reference (ms)", "Fused Serial (ms)",
+                        "Fused Parallel (ms)", "Max. Error"});
+
+    Trajectories aneurysmTrajectories = loadTrajectoriesFromFile(aneurysmFilename, TRAJECTORY_TYPE_ANEURYSM);
+    if (aneurysmTrajectories.empty()) {
+        return 1;
+    }
+    benchmarkDataSet("Aneurysm", aneurysmTrajectories, numIterations, csvWriter);
+
+    Trajectories wcbTrajectories = loadTrajectoriesFromFile(wcbFilename, TRAJECTORY_TYPE_WCB);
+    if (wcbTrajectories.empty()) {
+        return 1;
+    }
+    benchmarkDataSet("WCB", wcbTrajectories, numIterations, csvWriter);
+
+    return 0;
+}
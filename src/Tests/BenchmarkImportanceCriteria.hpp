@@ -0,0 +1,19 @@
+//
+// Created by christoph on 19.10.26.
+//
+
+#ifndef PIXELSYNCOIT_BENCHMARKIMPORTANCECRITERIA_HPP
+#define PIXELSYNCOIT_BENCHMARKIMPORTANCECRITERIA_HPP
+
+#include <string>
+#include <vector>
+
+/**
+ * Compares the reference importance criteria implementations (one pass per criterion) with the fused kernel
+ * (serial and parallel over trajectories) on the aneurysm and WCB data sets. All criteria are computed.
+ * Arguments (optional): [numIterations] [aneurysmFilename] [wcbFilename]
+ * The timings are written to the log file and to "benchmark_importance_criteria.csv".
+ */
+int benchmarkImportanceCriteria(const std::vector<std::string> &args);
+
+#endif //PIXELSYNCOIT_BENCHMARKIMPORTANCECRITERIA_HPP
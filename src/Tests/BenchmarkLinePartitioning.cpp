@@ -0,0 +1,79 @@
+//
+// Created by christoph on 19.10.26.
+//
+
+#include <Utils/File/Logfile.hpp>
+#include <Utils/File/FileUtils.hpp>
+#include <Utils/Convert.hpp>
+
+#include "Utils/TrajectoryFile.hpp"
+#include "Utils/LinePartitioning.hpp"
+#include "Performance/CsvWriter.hpp"
+#ifdef USE_RAYTRACING
+#include "Raytracing/RTRenderBackend.hpp"
+#endif
+#include "MainApp.hpp"
+#include "BenchmarkUtils.hpp"
+#include "BenchmarkLinePartitioning.hpp"
+
+int benchmarkLinePartitioning(const std::vector<std::string> &args)
+{
+    std::string dataSetFilename = args.size() > 0 ? args.at(0) : "Data/ConvectionRolls/turbulence80000.obj";
+    size_t maxNumPartitions = args.size() > 1 ? sgl::fromString<size_t>(args.at(1)) : 64;
+
+    TrajectoryType trajectoryType = PixelSyncApp::getTrajectoryTypeFromFilename(
+            sgl::FileUtils::get()->removeExtension(dataSetFilename));
+    Trajectories trajectories = loadTrajectoriesFromFile(dataSetFilename, trajectoryType);
+    if (trajectories.empty()) {
+        return 1;
+    }
+    const size_t numPoints = trajectories.getNumPoints();
+
+#ifdef USE_RAYTRACING
+    int argc = 1;
+    const char *argv[] = { "PixelSyncOIT" };
+    if (ospInit(&argc, argv) != OSP_NO_ERROR) {
+        sgl::Logfile::get()->writeError("Error in benchmarkLinePartitioning: Could not initialize OSPRay.");
+        return 1;
+    }
+    ospLoadModule("tubes");
+    RTRenderBackend renderBackend(false);
+#endif
+
+    CsvWriter csvWriter("benchmark_line_partitioning.csv");
+    csvWriter.writeRow({"Target Partitions", "Partitions", "Partitioning (ms)", "Surface Area Ratio",
+                        "Tube Conversion (ms)", "OSPRay Build (ms)"});
+
+    for (size_t targetNumPartitions = 1; targetNumPartitions <= maxNumPartitions; targetNumPartitions *= 2) {
+        const size_t targetPointsPerPartition = (numPoints + targetNumPartitions - 1) / targetNumPartitions;
+        LinePartitioning partitioning;
+        double timePartitioning = measureBestMilliseconds([&]() {
+            partitionLinesMorton(trajectories, targetPointsPerPartition, partitioning);
+        });
+        float surfaceAreaRatio = computePartitionSurfaceAreaRatio(trajectories, partitioning);
+
+        double timeConversion = 0.0, timeBuild = 0.0;
+#ifdef USE_RAYTRACING
+        renderBackend.setTargetPrimitivesPerPartition(targetPointsPerPartition);
+        timeConversion = measureMilliseconds([&]() {
+            renderBackend.loadTrajectories(dataSetFilename, trajectories);
+        });
+        timeBuild = measureMilliseconds([&]() {
+            renderBackend.commitWorld();
+        });
+#endif
+
+        sgl::Logfile::get()->writeInfo(std::string() + "Line partitioning benchmark ("
+                + sgl::toString(partitioning.getNumPartitions()) + " partitions): "
+                + "partitioning " + sgl::toString(timePartitioning) + "ms, "
+                + "surface area ratio " + sgl::toString(surfaceAreaRatio) + ", "
+                + "tube conversion " + sgl::toString(timeConversion) + "ms, "
+                + "OSPRay build " + sgl::toString(timeBuild) + "ms");
+        csvWriter.writeRow({
+                sgl::toString(targetNumPartitions), sgl::toString(partitioning.getNumPartitions()),
+                sgl::toString(timePartitioning), sgl::toString(surfaceAreaRatio),
+                sgl::toString(timeConversion), sgl::toString(timeBuild)});
+    }
+
+    return 0;
+}
@@ -0,0 +1,21 @@
+//
+// Created by christoph on 19.10.26.
+//
+
+#ifndef PIXELSYNCOIT_BENCHMARKLINEPARTITIONING_HPP
+#define PIXELSYNCOIT_BENCHMARKLINEPARTITIONING_HPP
+
+#include <string>
+#include <vector>
+
+/**
+ * Partitions a line data set into 1, 2, 4, ..., maxNumPartitions spatially coherent groups (see partitionLinesMorton)
+ * and measures the partitioning time and the overlap of the partition bounding boxes. When built with OSPRay
+ * (USE_RAYTRACING), the time for converting the lines to tubes and for building the OSPRay acceleration structures
+ * is measured, too.
+ * Arguments (optional): [lineDataSetFilename] [maxNumPartitions]
+ * The results are written to the log file and to "benchmark_line_partitioning.csv".
+ */
+int benchmarkLinePartitioning(const std::vector<std::string> &args);
+
+#endif //PIXELSYNCOIT_BENCHMARKLINEPARTITIONING_HPP
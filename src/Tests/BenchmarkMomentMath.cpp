@@ -0,0 +1,107 @@
+//
+// Created by christoph on 19.10.26.
+//
+
+#include <cmath>
+#include <random>
+#include <Utils/File/Logfile.hpp>
+#include <Utils/Convert.hpp>
+
+#include "OIT/MomentResolverCPU.hpp"
+#include "Performance/CsvWriter.hpp"
+#include "BenchmarkUtils.hpp"
+#include "BenchmarkMomentMath.hpp"
+
+int benchmarkMomentMath(const std::vector<std::string> &args)
+{
+    size_t numPixels = args.size() > 0 ? sgl::fromString<size_t>(args.at(0)) : 1920 * 1080;
+    int numFragments = args.size() > 1 ? sgl::fromString<int>(args.at(1)) : 16;
+    numFragments = std::max(numFragments, 1);
+
+    // Fragment f of pixel i is stored at index f * numPixels + i (i.e., one layer per call of generateMoments).
+    std::mt19937 generator(17);
+    std::uniform_real_distribution<float> depthDistribution(-1.0f, 1.0f);
+    std::uniform_real_distribution<float> alphaDistribution(0.02f, 0.6f);
+    std::uniform_int_distribution<int> fragmentDistribution(0, numFragments - 1);
+    std::vector<float> depths(numPixels * numFragments), transmittances(numPixels * numFragments);
+    for (size_t i = 0; i < depths.size(); i++) {
+        depths.at(i) = depthDistribution(generator);
+        transmittances.at(i) = 1.0f - alphaDistribution(generator);
+    }
+
+    // The transmittance is reconstructed at the depth of a random fragment of each pixel, i.e., the reference is the
+    // product of the transmittances of all fragments in front of it.
+    std::vector<float> queryDepths(numPixels), referenceTransmittances(numPixels);
+    for (size_t i = 0; i < numPixels; i++) {
+        float queryDepth = depths.at(fragmentDistribution(generator) * numPixels + i);
+        float transmittance = 1.0f;
+        for (int f = 0; f < numFragments; f++) {
+            if (depths.at(f * numPixels + i) < queryDepth) {
+                transmittance *= transmittances.at(f * numPixels + i);
+            }
+        }
+        queryDepths.at(i) = queryDepth;
+        referenceTransmittances.at(i) = transmittance;
+    }
+
+    CsvWriter csvWriter("benchmark_moment_math.csv");
+    csvWriter.writeRow({"Moments", "Num. Moments", "Pixel Format", "Generate (ms)", "Resolve (ms)",
+                        "RMSE", "Max. Error", "Invalid Pixels"});
+
+    bool isValid = true;
+    std::vector<float> transmittanceAtDepth(numPixels);
+    for (int usePowerMoments = 1; usePowerMoments >= 0; usePowerMoments--) {
+        for (int numMoments = 4; numMoments <= 8; numMoments += 2) {
+            for (int format = 0; format < 2; format++) {
+                MBOITPixelFormat pixelFormat = format == 0
+                        ? MBOIT_PIXEL_FORMAT_FLOAT_32 : MBOIT_PIXEL_FORMAT_UNORM_16;
+                MomentResolverCPU resolver(numMoments, pixelFormat, usePowerMoments);
+                resolver.resize(numPixels);
+
+                // The moments are accumulated, so each run starts with clearing them (like a frame of OIT_MBOIT).
+                double timeGenerate = measureBestMilliseconds([&]() {
+                    resolver.clear();
+                    for (int f = 0; f < numFragments; f++) {
+                        resolver.generateMoments(&depths.at(f * numPixels), &transmittances.at(f * numPixels));
+                    }
+                });
+                double timeResolve = measureBestMilliseconds([&]() {
+                    resolver.resolveMoments(queryDepths.data(), transmittanceAtDepth.data());
+                });
+
+                double squaredErrorSum = 0.0;
+                float maxError = 0.0f;
+                size_t numInvalidPixels = 0;
+                for (size_t i = 0; i < numPixels; i++) {
+                    float error = std::abs(transmittanceAtDepth.at(i) - referenceTransmittances.at(i));
+                    if (!std::isfinite(error)) {
+                        numInvalidPixels++;
+                        continue;
+                    }
+                    squaredErrorSum += double(error) * double(error);
+                    maxError = std::max(maxError, error);
+                }
+                double rmse = std::sqrt(squaredErrorSum / double(std::max(numPixels - numInvalidPixels, size_t(1))));
+
+                std::string momentType = usePowerMoments ? "Power" : "Trigonometric";
+                std::string pixelFormatName = format == 0 ? "FLOAT_32" : "UNORM_16";
+                sgl::Logfile::get()->writeInfo(std::string() + "Moment math benchmark (" + momentType + ", "
+                        + sgl::toString(numMoments) + " moments, " + pixelFormatName + "): generate "
+                        + sgl::toString(timeGenerate) + "ms, resolve " + sgl::toString(timeResolve) + "ms, RMSE "
+                        + sgl::toString(rmse) + ", max. error " + sgl::toString(maxError));
+                if (numInvalidPixels > 0) {
+                    sgl::Logfile::get()->writeError(std::string() + "Error in benchmarkMomentMath: "
+                            + sgl::toString(numInvalidPixels) + " pixels with invalid transmittance.");
+                    isValid = false;
+                }
+
+                csvWriter.writeRow({
+                        momentType, sgl::toString(numMoments), pixelFormatName, sgl::toString(timeGenerate),
+                        sgl::toString(timeResolve), sgl::toString(rmse), sgl::toString(maxError),
+                        sgl::toString(numInvalidPixels)});
+            }
+        }
+    }
+
+    return isValid ? 0 : 1;
+}
@@ -0,0 +1,20 @@
+//
+// Created by christoph on 19.10.26.
+//
+
+#ifndef PIXELSYNCOIT_BENCHMARKMOMENTMATH_HPP
+#define PIXELSYNCOIT_BENCHMARKMOMENTMATH_HPP
+
+#include <string>
+#include <vector>
+
+/**
+ * Generates random fragments for each pixel and compares the transmittance reconstructed by MomentResolverCPU with
+ * the exact transmittance for all MBOIT configurations (power/trigonometric moments, 4/6/8 moments, FLOAT_32/UNORM_16).
+ * Measures the time for generating and resolving the moments and the RMSE and maximum error of the reconstruction.
+ * Arguments (optional): [numPixels] [numFragmentsPerPixel]
+ * The results are written to the log file and to "benchmark_moment_math.csv".
+ */
+int benchmarkMomentMath(const std::vector<std::string> &args);
+
+#endif //PIXELSYNCOIT_BENCHMARKMOMENTMATH_HPP
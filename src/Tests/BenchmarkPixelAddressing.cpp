@@ -0,0 +1,369 @@
+//
+// Created by christoph on 19.10.26.
+//
+
+#include <cmath>
+#include <algorithm>
+#include <limits>
+#include <random>
+#include <functional>
+#include <Utils/File/Logfile.hpp>
+#include <Utils/Convert.hpp>
+
+#include "OIT/PixelAddressing.hpp"
+#include "Performance/CsvWriter.hpp"
+#include "BenchmarkUtils.hpp"
+#include "BenchmarkPixelAddressing.hpp"
+
+using namespace PixelAddressing;
+
+// Number of nodes stored per pixel in the k-buffer access pattern (8 bytes per node).
+const uint32_t KBUFFER_SIZE = 4;
+
+struct PixelPosition
+{
+    uint16_t x, y;
+};
+
+/**
+ * Set-associative cache with LRU replacement. Only the addresses are simulated, i.e., no data is stored.
+ */
+class CacheSimulator
+{
+public:
+    CacheSimulator(size_t cacheSizeBytes, size_t lineSizeBytes, size_t numWays)
+            : lineSizeBytes(lineSizeBytes), numWays(numWays), numSets(cacheSizeBytes / (lineSizeBytes * numWays)),
+              tags(numSets * numWays, std::numeric_limits<uint64_t>::max()), lastAccess(numSets * numWays, 0) {}
+
+    /// @return True if the access was a cache hit.
+    bool access(uint64_t address)
+    {
+        uint64_t line = address / lineSizeBytes;
+        size_t set = size_t(line % numSets);
+        uint64_t *setTags = &tags[set * numWays];
+        uint64_t *setLastAccess = &lastAccess[set * numWays];
+        accessCounter++;
+
+        size_t leastRecentlyUsedWay = 0;
+        for (size_t way = 0; way < numWays; way++) {
+            if (setTags[way] == line) {
+                setLastAccess[way] = accessCounter;
+                return true;
+            }
+            if (setLastAccess[way] < setLastAccess[leastRecentlyUsedWay]) {
+                leastRecentlyUsedWay = way;
+            }
+        }
+        setTags[leastRecentlyUsedWay] = line;
+        setLastAccess[leastRecentlyUsedWay] = accessCounter;
+        numMisses++;
+        return false;
+    }
+
+    inline uint64_t getNumMisses() const { return numMisses; }
+
+private:
+    size_t lineSizeBytes, numWays, numSets;
+    std::vector<uint64_t> tags;
+    std::vector<uint64_t> lastAccess;
+    uint64_t accessCounter = 0;
+    uint64_t numMisses = 0;
+};
+
+/// L1 (32KiB, 8-way) and L2 (1MiB, 16-way) data cache with 64 byte lines. The L2 cache is only accessed on L1 misses.
+class CacheHierarchySimulator
+{
+public:
+    CacheHierarchySimulator() : l1Cache(32 * 1024, 64, 8), l2Cache(1024 * 1024, 64, 16) {}
+    inline void access(uint64_t address)
+    {
+        numAccesses++;
+        if (!l1Cache.access(address)) {
+            l2Cache.access(address);
+        }
+    }
+    inline uint64_t getNumAccesses() const { return numAccesses; }
+    inline uint64_t getNumL1Misses() const { return l1Cache.getNumMisses(); }
+    inline uint64_t getNumL2Misses() const { return l2Cache.getNumMisses(); }
+
+private:
+    CacheSimulator l1Cache, l2Cache;
+    uint64_t numAccesses = 0;
+};
+
+/**
+ * Rasterizes random primitives until the fragment count corresponds to the average depth complexity.
+ * - lines: 1 pixel wide lines with a length of up to 64 pixels (DDA), similar to the line data sets.
+ * - quads: Rectangles with a side length of up to 32 pixels in scanline order.
+ */
+static void rasterizePrimitives(
+        const std::string &primitiveType, uint32_t width, uint32_t height, int averageDepthComplexity,
+        std::vector<PixelPosition> &fragments)
+{
+    const size_t numFragments = size_t(width) * size_t(height) * size_t(averageDepthComplexity);
+    fragments.clear();
+    fragments.reserve(numFragments + 64 * 64);
+
+    std::mt19937 generator(17);
+    std::uniform_int_distribution<int> xDistribution(0, int(width) - 1);
+    std::uniform_int_distribution<int> yDistribution(0, int(height) - 1);
+    std::uniform_int_distribution<int> lineOffsetDistribution(-64, 64);
+    std::uniform_int_distribution<int> quadSizeDistribution(1, 32);
+    while (fragments.size() < numFragments) {
+        int x0 = xDistribution(generator), y0 = yDistribution(generator);
+        if (primitiveType == "lines") {
+            int x1 = std::min(std::max(x0 + lineOffsetDistribution(generator), 0), int(width) - 1);
+            int y1 = std::min(std::max(y0 + lineOffsetDistribution(generator), 0), int(height) - 1);
+            int numSteps = std::max(std::abs(x1 - x0), std::abs(y1 - y0));
+            for (int i = 0; i <= numSteps; i++) {
+                float t = numSteps == 0 ? 0.0f : float(i) / float(numSteps);
+                PixelPosition fragment;
+                fragment.x = uint16_t(std::round(x0 + t * (x1 - x0)));
+                fragment.y = uint16_t(std::round(y0 + t * (y1 - y0)));
+                fragments.push_back(fragment);
+            }
+        } else {
+            int x1 = std::min(x0 + quadSizeDistribution(generator), int(width));
+            int y1 = std::min(y0 + quadSizeDistribution(generator), int(height));
+            for (int y = y0; y < y1; y++) {
+                for (int x = x0; x < x1; x++) {
+                    PixelPosition fragment;
+                    fragment.x = uint16_t(x);
+                    fragment.y = uint16_t(y);
+                    fragments.push_back(fragment);
+                }
+            }
+        }
+    }
+}
+
+/**
+ * Literal copy of addrGen in TiledAddress.glsl for the modes selectable with setNewTilingMode
+ * (mode 0 to 6 in selectTilingModeUI).
+ */
+static uint32_t addrGenGLSL(int modeIndex, uint32_t x, uint32_t y, uint32_t viewportW)
+{
+    static const uint32_t mortonCodeLookupTable[64] = {
+        0,  1,  4,  5,  16, 17, 20, 21,
+        2,  3,  6,  7,  18, 19, 22, 23,
+        8,  9,  12, 13, 24, 25, 28, 29,
+        10, 11, 14, 15, 26, 27, 30, 31,
+        32, 33, 36, 37, 48, 49, 52, 53,
+        34, 35, 38, 39, 50, 51, 54, 55,
+        40, 41, 44, 45, 56, 57, 60, 61,
+        42, 43, 46, 47, 58, 59, 62, 63
+    };
+    const uint32_t tileSizes[7][2] = { {1, 1}, {2, 2}, {2, 8}, {8, 2}, {4, 4}, {8, 8}, {8, 8} };
+    const uint32_t TILE_N = tileSizes[modeIndex][0], TILE_M = tileSizes[modeIndex][1];
+
+    if (modeIndex == 6) {
+        uint32_t surfaceWidth = viewportW >> 3U;
+        uint32_t tileAddr1D = ((x >> 3U) + surfaceWidth * (y >> 3U)) << 6U;
+        uint32_t pixelAddr1D = (x & 7U) + ((y & 7U) << 3U);
+        return tileAddr1D | mortonCodeLookupTable[pixelAddr1D];
+    } else if (modeIndex == 1) {
+        uint32_t surfaceWidth = viewportW >> 1U;
+        uint32_t tileAddr1D = ((x >> 1U) + surfaceWidth * (y >> 1U)) << 2U;
+        uint32_t pixelAddr1D = (x & 1U) + ((y & 1U) << 1U);
+        return tileAddr1D | pixelAddr1D;
+    } else if (modeIndex == 2) {
+        uint32_t surfaceWidth = viewportW >> 1U;
+        uint32_t tileAddr1D = ((x / 2U) + surfaceWidth * (y / 8U)) << 4U;
+        uint32_t pixelAddr1D = (x & 1U) + (y & 7U) * 2U;
+        return tileAddr1D | pixelAddr1D;
+    } else if (modeIndex != 0) {
+        uint32_t surfaceWidth = viewportW / TILE_N;
+        uint32_t tileAddr1D = ((x / TILE_N) + surfaceWidth * (y / TILE_M)) * (TILE_N * TILE_M);
+        uint32_t pixelAddr1D = (x & (TILE_N - 1)) + (y & (TILE_M - 1)) * TILE_N;
+        return tileAddr1D | pixelAddr1D;
+    }
+    return x + viewportW * y;
+}
+
+/**
+ * Checks that the addressing scheme maps the padded screen bijectively to [0, paddedWidth * paddedHeight) and, if
+ * glslModeIndex >= 0, that it matches the corresponding mode of the shader code.
+ */
+template<class Addressing>
+static bool validateAddressing(const std::string &name, uint32_t width, uint32_t height, int glslModeIndex)
+{
+    getScreenSizeWithTiling<Addressing>(width, height);
+    std::vector<uint8_t> isUsed(size_t(width) * size_t(height), 0);
+    for (uint32_t y = 0; y < height; y++) {
+        for (uint32_t x = 0; x < width; x++) {
+            uint32_t address = Addressing::addrGen(x, y, width);
+            if (address >= isUsed.size() || isUsed[address]) {
+                sgl::Logfile::get()->writeError(std::string() + "Error in benchmarkPixelAddressing: " + name
+                        + " is not bijective (pixel " + sgl::toString(x) + ", " + sgl::toString(y) + ").");
+                return false;
+            }
+            isUsed[address] = 1;
+            if (glslModeIndex >= 0 && address != addrGenGLSL(glslModeIndex, x, y, width)) {
+                sgl::Logfile::get()->writeError(std::string() + "Error in benchmarkPixelAddressing: " + name
+                        + " doesn't match TiledAddress.glsl (pixel " + sgl::toString(x) + ", " + sgl::toString(y)
+                        + ").");
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+/**
+ * Measures the access patterns for one addressing scheme.
+ * - K-Buffer: Each fragment inserts its depth into the sorted k-buffer of its pixel (KBUFFER_SIZE nodes per pixel).
+ * - Linked List: Each fragment appends a node to a global buffer and exchanges the head pointer of its pixel.
+ * - Resolve: The k-buffers are read in scanline order (e.g., by a full-screen resolve pass).
+ */
+template<class Addressing>
+static void benchmarkAddressing(
+        const std::string &name, const std::string &primitiveType, const std::vector<PixelPosition> &fragments,
+        uint32_t width, uint32_t height, CsvWriter &csvWriter)
+{
+    const uint32_t screenWidth = width, screenHeight = height;
+    getScreenSizeWithTiling<Addressing>(width, height);
+    const size_t numPixels = size_t(width) * size_t(height);
+    const size_t numFragments = fragments.size();
+
+    std::vector<uint64_t> kBuffer(numPixels * KBUFFER_SIZE);
+    std::vector<uint32_t> headPointers(numPixels);
+    std::vector<uint32_t> nextPointers(numFragments);
+    std::vector<uint64_t> resolvedDepths(size_t(screenWidth) * size_t(screenHeight));
+
+    auto kBufferPass = [&]() {
+        std::fill(kBuffer.begin(), kBuffer.end(), std::numeric_limits<uint64_t>::max());
+        for (size_t i = 0; i < numFragments; i++) {
+            uint64_t *pixelKBuffer = &kBuffer[size_t(Addressing::addrGen(fragments[i].x, fragments[i].y, width))
+                    * KBUFFER_SIZE];
+            // Pseudo-random depth, such that fragments are inserted at all positions of the k-buffer.
+            uint64_t key = uint64_t(i) * 0x9E3779B97F4A7C15ull;
+            for (uint32_t j = 0; j < KBUFFER_SIZE; j++) {
+                if (key < pixelKBuffer[j]) {
+                    std::swap(key, pixelKBuffer[j]);
+                }
+            }
+        }
+    };
+    auto linkedListPass = [&]() {
+        std::fill(headPointers.begin(), headPointers.end(), std::numeric_limits<uint32_t>::max());
+        for (size_t i = 0; i < numFragments; i++) {
+            uint32_t &head = headPointers[Addressing::addrGen(fragments[i].x, fragments[i].y, width)];
+            nextPointers[i] = head;
+            head = uint32_t(i);
+        }
+    };
+    auto resolvePass = [&]() {
+        for (uint32_t y = 0; y < screenHeight; y++) {
+            for (uint32_t x = 0; x < screenWidth; x++) {
+                const uint64_t *pixelKBuffer = &kBuffer[size_t(Addressing::addrGen(x, y, width)) * KBUFFER_SIZE];
+                uint64_t minDepth = pixelKBuffer[0];
+                for (uint32_t j = 1; j < KBUFFER_SIZE; j++) {
+                    minDepth = std::min(minDepth, pixelKBuffer[j]);
+                }
+                resolvedDepths[size_t(y) * screenWidth + x] = minDepth;
+            }
+        }
+    };
+
+    // Address traces for the cache simulation. The buffers are assumed to be aligned to the cache line size, and
+    // the linked list nodes follow the head pointers in memory.
+    const uint64_t nodeBufferOffset = numPixels * sizeof(uint32_t);
+    auto simulateKBufferPass = [&](CacheHierarchySimulator &cache) {
+        for (size_t i = 0; i < numFragments; i++) {
+            uint64_t pixelAddress = Addressing::addrGen(fragments[i].x, fragments[i].y, width);
+            for (uint32_t j = 0; j < KBUFFER_SIZE; j++) {
+                cache.access((pixelAddress * KBUFFER_SIZE + j) * sizeof(uint64_t));
+            }
+        }
+    };
+    auto simulateLinkedListPass = [&](CacheHierarchySimulator &cache) {
+        for (size_t i = 0; i < numFragments; i++) {
+            uint64_t pixelAddress = Addressing::addrGen(fragments[i].x, fragments[i].y, width);
+            cache.access(pixelAddress * sizeof(uint32_t));
+            cache.access(nodeBufferOffset + i * sizeof(uint32_t));
+        }
+    };
+    auto simulateResolvePass = [&](CacheHierarchySimulator &cache) {
+        for (uint32_t y = 0; y < screenHeight; y++) {
+            for (uint32_t x = 0; x < screenWidth; x++) {
+                uint64_t pixelAddress = Addressing::addrGen(x, y, width);
+                for (uint32_t j = 0; j < KBUFFER_SIZE; j++) {
+                    cache.access((pixelAddress * KBUFFER_SIZE + j) * sizeof(uint64_t));
+                }
+            }
+        }
+    };
+
+    const std::vector<std::string> patternNames = { "K-Buffer", "Linked List", "Resolve" };
+    const std::vector<std::function<void()>> passes = { kBufferPass, linkedListPass, resolvePass };
+    const std::vector<std::function<void(CacheHierarchySimulator&)>> simulations = {
+            simulateKBufferPass, simulateLinkedListPass, simulateResolvePass };
+    for (size_t patternIdx = 0; patternIdx < passes.size(); patternIdx++) {
+        double timeMS = measureBestMilliseconds(passes.at(patternIdx));
+        CacheHierarchySimulator cache;
+        simulations.at(patternIdx)(cache);
+
+        size_t numElements = patternIdx == 2 ? size_t(screenWidth) * size_t(screenHeight) : numFragments;
+        double elementsPerSecond = double(numElements) / timeMS * 1e-3;
+        double l1MissRate = double(cache.getNumL1Misses()) / double(std::max(cache.getNumAccesses(), uint64_t(1)));
+        sgl::Logfile::get()->writeInfo(std::string() + "Pixel addressing benchmark (" + name + ", "
+                + patternNames.at(patternIdx) + ", " + primitiveType + "): " + sgl::toString(timeMS) + "ms, "
+                + sgl::toString(elementsPerSecond) + "M accesses/s, L1 misses " + sgl::toString(cache.getNumL1Misses())
+                + ", L2 misses " + sgl::toString(cache.getNumL2Misses()));
+        csvWriter.writeRow({
+                name, patternNames.at(patternIdx), primitiveType, sgl::toString(timeMS),
+                sgl::toString(elementsPerSecond), sgl::toString(cache.getNumL1Misses()),
+                sgl::toString(cache.getNumL2Misses()), sgl::toString(l1MissRate)});
+    }
+}
+
+int benchmarkPixelAddressing(const std::vector<std::string> &args)
+{
+    uint32_t width = args.size() > 0 ? sgl::fromString<uint32_t>(args.at(0)) : 1920;
+    uint32_t height = args.size() > 1 ? sgl::fromString<uint32_t>(args.at(1)) : 1080;
+    int averageDepthComplexity = args.size() > 2 ? sgl::fromString<int>(args.at(2)) : 8;
+    width = std::min(std::max(width, 1u), 65535u);
+    height = std::min(std::max(height, 1u), 65535u);
+    averageDepthComplexity = std::max(averageDepthComplexity, 1);
+
+    // Same modes as selectTilingModeUI, plus schemes only available on the CPU (glslModeIndex = -1).
+    bool isValid = true;
+    isValid = validateAddressing<LinearAddressing>("1x1", width, height, 0) && isValid;
+    isValid = validateAddressing<TiledAddressing<2, 2>>("2x2", width, height, 1) && isValid;
+    isValid = validateAddressing<TiledAddressing<2, 8>>("2x8", width, height, 2) && isValid;
+    isValid = validateAddressing<TiledAddressing<8, 2>>("8x2", width, height, 3) && isValid;
+    isValid = validateAddressing<TiledAddressing<4, 4>>("4x4", width, height, 4) && isValid;
+    isValid = validateAddressing<TiledAddressing<8, 8>>("8x8", width, height, 5) && isValid;
+    isValid = validateAddressing<MortonAddressing<8>>("8x8 Morton Code", width, height, 6) && isValid;
+    isValid = validateAddressing<MortonAddressing<64>>("64x64 Morton Code", width, height, -1) && isValid;
+    isValid = validateAddressing<HilbertAddressing<8>>("8x8 Hilbert Curve", width, height, -1) && isValid;
+    isValid = validateAddressing<HilbertAddressing<64>>("64x64 Hilbert Curve", width, height, -1) && isValid;
+
+    CsvWriter csvWriter("benchmark_pixel_addressing.csv");
+    csvWriter.writeRow({"Addressing", "Access Pattern", "Primitives", "Time (ms)", "Accesses per Second (M)",
+                        "L1 Misses", "L2 Misses", "L1 Miss Rate"});
+
+    std::vector<PixelPosition> fragments;
+    for (const char *primitiveType : { "lines", "quads" }) {
+        rasterizePrimitives(primitiveType, width, height, averageDepthComplexity, fragments);
+        benchmarkAddressing<LinearAddressing>("1x1", primitiveType, fragments, width, height, csvWriter);
+        benchmarkAddressing<TiledAddressing<2, 2>>("2x2", primitiveType, fragments, width, height, csvWriter);
+        benchmarkAddressing<TiledAddressing<2, 8>>("2x8", primitiveType, fragments, width, height, csvWriter);
+        benchmarkAddressing<TiledAddressing<8, 2>>("8x2", primitiveType, fragments, width, height, csvWriter);
+        benchmarkAddressing<TiledAddressing<4, 4>>("4x4", primitiveType, fragments, width, height, csvWriter);
+        benchmarkAddressing<TiledAddressing<8, 8>>("8x8", primitiveType, fragments, width, height, csvWriter);
+        benchmarkAddressing<MortonAddressing<8>>("8x8 Morton Code", primitiveType, fragments, width, height,
+                csvWriter);
+        benchmarkAddressing<MortonAddressing<64>>("64x64 Morton Code", primitiveType, fragments, width, height,
+                csvWriter);
+        benchmarkAddressing<HilbertAddressing<8>>("8x8 Hilbert Curve", primitiveType, fragments, width, height,
+                csvWriter);
+        benchmarkAddressing<HilbertAddressing<64>>("64x64 Hilbert Curve", primitiveType, fragments, width, height,
+                csvWriter);
+    }
+
+    if (isValid) {
+        sgl::Logfile::get()->writeInfo("Pixel addressing benchmark: All addressing schemes are valid.");
+    }
+    return isValid ? 0 : 1;
+}
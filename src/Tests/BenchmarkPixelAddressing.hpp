@@ -0,0 +1,21 @@
+//
+// Created by christoph on 19.10.26.
+//
+
+#ifndef PIXELSYNCOIT_BENCHMARKPIXELADDRESSING_HPP
+#define PIXELSYNCOIT_BENCHMARKPIXELADDRESSING_HPP
+
+#include <string>
+#include <vector>
+
+/**
+ * CPU counterpart of getTestModesTiling: Compares the addressing schemes of PixelAddressing.hpp for k-buffer and
+ * linked list style accesses of rasterized lines and quads. For each scheme, the throughput and the number of cache
+ * misses of a simulated two-level cache are measured. Additionally, it is checked that the schemes are bijective and
+ * that they match the index functions in TiledAddress.glsl.
+ * Arguments (optional): [width] [height] [averageDepthComplexity]
+ * The results are written to the log file and to "benchmark_pixel_addressing.csv".
+ */
+int benchmarkPixelAddressing(const std::vector<std::string> &args);
+
+#endif //PIXELSYNCOIT_BENCHMARKPIXELADDRESSING_HPP
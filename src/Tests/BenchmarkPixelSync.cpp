@@ -0,0 +1,376 @@
+//
+// Created by christoph on 19.10.26.
+//
+
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+#include <atomic>
+#include <limits>
+#include <random>
+#include <omp.h>
+#include <Utils/File/Logfile.hpp>
+#include <Utils/Convert.hpp>
+
+#include "Performance/CsvWriter.hpp"
+#include "BenchmarkUtils.hpp"
+#include "BenchmarkPixelSync.hpp"
+
+// Number of fragments stored per pixel (same default as OIT_KBuffer).
+const int KBUFFER_SIZE = 8;
+// Side length of the screen tiles owned by one thread in the tile ownership strategy.
+const int TILE_SIZE = 16;
+const uint64_t EMPTY_KEY = std::numeric_limits<uint64_t>::max();
+
+/**
+ * The fragments are stored as structure of arrays. The key of a fragment stores the bits of the (positive) depth in
+ * the upper and the fragment index in the lower 32 bits, i.e., keys are unique and ordered by depth. Thus, the
+ * k-buffer content after inserting all fragments doesn't depend on the insertion order.
+ */
+struct FragmentStream
+{
+    std::vector<uint32_t> pixelIndices;
+    std::vector<uint64_t> keys;
+};
+
+static uint64_t makeFragmentKey(float depth, uint32_t fragmentIndex)
+{
+    uint32_t depthBits;
+    memcpy(&depthBits, &depth, sizeof(float));
+    return (uint64_t(depthBits) << 32) | uint64_t(fragmentIndex);
+}
+
+/**
+ * Generates the fragment stream.
+ * - uniform: The fragments are distributed uniformly across the screen (Poisson distributed depth complexity).
+ * - hotspot: The pixel positions are normally distributed around the screen center (high contention).
+ * - overdraw: Full-screen layers rasterized one after another (like the quads of TestPixelSyncPerformance).
+ */
+static bool generateFragmentStream(
+        const std::string &distribution, int averageDepthComplexity, int width, int height, FragmentStream &stream)
+{
+    const size_t numPixels = size_t(width) * size_t(height);
+    const size_t numFragments = numPixels * size_t(averageDepthComplexity);
+    stream.pixelIndices.resize(numFragments);
+    stream.keys.resize(numFragments);
+
+    std::mt19937 generator(17);
+    std::uniform_real_distribution<float> depthDistribution(0.0f, 1.0f);
+    if (distribution == "uniform") {
+        std::uniform_int_distribution<uint32_t> pixelDistribution(0, uint32_t(numPixels - 1));
+        for (size_t i = 0; i < numFragments; i++) {
+            stream.pixelIndices.at(i) = pixelDistribution(generator);
+        }
+    } else if (distribution == "hotspot") {
+        std::normal_distribution<float> xDistribution(width * 0.5f, width * 0.125f);
+        std::normal_distribution<float> yDistribution(height * 0.5f, height * 0.125f);
+        for (size_t i = 0; i < numFragments; i++) {
+            int x = std::min(std::max(int(xDistribution(generator)), 0), width - 1);
+            int y = std::min(std::max(int(yDistribution(generator)), 0), height - 1);
+            stream.pixelIndices.at(i) = uint32_t(y * width + x);
+        }
+    } else if (distribution == "overdraw") {
+        for (size_t i = 0; i < numFragments; i++) {
+            stream.pixelIndices.at(i) = uint32_t(i % numPixels);
+        }
+    } else {
+        sgl::Logfile::get()->writeError(std::string() + "Error in benchmarkPixelSync: Unknown distribution \""
+                + distribution + "\".");
+        return false;
+    }
+
+    for (size_t i = 0; i < numFragments; i++) {
+        stream.keys.at(i) = makeFragmentKey(depthDistribution(generator), uint32_t(i));
+    }
+    return true;
+}
+
+/// Inserts the key into the sorted k-buffer of a pixel. The largest key is dropped if the buffer is full.
+static inline void insertFragment(uint64_t *kBuffer, uint64_t key)
+{
+    for (int i = 0; i < KBUFFER_SIZE; i++) {
+        if (key < kBuffer[i]) {
+            std::swap(key, kBuffer[i]);
+        }
+    }
+}
+
+/**
+ * Lock-free version of insertFragment. Each slot is updated with an atomic minimum implemented as compare-and-swap
+ * loop, and the replaced key is carried on to the next slot (like atomicMin on 64-bit values in the GPU k-buffer).
+ */
+static inline void insertFragmentAtomic(std::atomic<uint64_t> *kBuffer, uint64_t key)
+{
+    for (int i = 0; i < KBUFFER_SIZE && key != EMPTY_KEY; i++) {
+        uint64_t oldKey = kBuffer[i].load(std::memory_order_relaxed);
+        while (key < oldKey) {
+            if (kBuffer[i].compare_exchange_weak(oldKey, key, std::memory_order_relaxed)) {
+                key = oldKey;
+                break;
+            }
+        }
+    }
+}
+
+class PixelSyncBenchmark
+{
+public:
+    PixelSyncBenchmark(const FragmentStream &stream, int width, int height)
+            : stream(stream), width(width), height(height), numPixels(size_t(width) * size_t(height)),
+              numFragments(stream.keys.size()), kBuffer(numPixels * KBUFFER_SIZE),
+              atomicKBuffer(numPixels * KBUFFER_SIZE), pixelLocks(numPixels)
+    {
+        numTilesX = (width - 1) / TILE_SIZE + 1;
+        numTilesY = (height - 1) / TILE_SIZE + 1;
+        binnedFragments.resize(numFragments);
+        tileOffsets.resize(numTilesX * numTilesY + 1);
+    }
+
+    /// Serial insertion without any synchronization.
+    void runReference(std::vector<uint64_t> &referenceKBuffer)
+    {
+        referenceKBuffer.resize(numPixels * KBUFFER_SIZE);
+        std::fill(referenceKBuffer.begin(), referenceKBuffer.end(), EMPTY_KEY);
+        for (size_t i = 0; i < numFragments; i++) {
+            insertFragment(&referenceKBuffer[size_t(stream.pixelIndices[i]) * KBUFFER_SIZE], stream.keys[i]);
+        }
+    }
+
+    /// Each fragment locks its pixel with a test-and-test-and-set spinlock (like the critical section of pixel sync).
+    void runSpinlock(int numThreads)
+    {
+        clearKBuffer(numThreads);
+        #pragma omp parallel for num_threads(numThreads)
+        for (size_t i = 0; i < numPixels; i++) {
+            pixelLocks[i].store(0, std::memory_order_relaxed);
+        }
+
+        #pragma omp parallel for num_threads(numThreads)
+        for (size_t i = 0; i < numFragments; i++) {
+            uint32_t pixelIndex = stream.pixelIndices[i];
+            std::atomic<uint32_t> &lock = pixelLocks[pixelIndex];
+            while (lock.exchange(1, std::memory_order_acquire) != 0) {
+                while (lock.load(std::memory_order_relaxed) != 0);
+            }
+            insertFragment(&kBuffer[size_t(pixelIndex) * KBUFFER_SIZE], stream.keys[i]);
+            lock.store(0, std::memory_order_release);
+        }
+    }
+
+    /// Lock-free insertion with atomic compare-and-swap operations (see insertFragmentAtomic).
+    void runAtomicCAS(int numThreads)
+    {
+        #pragma omp parallel for num_threads(numThreads)
+        for (size_t i = 0; i < numPixels * KBUFFER_SIZE; i++) {
+            atomicKBuffer[i].store(EMPTY_KEY, std::memory_order_relaxed);
+        }
+
+        #pragma omp parallel for num_threads(numThreads)
+        for (size_t i = 0; i < numFragments; i++) {
+            insertFragmentAtomic(&atomicKBuffer[size_t(stream.pixelIndices[i]) * KBUFFER_SIZE], stream.keys[i]);
+        }
+
+        #pragma omp parallel for num_threads(numThreads)
+        for (size_t i = 0; i < numPixels * KBUFFER_SIZE; i++) {
+            kBuffer[i] = atomicKBuffer[i].load(std::memory_order_relaxed);
+        }
+    }
+
+    /**
+     * The fragments are binned into screen tiles first (counting sort with per-thread histograms). Afterwards, each
+     * tile is processed by exactly one thread, i.e., no synchronization is necessary for inserting the fragments.
+     */
+    void runTileOwnership(int numThreads)
+    {
+        clearKBuffer(numThreads);
+        const int numTiles = numTilesX * numTilesY;
+        tileCounts.resize(size_t(numThreads) * numTiles);
+
+        #pragma omp parallel num_threads(numThreads)
+        {
+            const int threadIdx = omp_get_thread_num();
+            const int threadCount = omp_get_num_threads();
+            const size_t begin = numFragments * threadIdx / threadCount;
+            const size_t end = numFragments * (threadIdx + 1) / threadCount;
+            uint32_t *counts = &tileCounts[size_t(threadIdx) * numTiles];
+            std::fill(counts, counts + numTiles, 0u);
+            for (size_t i = begin; i < end; i++) {
+                counts[getTileIndex(stream.pixelIndices[i])]++;
+            }
+
+            #pragma omp barrier
+            #pragma omp single
+            {
+                // Exclusive prefix sum over (tile, thread), such that the fragments of a tile stay in stream order.
+                uint32_t offset = 0;
+                for (int tileIdx = 0; tileIdx < numTiles; tileIdx++) {
+                    tileOffsets[tileIdx] = offset;
+                    for (int t = 0; t < threadCount; t++) {
+                        uint32_t count = tileCounts[size_t(t) * numTiles + tileIdx];
+                        tileCounts[size_t(t) * numTiles + tileIdx] = offset;
+                        offset += count;
+                    }
+                }
+                tileOffsets[numTiles] = offset;
+            }
+
+            for (size_t i = begin; i < end; i++) {
+                binnedFragments[counts[getTileIndex(stream.pixelIndices[i])]++] = uint32_t(i);
+            }
+
+            #pragma omp barrier
+            #pragma omp for schedule(dynamic)
+            for (int tileIdx = 0; tileIdx < numTiles; tileIdx++) {
+                for (uint32_t j = tileOffsets[tileIdx]; j < tileOffsets[tileIdx + 1]; j++) {
+                    uint32_t fragmentIndex = binnedFragments[j];
+                    insertFragment(&kBuffer[size_t(stream.pixelIndices[fragmentIndex]) * KBUFFER_SIZE],
+                            stream.keys[fragmentIndex]);
+                }
+            }
+        }
+    }
+
+    /**
+     * Each thread inserts its part of the fragment stream into a private k-buffer for the whole screen. Afterwards,
+     * the private k-buffers are merged per pixel.
+     */
+    void runSortLast(int numThreads)
+    {
+        privateKBuffers.resize(numThreads);
+        for (std::vector<uint64_t> &privateKBuffer : privateKBuffers) {
+            privateKBuffer.resize(numPixels * KBUFFER_SIZE);
+        }
+
+        #pragma omp parallel num_threads(numThreads)
+        {
+            const int threadIdx = omp_get_thread_num();
+            const int threadCount = omp_get_num_threads();
+            const size_t begin = numFragments * threadIdx / threadCount;
+            const size_t end = numFragments * (threadIdx + 1) / threadCount;
+            std::vector<uint64_t> &privateKBuffer = privateKBuffers[threadIdx];
+            std::fill(privateKBuffer.begin(), privateKBuffer.end(), EMPTY_KEY);
+            for (size_t i = begin; i < end; i++) {
+                insertFragment(&privateKBuffer[size_t(stream.pixelIndices[i]) * KBUFFER_SIZE], stream.keys[i]);
+            }
+
+            #pragma omp barrier
+            #pragma omp for
+            for (size_t pixelIndex = 0; pixelIndex < numPixels; pixelIndex++) {
+                uint64_t *mergedKBuffer = &kBuffer[pixelIndex * KBUFFER_SIZE];
+                std::copy(&privateKBuffers[0][pixelIndex * KBUFFER_SIZE],
+                          &privateKBuffers[0][pixelIndex * KBUFFER_SIZE] + KBUFFER_SIZE, mergedKBuffer);
+                for (int t = 1; t < threadCount; t++) {
+                    const uint64_t *threadKBuffer = &privateKBuffers[t][pixelIndex * KBUFFER_SIZE];
+                    for (int i = 0; i < KBUFFER_SIZE && threadKBuffer[i] < mergedKBuffer[KBUFFER_SIZE - 1]; i++) {
+                        insertFragment(mergedKBuffer, threadKBuffer[i]);
+                    }
+                }
+            }
+        }
+    }
+
+    inline const std::vector<uint64_t> &getKBuffer() const { return kBuffer; }
+
+private:
+    void clearKBuffer(int numThreads)
+    {
+        #pragma omp parallel for num_threads(numThreads)
+        for (size_t i = 0; i < numPixels * KBUFFER_SIZE; i++) {
+            kBuffer[i] = EMPTY_KEY;
+        }
+    }
+
+    inline int getTileIndex(uint32_t pixelIndex) const
+    {
+        int x = int(pixelIndex % uint32_t(width));
+        int y = int(pixelIndex / uint32_t(width));
+        return (y / TILE_SIZE) * numTilesX + x / TILE_SIZE;
+    }
+
+    const FragmentStream &stream;
+    int width, height;
+    size_t numPixels, numFragments;
+    std::vector<uint64_t> kBuffer;
+
+    std::vector<std::atomic<uint64_t>> atomicKBuffer;
+    std::vector<std::atomic<uint32_t>> pixelLocks;
+
+    int numTilesX, numTilesY;
+    std::vector<uint32_t> tileCounts;
+    std::vector<uint32_t> tileOffsets;
+    std::vector<uint32_t> binnedFragments;
+
+    std::vector<std::vector<uint64_t>> privateKBuffers;
+};
+
+int benchmarkPixelSync(const std::vector<std::string> &args)
+{
+    std::string distribution = args.size() > 0 ? args.at(0) : "uniform";
+    int averageDepthComplexity = args.size() > 1 ? sgl::fromString<int>(args.at(1)) : 32;
+    int width = args.size() > 2 ? sgl::fromString<int>(args.at(2)) : 512;
+    int height = args.size() > 3 ? sgl::fromString<int>(args.at(3)) : 512;
+    averageDepthComplexity = std::max(averageDepthComplexity, 1);
+    width = std::max(width, 1);
+    height = std::max(height, 1);
+
+    FragmentStream stream;
+    if (!generateFragmentStream(distribution, averageDepthComplexity, width, height, stream)) {
+        return 1;
+    }
+    const size_t numFragments = stream.keys.size();
+
+    PixelSyncBenchmark benchmark(stream, width, height);
+    std::vector<uint64_t> referenceKBuffer;
+    double timeReference = measureMilliseconds([&]() {
+        benchmark.runReference(referenceKBuffer);
+    });
+
+    typedef void (PixelSyncBenchmark::*StrategyFunction)(int);
+    const std::vector<std::pair<std::string, StrategyFunction>> strategies = {
+            { "Spinlock", &PixelSyncBenchmark::runSpinlock },
+            { "Atomic CAS", &PixelSyncBenchmark::runAtomicCAS },
+            { "Tile Ownership", &PixelSyncBenchmark::runTileOwnership },
+            { "Sort-Last", &PixelSyncBenchmark::runSortLast },
+    };
+
+    std::vector<int> threadCounts;
+    const int maxNumThreads = omp_get_max_threads();
+    for (int numThreads = 1; numThreads < maxNumThreads; numThreads *= 2) {
+        threadCounts.push_back(numThreads);
+    }
+    threadCounts.push_back(maxNumThreads);
+
+    CsvWriter csvWriter("benchmark_pixel_sync.csv");
+    csvWriter.writeRow({"Strategy", "Distribution", "Threads", "Time (ms)", "Fragments per Second (M)",
+                        "Speedup", "Valid"});
+    csvWriter.writeRow({"Serial", distribution, "1", sgl::toString(timeReference),
+                        sgl::toString(double(numFragments) / timeReference * 1e-3), "1", "1"});
+
+    bool isValid = true;
+    for (const std::pair<std::string, StrategyFunction> &strategy : strategies) {
+        for (int numThreads : threadCounts) {
+            // Best of multiple runs (the first run also touches the memory of the buffers).
+            double timeMS = measureBestMilliseconds([&]() {
+                (benchmark.*strategy.second)(numThreads);
+            });
+
+            bool isStrategyValid = benchmark.getKBuffer() == referenceKBuffer;
+            if (!isStrategyValid) {
+                sgl::Logfile::get()->writeError(std::string() + "Error in benchmarkPixelSync: " + strategy.first
+                        + " with " + sgl::toString(numThreads) + " threads doesn't match the serial reference.");
+                isValid = false;
+            }
+
+            double fragmentsPerSecond = double(numFragments) / timeMS * 1e-3;
+            sgl::Logfile::get()->writeInfo(std::string() + "Pixel sync benchmark (" + strategy.first + ", "
+                    + distribution + ", " + sgl::toString(numThreads) + " threads): " + sgl::toString(timeMS)
+                    + "ms, " + sgl::toString(fragmentsPerSecond) + "M fragments/s");
+            csvWriter.writeRow({
+                    strategy.first, distribution, sgl::toString(numThreads), sgl::toString(timeMS),
+                    sgl::toString(fragmentsPerSecond), sgl::toString(timeReference / timeMS),
+                    sgl::toString(int(isStrategyValid))});
+        }
+    }
+
+    return isValid ? 0 : 1;
+}
@@ -0,0 +1,22 @@
+//
+// Created by christoph on 19.10.26.
+//
+
+#ifndef PIXELSYNCOIT_BENCHMARKPIXELSYNC_HPP
+#define PIXELSYNCOIT_BENCHMARKPIXELSYNC_HPP
+
+#include <string>
+#include <vector>
+
+/**
+ * CPU counterpart of TestPixelSyncPerformance: A software fragment stream is inserted into per-pixel k-buffers
+ * using different per-pixel synchronization strategies (per-pixel spinlocks, lock-free atomic compare-and-swap
+ * insertion, tile ownership without locks and sort-last merging of per-thread buffers). The throughput is measured
+ * for 1, 2, 4, ... threads up to the number of available cores, and the resulting k-buffers are compared with a
+ * serial reference.
+ * Arguments (optional): [distribution = uniform|hotspot|overdraw] [averageDepthComplexity] [width] [height]
+ * The results are written to the log file and to "benchmark_pixel_sync.csv".
+ */
+int benchmarkPixelSync(const std::vector<std::string> &args);
+
+#endif //PIXELSYNCOIT_BENCHMARKPIXELSYNC_HPP
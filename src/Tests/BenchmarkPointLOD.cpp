@@ -0,0 +1,124 @@
+//
+// Created by christoph on 19.10.26.
+//
+
+#include <chrono>
+#include <cmath>
+#include <glm/gtc/matrix_transform.hpp>
+#include <Utils/File/Logfile.hpp>
+#include <Utils/File/FileUtils.hpp>
+#include <Utils/Convert.hpp>
+
+#include "Utils/MeshSerializer.hpp"
+#include "Utils/PointRendering/PointFileLoader.hpp"
+#include "Utils/PointRendering/PointLODHierarchy.hpp"
+#include "Performance/CsvWriter.hpp"
+#include "BenchmarkPointLOD.hpp"
+
+/**
+ * Checks that the selected indices are valid and that every original point is covered at most once, either by
+ * itself or by the representative of one of the nodes containing it.
+ */
+static bool validateSelection(
+        const PointLODHierarchy &pointLOD, const std::vector<uint32_t> &indices, size_t pointBudget,
+        std::string &errorMessage)
+{
+    const std::vector<PointLODNode> &nodes = pointLOD.getNodes();
+    const uint32_t numOriginalPoints = pointLOD.getNumOriginalPoints();
+    if (indices.size() > std::max(pointBudget, size_t(1))) {
+        errorMessage = "Point budget exceeded";
+        return false;
+    }
+
+    std::vector<uint8_t> isCovered(numOriginalPoints, 0);
+    for (uint32_t index : indices) {
+        uint32_t first = index, count = 1;
+        if (index >= numOriginalPoints) {
+            if (index - numOriginalPoints >= nodes.size()) {
+                errorMessage = "Index out of range";
+                return false;
+            }
+            const PointLODNode &node = nodes.at(index - numOriginalPoints);
+            first = node.firstPoint;
+            count = node.numPoints;
+        }
+        for (uint32_t i = first; i < first + count; i++) {
+            if (isCovered.at(i)) {
+                errorMessage = "Point " + sgl::toString(i) + " is covered more than once";
+                return false;
+            }
+            isCovered.at(i) = 1;
+        }
+    }
+    return true;
+}
+
+int benchmarkPointLOD(const std::vector<std::string> &args)
+{
+    std::string dataSetFilename = args.size() > 0 ? args.at(0) : "Data/PointDatasets/0.000xv000.dat";
+    std::string binaryFilename = sgl::FileUtils::get()->removeExtension(dataSetFilename) + ".binmesh";
+    if (!sgl::FileUtils::get()->exists(binaryFilename)) {
+        convertPointDataSetToBinmesh(dataSetFilename, binaryFilename);
+    }
+
+    BinaryMesh mesh;
+    readMesh3D(binaryFilename, mesh);
+    PointLODHierarchy pointLOD;
+    if (mesh.submeshes.empty() || !pointLOD.loadFromUniforms(mesh.submeshes.front().uniforms)) {
+        sgl::Logfile::get()->writeError(std::string() + "Error in benchmarkPointLOD: \"" + binaryFilename
+                + "\" contains no level of detail hierarchy.");
+        return 1;
+    }
+    const uint32_t numOriginalPoints = pointLOD.getNumOriginalPoints();
+    const size_t numNodes = pointLOD.getNodes().size();
+
+    // Same camera settings as the main application
+    const float fovy = std::atan(1.0f / 2.0f) * 2.0f;
+    const float viewportWidth = 1920.0f, viewportHeight = 1080.0f;
+    const glm::mat4 projectionMatrix = glm::perspective(fovy, viewportWidth / viewportHeight, 0.01f, 100.0f);
+    const float pixelsPerUnit = projectionMatrix[1][1] * viewportHeight * 0.5f;
+
+    const std::vector<float> cameraDistances = { 0.25f, 0.5f, 1.0f, 2.0f, 4.0f };
+    const std::vector<float> maxScreenErrors = { 0.5f, 1.0f, 2.0f, 4.0f, 8.0f };
+    const std::vector<size_t> pointBudgets = { 100000, 1000000, 10000000 };
+
+    CsvWriter csvWriter("benchmark_point_lod.csv");
+    csvWriter.writeRow({"Camera Distance", "Max. Screen Error", "Point Budget", "Emitted Points", "Representatives",
+                        "Visited Nodes", "Max. Emitted Error", "Time (ms)"});
+
+    bool isValid = true;
+    std::vector<uint32_t> indices;
+    for (float cameraDistance : cameraDistances) {
+        glm::mat4 viewMatrix = glm::lookAt(
+                glm::vec3(0.0f, 0.0f, cameraDistance), glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+        glm::mat4 mvpMatrix = projectionMatrix * viewMatrix;
+        for (float maxScreenError : maxScreenErrors) {
+            for (size_t pointBudget : pointBudgets) {
+                auto start = std::chrono::high_resolution_clock::now();
+                PointLODSelectionStatistics statistics = pointLOD.selectPoints(
+                        mvpMatrix, viewMatrix, pixelsPerUnit, pointBudget, maxScreenError, indices);
+                auto end = std::chrono::high_resolution_clock::now();
+                std::chrono::duration<double, std::milli> elapsed = end - start;
+
+                std::string errorMessage;
+                if (!validateSelection(pointLOD, indices, pointBudget, errorMessage)) {
+                    sgl::Logfile::get()->writeError(std::string() + "Error in benchmarkPointLOD: Invalid selection "
+                            + "(distance " + sgl::toString(cameraDistance) + ", error "
+                            + sgl::toString(maxScreenError) + ", budget " + sgl::toString(pointBudget) + "): "
+                            + errorMessage);
+                    isValid = false;
+                }
+
+                csvWriter.writeRow({
+                        sgl::toString(cameraDistance), sgl::toString(maxScreenError), sgl::toString(pointBudget),
+                        sgl::toString(statistics.numEmittedPoints), sgl::toString(statistics.numRepresentatives),
+                        sgl::toString(statistics.numVisitedNodes), sgl::toString(statistics.maxScreenError),
+                        sgl::toString(elapsed.count())});
+            }
+        }
+    }
+
+    sgl::Logfile::get()->writeInfo(std::string() + "Point LOD benchmark (" + sgl::toString(numOriginalPoints)
+            + " points, " + sgl::toString(numNodes) + " nodes): " + (isValid ? "all selections valid" : "FAILED"));
+    return isValid ? 0 : 1;
+}
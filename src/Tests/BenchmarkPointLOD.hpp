@@ -0,0 +1,22 @@
+//
+// Created by christoph on 19.10.26.
+//
+
+#ifndef PIXELSYNCOIT_BENCHMARKPOINTLOD_HPP
+#define PIXELSYNCOIT_BENCHMARKPOINTLOD_HPP
+
+#include <string>
+#include <vector>
+
+/**
+ * Traverses the level of detail hierarchy of a point data set for several camera distances, screen space error
+ * thresholds and point budgets. Each selection is validated: The budget is respected, all indices are valid and the
+ * selected points and representatives form a cut through the hierarchy (i.e., no original point is covered twice).
+ * The point data set is converted to a binary mesh first if necessary.
+ * Arguments (optional): [pointDataSetFilename]
+ * The results are written to the log file and to "benchmark_point_lod.csv".
+ * @return 0 if all selections are valid, 1 otherwise.
+ */
+int benchmarkPointLOD(const std::vector<std::string> &args);
+
+#endif //PIXELSYNCOIT_BENCHMARKPOINTLOD_HPP
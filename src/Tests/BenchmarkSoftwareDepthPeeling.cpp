@@ -0,0 +1,119 @@
+//
+// Created by christoph on 19.10.26.
+//
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <glm/gtc/matrix_transform.hpp>
+#include <Utils/File/Logfile.hpp>
+#include <Utils/File/FileUtils.hpp>
+#include <Utils/Convert.hpp>
+
+#include "Utils/TrajectoryFile.hpp"
+#include "Utils/CameraPath.hpp"
+#include "Utils/OfflineRendering.hpp"
+#include "Performance/CsvWriter.hpp"
+#include "OIT/SoftwareDepthPeeling.hpp"
+#include "TransferFunctionWindow.hpp"
+#include "MainApp.hpp"
+#include "BenchmarkSoftwareDepthPeeling.hpp"
+
+/// Same default importance criteria as PixelSyncApp::changeImportanceCriterionType.
+static int getDefaultImportanceCriterionIndex(TrajectoryType trajectoryType)
+{
+    if (trajectoryType == TRAJECTORY_TYPE_ANEURYSM) {
+        return (int)IMPORTANCE_CRITERION_ANEURYSM_VORTICITY;
+    } else if (trajectoryType == TRAJECTORY_TYPE_WCB) {
+        return (int)IMPORTANCE_CRITERION_WCB_CURVATURE;
+    } else if (trajectoryType == TRAJECTORY_TYPE_CFD) {
+        return (int)IMPORTANCE_CRITERION_CFD_CURL;
+    } else if (trajectoryType == TRAJECTORY_TYPE_UCLA) {
+        return (int)IMPORTANCE_CRITERION_UCLA_MAGNITUDE;
+    } else {
+        return (int)IMPORTANCE_CRITERION_CONVECTION_ROLLS_VORTICITY;
+    }
+}
+
+int benchmarkSoftwareDepthPeeling(const std::vector<std::string> &args)
+{
+    std::string modelName = args.size() > 0 ? args.at(0) : "Aneurysm";
+    const int width = args.size() > 1 ? sgl::fromString<int>(args.at(1)) : 1920;
+    const int height = args.size() > 2 ? sgl::fromString<int>(args.at(2)) : 1080;
+    const float framesPerSecond = args.size() > 3 ? sgl::fromString<float>(args.at(3)) : 1.0f;
+    const bool useBillboardLines = args.size() > 4 && args.at(4) == "billboards";
+
+    std::string modelFilename = getModelFilenameFromDisplayName(modelName);
+    std::string modelFilenamePure = sgl::FileUtils::get()->removeExtension(modelFilename);
+    if (modelFilename.empty()
+            || PixelSyncApp::getModelTypeFromFilename(modelFilenamePure) != MODEL_TYPE_TRAJECTORIES) {
+        sgl::Logfile::get()->writeError(std::string() + "Error in benchmarkSoftwareDepthPeeling: \"" + modelName
+                + "\" is not a line data set.");
+        return 1;
+    }
+    if (width <= 0 || height <= 0 || framesPerSecond <= 0.0f) {
+        sgl::Logfile::get()->writeError("Error in benchmarkSoftwareDepthPeeling: Invalid arguments.");
+        return 1;
+    }
+
+    CameraPath cameraPath;
+    std::string cameraPathFilename = "Data/CameraPaths/"
+            + sgl::FileUtils::get()->getPathAsList(modelFilenamePure).back() + ".binpath";
+    if (!cameraPath.fromBinaryFile(cameraPathFilename)) {
+        return 1;
+    }
+
+    TrajectoryType trajectoryType = PixelSyncApp::getTrajectoryTypeFromFilename(modelFilenamePure);
+    Trajectories trajectories = loadTrajectoriesFromFile(modelFilename, trajectoryType);
+    if (trajectories.empty()) {
+        sgl::Logfile::get()->writeError(std::string() + "Error in benchmarkSoftwareDepthPeeling: Couldn't load \""
+                + modelFilename + "\".");
+        return 1;
+    }
+
+    const glm::mat4 projectionMatrix = glm::perspective(
+            getDefaultCameraFovy(), float(width) / float(height), 0.01f, 100.0f);
+    TransferFunctionWindow transferFunctionWindow(true);
+
+    SoftwareDepthPeeling renderer;
+    renderer.setViewportSize(width, height);
+    renderer.setLineRadius(0.001f);
+    renderer.setUseBillboardLines(useBillboardLines);
+    renderer.setTransferFunction(transferFunctionWindow.getTransferFunctionMap_linearRGB());
+    renderer.setTrajectories(trajectories, getDefaultImportanceCriterionIndex(trajectoryType));
+    trajectories = Trajectories();
+
+    sgl::FileUtils::get()->ensureDirectoryExists("images/");
+    CsvWriter csvWriter("benchmark_software_depth_peeling.csv");
+    csvWriter.writeRow({"Frame", "Time (ms)", "Max. Depth Complexity", "Fragments", "Image Filename"});
+
+    double totalTimeMS = 0.0;
+    size_t maxDepthComplexity = 0;
+    AsyncFrameWriter frameWriter;
+    const int numFrames = int(std::floor(cameraPath.getEndTime() * framesPerSecond)) + 1;
+    for (int frameIdx = 0; frameIdx < numFrames; frameIdx++) {
+        cameraPath.update(float(frameIdx) / framesPerSecond);
+
+        auto start = std::chrono::high_resolution_clock::now();
+        const uint32_t *imageData = renderer.render(cameraPath.getViewMatrix(), projectionMatrix);
+        auto end = std::chrono::high_resolution_clock::now();
+        double timeMS = std::chrono::duration<double, std::milli>(end - start).count();
+        totalTimeMS += timeMS;
+        maxDepthComplexity = std::max(maxDepthComplexity, renderer.getMaxDepthComplexity());
+
+        std::string filename = std::string() + "images/software_depth_peeling_frame_"
+                + std::to_string(frameIdx + 1) + ".png";
+        frameWriter.writeFrame(imageData, width, height, filename);
+
+        csvWriter.writeRow({
+                sgl::toString(frameIdx + 1), sgl::toString(timeMS), sgl::toString(renderer.getMaxDepthComplexity()),
+                sgl::toString(renderer.getNumFragments()), filename});
+    }
+    frameWriter.wait();
+
+    sgl::Logfile::get()->writeInfo(std::string() + "Software depth peeling (" + modelName + ", "
+            + sgl::toString(renderer.getNumSegments()) + " segments): " + sgl::toString(numFrames) + " frames, "
+            + sgl::toString(totalTimeMS / double(numFrames)) + "ms per frame, max. depth complexity "
+            + sgl::toString(maxDepthComplexity));
+    return 0;
+}
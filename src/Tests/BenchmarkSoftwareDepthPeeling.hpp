@@ -0,0 +1,21 @@
+//
+// Created by christoph on 19.10.26.
+//
+
+#ifndef PIXELSYNCOIT_BENCHMARKSOFTWAREDEPTHPEELING_HPP
+#define PIXELSYNCOIT_BENCHMARKSOFTWAREDEPTHPEELING_HPP
+
+#include <string>
+#include <vector>
+
+/**
+ * Renders reference images of a line data set along its camera path (Data/CameraPaths/<data set>.binpath) with
+ * SoftwareDepthPeeling, i.e., without a GPU. The frames are stored in "images/software_depth_peeling_frame_<i>.png".
+ * Arguments (optional): [modelName (display name)] [width] [height] [framesPerSecond] [tubes|billboards]
+ * The frame times and the maximum depth complexity of each frame (i.e., the number of passes OIT_DepthPeeling needs)
+ * are written to the log file and to "benchmark_software_depth_peeling.csv".
+ * @return 0 on success, 1 if the data set or the camera path could not be loaded.
+ */
+int benchmarkSoftwareDepthPeeling(const std::vector<std::string> &args);
+
+#endif //PIXELSYNCOIT_BENCHMARKSOFTWAREDEPTHPEELING_HPP
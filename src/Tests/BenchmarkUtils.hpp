@@ -0,0 +1,40 @@
+//
+// Created by christoph on 19.10.26.
+//
+
+#ifndef PIXELSYNCOIT_BENCHMARKUTILS_HPP
+#define PIXELSYNCOIT_BENCHMARKUTILS_HPP
+
+#include <chrono>
+#include <limits>
+#include <algorithm>
+#include <functional>
+
+/// Default number of runs of measureBestMilliseconds.
+const int BENCHMARK_NUM_REPETITIONS = 3;
+
+/// Returns the wall-clock time of one call of the passed function in milliseconds.
+inline double measureMilliseconds(const std::function<void()> &function)
+{
+    auto start = std::chrono::high_resolution_clock::now();
+    function();
+    auto end = std::chrono::high_resolution_clock::now();
+    std::chrono::duration<double, std::milli> elapsed = end - start;
+    return elapsed.count();
+}
+
+/**
+ * Calls the passed function numRepetitions times and returns the shortest time in milliseconds, i.e., the time of the
+ * run least disturbed by other processes (and not slowed down by first touching the memory of the buffers).
+ */
+inline double measureBestMilliseconds(
+        const std::function<void()> &function, int numRepetitions = BENCHMARK_NUM_REPETITIONS)
+{
+    double bestTimeMS = std::numeric_limits<double>::max();
+    for (int repetition = 0; repetition < numRepetitions; repetition++) {
+        bestTimeMS = std::min(bestTimeMS, measureMilliseconds(function));
+    }
+    return bestTimeMS;
+}
+
+#endif //PIXELSYNCOIT_BENCHMARKUTILS_HPP
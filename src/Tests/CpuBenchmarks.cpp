@@ -0,0 +1,44 @@
+//
+// Created by christoph on 19.10.26.
+//
+
+#include <map>
+#include <Utils/File/Logfile.hpp>
+
+#include "BenchmarkImportanceCriteria.hpp"
+#include "BenchmarkLinePartitioning.hpp"
+#include "BenchmarkMomentMath.hpp"
+#include "BenchmarkPixelAddressing.hpp"
+#include "BenchmarkPixelSync.hpp"
+#include "BenchmarkPointLOD.hpp"
+#include "BenchmarkSoftwareDepthPeeling.hpp"
+#include "CpuBenchmarks.hpp"
+
+typedef int (*CpuBenchmarkFunction)(const std::vector<std::string>&);
+
+static const std::map<std::string, CpuBenchmarkFunction> CPU_BENCHMARKS = {
+        { "importance-criteria", benchmarkImportanceCriteria },
+        { "line-partitioning", benchmarkLinePartitioning },
+        { "moment-math", benchmarkMomentMath },
+        { "pixel-addressing", benchmarkPixelAddressing },
+        { "pixel-sync", benchmarkPixelSync },
+        { "point-lod", benchmarkPointLOD },
+        { "software-depth-peeling", benchmarkSoftwareDepthPeeling },
+};
+
+int runCpuBenchmark(const std::vector<std::string> &args)
+{
+    auto it = args.empty() ? CPU_BENCHMARKS.end() : CPU_BENCHMARKS.find(args.front());
+    if (it == CPU_BENCHMARKS.end()) {
+        std::string benchmarkNames;
+        for (auto &benchmark : CPU_BENCHMARKS) {
+            benchmarkNames += " " + benchmark.first;
+        }
+        sgl::Logfile::get()->writeError(std::string() + "Error in runCpuBenchmark: Unknown benchmark. "
+                + "Available benchmarks:" + benchmarkNames);
+        return 1;
+    }
+
+    std::vector<std::string> benchmarkArgs(args.begin() + 1, args.end());
+    return it->second(benchmarkArgs);
+}
@@ -0,0 +1,19 @@
+//
+// Created by christoph on 19.10.26.
+//
+
+#ifndef PIXELSYNCOIT_CPUBENCHMARKS_HPP
+#define PIXELSYNCOIT_CPUBENCHMARKS_HPP
+
+#include <string>
+#include <vector>
+
+/**
+ * Runs a CPU micro-benchmark without creating a window.
+ * Usage: PixelSyncOIT --benchmark <name> [arguments...]
+ * @param args The benchmark name followed by its arguments.
+ * @return The exit code of the application.
+ */
+int runCpuBenchmark(const std::vector<std::string> &args);
+
+#endif //PIXELSYNCOIT_CPUBENCHMARKS_HPP
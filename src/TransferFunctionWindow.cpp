@@ -28,7 +28,7 @@ const size_t TRANSFER_FUNCTION_TEXTURE_SIZE = 256;
 
 TransferFunctionWindow *g_TransferFunctionWindowHandle = NULL;
 
-TransferFunctionWindow::TransferFunctionWindow()
+TransferFunctionWindow::TransferFunctionWindow(bool headless)
 {
     colorPoints = { ColorPoint_sRGB(sgl::Color(255, 255, 255), 0.0f), ColorPoint_sRGB(sgl::Color(255, 0, 0), 1.0f) };
     /*colorPoints = { ColorPoint(sgl::Color(255, 255, 255), 0.0f),
@@ -40,7 +40,10 @@ TransferFunctionWindow::TransferFunctionWindow()
     transferFunctionMap_linearRGB.resize(TRANSFER_FUNCTION_TEXTURE_SIZE);
     tfMapTextureSettings.type = sgl::TEXTURE_1D;
     tfMapTextureSettings.internalFormat = GL_RGBA16;
-    tfMapTexture = sgl::TextureManager->createEmptyTexture(TRANSFER_FUNCTION_TEXTURE_SIZE, tfMapTextureSettings);
+    if (!headless) {
+        tfMapTexture = sgl::TextureManager->createEmptyTexture(
+                TRANSFER_FUNCTION_TEXTURE_SIZE, tfMapTextureSettings);
+    }
     updateAvailableFiles();
     rebuildTransferFunctionMap();
 
@@ -414,9 +417,10 @@ void TransferFunctionWindow::rebuildTransferFunctionMap()
         rebuildTransferFunctionMap_sRGB();
     }
 
-    if (useLinearRGB) {
+    // No texture exists in headless mode.
+    if (tfMapTexture && useLinearRGB) {
         tfMapTexture->uploadPixelData(TRANSFER_FUNCTION_TEXTURE_SIZE, &transferFunctionMap_linearRGB.front());
-    } else {
+    } else if (tfMapTexture) {
         tfMapTexture->uploadPixelData(TRANSFER_FUNCTION_TEXTURE_SIZE, &transferFunctionMap_sRGB.front());
     }
 
@@ -56,7 +56,8 @@ enum SelectedPointType {
 class TransferFunctionWindow
 {
 public:
-    TransferFunctionWindow();
+    /// @param headless If true, no OpenGL texture is created for the transfer function map (e.g., for batch modes).
+    TransferFunctionWindow(bool headless = false);
     bool saveFunctionToFile(const std::string &filename);
     bool loadFunctionFromFile(const std::string &filename);
     void updateAvailableFiles();
@@ -73,6 +74,7 @@ public:
     // For querying transfer function in application
     float getOpacityAtAttribute(float attribute); // attribute: Between 0 and 1
     const std::vector<sgl::Color> &getTransferFunctionMap_sRGB() { return transferFunctionMap_sRGB; }
+    const std::vector<sgl::Color> &getTransferFunctionMap_linearRGB() { return transferFunctionMap_linearRGB; }
 
     // For OpenGL: Has 256 entries. Get mapped color for normalized attribute by accessing entry at "attr*255".
     sgl::TexturePtr &getTransferFunctionMapTexture();
@@ -0,0 +1,316 @@
+//
+// Created by christoph on 19.10.26.
+//
+
+#include <fstream>
+#include <sstream>
+#include <cstring>
+#include <cstdio>
+#include <algorithm>
+#include <boost/filesystem.hpp>
+#include <Utils/File/Logfile.hpp>
+
+#include "MappedFile.hpp"
+#include "AssetCache.hpp"
+
+/// Number of background conversion threads (each conversion is parallelized with OpenMP itself).
+const unsigned int ASSET_CACHE_NUM_WORKER_THREADS = 2;
+
+static const uint64_t FNV_OFFSET_BASIS = 14695981039346656037ull;
+static const uint64_t FNV_PRIME = 1099511628211ull;
+
+/// FNV-1a hash (processing 8 bytes at once).
+static uint64_t hashBytes(const char *data, size_t size, uint64_t hash = FNV_OFFSET_BASIS)
+{
+    size_t i = 0;
+    for (; i + sizeof(uint64_t) <= size; i += sizeof(uint64_t)) {
+        uint64_t word;
+        memcpy(&word, data + i, sizeof(uint64_t));
+        hash = (hash ^ word) * FNV_PRIME;
+    }
+    for (; i < size; i++) {
+        hash = (hash ^ uint64_t(uint8_t(data[i]))) * FNV_PRIME;
+    }
+    return hash;
+}
+
+static std::string toHexString(uint64_t value)
+{
+    char buffer[17];
+    snprintf(buffer, sizeof(buffer), "%016llx", (unsigned long long)value);
+    return buffer;
+}
+
+AssetCache *AssetCache::get()
+{
+    static AssetCache assetCache;
+    return &assetCache;
+}
+
+AssetCache::AssetCache()
+{
+    loadIndex();
+}
+
+AssetCache::~AssetCache()
+{
+    {
+        std::lock_guard<std::mutex> lock(jobMutex);
+        stopWorkerThreads = true;
+    }
+    jobCondition.notify_all();
+    for (std::thread &workerThread : workerThreads) {
+        workerThread.join();
+    }
+}
+
+std::string AssetCache::getCachedFilename(
+        const std::string &sourceFilename, const std::string &conversionParameters, const std::string &extension)
+{
+    uint64_t hash = getContentHash(sourceFilename);
+    std::string key = conversionParameters + '\0' + extension;
+    hash = hashBytes(key.c_str(), key.size(), hash);
+    std::string cachedFilename = cacheDirectory + boost::filesystem::path(sourceFilename).stem().string()
+            + "_" + toHexString(hash) + "." + extension;
+
+    std::lock_guard<std::mutex> lock(indexMutex);
+    if (assetEntries.find(cachedFilename) == assetEntries.end()) {
+        assetEntries[cachedFilename] = std::make_pair(sourceFilename, conversionParameters);
+        saveIndex();
+    }
+    return cachedFilename;
+}
+
+bool AssetCache::lookupContentHash(
+        const std::string &sourceFilename, uint64_t &fileSize, int64_t &modificationTime, uint64_t &contentHash)
+{
+    boost::system::error_code errorCode;
+    fileSize = boost::filesystem::file_size(sourceFilename, errorCode);
+    if (errorCode) {
+        // The source file doesn't exist: Hash the file name only (the conversion will report the error).
+        contentHash = hashBytes(sourceFilename.c_str(), sourceFilename.size());
+        return true;
+    }
+    modificationTime = int64_t(boost::filesystem::last_write_time(sourceFilename, errorCode));
+
+    std::lock_guard<std::mutex> lock(indexMutex);
+    auto it = sourceEntries.find(sourceFilename);
+    if (it != sourceEntries.end() && it->second.fileSize == fileSize
+            && it->second.modificationTime == modificationTime) {
+        contentHash = it->second.contentHash;
+        return true;
+    }
+    return false;
+}
+
+bool AssetCache::isContentHashCached(const std::string &sourceFilename)
+{
+    uint64_t fileSize, contentHash;
+    int64_t modificationTime;
+    return lookupContentHash(sourceFilename, fileSize, modificationTime, contentHash);
+}
+
+uint64_t AssetCache::getContentHash(const std::string &sourceFilename)
+{
+    uint64_t fileSize, contentHash;
+    int64_t modificationTime;
+    if (lookupContentHash(sourceFilename, fileSize, modificationTime, contentHash)) {
+        return contentHash;
+    }
+
+    sgl::Logfile::get()->writeInfo(std::string() + "Hashing \"" + sourceFilename
+            + "\" (only done on the first load of a new or changed file)...");
+    MappedFile file;
+    if (!file.open(sourceFilename)) {
+        return hashBytes(sourceFilename.c_str(), sourceFilename.size());
+    }
+
+    // Hash fixed-size chunks in parallel and combine the chunk hashes (independent of the number of threads).
+    const size_t CHUNK_SIZE = size_t(16) << 20;
+    const char *data = file.getData();
+    const size_t size = file.getSize();
+    const int numChunks = int((size + CHUNK_SIZE - 1) / CHUNK_SIZE);
+    std::vector<uint64_t> chunkHashes(numChunks);
+    #pragma omp parallel for
+    for (int chunkIdx = 0; chunkIdx < numChunks; chunkIdx++) {
+        size_t chunkStart = size_t(chunkIdx) * CHUNK_SIZE;
+        chunkHashes[chunkIdx] = hashBytes(data + chunkStart, std::min(CHUNK_SIZE, size - chunkStart));
+    }
+    contentHash = hashBytes(
+            reinterpret_cast<const char*>(chunkHashes.data()), chunkHashes.size() * sizeof(uint64_t));
+
+    std::lock_guard<std::mutex> lock(indexMutex);
+    SourceEntry &entry = sourceEntries[sourceFilename];
+    entry.fileSize = fileSize;
+    entry.modificationTime = modificationTime;
+    entry.contentHash = contentHash;
+    saveIndex();
+    return contentHash;
+}
+
+bool AssetCache::convert(const std::string &cachedFilename, ConversionFunction conversionFunction)
+{
+    {
+        // A background job might be writing the same temporary file: Wait for it and use its result.
+        std::unique_lock<std::mutex> lock(jobMutex);
+        if (pendingConversions.find(cachedFilename) != pendingConversions.end()) {
+            conversionFinishedCondition.wait(lock, [this, &cachedFilename]() {
+                return pendingConversions.find(cachedFilename) == pendingConversions.end();
+            });
+            if (boost::filesystem::exists(cachedFilename)) {
+                return true;
+            }
+        }
+        pendingConversions.insert(cachedFilename);
+    }
+
+    bool succeeded = convertToCachedFile(cachedFilename, conversionFunction);
+
+    // Background requests for the same file made in the meantime were skipped, so report the result to them, too.
+    std::lock_guard<std::mutex> lock(jobMutex);
+    pendingConversions.erase(cachedFilename);
+    finishedConversions.push_back(FinishedConversion{ cachedFilename, succeeded });
+    conversionFinishedCondition.notify_all();
+    return succeeded;
+}
+
+bool AssetCache::convertToCachedFile(const std::string &cachedFilename, ConversionFunction conversionFunction)
+{
+    boost::system::error_code errorCode;
+    boost::filesystem::create_directories(cacheDirectory, errorCode);
+
+    // Write to a temporary file first, so that a partially written file is never used. Leftovers of crashed or
+    // failed earlier conversions are removed first, so that they can never be renamed to the cached file.
+    std::string temporaryFilename = cachedFilename + ".tmp";
+    boost::filesystem::remove(temporaryFilename, errorCode);
+    if (!conversionFunction(temporaryFilename) || !boost::filesystem::exists(temporaryFilename)) {
+        sgl::Logfile::get()->writeError(std::string() + "Error in AssetCache::convert: Couldn't create \""
+                + cachedFilename + "\".");
+        boost::filesystem::remove(temporaryFilename, errorCode);
+        return false;
+    }
+    boost::filesystem::rename(temporaryFilename, cachedFilename, errorCode);
+    if (errorCode) {
+        sgl::Logfile::get()->writeError(std::string() + "Error in AssetCache::convert: Couldn't rename \""
+                + temporaryFilename + "\".");
+        return false;
+    }
+    return true;
+}
+
+void AssetCache::requestContentHash(const std::string &sourceFilename)
+{
+    requestConversion(sourceFilename, ConversionFunction());
+}
+
+void AssetCache::requestConversion(const std::string &cachedFilename, ConversionFunction conversionFunction)
+{
+    std::lock_guard<std::mutex> lock(jobMutex);
+    if (pendingConversions.find(cachedFilename) != pendingConversions.end()) {
+        return;
+    }
+    if (workerThreads.empty()) {
+        for (unsigned int i = 0; i < ASSET_CACHE_NUM_WORKER_THREADS; i++) {
+            workerThreads.push_back(std::thread(&AssetCache::workerThreadFunction, this));
+        }
+    }
+    pendingConversions.insert(cachedFilename);
+    jobQueue.push_back(ConversionJob{ cachedFilename, conversionFunction });
+    jobCondition.notify_one();
+}
+
+bool AssetCache::isConversionPending(const std::string &cachedFilename)
+{
+    std::lock_guard<std::mutex> lock(jobMutex);
+    return pendingConversions.find(cachedFilename) != pendingConversions.end();
+}
+
+std::vector<AssetCache::FinishedConversion> AssetCache::popFinishedConversions()
+{
+    std::lock_guard<std::mutex> lock(jobMutex);
+    std::vector<FinishedConversion> conversions;
+    conversions.swap(finishedConversions);
+    return conversions;
+}
+
+void AssetCache::workerThreadFunction()
+{
+    while (true) {
+        ConversionJob job;
+        {
+            std::unique_lock<std::mutex> lock(jobMutex);
+            jobCondition.wait(lock, [this]() { return stopWorkerThreads || !jobQueue.empty(); });
+            if (stopWorkerThreads) {
+                return;
+            }
+            job = jobQueue.front();
+            jobQueue.pop_front();
+        }
+
+        bool succeeded = true;
+        if (job.conversionFunction) {
+            sgl::Logfile::get()->writeInfo(std::string() + "Converting \"" + job.cachedFilename
+                    + "\" in the background...");
+            succeeded = convertToCachedFile(job.cachedFilename, job.conversionFunction);
+        } else {
+            getContentHash(job.cachedFilename);
+        }
+
+        std::lock_guard<std::mutex> lock(jobMutex);
+        pendingConversions.erase(job.cachedFilename);
+        finishedConversions.push_back(FinishedConversion{ job.cachedFilename, succeeded });
+        conversionFinishedCondition.notify_all();
+    }
+}
+
+void AssetCache::loadIndex()
+{
+    std::ifstream file(indexFilename.c_str());
+    if (!file.is_open()) {
+        return;
+    }
+
+    // Format: "source <hash> <size> <modification time> <filename>" or "asset <file>\t<source>\t<parameters>".
+    std::string line;
+    while (std::getline(file, line)) {
+        if (line.compare(0, 7, "source ") == 0) {
+            std::istringstream lineStream(line.substr(7));
+            std::string hashString, filename;
+            SourceEntry entry;
+            lineStream >> hashString >> entry.fileSize >> entry.modificationTime;
+            lineStream.ignore(1);
+            std::getline(lineStream, filename);
+            if (!lineStream.fail() && !filename.empty()) {
+                entry.contentHash = std::stoull(hashString, nullptr, 16);
+                sourceEntries[filename] = entry;
+            }
+        } else if (line.compare(0, 6, "asset ") == 0) {
+            size_t separator0 = line.find('\t', 6);
+            size_t separator1 = separator0 == std::string::npos ? separator0 : line.find('\t', separator0 + 1);
+            if (separator1 != std::string::npos) {
+                assetEntries[line.substr(6, separator0 - 6)] = std::make_pair(
+                        line.substr(separator0 + 1, separator1 - separator0 - 1), line.substr(separator1 + 1));
+            }
+        }
+    }
+}
+
+void AssetCache::saveIndex()
+{
+    boost::system::error_code errorCode;
+    boost::filesystem::create_directories(cacheDirectory, errorCode);
+    std::ofstream file(indexFilename.c_str());
+    if (!file.is_open()) {
+        sgl::Logfile::get()->writeError(std::string() + "Error in AssetCache::saveIndex: Couldn't open \""
+                + indexFilename + "\".");
+        return;
+    }
+    for (auto &sourceEntry : sourceEntries) {
+        file << "source " << toHexString(sourceEntry.second.contentHash) << " " << sourceEntry.second.fileSize << " "
+             << sourceEntry.second.modificationTime << " " << sourceEntry.first << "\n";
+    }
+    for (auto &assetEntry : assetEntries) {
+        file << "asset " << assetEntry.first << "\t" << assetEntry.second.first << "\t"
+             << assetEntry.second.second << "\n";
+    }
+}
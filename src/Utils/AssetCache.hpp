@@ -0,0 +1,122 @@
+//
+// Created by christoph on 19.10.26.
+//
+
+#ifndef PIXELSYNCOIT_ASSETCACHE_HPP
+#define PIXELSYNCOIT_ASSETCACHE_HPP
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <map>
+#include <set>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <cstdint>
+
+/**
+ * Cache for converted assets (e.g., .binmesh and .voxel files created from .obj, .hair, .dat or .bobj files).
+ * The cached file name contains a hash of the content of the source file and of the conversion parameters (line
+ * radius, number of circle segments, grid resolution, trajectory type, ...). Thus, changing the source file or the
+ * parameters automatically invalidates the cached asset, and assets converted with different parameters can coexist.
+ *
+ * The cache directory contains an index file, which stores the content hash of each source file together with its
+ * size and modification time (so that unchanged source files don't need to be hashed again) and the list of
+ * converted assets.
+ *
+ * Conversions can either be run synchronously (convert) or on a pool of background threads (requestConversion).
+ * The same holds for hashing new source files (getCachedFilename or requestContentHash).
+ * The converted file is first written to a temporary file and renamed when the conversion has finished, i.e., a
+ * cached file is never read while it is still being written.
+ */
+class AssetCache
+{
+public:
+    /// Writes the converted asset to the passed file name. Returns false if the conversion failed.
+    typedef std::function<bool(const std::string &outputFilename)> ConversionFunction;
+
+    struct FinishedConversion {
+        std::string cachedFilename;
+        bool succeeded;
+    };
+
+    static AssetCache *get();
+    ~AssetCache();
+
+    /**
+     * @param sourceFilename The file the asset is converted from.
+     * @param conversionParameters All parameters influencing the conversion (e.g., "lineRadius=0.001;segments=3").
+     * @param extension The file extension of the converted asset (e.g., "binmesh").
+     * @return The file name of the converted asset in the cache directory (the file might not exist yet).
+     * NOTE: If the source file is new or has changed since the last hashing, its content is hashed on the calling
+     * thread (see isContentHashCached and requestContentHash).
+     */
+    std::string getCachedFilename(
+            const std::string &sourceFilename, const std::string &conversionParameters, const std::string &extension);
+
+    /// Returns whether getCachedFilename can compute the cached file name without reading the source file.
+    bool isContentHashCached(const std::string &sourceFilename);
+    /**
+     * Hashes the source file on one of the background worker threads. The finished job is reported by
+     * popFinishedConversions with the source file name as cachedFilename.
+     */
+    void requestContentHash(const std::string &sourceFilename);
+
+    /**
+     * Converts the asset synchronously on the calling thread. If a background conversion to the same file is pending,
+     * it is waited for instead.
+     */
+    bool convert(const std::string &cachedFilename, ConversionFunction conversionFunction);
+
+    /**
+     * Adds a conversion job to the queue of the background worker threads. Nothing is done if a conversion to the
+     * same cached file name is already pending. Finished jobs are reported by popFinishedConversions.
+     * NOTE: The conversion function must not use OpenGL.
+     */
+    void requestConversion(const std::string &cachedFilename, ConversionFunction conversionFunction);
+    bool isConversionPending(const std::string &cachedFilename);
+    /// Returns the background conversions finished since the last call (to be polled by the main thread).
+    std::vector<FinishedConversion> popFinishedConversions();
+
+private:
+    AssetCache();
+    /// Converts to the temporary file and renames it to the cached file name on success.
+    bool convertToCachedFile(const std::string &cachedFilename, ConversionFunction conversionFunction);
+    uint64_t getContentHash(const std::string &sourceFilename);
+    /// Returns false if the source file needs to be hashed (fileSize and modificationTime are set in this case).
+    bool lookupContentHash(
+            const std::string &sourceFilename, uint64_t &fileSize, int64_t &modificationTime, uint64_t &contentHash);
+    void loadIndex();
+    void saveIndex();
+    void workerThreadFunction();
+
+    struct SourceEntry {
+        uint64_t fileSize;
+        int64_t modificationTime;
+        uint64_t contentHash;
+    };
+    struct ConversionJob {
+        std::string cachedFilename; ///< The source file name for jobs only hashing the source file.
+        ConversionFunction conversionFunction; ///< Empty for jobs only hashing the source file.
+    };
+
+    const std::string cacheDirectory = "Data/Cache/";
+    const std::string indexFilename = "Data/Cache/index.txt";
+    std::mutex indexMutex;
+    std::map<std::string, SourceEntry> sourceEntries;
+    /// Maps the cached file name to the source file name and the conversion parameters.
+    std::map<std::string, std::pair<std::string, std::string>> assetEntries;
+
+    std::mutex jobMutex;
+    std::condition_variable jobCondition;
+    std::condition_variable conversionFinishedCondition;
+    std::deque<ConversionJob> jobQueue;
+    std::set<std::string> pendingConversions;
+    std::vector<FinishedConversion> finishedConversions;
+    std::vector<std::thread> workerThreads;
+    bool stopWorkerThreads = false;
+};
+
+#endif //PIXELSYNCOIT_ASSETCACHE_HPP
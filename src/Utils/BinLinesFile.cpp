@@ -0,0 +1,125 @@
+//
+// Created by christoph on 19.10.26.
+//
+
+#include <cmath>
+#include <cstring>
+#include <Utils/File/Logfile.hpp>
+#include <Utils/Convert.hpp>
+
+#include "BinLinesFile.hpp"
+
+static inline uint32_t readUint32(const char *data, size_t offset)
+{
+    uint32_t value;
+    memcpy(&value, data + offset, sizeof(uint32_t));
+    return value;
+}
+
+bool BinLinesFile::open(const std::string &filename)
+{
+    lineDataOffsets.clear();
+    lineOffsets.clear();
+    numAttributes = 0;
+    if (!file.open(filename)) {
+        return false;
+    }
+
+    const char *data = file.getData();
+    const size_t fileSize = file.getSize();
+    const size_t HEADER_SIZE = 3 * sizeof(uint32_t);
+    if (fileSize < HEADER_SIZE) {
+        sgl::Logfile::get()->writeError(std::string() + "Error in BinLinesFile::open: File \""
+                + filename + "\" is too small.");
+        file.close();
+        return false;
+    }
+
+    // Read format version
+    const uint32_t LINE_FILE_FORMAT_VERSION = 1u;
+    uint32_t versionNumber = readUint32(data, 0);
+    if (versionNumber != LINE_FILE_FORMAT_VERSION) {
+        sgl::Logfile::get()->writeError(std::string()
+                + "Error in BinLinesFile::open: Invalid magic number in file \"" + filename + "\".");
+        file.close();
+        return false;
+    }
+
+    // The line headers are chained (each line stores its size), thus the line table is built sequentially. This only
+    // touches one value per line and is cheap compared to reading the point data.
+    uint32_t numLines = readUint32(data, 4);
+    numAttributes = readUint32(data, 8);
+    const size_t pointSize = sizeof(glm::vec3) + size_t(numAttributes) * sizeof(float);
+    lineDataOffsets.reserve(numLines);
+    lineOffsets.reserve(size_t(numLines) + 1);
+    lineOffsets.push_back(0);
+    size_t offset = HEADER_SIZE;
+    bool countsValid = true;
+    for (uint32_t lineIdx = 0; lineIdx < numLines; lineIdx++) {
+        if (offset + sizeof(uint32_t) > fileSize) {
+            countsValid = false;
+            break;
+        }
+        size_t numPoints = readUint32(data, offset);
+        offset += sizeof(uint32_t);
+        if (numPoints > (fileSize - offset) / pointSize) {
+            countsValid = false;
+            break;
+        }
+        lineDataOffsets.push_back(offset);
+        lineOffsets.push_back(lineOffsets.back() + numPoints);
+        offset += numPoints * pointSize;
+    }
+    if (!countsValid) {
+        sgl::Logfile::get()->writeError(std::string() + "Error in BinLinesFile::open: The declared number of lines "
+                + "or points exceeds the size of file \"" + filename + "\".");
+        lineDataOffsets.clear();
+        lineOffsets.clear();
+        numAttributes = 0;
+        file.close();
+        return false;
+    }
+    if (offset != fileSize) {
+        sgl::Logfile::get()->writeInfo(std::string() + "Warning in BinLinesFile::open: "
+                + sgl::toString(fileSize - offset) + " unused bytes at the end of file \"" + filename + "\".");
+    }
+    return true;
+}
+
+size_t BinLinesFile::countInvalidPoints() const
+{
+    const float MAX_VAL = 1e10f;
+    const int numLines = int(getNumLines());
+    size_t numInvalidPoints = 0;
+    #pragma omp parallel for reduction(+:numInvalidPoints) schedule(dynamic, 64)
+    for (int lineIdx = 0; lineIdx < numLines; lineIdx++) {
+        ArrayView<const glm::vec3> positions = getLinePositions(lineIdx);
+        for (const glm::vec3 &pos : positions) {
+            if (std::fabs(pos.x) > MAX_VAL || std::fabs(pos.y) > MAX_VAL || std::fabs(pos.z) > MAX_VAL) {
+                numInvalidPoints++;
+            }
+        }
+    }
+    return numInvalidPoints;
+}
+
+void BinLinesFile::copyToTrajectories(Trajectories &trajectories) const
+{
+    trajectories.clear(numAttributes);
+    trajectories.lineOffsets = lineOffsets.empty() ? std::vector<size_t>{ 0 } : lineOffsets;
+    trajectories.positions.resize(getNumPoints());
+    for (std::vector<float> &attribute : trajectories.attributes) {
+        attribute.resize(getNumPoints());
+    }
+
+    trajectories.forEachLineParallel([&](size_t lineIdx) {
+        const size_t lineOffset = lineOffsets[lineIdx];
+        ArrayView<const glm::vec3> positions = getLinePositions(lineIdx);
+        memcpy(trajectories.positions.data() + lineOffset, positions.data(), positions.size() * sizeof(glm::vec3));
+        for (size_t attributeIdx = 0; attributeIdx < numAttributes; attributeIdx++) {
+            ArrayView<const float> attribute = getLineAttribute(lineIdx, attributeIdx);
+            memcpy(trajectories.attributes[attributeIdx].data() + lineOffset, attribute.data(),
+                   attribute.size() * sizeof(float));
+        }
+    });
+}
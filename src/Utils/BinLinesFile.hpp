@@ -0,0 +1,68 @@
+//
+// Created by christoph on 19.10.26.
+//
+
+#ifndef PIXELSYNCOIT_BINLINESFILE_HPP
+#define PIXELSYNCOIT_BINLINESFILE_HPP
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <glm/glm.hpp>
+
+#include "MappedFile.hpp"
+#include "TrajectoryFile.hpp"
+
+/**
+ * Read-only view of a memory-mapped .binlines file. The line data is never copied: The per-line views point directly
+ * into the file mapping.
+ *
+ * File layout (all values 4 bytes, little endian): uint32 format version (1), uint32 numLines, uint32 numAttributes.
+ * For each line: uint32 numPoints, numPoints vec3 positions, numAttributes arrays of numPoints floats.
+ */
+class BinLinesFile
+{
+public:
+    /**
+     * Maps the file and builds the table of line offsets. The declared point counts are checked against the file
+     * size, i.e., after a successful call all views are valid.
+     * @return False if the file could not be opened or is malformed.
+     */
+    bool open(const std::string &filename);
+
+    inline size_t getNumLines() const { return lineDataOffsets.size(); }
+    inline size_t getNumAttributes() const { return numAttributes; }
+    inline size_t getNumPoints() const { return lineOffsets.empty() ? 0 : lineOffsets.back(); }
+    inline size_t getLineNumPoints(size_t lineIdx) const { return lineOffsets[lineIdx+1] - lineOffsets[lineIdx]; }
+
+    inline ArrayView<const glm::vec3> getLinePositions(size_t lineIdx) const {
+        return ArrayView<const glm::vec3>(reinterpret_cast<const glm::vec3*>(
+                file.getData() + lineDataOffsets[lineIdx]), getLineNumPoints(lineIdx));
+    }
+    inline ArrayView<const float> getLineAttribute(size_t lineIdx, size_t attributeIdx) const {
+        const size_t numPoints = getLineNumPoints(lineIdx);
+        return ArrayView<const float>(reinterpret_cast<const float*>(
+                file.getData() + lineDataOffsets[lineIdx] + numPoints * (sizeof(glm::vec3)
+                + attributeIdx * sizeof(float))), numPoints);
+    }
+
+    /**
+     * Scans all points in parallel for positions marked as invalid (coordinates with an absolute value > 1e10, used
+     * in many scientific data sets to indicate invalid lines).
+     * @return The number of invalid points.
+     */
+    size_t countInvalidPoints() const;
+
+    /// Copies all lines to the flat arrays of the passed trajectories (in parallel).
+    void copyToTrajectories(Trajectories &trajectories) const;
+
+private:
+    MappedFile file;
+    uint32_t numAttributes = 0;
+    /// Byte offset of the position array of each line in the file.
+    std::vector<size_t> lineDataOffsets;
+    /// Point offsets of the lines (prefix sum of the point counts, numLines + 1 entries).
+    std::vector<size_t> lineOffsets;
+};
+
+#endif //PIXELSYNCOIT_BINLINESFILE_HPP
@@ -33,8 +33,9 @@
  * Converts the content of a binary OBJ file to the binmesh format.
  * @param objFilename The filename of the .bobj file
  * @param binaryFilename: The filename of the binary output file.
+ * @return False if the input couldn't be read or the output couldn't be written.
  */
-void convertBinaryObjMeshToBinmesh(
+bool convertBinaryObjMeshToBinmesh(
         const std::string &bobjFilename,
         const std::string &binaryFilename);
 
@@ -0,0 +1,241 @@
+//
+// Created by christoph on 19.10.26.
+//
+
+#include <cassert>
+#include <algorithm>
+#include <numeric>
+#include <cfloat>
+
+#include "Frustum.hpp"
+#include "ChunkBVH.hpp"
+
+void ChunkBVH::build(const std::vector<sgl::AABB3> &chunkBoundingBoxes)
+{
+    nodes.clear();
+    chunkIndices.clear();
+    chunkMinX.clear(); chunkMinY.clear(); chunkMinZ.clear();
+    chunkMaxX.clear(); chunkMaxY.clear(); chunkMaxZ.clear();
+    if (chunkBoundingBoxes.empty()) {
+        return;
+    }
+
+    const size_t numChunks = chunkBoundingBoxes.size();
+    std::vector<glm::vec3> centroids(numChunks);
+    for (size_t i = 0; i < numChunks; i++) {
+        centroids.at(i) = chunkBoundingBoxes.at(i).getCenter();
+    }
+    std::vector<uint32_t> chunkOrder(numChunks);
+    std::iota(chunkOrder.begin(), chunkOrder.end(), 0);
+
+    nodes.reserve(2 * (numChunks / MAX_CHUNKS_PER_LEAF + 1));
+    chunkIndices.reserve(numChunks);
+    nodes.push_back(Node());
+    buildNode(0, 0, chunkBoundingBoxes, centroids, chunkOrder.data(), chunkOrder.data() + numChunks);
+
+    // Copy the boxes to the SoA arrays in leaf order.
+    chunkMinX.resize(numChunks); chunkMinY.resize(numChunks); chunkMinZ.resize(numChunks);
+    chunkMaxX.resize(numChunks); chunkMaxY.resize(numChunks); chunkMaxZ.resize(numChunks);
+    for (size_t i = 0; i < numChunks; i++) {
+        const sgl::AABB3 &boundingBox = chunkBoundingBoxes.at(chunkIndices.at(i));
+        chunkMinX.at(i) = boundingBox.min.x;
+        chunkMinY.at(i) = boundingBox.min.y;
+        chunkMinZ.at(i) = boundingBox.min.z;
+        chunkMaxX.at(i) = boundingBox.max.x;
+        chunkMaxY.at(i) = boundingBox.max.y;
+        chunkMaxZ.at(i) = boundingBox.max.z;
+    }
+}
+
+void ChunkBVH::buildNode(
+        uint32_t nodeIdx, uint32_t depth, const std::vector<sgl::AABB3> &chunkBoundingBoxes,
+        const std::vector<glm::vec3> &centroids, uint32_t *chunkBegin, uint32_t *chunkEnd)
+{
+    // The median split guarantees a depth of at most log2(#chunks) + 1, i.e., less than 33 for 32-bit indices.
+    assert(depth + 1 < uint32_t(NODE_STACK_SIZE));
+    glm::vec3 boundingBoxMin(FLT_MAX), boundingBoxMax(-FLT_MAX);
+    glm::vec3 centroidMin(FLT_MAX), centroidMax(-FLT_MAX);
+    for (uint32_t *it = chunkBegin; it != chunkEnd; it++) {
+        boundingBoxMin = glm::min(boundingBoxMin, chunkBoundingBoxes.at(*it).min);
+        boundingBoxMax = glm::max(boundingBoxMax, chunkBoundingBoxes.at(*it).max);
+        centroidMin = glm::min(centroidMin, centroids.at(*it));
+        centroidMax = glm::max(centroidMax, centroids.at(*it));
+    }
+    nodes.at(nodeIdx).boundingBoxMin = boundingBoxMin;
+    nodes.at(nodeIdx).boundingBoxMax = boundingBoxMax;
+
+    const uint32_t numChunks = uint32_t(chunkEnd - chunkBegin);
+    if (numChunks <= MAX_CHUNKS_PER_LEAF) {
+        nodes.at(nodeIdx).firstChildOrChunk = uint32_t(chunkIndices.size());
+        nodes.at(nodeIdx).numChunks = numChunks;
+        chunkIndices.insert(chunkIndices.end(), chunkBegin, chunkEnd);
+        return;
+    }
+
+    // Median split along the axis with the largest centroid extent.
+    glm::vec3 centroidExtent = centroidMax - centroidMin;
+    int axis = 0;
+    if (centroidExtent.y > centroidExtent[axis]) axis = 1;
+    if (centroidExtent.z > centroidExtent[axis]) axis = 2;
+    uint32_t *chunkMiddle = chunkBegin + numChunks / 2;
+    std::nth_element(chunkBegin, chunkMiddle, chunkEnd, [&](uint32_t a, uint32_t b) {
+        return centroids.at(a)[axis] < centroids.at(b)[axis];
+    });
+
+    const uint32_t firstChild = uint32_t(nodes.size());
+    nodes.at(nodeIdx).firstChildOrChunk = firstChild;
+    nodes.at(nodeIdx).numChunks = 0;
+    nodes.push_back(Node());
+    nodes.push_back(Node());
+    buildNode(firstChild, depth + 1, chunkBoundingBoxes, centroids, chunkBegin, chunkMiddle);
+    buildNode(firstChild + 1, depth + 1, chunkBoundingBoxes, centroids, chunkMiddle, chunkEnd);
+}
+
+bool ChunkBVH::computeViewDepthRange(
+        const glm::mat4 &mvMatrix, const glm::mat4 &projectionMatrix, float nearDistance, float farDistance,
+        float &minDepth, float &maxDepth) const
+{
+    if (nodes.empty()) {
+        return false;
+    }
+
+    glm::vec4 frustumPlanes[6];
+    extractFrustumPlanes(projectionMatrix * mvMatrix, frustumPlanes);
+    float planeX[6], planeY[6], planeZ[6], planeW[6];
+    for (int i = 0; i < 6; i++) {
+        planeX[i] = frustumPlanes[i].x;
+        planeY[i] = frustumPlanes[i].y;
+        planeZ[i] = frustumPlanes[i].z;
+        planeW[i] = frustumPlanes[i].w;
+    }
+
+    // The view depth of a point p is dot(depthAxis, p) + depthOffset (the camera looks along the negative z axis).
+    const glm::vec3 depthAxis(-mvMatrix[0][2], -mvMatrix[1][2], -mvMatrix[2][2]);
+    const float depthOffset = -mvMatrix[3][2];
+    const glm::vec3 absDepthAxis = glm::abs(depthAxis);
+
+    float currentMinDepth = FLT_MAX, currentMaxDepth = -FLT_MAX;
+    const float *minX = chunkMinX.data(), *minY = chunkMinY.data(), *minZ = chunkMinZ.data();
+    const float *maxX = chunkMaxX.data(), *maxY = chunkMaxY.data(), *maxZ = chunkMaxZ.data();
+
+    uint32_t nodeStack[NODE_STACK_SIZE];
+    int stackSize = 0;
+    nodeStack[stackSize++] = 0;
+    while (stackSize > 0) {
+        const Node &node = nodes[nodeStack[--stackSize]];
+        if (!isBoxInFrustum(node.boundingBoxMin, node.boundingBoxMax, frustumPlanes)) {
+            continue;
+        }
+
+        // Subtrees whose depth range lies within the current range can't extend it.
+        glm::vec3 center = 0.5f * (node.boundingBoxMin + node.boundingBoxMax);
+        glm::vec3 halfExtent = 0.5f * (node.boundingBoxMax - node.boundingBoxMin);
+        float centerDepth = glm::dot(depthAxis, center) + depthOffset;
+        float depthExtent = glm::dot(absDepthAxis, halfExtent);
+        float nodeMinDepth = std::max(centerDepth - depthExtent, nearDistance);
+        float nodeMaxDepth = std::min(centerDepth + depthExtent, farDistance);
+        if (nodeMinDepth >= currentMinDepth && nodeMaxDepth <= currentMaxDepth) {
+            continue;
+        }
+
+        if (node.numChunks == 0) {
+            assert(stackSize + 2 <= NODE_STACK_SIZE);
+            nodeStack[stackSize++] = node.firstChildOrChunk;
+            nodeStack[stackSize++] = node.firstChildOrChunk + 1;
+            continue;
+        }
+
+        // Leaf: Frustum test and depth range of all chunk boxes in one SIMD loop.
+        float leafMinDepth = currentMinDepth, leafMaxDepth = currentMaxDepth;
+        const uint32_t chunkBegin = node.firstChildOrChunk, chunkEnd = chunkBegin + node.numChunks;
+        #pragma omp simd reduction(min:leafMinDepth) reduction(max:leafMaxDepth)
+        for (uint32_t i = chunkBegin; i < chunkEnd; i++) {
+            bool isVisible = true;
+            for (int p = 0; p < 6; p++) {
+                float x = planeX[p] >= 0.0f ? maxX[i] : minX[i];
+                float y = planeY[p] >= 0.0f ? maxY[i] : minY[i];
+                float z = planeZ[p] >= 0.0f ? maxZ[i] : minZ[i];
+                isVisible = isVisible && planeX[p] * x + planeY[p] * y + planeZ[p] * z + planeW[p] >= 0.0f;
+            }
+            float chunkCenterDepth =
+                    0.5f * (depthAxis.x * (minX[i] + maxX[i]) + depthAxis.y * (minY[i] + maxY[i])
+                    + depthAxis.z * (minZ[i] + maxZ[i])) + depthOffset;
+            float chunkDepthExtent =
+                    0.5f * (absDepthAxis.x * (maxX[i] - minX[i]) + absDepthAxis.y * (maxY[i] - minY[i])
+                    + absDepthAxis.z * (maxZ[i] - minZ[i]));
+            // Parts of a visible chunk in front of the near plane or behind the far plane aren't rendered.
+            float chunkMinDepth = std::max(chunkCenterDepth - chunkDepthExtent, nearDistance);
+            float chunkMaxDepth = std::min(chunkCenterDepth + chunkDepthExtent, farDistance);
+            leafMinDepth = std::min(leafMinDepth, isVisible ? chunkMinDepth : FLT_MAX);
+            leafMaxDepth = std::max(leafMaxDepth, isVisible ? chunkMaxDepth : -FLT_MAX);
+        }
+        currentMinDepth = leafMinDepth;
+        currentMaxDepth = leafMaxDepth;
+    }
+
+    if (currentMinDepth > currentMaxDepth) {
+        return false;
+    }
+    minDepth = currentMinDepth;
+    maxDepth = currentMaxDepth;
+    return true;
+}
+
+size_t ChunkBVH::cullChunks(const glm::mat4 &mvpMatrix, std::vector<uint8_t> &chunkVisibility) const
+{
+    chunkVisibility.assign(chunkIndices.size(), 0);
+    if (nodes.empty()) {
+        return 0;
+    }
+
+    glm::vec4 frustumPlanes[6];
+    extractFrustumPlanes(mvpMatrix, frustumPlanes);
+    float planeX[6], planeY[6], planeZ[6], planeW[6];
+    for (int i = 0; i < 6; i++) {
+        planeX[i] = frustumPlanes[i].x;
+        planeY[i] = frustumPlanes[i].y;
+        planeZ[i] = frustumPlanes[i].z;
+        planeW[i] = frustumPlanes[i].w;
+    }
+
+    const float *minX = chunkMinX.data(), *minY = chunkMinY.data(), *minZ = chunkMinZ.data();
+    const float *maxX = chunkMaxX.data(), *maxY = chunkMaxY.data(), *maxZ = chunkMaxZ.data();
+    uint8_t leafVisibility[MAX_CHUNKS_PER_LEAF];
+    size_t numVisibleChunks = 0;
+
+    uint32_t nodeStack[NODE_STACK_SIZE];
+    int stackSize = 0;
+    nodeStack[stackSize++] = 0;
+    while (stackSize > 0) {
+        const Node &node = nodes[nodeStack[--stackSize]];
+        if (!isBoxInFrustum(node.boundingBoxMin, node.boundingBoxMax, frustumPlanes)) {
+            continue;
+        }
+        if (node.numChunks == 0) {
+            assert(stackSize + 2 <= NODE_STACK_SIZE);
+            nodeStack[stackSize++] = node.firstChildOrChunk;
+            nodeStack[stackSize++] = node.firstChildOrChunk + 1;
+            continue;
+        }
+
+        const uint32_t chunkBegin = node.firstChildOrChunk;
+        const uint32_t numChunks = node.numChunks;
+        #pragma omp simd
+        for (uint32_t j = 0; j < numChunks; j++) {
+            const uint32_t i = chunkBegin + j;
+            bool isVisible = true;
+            for (int p = 0; p < 6; p++) {
+                float x = planeX[p] >= 0.0f ? maxX[i] : minX[i];
+                float y = planeY[p] >= 0.0f ? maxY[i] : minY[i];
+                float z = planeZ[p] >= 0.0f ? maxZ[i] : minZ[i];
+                isVisible = isVisible && planeX[p] * x + planeY[p] * y + planeZ[p] * z + planeW[p] >= 0.0f;
+            }
+            leafVisibility[j] = isVisible ? 1 : 0;
+        }
+        for (uint32_t j = 0; j < numChunks; j++) {
+            chunkVisibility[chunkIndices[chunkBegin + j]] = leafVisibility[j];
+            numVisibleChunks += leafVisibility[j];
+        }
+    }
+    return numVisibleChunks;
+}
@@ -0,0 +1,70 @@
+//
+// Created by christoph on 19.10.26.
+//
+
+#ifndef PIXELSYNCOIT_CHUNKBVH_HPP
+#define PIXELSYNCOIT_CHUNKBVH_HPP
+
+#include <vector>
+#include <cstdint>
+#include <glm/glm.hpp>
+#include <Math/Geometry/AABB3.hpp>
+
+/**
+ * Bounding volume hierarchy over the bounding boxes of mesh chunks (see BinaryMeshChunk). It is built once at load
+ * time and answers per-frame view dependent queries on the CPU. The leaves store the boxes of up to
+ * MAX_CHUNKS_PER_LEAF chunks in SoA layout, such that all boxes of a leaf are processed in one SIMD loop.
+ */
+class ChunkBVH
+{
+public:
+    static const uint32_t MAX_CHUNKS_PER_LEAF = 16;
+
+    /// Builds the hierarchy. The chunk index used in queries is the index in chunkBoundingBoxes.
+    void build(const std::vector<sgl::AABB3> &chunkBoundingBoxes);
+    inline bool isEmpty() const { return nodes.empty(); }
+
+    /**
+     * Computes the range of view depths (i.e., distances along the view direction) covered by all chunks
+     * intersecting the view frustum. This is a lot tighter than the depth range of the whole model if the camera is
+     * inside of or close to the data.
+     * @param mvMatrix, projectionMatrix: The model-view and the projection matrix.
+     * @param nearDistance, farDistance: The depths of the chunks are clamped to the near and far plane.
+     * @return False if no chunk intersects the view frustum.
+     */
+    bool computeViewDepthRange(
+            const glm::mat4 &mvMatrix, const glm::mat4 &projectionMatrix, float nearDistance, float farDistance,
+            float &minDepth, float &maxDepth) const;
+
+    /**
+     * Frustum culling of the chunks.
+     * @param mvpMatrix: The model-view-projection matrix.
+     * @param chunkVisibility: Set to 1 for all chunks intersecting the view frustum and to 0 otherwise.
+     * @return The number of visible chunks.
+     */
+    size_t cullChunks(const glm::mat4 &mvpMatrix, std::vector<uint8_t> &chunkVisibility) const;
+
+private:
+    struct Node
+    {
+        glm::vec3 boundingBoxMin;
+        uint32_t firstChildOrChunk; ///< Inner nodes: Index of the first child (the second one follows directly).
+        glm::vec3 boundingBoxMax;
+        uint32_t numChunks; ///< 0 for inner nodes.
+    };
+
+    /// The traversal stack holds at most (tree depth + 1) nodes.
+    static const int NODE_STACK_SIZE = 64;
+
+    void buildNode(
+            uint32_t nodeIdx, uint32_t depth, const std::vector<sgl::AABB3> &chunkBoundingBoxes,
+            const std::vector<glm::vec3> &centroids, uint32_t *chunkBegin, uint32_t *chunkEnd);
+
+    std::vector<Node> nodes;
+
+    // The bounding boxes of the chunks in leaf order (SoA).
+    std::vector<float> chunkMinX, chunkMinY, chunkMinZ, chunkMaxX, chunkMaxY, chunkMaxZ;
+    std::vector<uint32_t> chunkIndices;
+};
+
+#endif //PIXELSYNCOIT_CHUNKBVH_HPP
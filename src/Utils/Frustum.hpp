@@ -0,0 +1,45 @@
+//
+// Created by christoph on 19.10.26.
+//
+
+#ifndef PIXELSYNCOIT_FRUSTUM_HPP
+#define PIXELSYNCOIT_FRUSTUM_HPP
+
+#include <glm/glm.hpp>
+
+/**
+ * Extracts the six planes (left, right, bottom, top, near, far) of the view frustum from a (model-)view-projection
+ * matrix (Gribb/Hartmann). A point p lies inside of the frustum if dot(plane.xyz, p) + plane.w >= 0 for all planes.
+ * The planes are not normalized.
+ */
+inline void extractFrustumPlanes(const glm::mat4 &mvpMatrix, glm::vec4 frustumPlanes[6])
+{
+    glm::vec4 rows[4];
+    for (int i = 0; i < 4; i++) {
+        rows[i] = glm::vec4(mvpMatrix[0][i], mvpMatrix[1][i], mvpMatrix[2][i], mvpMatrix[3][i]);
+    }
+    frustumPlanes[0] = rows[3] + rows[0];
+    frustumPlanes[1] = rows[3] - rows[0];
+    frustumPlanes[2] = rows[3] + rows[1];
+    frustumPlanes[3] = rows[3] - rows[1];
+    frustumPlanes[4] = rows[3] + rows[2];
+    frustumPlanes[5] = rows[3] - rows[2];
+}
+
+/// Conservative test: Returns false only if the box lies completely outside of one of the frustum planes.
+inline bool isBoxInFrustum(const glm::vec3 &boxMin, const glm::vec3 &boxMax, const glm::vec4 frustumPlanes[6])
+{
+    for (int i = 0; i < 6; i++) {
+        const glm::vec4 &plane = frustumPlanes[i];
+        glm::vec3 positiveVertex(
+                plane.x >= 0.0f ? boxMax.x : boxMin.x,
+                plane.y >= 0.0f ? boxMax.y : boxMin.y,
+                plane.z >= 0.0f ? boxMax.z : boxMin.z);
+        if (glm::dot(glm::vec3(plane), positiveVertex) + plane.w < 0.0f) {
+            return false;
+        }
+    }
+    return true;
+}
+
+#endif //PIXELSYNCOIT_FRUSTUM_HPP
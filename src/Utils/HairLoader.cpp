@@ -2,6 +2,11 @@
 // Created by christoph on 22.01.19.
 //
 
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <utility>
 #include <boost/algorithm/string.hpp>
 #include <boost/algorithm/string/split.hpp>
 
@@ -23,42 +28,68 @@ uint32_t toUint32Color(const glm::vec4 &vecColor) {
     return packedColor;
 }
 
+template<class T>
+static inline T readHairFileValue(const char *data, size_t offset) {
+    T value;
+    memcpy(&value, data + offset, sizeof(T));
+    return value;
+}
+
 /**
  * Loads the specified hair file into memory.
  * For more on the file format see http://www.cemyuksel.com/research/hairmodels/
  */
-void loadHairFile(const std::string &hairFilename, HairData &hairData) {
-    std::ifstream file(hairFilename.c_str(), std::ifstream::binary);
-    if (!file.is_open()) {
-        sgl::Logfile::get()->writeError(std::string() +
-                "Error in readMesh3D: File \"" + hairFilename + "\" not found.");
-        return;
+bool loadHairFile(const std::string &hairFilename, HairData &hairData, bool useMemoryMapping) {
+    std::shared_ptr<MappedFile> mappedFile(new MappedFile);
+    std::vector<char> fileBuffer;
+    const char *fileData;
+    size_t fileSize;
+    if (useMemoryMapping) {
+        if (!mappedFile->open(hairFilename)) {
+            return false;
+        }
+        fileData = mappedFile->getData();
+        fileSize = mappedFile->getSize();
+    } else {
+        std::ifstream file(hairFilename.c_str(), std::ifstream::binary);
+        if (!file.is_open()) {
+            sgl::Logfile::get()->writeError(std::string() +
+                    "Error in loadHairFile: File \"" + hairFilename + "\" not found.");
+            return false;
+        }
+        file.seekg(0, file.end);
+        fileSize = file.tellg();
+        file.seekg(0);
+        fileBuffer.resize(fileSize);
+        if (fileSize > 0 && !file.read(fileBuffer.data(), fileSize)) {
+            sgl::Logfile::get()->writeError(std::string() +
+                    "Error in loadHairFile: Couldn't read file \"" + hairFilename + "\".");
+            return false;
+        }
+        fileData = fileBuffer.data();
     }
 
-    file.seekg(0, file.end);
-    size_t size = file.tellg();
-    file.seekg(0);
-    char *buffer = new char[size];
-    file.read(buffer, size);
+    // Header: magic number, numStrands, totalNumPoints, settings bit field, default values and file information.
+    const size_t HEADER_SIZE = 128;
+    if (fileSize < HEADER_SIZE) {
+        sgl::Logfile::get()->writeError(std::string() + "Error in loadHairFile: File \""
+                                        + hairFilename + "\" is too small.");
+        return false;
+    }
 
     // Read magic number
-    sgl::BinaryReadStream stream(buffer, size);
     const uint32_t FILE_FORMAT_HAIR_MAGIC_NUMBER = 0x52494148; // 48 41 49 52
-    uint32_t magicNumber;
-    stream.read(magicNumber);
+    uint32_t magicNumber = readHairFileValue<uint32_t>(fileData, 0);
     if (magicNumber != FILE_FORMAT_HAIR_MAGIC_NUMBER) {
         sgl::Logfile::get()->writeError(std::string() + "Error in loadHairFile: Invalid magic number in file \""
                                         + hairFilename + "\".");
-        return;
+        return false;
     }
 
-
-
     // Rest of header after magic number
-    uint32_t numStrands, totalNumPoints, settingsBitField;
-    stream.read(numStrands);
-    stream.read(totalNumPoints);
-    stream.read(settingsBitField);
+    uint32_t numStrands = readHairFileValue<uint32_t>(fileData, 4);
+    uint32_t totalNumPoints = readHairFileValue<uint32_t>(fileData, 8);
+    uint32_t settingsBitField = readHairFileValue<uint32_t>(fileData, 12);
 
     // Read bitfield options
     bool hasSegmentsArray, hasPointsArray, hasThicknessArray, hasOpacityArray, hasColorArray;
@@ -71,267 +102,345 @@ void loadHairFile(const std::string &hairFilename, HairData &hairData) {
     if (!hasPointsArray) {
         sgl::Logfile::get()->writeError(std::string() + "Error in loadHairFile: Invalid bitfield in file \""
                                         + hairFilename + "\".");
-        return;
+        return false;
     }
 
     // Read default values
-    uint32_t defaultNumSegments;
-    float defaultThickness, defaultOpacity;
-    glm::vec3 defaultColor;
-    stream.read(defaultNumSegments);
-    stream.read(defaultThickness);
-    stream.read(defaultOpacity);
-    stream.read(defaultColor);
-
-    // Read file information
-    const size_t FILE_INFO_SIZE = 88;
-    char fileInformation[FILE_INFO_SIZE];
-    stream.read(fileInformation, FILE_INFO_SIZE);
+    uint32_t defaultNumSegments = readHairFileValue<uint32_t>(fileData, 16);
+    float defaultThickness = readHairFileValue<float>(fileData, 20);
+    float defaultOpacity = readHairFileValue<float>(fileData, 24);
+    glm::vec3 defaultColor = readHairFileValue<glm::vec3>(fileData, 28);
 
 
     // ---------- Starting from here: Read actual hair data ----------
 
-    // First: Read number of segments per strand and reserve data for point, thickness and color arrays (if necessary)
+    // First: Compute the point offsets of the strands from the number of segments per strand
+    size_t offset = HEADER_SIZE;
+    if (hasSegmentsArray && fileSize < offset + size_t(numStrands) * sizeof(uint16_t)) {
+        sgl::Logfile::get()->writeError(std::string() + "Error in loadHairFile: Unexpected end of file \""
+                                        + hairFilename + "\".");
+        return false;
+    }
     hairData.filename = hairFilename;
-    hairData.strands.resize(numStrands);
-    if (hasSegmentsArray) {
-        std::vector<uint16_t> segmentsArray;
-        segmentsArray.resize(numStrands);
-        stream.read(&segmentsArray.front(), numStrands * sizeof(uint16_t));
-        for (size_t i = 0; i < numStrands; i++) {
-            size_t numPoints = segmentsArray.at(i)+1;
-            HairStrand &strand = hairData.strands.at(i);
-            strand.points.resize(numPoints);
-            if (hasThicknessArray) {
-                strand.thicknesses.resize(numPoints);
-            }
-            if (hasOpacityArray || hasColorArray) {
-                strand.colors.resize(numPoints);
-            }
+    hairData.strandOffsets.resize(size_t(numStrands) + 1);
+    hairData.strandOffsets[0] = 0;
+    size_t numPoints = 0;
+    for (size_t i = 0; i < numStrands; i++) {
+        if (hasSegmentsArray) {
+            numPoints += size_t(readHairFileValue<uint16_t>(fileData, offset + i * sizeof(uint16_t))) + 1;
+        } else {
+            numPoints += size_t(defaultNumSegments) + 1;
         }
-    } else {
-        for (HairStrand &strand : hairData.strands) {
-            size_t numPoints = defaultNumSegments+1;
-            strand.points.resize(numPoints);
-            if (hasThicknessArray) {
-                strand.thicknesses.resize(numPoints);
-            }
-            if (hasOpacityArray || hasColorArray) {
-                strand.colors.resize(numPoints);
-            }
+        if (numPoints > size_t(UINT32_MAX)) {
+            sgl::Logfile::get()->writeError(std::string() + "Error in loadHairFile: Too many points in file \""
+                                            + hairFilename + "\".");
+            hairData.strandOffsets.clear();
+            return false;
         }
+        hairData.strandOffsets[i + 1] = uint32_t(numPoints);
+    }
+    if (hasSegmentsArray) {
+        offset += size_t(numStrands) * sizeof(uint16_t);
+    }
+    if (numPoints != size_t(totalNumPoints)) {
+        sgl::Logfile::get()->writeError(std::string() + "Error in loadHairFile: The number of points in the header "
+                                        + "doesn't match the segments of the strands in file \"" + hairFilename + "\".");
+        hairData.strandOffsets.clear();
+        return false;
+    }
+
+    const size_t pointsOffset = offset;
+    const size_t thicknessesOffset = pointsOffset + numPoints * sizeof(glm::vec3);
+    const size_t opacitiesOffset = thicknessesOffset + (hasThicknessArray ? numPoints * sizeof(float) : 0);
+    const size_t colorsOffset = opacitiesOffset + (hasOpacityArray ? numPoints * sizeof(float) : 0);
+    const size_t dataEnd = colorsOffset + (hasColorArray ? numPoints * sizeof(glm::vec3) : 0);
+    if (fileSize < dataEnd) {
+        sgl::Logfile::get()->writeError(std::string() + "Error in loadHairFile: Unexpected end of file \""
+                                        + hairFilename + "\".");
+        hairData.strandOffsets.clear();
+        return false;
     }
 
-    // Next: Read points array (obligatory)
-    for (HairStrand &strand : hairData.strands) {
-        stream.read(&strand.points.front(), strand.points.size() * sizeof(float) * 3);
+    // Next: Points array (obligatory). The segments array has a size of 2 bytes per strand, i.e., all following
+    // arrays are only guaranteed to be 4-byte aligned if the number of strands is even. Otherwise, they are copied.
+    const bool canViewData = useMemoryMapping && pointsOffset % sizeof(float) == 0;
+    if (canViewData) {
+        hairData.points = reinterpret_cast<const glm::vec3*>(fileData + pointsOffset);
+    } else {
+        hairData.pointStorage.resize(numPoints);
+        memcpy(hairData.pointStorage.data(), fileData + pointsOffset, numPoints * sizeof(glm::vec3));
+        hairData.points = hairData.pointStorage.data();
     }
 
-    // Next: Read thickness array (optional)
+    // Next: Thickness array (optional)
     hairData.hasThicknessArray = hasThicknessArray;
     hairData.defaultThickness = defaultThickness;
     if (hasThicknessArray) {
-        for (HairStrand &strand : hairData.strands) {
-            stream.read(&strand.thicknesses.front(), strand.thicknesses.size() * sizeof(float));
+        if (canViewData) {
+            hairData.thicknesses = reinterpret_cast<const float*>(fileData + thicknessesOffset);
+        } else {
+            hairData.thicknessStorage.resize(numPoints);
+            memcpy(hairData.thicknessStorage.data(), fileData + thicknessesOffset, numPoints * sizeof(float));
+            hairData.thicknesses = hairData.thicknessStorage.data();
         }
     }
+    if (canViewData) {
+        hairData.fileMapping = mappedFile;
+    }
 
-    // Next: Read opacity and color array (optional)
+    // Next: Merge the opacity and color arrays (optional) and convert them to 32-bit RGBA colors
     hairData.hasColorArray = hasOpacityArray || hasColorArray;
     hairData.defaultOpacity = defaultOpacity;
     hairData.defaultColor = defaultColor;
     if (hairData.hasColorArray) {
-        // 1. Read color and opacity arrays (optional)
-        std::vector<std::vector<float>> opacityArrays;
-        std::vector<std::vector<glm::vec3>> colorArrays;
-        opacityArrays.resize(numStrands);
-        colorArrays.resize(numStrands);
-        if (hasOpacityArray) {
-            for (size_t i = 0; i < numStrands; i++) {
-                std::vector<float> &opacityArray = opacityArrays.at(i);
-                opacityArray.resize(hairData.strands.at(i).colors.size());
-                stream.read(&opacityArray.front(), hairData.strands.at(i).points.size() * sizeof(float));
+        hairData.colors.resize(numPoints);
+        uint32_t *colors = hairData.colors.data();
+        #pragma omp parallel for
+        for (size_t i = 0; i < numPoints; i++) {
+            glm::vec4 colorOpacity(defaultColor, defaultOpacity);
+            if (hasColorArray) {
+                colorOpacity = glm::vec4(readHairFileValue<glm::vec3>(
+                        fileData, colorsOffset + i * sizeof(glm::vec3)), colorOpacity.a);
             }
-        }
-        if (hasColorArray) {
-            for (size_t i = 0; i < numStrands; i++) {
-                std::vector<glm::vec3> &colorArray = colorArrays.at(i);
-                colorArray.resize(hairData.strands.at(i).colors.size());
-                stream.read(&colorArray.front(), hairData.strands.at(i).points.size() * sizeof(glm::vec3));
+            if (hasOpacityArray) {
+                colorOpacity.a = readHairFileValue<float>(fileData, opacitiesOffset + i * sizeof(float));
             }
+            colors[i] = toUint32Color(colorOpacity);
         }
+    }
 
-        // 2. Merge the arrays
-        std::vector<std::vector<glm::vec4>> mergedColorOpacityArrays;
-        mergedColorOpacityArrays.resize(numStrands);
-        if (hasOpacityArray && hasColorArray) {
-            for (size_t i = 0; i < numStrands; i++) {
-                size_t numPoints = hairData.strands.at(i).points.size();
-                std::vector<float> &opacityArray = opacityArrays.at(i);
-                std::vector<glm::vec3> &colorArray = colorArrays.at(i);
-                std::vector<glm::vec4> &mergedColorOpacityArray = mergedColorOpacityArrays.at(i);
-                mergedColorOpacityArray.resize(hairData.strands.at(i).colors.size());
-                for (size_t j = 0; j < numPoints; j++) {
-                    mergedColorOpacityArray.at(j) = glm::vec4(colorArray.at(j), opacityArray.at(j));
-                }
-            }
-        } else if (hasOpacityArray && !hasColorArray) {
-            for (size_t i = 0; i < numStrands; i++) {
-                size_t numPoints = hairData.strands.at(i).points.size();
-                std::vector<float> &opacityArray = opacityArrays.at(i);
-                std::vector<glm::vec4> &mergedColorOpacityArray = mergedColorOpacityArrays.at(i);
-                mergedColorOpacityArray.resize(hairData.strands.at(i).colors.size());
-                for (size_t j = 0; j < numPoints; j++) {
-                    mergedColorOpacityArray.at(j) = glm::vec4(defaultColor, opacityArray.at(j));
-                }
-            }
-        } else { //if (!hasOpacityArray && hasColorArray) {
-            for (size_t i = 0; i < numStrands; i++) {
-                size_t numPoints = hairData.strands.at(i).points.size();
-                std::vector<glm::vec3> &colorArray = colorArrays.at(i);
-                std::vector<glm::vec4> &mergedColorOpacityArray = mergedColorOpacityArrays.at(i);
-                mergedColorOpacityArray.resize(hairData.strands.at(i).colors.size());
-                for (size_t j = 0; j < numPoints; j++) {
-                    mergedColorOpacityArray.at(j) = glm::vec4(colorArray.at(j), defaultOpacity);
-                }
-            }
-        }
+    return true;
+}
 
-        // 3. Convert floating point colors & opacities to 32-bit RGBA colors
-        for (size_t i = 0; i < numStrands; i++) {
-            size_t numPoints = hairData.strands.at(i).points.size();
-            std::vector<glm::vec4> &mergedColorOpacityArray = mergedColorOpacityArrays.at(i);
-            std::vector<uint32_t> &colorArray = hairData.strands.at(i).colors;
-            for (size_t j = 0; j < numPoints; j++) {
-                colorArray.at(j) = toUint32Color(mergedColorOpacityArray.at(j));
-            }
+void downscaleHairData(HairData &hairData, float scalingFactor)
+{
+    // The points and thicknesses may view the read-only file mapping. Thus, the scaled data is written to the storage
+    // arrays (in place if the data was already copied there).
+    const size_t numPoints = hairData.getNumPoints();
+    const glm::vec3 *inputPoints = hairData.points;
+    hairData.pointStorage.resize(numPoints);
+    glm::vec3 *points = hairData.pointStorage.data();
+    hairData.defaultThickness *= scalingFactor;
+
+    // For some hair data files: Swap y-axis and z-axis
+    const bool swapYZ = !boost::starts_with(hairData.filename, "Data/Hair/ponytail")
+            && !boost::starts_with(hairData.filename, "Data/Hair/bear");
+    #pragma omp parallel for
+    for (size_t i = 0; i < numPoints; i++) {
+        glm::vec3 point = inputPoints[i] * scalingFactor;
+        if (swapYZ) {
+            std::swap(point.y, point.z);
         }
+        points[i] = point;
+    }
+    hairData.points = points;
+
+    if (hairData.thicknesses != nullptr) {
+        const float *inputThicknesses = hairData.thicknesses;
+        hairData.thicknessStorage.resize(numPoints);
+        float *thicknesses = hairData.thicknessStorage.data();
+        #pragma omp parallel for simd
+        for (size_t i = 0; i < numPoints; i++) {
+            thicknesses[i] = inputThicknesses[i] * scalingFactor;
+        }
+        hairData.thicknesses = thicknesses;
+    }
 
+    // Nothing views the file mapping anymore.
+    hairData.fileMapping.reset();
+}
+
+/**
+ * Returns whether the point i of a strand creates a tube node and computes its normalized tangent. Same rules as in
+ * createTubeRenderData: Invalid points and points (almost) identical to their successor are skipped.
+ */
+static inline bool computeHairTubeNodeTangent(const glm::vec3 *points, size_t numPoints, size_t i, glm::vec3 &tangent)
+{
+    const glm::vec3 &center = points[i];
+    const float MAX_VAL = 1e10;
+    if (std::fabs(center.x) > MAX_VAL || std::fabs(center.y) > MAX_VAL || std::fabs(center.z) > MAX_VAL) {
+        return false;
     }
+    if (i == numPoints-1) {
+        tangent = points[i] - points[i-1];
+    } else {
+        tangent = points[i+1] - points[i];
+    }
+    float tangentLength = glm::length(tangent);
+    if (tangentLength < 0.0001f) {
+        return false;
+    }
+    tangent /= tangentLength;
+    return true;
 }
 
-void downscaleHairData(HairData &hairData, float scalingFactor)
+/// Returns the number of tube nodes of a strand (0 if the strand creates no triangles).
+static size_t countHairTubeNodes(const glm::vec3 *points, size_t numPoints)
 {
-    hairData.defaultThickness *= scalingFactor;
-    for (HairStrand &hairStrand : hairData.strands) {
-        for (glm::vec3 &pt : hairStrand.points) {
-            pt *= scalingFactor;
+    // Like in createTubeRenderData, closed strands are removed.
+    if (numPoints < 2 || glm::length(points[0] - points[numPoints-1]) < 0.01f) {
+        return 0;
+    }
+    size_t numNodes = 0;
+    glm::vec3 tangent;
+    for (size_t i = 0; i < numPoints; i++) {
+        if (computeHairTubeNodeTangent(points, numPoints, i, tangent)) {
+            numNodes++;
         }
     }
+    return numNodes <= 1 ? 0 : numNodes;
+}
 
-    // For some hair data files: Swap y-axis and z-axis
-    if (!boost::starts_with(hairData.filename, "Data/Hair/ponytail")
-            && !boost::starts_with(hairData.filename, "Data/Hair/bear")) {
-        glm::mat4 hairRotationMatrix = sgl::matrixRowMajor(
-                1.0f, 0.0f, 0.0f, 0.0f,
-                0.0f, 0.0f, 1.0f, 0.0f,
-                0.0f, 1.0f, 0.0f, 0.0f,
-                0.0f, 0.0f, 0.0f, 1.0f
-        );
-        for (HairStrand &hairStrand : hairData.strands) {
-            for (glm::vec3 &pt : hairStrand.points) {
-                pt = sgl::transformPoint(hairRotationMatrix, pt);
+/**
+ * Writes the tube of one strand to preallocated output arrays (see countHairTubeNodes for the number of nodes).
+ * @param thicknesses: Per-point tube radius or nullptr for defaultThickness.
+ * @param colors: Per-point colors or nullptr.
+ * @param unitCircle: The circle points of the tube cross section with radius one.
+ */
+static void createHairTube(
+        const glm::vec3 *points, size_t numPoints, const float *thicknesses, float defaultThickness,
+        const uint32_t *colors, const std::vector<glm::vec2> &unitCircle,
+        glm::vec3 *vertices, glm::vec3 *normals, uint32_t *vertexColors)
+{
+    const uint32_t numCirclePoints = uint32_t(unitCircle.size());
+    glm::vec3 lastTangent = glm::vec3(1.0f, 0.0f, 0.0f);
+    uint32_t numNodes = 0;
+    glm::vec3 normal;
+    for (size_t i = 0; i < numPoints; i++) {
+        if (!computeHairTubeNodeTangent(points, numPoints, i, normal)) {
+            continue;
+        }
+
+        // Orient the circle in the plane orthogonal to the line (Gram-Schmidt w.r.t. the last circle).
+        glm::vec3 helperAxis = lastTangent;
+        if (glm::length(glm::cross(helperAxis, normal)) < 0.01f) {
+            helperAxis = glm::vec3(0.0f, 1.0f, 0.0f);
+        }
+        glm::vec3 tangent = glm::normalize(helperAxis - normal * glm::dot(helperAxis, normal));
+        glm::vec3 binormal = glm::normalize(glm::cross(normal, tangent));
+        lastTangent = tangent;
+
+        const float radius = thicknesses != nullptr ? thicknesses[i] : defaultThickness;
+        const size_t vertexOffset = size_t(numNodes) * numCirclePoints;
+        for (uint32_t j = 0; j < numCirclePoints; j++) {
+            glm::vec3 offset = unitCircle[j].x * tangent + unitCircle[j].y * binormal;
+            vertices[vertexOffset + j] = points[i] + radius * offset;
+            normals[vertexOffset + j] = glm::normalize(offset);
+            if (colors != nullptr) {
+                vertexColors[vertexOffset + j] = colors[i];
             }
         }
+        numNodes++;
     }
 }
 
-void convertHairDataToBinaryTriangleMesh(
+bool convertHairDataToBinaryTriangleMesh(
         const std::string &hairFilename,
-        const std::string &binaryFilename)
+        const std::string &binaryFilename,
+        const TubeMeshEncodings &encodings)
 {
     // First, load the hair data from the specified file
     HairData hairData;
-    loadHairFile(hairFilename, hairData);
+    if (!loadHairFile(hairFilename, hairData)) {
+        return false;
+    }
     downscaleHairData(hairData, HAIR_MODEL_SCALING_FACTOR);
 
-    BinaryMesh binaryMesh;
-    binaryMesh.submeshes.push_back(BinarySubMesh());
-    BinarySubMesh &submesh = binaryMesh.submeshes.front();
-    submesh.vertexMode = sgl::VERTEX_MODE_TRIANGLES;
-
-    std::vector<glm::vec3> globalVertexPositions;
-    std::vector<glm::vec3> globalNormals;
-    std::vector<uint32_t> globalColors;
-    std::vector<uint32_t> globalIndices;
-
-    initializeCircleData(3, hairData.defaultThickness);
-
-    size_t numStrands = hairData.strands.size();
-    for (HairStrand &strand : hairData.strands) {
-        std::vector<glm::vec3> &pathLineCenters = strand.points;
-        std::vector<float> &pathLineThicknesses = strand.thicknesses;
-        std::vector<uint32_t> &pathLineColors = strand.colors;
-
-        // Create tube render data
-        std::vector<glm::vec3> localVertices;
-        std::vector<uint32_t> localColors;
-        std::vector<glm::vec3> localNormals;
-        std::vector<uint32_t> localIndices;
-        if (hairData.hasThicknessArray) {
-            sgl::Logfile::get()->writeError("Error in convertHairDataToBinaryTriangleMesh: Variable thickness not yet "
-                                            "supported.");
-        } else {
-            createTubeRenderData(pathLineCenters, pathLineColors, localVertices, localNormals, localColors, localIndices);
-        }
-        //createTubeRenderData(pathLineCenters, pathLineThicknesses, hairData.defaultThickness, pathLineColors,
-        //        localVertices, localColors, localIndices);
-        //createNormals(localVertices, localIndices, localNormals);
+    std::vector<glm::vec2> unitCircle;
+    getPointsOnCircle(unitCircle, glm::vec2(0.0f, 0.0f), 1.0f, HAIR_TUBE_NUM_CIRCLE_SEGMENTS);
+    const size_t numCirclePoints = unitCircle.size();
+
+    // Pass 1: Count the tube nodes of all strands and compute the output offsets (deterministic for any number of
+    // threads, as the strands are written in their original order).
+    const size_t numStrands = hairData.getNumStrands();
+    std::vector<size_t> vertexOffsets(numStrands + 1, 0);
+    #pragma omp parallel for schedule(dynamic, 256)
+    for (size_t i = 0; i < numStrands; i++) {
+        vertexOffsets[i + 1] = countHairTubeNodes(
+                hairData.points + hairData.strandOffsets[i], hairData.getStrandNumPoints(i)) * numCirclePoints;
+    }
+    for (size_t i = 0; i < numStrands; i++) {
+        vertexOffsets[i + 1] += vertexOffsets[i];
+    }
+    const size_t numVertices = vertexOffsets.back();
+    if (numVertices > size_t(UINT32_MAX)) {
+        sgl::Logfile::get()->writeError("Error in convertHairDataToBinaryTriangleMesh: Too many vertices.");
+        return false;
+    }
 
-        // Local -> global
-        for (size_t i = 0; i < localIndices.size(); i++) {
-            globalIndices.push_back(localIndices.at(i) + globalVertexPositions.size());
+    // Each node except for the last one of a strand creates 2*numCirclePoints triangles.
+    size_t numIndices = 0;
+    for (size_t i = 0; i < numStrands; i++) {
+        size_t numNodes = (vertexOffsets[i + 1] - vertexOffsets[i]) / numCirclePoints;
+        if (numNodes > 1) {
+            numIndices += (numNodes - 1) * numCirclePoints * 6;
         }
-        globalVertexPositions.insert(globalVertexPositions.end(), localVertices.begin(), localVertices.end());
-        globalColors.insert(globalColors.end(), localColors.begin(), localColors.end());
-        globalNormals.insert(globalNormals.end(), localNormals.begin(), localNormals.end());
     }
 
+    // Pass 2: Write the indices, then generate the tubes of a block of strands at a time in parallel and stream them
+    // to the file. All array sizes are known from pass 1, thus the data is written directly to its final position.
+    ObjMaterial material;
+    material.diffuseColor = hairData.defaultColor;
+    material.opacity = hairData.defaultOpacity;
 
-    submesh.material.diffuseColor = hairData.defaultColor;
-    submesh.material.opacity = hairData.defaultOpacity;
-    submesh.indices = globalIndices;
-
-    BinaryMeshAttribute positionAttribute;
-    positionAttribute.name = "vertexPosition";
-    positionAttribute.attributeFormat = sgl::ATTRIB_FLOAT;
-    positionAttribute.numComponents = 3;
-    positionAttribute.data.resize(globalVertexPositions.size() * sizeof(glm::vec3));
-    memcpy(&positionAttribute.data.front(), &globalVertexPositions.front(), globalVertexPositions.size() * sizeof(glm::vec3));
-    submesh.attributes.push_back(positionAttribute);
-
-    BinaryMeshAttribute lineNormalsAttribute;
-    lineNormalsAttribute.name = "vertexNormal";
-    lineNormalsAttribute.attributeFormat = sgl::ATTRIB_FLOAT;
-    lineNormalsAttribute.numComponents = 3;
-    lineNormalsAttribute.data.resize(globalNormals.size() * sizeof(glm::vec3));
-    memcpy(&lineNormalsAttribute.data.front(), &globalNormals.front(), globalNormals.size() * sizeof(glm::vec3));
-    submesh.attributes.push_back(lineNormalsAttribute);
-
+    BinaryMeshStreamWriter writer;
+    if (!writer.open(binaryFilename)) {
+        return false;
+    }
+    writer.beginSubmesh(material, sgl::VERTEX_MODE_TRIANGLES, numIndices);
+    writer.setIndexEncoding(encodings.indexEncoding);
+    size_t positionAttributeIndex = writer.addAttribute(
+            "vertexPosition", sgl::ATTRIB_FLOAT, 3, numVertices * sizeof(glm::vec3), encodings.positionEncoding);
+    size_t normalAttributeIndex = writer.addAttribute(
+            "vertexNormal", sgl::ATTRIB_FLOAT, 3, numVertices * sizeof(glm::vec3), encodings.normalEncoding);
+    size_t colorAttributeIndex = 0;
     if (hairData.hasColorArray) {
-        BinaryMeshAttribute colorsAttribute;
-        colorsAttribute.name = "vertexColor";
-        colorsAttribute.attributeFormat = sgl::ATTRIB_UNSIGNED_BYTE;
-        colorsAttribute.numComponents = 4;
-        colorsAttribute.data.resize(globalColors.size() * sizeof(uint32_t));
-        memcpy(&colorsAttribute.data.front(), &globalColors.front(), globalColors.size() * sizeof(uint32_t));
-        submesh.attributes.push_back(colorsAttribute);
+        colorAttributeIndex = writer.addAttribute(
+                "vertexColor", sgl::ATTRIB_UNSIGNED_BYTE, 4, numVertices * sizeof(uint32_t));
     }
+    writeTubeIndices(writer, vertexOffsets, uint32_t(numCirclePoints));
+
+    const size_t STRANDS_PER_BLOCK = 16384;
+    std::vector<glm::vec3> blockVertices;
+    std::vector<glm::vec3> blockNormals;
+    std::vector<uint32_t> blockVertexColors;
+    for (size_t blockStart = 0; blockStart < numStrands; blockStart += STRANDS_PER_BLOCK) {
+        const size_t blockEnd = std::min(blockStart + STRANDS_PER_BLOCK, numStrands);
+        const size_t blockVertexOffset = vertexOffsets[blockStart];
+        const size_t blockNumVertices = vertexOffsets[blockEnd] - blockVertexOffset;
+        blockVertices.resize(blockNumVertices);
+        blockNormals.resize(blockNumVertices);
+        if (hairData.hasColorArray) {
+            blockVertexColors.resize(blockNumVertices);
+        }
 
-    if (hairData.hasThicknessArray) {
-        // TODO
-        /*BinaryMeshAttribute thicknessesAttribute;
-        thicknessesAttribute.name = "vertexThickness";
-        thicknessesAttribute.attributeFormat = sgl::ATTRIB_UNSIGNED_INT;
-        thicknessesAttribute.numComponents = 1;
-        thicknessesAttribute.data.resize(globalColors.size() * sizeof(uint32_t));
-        memcpy(&thicknessesAttribute.data.front(), &globalThicknesses.front(), globalThicknesses.size() * sizeof(float));
-        submesh.attributes.push_back(thicknessesAttribute);*/
+        #pragma omp parallel for schedule(dynamic, 256)
+        for (size_t i = blockStart; i < blockEnd; i++) {
+            if (vertexOffsets[i + 1] == vertexOffsets[i]) {
+                continue;
+            }
+            const size_t firstPoint = hairData.strandOffsets[i];
+            const size_t localVertexOffset = vertexOffsets[i] - blockVertexOffset;
+            createHairTube(
+                    hairData.points + firstPoint, hairData.getStrandNumPoints(i),
+                    hairData.thicknesses != nullptr ? hairData.thicknesses + firstPoint : nullptr,
+                    hairData.defaultThickness,
+                    hairData.colors.empty() ? nullptr : hairData.colors.data() + firstPoint,
+                    unitCircle, blockVertices.data() + localVertexOffset, blockNormals.data() + localVertexOffset,
+                    hairData.hasColorArray ? blockVertexColors.data() + localVertexOffset : nullptr);
+        }
+
+        writer.appendAttributeData(positionAttributeIndex, blockVertices.data(), blockNumVertices * sizeof(glm::vec3));
+        writer.appendAttributeData(normalAttributeIndex, blockNormals.data(), blockNumVertices * sizeof(glm::vec3));
+        if (hairData.hasColorArray) {
+            writer.appendAttributeData(colorAttributeIndex, blockVertexColors.data(),
+                    blockNumVertices * sizeof(uint32_t));
+        }
     }
 
     sgl::Logfile::get()->writeInfo(std::string() + "Summary: "
-                              + sgl::toString(globalVertexPositions.size()) + " vertices, "
-                              + sgl::toString(globalIndices.size()) + " indices.");
+                              + sgl::toString(numVertices) + " vertices, "
+                              + sgl::toString(numIndices) + " indices.");
     sgl::Logfile::get()->writeInfo(std::string() + "Writing binary mesh...");
-    writeMesh3D(binaryFilename, binaryMesh);
+    return writer.close();
 }
@@ -8,45 +8,84 @@
 #include <vector>
 #include <map>
 #include <string>
+#include <memory>
+#include <cstdint>
 
 #include <glm/glm.hpp>
 
+#include "MappedFile.hpp"
+#include "MeshCompression.hpp"
+
 const float HAIR_MODEL_SCALING_FACTOR = 0.005f;
+const int HAIR_TUBE_NUM_CIRCLE_SEGMENTS = 3;
+
+/**
+ * Hair strands in a flat layout: The points of all strands are stored in one contiguous array, strand i consists of
+ * the points [strandOffsets[i], strandOffsets[i+1]). The per-point thicknesses and colors use the same indexing.
+ * If the file was memory-mapped, points and thicknesses directly view the read-only file mapping, i.e., no per-strand
+ * allocations are necessary and only the pages that are accessed are read from disk.
+ */
+struct HairData {
+    HairData() = default;
+    HairData(const HairData&) = delete;
+    HairData &operator=(const HairData&) = delete;
+
+    std::string filename;
+    std::vector<uint32_t> strandOffsets;
 
-struct HairStrand {
     // Obligatory data
-    std::vector<glm::vec3> points;
+    const glm::vec3 *points = nullptr;
 
-    // --- For all following data fields: If the vector is empty, assume constant default value for all points ---
+    // --- For all following data fields: If the array is empty, assume constant default value for all points ---
     // Thickness
-    std::vector<float> thicknesses;
+    const float *thicknesses = nullptr;
 
     // Opacity & color (merge to one array if either opacity or color is given)
     std::vector<uint32_t> colors;
-};
 
-struct HairData {
-    std::string filename;
-    std::vector<HairStrand> strands;
-
-    // Only used if arrays in strands empty
-    bool hasThicknessArray;
-    bool hasColorArray;
-    float defaultThickness;
-    float defaultOpacity;
-    glm::vec3 defaultColor;
+    // Only used if arrays are empty
+    bool hasThicknessArray = false;
+    bool hasColorArray = false;
+    float defaultThickness = 0.0f;
+    float defaultOpacity = 1.0f;
+    glm::vec3 defaultColor = glm::vec3(1.0f);
+
+    // Backing storage of points and thicknesses (either the file mapping or, if the data is misaligned or was
+    // downscaled, a copy).
+    std::shared_ptr<MappedFile> fileMapping;
+    std::vector<glm::vec3> pointStorage;
+    std::vector<float> thicknessStorage;
+
+    inline size_t getNumStrands() const { return strandOffsets.empty() ? 0 : strandOffsets.size() - 1; }
+    inline size_t getNumPoints() const { return strandOffsets.empty() ? 0 : strandOffsets.back(); }
+    inline size_t getStrandNumPoints(size_t strandIdx) const {
+        return strandOffsets[strandIdx + 1] - strandOffsets[strandIdx];
+    }
 };
 
 /**
  * Loads the specified hair file into memory.
  * For more on the file format see http://www.cemyuksel.com/research/hairmodels/
+ * @param useMemoryMapping: Whether to view the point and thickness arrays in a memory mapping of the file instead of
+ * reading the file into memory.
+ * @return False if the file could not be loaded.
  */
-void loadHairFile(const std::string &hairFilename, HairData &hairData);
+bool loadHairFile(const std::string &hairFilename, HairData &hairData, bool useMemoryMapping = true);
 
-void convertHairDataToBinaryTriangleMesh(
+/**
+ * Converts a hair file to a triangle mesh of tubes around the strands. The strands are converted in parallel: The
+ * first pass computes the output offsets of all strands, the second one writes the tubes directly to the output
+ * arrays. Per-point thicknesses are used as tube radius if the file contains a thickness array.
+ * @param encodings: The encodings of the tube positions, normals and indices in the binmesh file.
+ * @return False if the input couldn't be read or the output couldn't be written.
+ */
+bool convertHairDataToBinaryTriangleMesh(
         const std::string &hairFilename,
-        const std::string &binaryFilename);
+        const std::string &binaryFilename,
+        const TubeMeshEncodings &encodings = TubeMeshEncodings());
 
+/// Scales the points and thicknesses (and swaps the y- and z-axis for some data sets). The result is stored in
+/// pointStorage and thicknessStorage, as the input may view the read-only file mapping.
 void downscaleHairData(HairData &hairData, float scalingFactor);
 
 #endif //PIXELSYNCOIT_HAIRLOADER_HPP
@@ -8,19 +8,29 @@
 /// https://www.khronos.org/registry/OpenGL-Refpages/gl4/html/packUnorm.xhtml
 void packUnorm16Array(const std::vector<float> &floatVector, std::vector<uint16_t> &unormVector)
 {
+    const float *floatValues = floatVector.data();
+    const size_t numValues = floatVector.size();
     float minValue = FLT_MAX;
     float maxValue = -FLT_MAX;
-    #pragma omp parallel for reduction(min:minValue) reduction(max:maxValue)
-    for (size_t i = 0; i < floatVector.size(); i++) {
-        minValue = std::min(minValue, floatVector.at(i));
-        maxValue = std::max(maxValue, floatVector.at(i));
+    #pragma omp parallel for simd reduction(min:minValue) reduction(max:maxValue)
+    for (size_t i = 0; i < numValues; i++) {
+        minValue = std::min(minValue, floatValues[i]);
+        maxValue = std::max(maxValue, floatValues[i]);
     }
 
-    unormVector.resize(floatVector.size());
-    #pragma omp parallel for
-    for (size_t i = 0; i < unormVector.size(); i++) {
-        unormVector.at(i) = glm::round(glm::clamp((floatVector.at(i) - minValue) / (maxValue - minValue),
-                                                  0.0f, 1.0f) * 65535.0f);
+    unormVector.resize(numValues);
+    packUnorm16Array(floatValues, numValues, minValue, maxValue, unormVector.data());
+}
+
+void packUnorm16Array(
+        const float *floatValues, size_t numValues, float minValue, float maxValue, uint16_t *unormValues)
+{
+    // Constant arrays are mapped to zero.
+    const float scale = maxValue > minValue ? 65535.0f / (maxValue - minValue) : 0.0f;
+    #pragma omp parallel for simd
+    for (size_t i = 0; i < numValues; i++) {
+        // Values are non-negative after clamping, thus adding 0.5 and truncating is equal to rounding.
+        unormValues[i] = uint16_t(glm::clamp((floatValues[i] - minValue) * scale, 0.0f, 65535.0f) + 0.5f);
     }
 }
 
@@ -37,13 +47,34 @@ void packUnorm16ArrayOfArrays(
 
 
 /// https://www.khronos.org/registry/OpenGL-Refpages/gl4/html/unpackUnorm.xhtml
-void unpackUnorm16Array(uint16_t *unormVector, size_t vectorSize, std::vector<float> &floatVector)
+void unpackUnorm16Array(const uint16_t *unormVector, size_t vectorSize, std::vector<float> &floatVector)
 {
     floatVector.resize(vectorSize);
-    #pragma omp parallel for
+    float *floatValues = floatVector.data();
+    const float scale = 1.0f / 65535.0f;
+    #pragma omp parallel for simd
+    for (size_t i = 0; i < vectorSize; i++) {
+        floatValues[i] = float(unormVector[i]) * scale;
+    }
+}
+
+void computeUnorm16ArrayRange(const uint16_t *unormVector, size_t vectorSize, float &minValue, float &maxValue)
+{
+    if (vectorSize == 0) {
+        minValue = 0.0f;
+        maxValue = 0.0f;
+        return;
+    }
+
+    uint16_t minUnorm = 0xFFFFu;
+    uint16_t maxUnorm = 0u;
+    #pragma omp parallel for simd reduction(min:minUnorm) reduction(max:maxUnorm)
     for (size_t i = 0; i < vectorSize; i++) {
-        floatVector.at(i) = unormVector[i]/65535.0;
+        minUnorm = std::min(minUnorm, unormVector[i]);
+        maxUnorm = std::max(maxUnorm, unormVector[i]);
     }
+    minValue = float(minUnorm) / 65535.0f;
+    maxValue = float(maxUnorm) / 65535.0f;
 }
 
 
@@ -234,58 +265,181 @@ std::vector<float> computeSegmentHeightDifference(std::vector<glm::vec3> &vertex
 }
 
 
+uint32_t getImportanceCriteriaMask(TrajectoryType trajectoryType)
+{
+    if (trajectoryType == TRAJECTORY_TYPE_WCB) {
+        // 0. Pressure mapped to [0, 1], 1. Curvature
+        return IMPORTANCE_CRITERION_BIT_ATTRIBUTE | IMPORTANCE_CRITERION_BIT_CURVATURE;
+    }
+    // 0. Vorticity/Attribute
+    return IMPORTANCE_CRITERION_BIT_ATTRIBUTE;
+}
+
+int getNumImportanceCriteria(uint32_t criteriaMask)
+{
+    int numCriteria = 0;
+    for (uint32_t bits = criteriaMask & IMPORTANCE_CRITERION_BITS_ALL; bits != 0; bits &= bits - 1u) {
+        numCriteria++;
+    }
+    return numCriteria;
+}
+
+/**
+ * Node i uses the tangent of segment i (i.e., p_{i+1} - p_i) and the last node uses the tangent of segment n-2.
+ * This way all criteria of node i only depend on the segments i-1 and i, which are recomputed from the positions
+ * in each iteration so that the loop has no carried dependencies and can be vectorized.
+ */
+void computeImportanceCriteriaFused(
+        size_t numVertices,
+        const glm::vec3 *vertexPositions,
+        const float *vertexAttributes,
+        uint32_t criteriaMask,
+        float *const *outputArrays)
+{
+    float *attributeOut = nullptr, *curvatureOut = nullptr, *segmentLengthOut = nullptr,
+            *segmentAttributeDifferenceOut = nullptr, *totalAttributeDifferenceOut = nullptr,
+            *angleOfAscentOut = nullptr, *segmentHeightDifferenceOut = nullptr;
+    float **outputPointers[] = {
+            &attributeOut, &curvatureOut, &segmentLengthOut, &segmentAttributeDifferenceOut,
+            &totalAttributeDifferenceOut, &angleOfAscentOut, &segmentHeightDifferenceOut
+    };
+    int outputIndex = 0;
+    for (int bit = 0; bit < 7; bit++) {
+        if ((criteriaMask & (1u << bit)) != 0) {
+            *outputPointers[bit] = outputArrays[outputIndex++];
+        }
+    }
+
+    const size_t n = numVertices;
+    if (n < 2) {
+        // Degenerate trajectory without any line segment.
+        for (int i = 0; i < outputIndex; i++) {
+            for (size_t j = 0; j < n; j++) {
+                outputArrays[i][j] = 0.0f;
+            }
+        }
+        if (attributeOut != nullptr && n == 1) {
+            attributeOut[0] = vertexAttributes[0];
+        }
+        return;
+    }
+
+    const float *p = &vertexPositions[0].x;
+    const float *a = vertexAttributes;
+    float minAttribute = FLT_MAX;
+    float maxAttribute = -FLT_MAX;
+    int hasDegenerateSegment = 0;
+
+    #pragma omp simd reduction(min:minAttribute) reduction(max:maxAttribute) reduction(|:hasDegenerateSegment)
+    for (size_t i = 0; i < n-1; i++) {
+        // Segment i (p_{i+1} - p_i) and segment i-1 (p_i - p_{i-1}, only valid for i > 0).
+        const size_t i0 = i*3, i1 = i*3+3, im = i > 0 ? i*3-3 : i*3;
+        const float tx = p[i1] - p[i0], ty = p[i1+1] - p[i0+1], tz = p[i1+2] - p[i0+2];
+        const float lx = p[i0] - p[im], ly = p[i0+1] - p[im+1], lz = p[i0+2] - p[im+2];
+        const float length = std::sqrt(tx*tx + ty*ty + tz*tz);
+        const float lastLength = std::sqrt(lx*lx + ly*ly + lz*lz);
+
+        const float attribute = a[i];
+        minAttribute = std::min(minAttribute, attribute);
+        maxAttribute = std::max(maxAttribute, attribute);
+        if (attributeOut != nullptr) {
+            attributeOut[i] = attribute;
+        }
+        if (segmentLengthOut != nullptr) {
+            segmentLengthOut[i] = length;
+        }
+        if (segmentAttributeDifferenceOut != nullptr) {
+            segmentAttributeDifferenceOut[i] = std::abs(a[i+1] - attribute);
+        }
+        if (segmentHeightDifferenceOut != nullptr) {
+            segmentHeightDifferenceOut[i] = ty;
+        }
+        if (angleOfAscentOut != nullptr) {
+            float cosAngle = glm::clamp(ty / length, 0.0f, 1.0f);
+            angleOfAscentOut[i] = length < 0.0001f ? 0.0f : 1.0f - std::acos(cosAngle) / sgl::PI;
+        }
+        if (curvatureOut != nullptr) {
+            // The reference implementation compares against the last non-degenerate tangent.
+            // Degenerate predecessors are rare and handled by the scalar fix-up pass below.
+            hasDegenerateSegment |= int(i > 0 && lastLength < 1E-08f);
+            float cosAngle = glm::clamp((tx*lx + ty*ly + tz*lz) / (length * lastLength), 0.0f, 1.0f);
+            curvatureOut[i] = i == 0 || length < 1E-08f || lastLength < 1E-08f
+                    ? 0.0f : std::acos(cosAngle) / sgl::PI;
+        }
+    }
+
+    // Last node: Uses the tangent of the last segment.
+    const size_t last = n-1;
+    const glm::vec3 lastTangent = vertexPositions[last] - vertexPositions[last-1];
+    const float lastSegmentLength = glm::length(lastTangent);
+    minAttribute = std::min(minAttribute, a[last]);
+    maxAttribute = std::max(maxAttribute, a[last]);
+    if (attributeOut != nullptr) {
+        attributeOut[last] = a[last];
+    }
+    if (segmentLengthOut != nullptr) {
+        segmentLengthOut[last] = lastSegmentLength;
+    }
+    if (segmentAttributeDifferenceOut != nullptr) {
+        segmentAttributeDifferenceOut[last] = std::abs(a[last] - a[last-1]);
+    }
+    if (segmentHeightDifferenceOut != nullptr) {
+        segmentHeightDifferenceOut[last] = lastTangent.y;
+    }
+    if (angleOfAscentOut != nullptr) {
+        float cosAngle = glm::clamp(lastTangent.y / lastSegmentLength, 0.0f, 1.0f);
+        angleOfAscentOut[last] = lastSegmentLength < 0.0001f ? 0.0f : 1.0f - std::acos(cosAngle) / sgl::PI;
+    }
+    if (curvatureOut != nullptr) {
+        curvatureOut[last] = 0.0f;
+    }
+
+    if (totalAttributeDifferenceOut != nullptr) {
+        const float totalAttributeDifference = maxAttribute - minAttribute;
+        #pragma omp simd
+        for (size_t i = 0; i < n; i++) {
+            totalAttributeDifferenceOut[i] = totalAttributeDifference;
+        }
+    }
+
+    if (curvatureOut != nullptr && hasDegenerateSegment) {
+        // Scalar fix-up for nodes following (almost) identical vertices.
+        glm::vec3 lastValidTangent = glm::vec3(1.0f, 0.0f, 0.0f);
+        for (size_t i = 0; i < n-1; i++) {
+            glm::vec3 tangent = vertexPositions[i+1] - vertexPositions[i];
+            if (glm::length(tangent) < 1E-08f) {
+                curvatureOut[i] = 0.0f;
+                continue;
+            }
+            tangent = glm::normalize(tangent);
+            if (i != 0) {
+                float cosAngle = glm::clamp(glm::dot(tangent, lastValidTangent), 0.0f, 1.0f);
+                curvatureOut[i] = glm::acos(cosAngle) / sgl::PI;
+            }
+            lastValidTangent = tangent;
+        }
+    }
+}
+
+
 void computeTrajectoryAttributes(
         TrajectoryType trajectoryType,
         std::vector<glm::vec3> &vertexPositions,
         std::vector<float> &vertexAttributes,
         std::vector<std::vector<float>> &importanceCriteria)
 {
-    if (trajectoryType == TRAJECTORY_TYPE_ANEURYSM) {
-        // 0. Vorticity/Attribute
-        importanceCriteria.push_back(vertexAttributes);
-//        // 1. Curvature
-//        importanceCriteria.push_back(computeCurvature(vertexPositions));
-    } else if (trajectoryType == TRAJECTORY_TYPE_WCB) {
-        // 0. Pressure mapped to [0, 1]
-        importanceCriteria.push_back(vertexAttributes);
-        // 1. Curvature
-        importanceCriteria.push_back(computeCurvature(vertexPositions));
-//        importanceCriteria.push_back(computeSegmentLengths(vertexPositions));
-//        // 2. Trajectory pressure/attribute difference per segment
-//        importanceCriteria.push_back(computeSegmentAttributeDifference(vertexPositions, vertexAttributes));
-//        // 3. Total trajectory pressure/attribute difference
-//        importanceCriteria.push_back(computeTotalAttributeDifference(vertexPositions, vertexAttributes));
-//        // 4. Angle of ascent
-//        importanceCriteria.push_back(computeAngleOfAscent(vertexPositions));
-//        // 5. Height difference per segment
-//        importanceCriteria.push_back(computeSegmentHeightDifference(vertexPositions));
-    } else if (trajectoryType == TRAJECTORY_TYPE_CONVECTION_ROLLS) {
-        // 0. Vorticity/Attribute
-        importanceCriteria.push_back(vertexAttributes);
-        // 1. Curvature
-//        importanceCriteria.push_back(computeCurvature(vertexPositions));
-//        // 2. Segment length
-//        importanceCriteria.push_back(computeSegmentLengths(vertexPositions));
-    } else if (trajectoryType == TRAJECTORY_TYPE_CONVECTION_ROLLS_NEW) {
-        // 0. Vorticity/Attribute
-        importanceCriteria.push_back(vertexAttributes);
-        // 1. Curvature
-//        importanceCriteria.push_back(computeCurvature(vertexPositions));
-//        // 2. Segment length
-//        importanceCriteria.push_back(computeSegmentLengths(vertexPositions));
-    } else if (trajectoryType == TRAJECTORY_TYPE_RINGS) {
-        // 0. Vorticity/Attribute
-        importanceCriteria.push_back(vertexAttributes);
-//
-//        importanceCriteria.push_back(computeCurvature(vertexPositions));
-//
-//        importanceCriteria.push_back(computeSegmentLengths(vertexPositions));
-    } else if (trajectoryType == TRAJECTORY_TYPE_UCLA) {
-        // 0. Vorticity/Attrsibute
-        importanceCriteria.push_back(vertexAttributes);
-        //
-//        importanceCriteria.push_back(computeCurvature(vertexPositions));
-        //
-        //        importanceCriteria.push_back(computeSegmentLengths(vertexPositions));
+    const uint32_t criteriaMask = getImportanceCriteriaMask(trajectoryType);
+    const int numCriteria = getNumImportanceCriteria(criteriaMask);
+    const size_t n = vertexPositions.size();
+
+    size_t firstCriterion = importanceCriteria.size();
+    importanceCriteria.resize(firstCriterion + numCriteria);
+    std::vector<float*> outputArrays(numCriteria);
+    for (int i = 0; i < numCriteria; i++) {
+        importanceCriteria.at(firstCriterion + i).resize(n);
+        outputArrays.at(i) = importanceCriteria.at(firstCriterion + i).data();
     }
+
+    computeImportanceCriteriaFused(
+            n, vertexPositions.data(), vertexAttributes.data(), criteriaMask, outputArrays.data());
 }
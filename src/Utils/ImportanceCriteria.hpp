@@ -61,13 +61,70 @@ const char *const IMPORTANCE_CRITERION_CFD_DISPLAYNAMES[] = {
 /// https://www.khronos.org/registry/OpenGL-Refpages/gl4/html/packUnorm.xhtml
 void packUnorm16Array(const std::vector<float> &floatVector, std::vector<uint16_t> &unormVector);
 
+/// Packs the values relative to a known range (e.g., the range of the whole data set when packing it in chunks).
+void packUnorm16Array(
+        const float *floatValues, size_t numValues, float minValue, float maxValue, uint16_t *unormValues);
+
 /// https://www.khronos.org/registry/OpenGL-Refpages/gl4/html/packUnorm.xhtml
 void packUnorm16ArrayOfArrays(
         const std::vector<std::vector<float>> &floatVector,
         std::vector<std::vector<uint16_t>> &unormVector);
 
 /// https://www.khronos.org/registry/OpenGL-Refpages/gl4/html/unpackUnorm.xhtml
-void unpackUnorm16Array(uint16_t *unormVector, size_t vectorSize, std::vector<float> &floatVector);
+void unpackUnorm16Array(const uint16_t *unormVector, size_t vectorSize, std::vector<float> &floatVector);
+
+/// Computes the minimum and maximum of the unpacked values (i.e., in [0, 1]) without unpacking the array.
+void computeUnorm16ArrayRange(const uint16_t *unormVector, size_t vectorSize, float &minValue, float &maxValue);
+
+/// Reference implementations computing one importance criterion per pass (used for validation and benchmarking).
+std::vector<float> computeSegmentLengths(std::vector<glm::vec3> &vertexPositions);
+std::vector<float> computeCurvature(std::vector<glm::vec3> &vertexPositions);
+std::vector<float> computeSegmentAttributeDifference(
+        std::vector<glm::vec3> &vertexPositions,
+        std::vector<float> &vertexAttributes);
+std::vector<float> computeTotalAttributeDifference(
+        std::vector<glm::vec3> &vertexPositions,
+        std::vector<float> &vertexAttributes);
+std::vector<float> computeAngleOfAscent(std::vector<glm::vec3> &vertexPositions);
+std::vector<float> computeSegmentHeightDifference(std::vector<glm::vec3> &vertexPositions);
+
+/**
+ * Bit mask of the per-vertex importance criteria computed by computeImportanceCriteriaFused.
+ * The output arrays are ordered by ascending bit index.
+ */
+enum ImportanceCriterionBits {
+    IMPORTANCE_CRITERION_BIT_ATTRIBUTE = 1u << 0u,
+    IMPORTANCE_CRITERION_BIT_CURVATURE = 1u << 1u,
+    IMPORTANCE_CRITERION_BIT_SEGMENT_LENGTH = 1u << 2u,
+    IMPORTANCE_CRITERION_BIT_SEGMENT_ATTRIBUTE_DIFFERENCE = 1u << 3u,
+    IMPORTANCE_CRITERION_BIT_TOTAL_ATTRIBUTE_DIFFERENCE = 1u << 4u,
+    IMPORTANCE_CRITERION_BIT_ANGLE_OF_ASCENT = 1u << 5u,
+    IMPORTANCE_CRITERION_BIT_SEGMENT_HEIGHT_DIFFERENCE = 1u << 6u,
+    IMPORTANCE_CRITERION_BITS_ALL = (1u << 7u) - 1u
+};
+
+/// Returns the importance criteria stored for trajectories of the passed type (see computeTrajectoryAttributes).
+uint32_t getImportanceCriteriaMask(TrajectoryType trajectoryType);
+
+/// Returns the number of bits set in the passed importance criteria mask.
+int getNumImportanceCriteria(uint32_t criteriaMask);
+
+/**
+ * Computes all importance criteria selected in "criteriaMask" for one trajectory in a single vectorized pass.
+ * The results match the reference implementations above (computeCurvature, computeSegmentLengths, ...).
+ * @param numVertices The number of trajectory vertices.
+ * @param vertexPositions The trajectory vertex positions (numVertices entries).
+ * @param vertexAttributes The trajectory vertex attributes (numVertices entries).
+ * @param criteriaMask A combination of ImportanceCriterionBits.
+ * @param outputArrays One preallocated array of numVertices floats per bit set in criteriaMask (ascending bit order).
+ * The output array of IMPORTANCE_CRITERION_BIT_ATTRIBUTE may alias vertexAttributes.
+ */
+void computeImportanceCriteriaFused(
+        size_t numVertices,
+        const glm::vec3 *vertexPositions,
+        const float *vertexAttributes,
+        uint32_t criteriaMask,
+        float *const *outputArrays);
 
 void computeTrajectoryAttributes(
         TrajectoryType trajectoryType,
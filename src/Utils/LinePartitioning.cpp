@@ -0,0 +1,123 @@
+//
+// Created by christoph on 19.10.26.
+//
+
+#include <algorithm>
+#include <utility>
+#include <cfloat>
+
+#include "MortonCode.hpp"
+#include "LinePartitioning.hpp"
+
+void partitionLinesMorton(
+        const Trajectories &trajectories, size_t targetPointsPerPartition, LinePartitioning &partitioning)
+{
+    const size_t numLines = trajectories.size();
+    partitioning.lineOrder.clear();
+    partitioning.partitionOffsets = { 0 };
+    if (numLines == 0) {
+        return;
+    }
+
+    // 1. Compute the centroids of all lines and their bounding box in parallel.
+    std::vector<glm::vec3> centroids(numLines);
+    glm::vec3 minCentroid(FLT_MAX), maxCentroid(-FLT_MAX);
+    #pragma omp parallel
+    {
+        glm::vec3 threadMin(FLT_MAX), threadMax(-FLT_MAX);
+        #pragma omp for schedule(dynamic, 64)
+        for (size_t lineIdx = 0; lineIdx < numLines; lineIdx++) {
+            ArrayView<const glm::vec3> positions = trajectories.getLinePositions(lineIdx);
+            glm::vec3 centroid(0.0f);
+            for (const glm::vec3 &position : positions) {
+                centroid += position;
+            }
+            if (positions.size() > 0) {
+                centroid /= float(positions.size());
+            }
+            centroids[lineIdx] = centroid;
+            threadMin = glm::min(threadMin, centroid);
+            threadMax = glm::max(threadMax, centroid);
+        }
+        #pragma omp critical
+        {
+            minCentroid = glm::min(minCentroid, threadMin);
+            maxCentroid = glm::max(maxCentroid, threadMax);
+        }
+    }
+
+    // 2. Sort the lines by the Morton code of their centroid.
+    const glm::vec3 extent = glm::max(maxCentroid - minCentroid, glm::vec3(FLT_MIN));
+    std::vector<std::pair<uint64_t, uint32_t>> mortonCodes(numLines);
+    #pragma omp parallel for
+    for (size_t lineIdx = 0; lineIdx < numLines; lineIdx++) {
+        mortonCodes[lineIdx] = std::make_pair(
+                computeMortonCode3D((centroids[lineIdx] - minCentroid) / extent), uint32_t(lineIdx));
+    }
+    std::sort(mortonCodes.begin(), mortonCodes.end());
+
+    // 3. Cut the sorted line list into partitions with (approximately) the target number of points.
+    targetPointsPerPartition = std::max(targetPointsPerPartition, size_t(1));
+    partitioning.lineOrder.resize(numLines);
+    size_t numPartitionPoints = 0;
+    for (size_t i = 0; i < numLines; i++) {
+        const uint32_t lineIdx = mortonCodes[i].second;
+        partitioning.lineOrder[i] = lineIdx;
+        numPartitionPoints += trajectories.getLineNumPoints(lineIdx);
+        if (numPartitionPoints >= targetPointsPerPartition && i + 1 < numLines) {
+            partitioning.partitionOffsets.push_back(i + 1);
+            numPartitionPoints = 0;
+        }
+    }
+    partitioning.partitionOffsets.push_back(numLines);
+}
+
+static float computeSurfaceArea(const glm::vec3 &minPosition, const glm::vec3 &maxPosition)
+{
+    if (minPosition.x > maxPosition.x) {
+        return 0.0f;
+    }
+    glm::vec3 extent = maxPosition - minPosition;
+    return 2.0f * (extent.x * extent.y + extent.x * extent.z + extent.y * extent.z);
+}
+
+float computePartitionSurfaceAreaRatio(const Trajectories &trajectories, const LinePartitioning &partitioning)
+{
+    const size_t numPartitions = partitioning.getNumPartitions();
+    std::vector<float> partitionSurfaceAreas(numPartitions);
+    glm::vec3 minPosition(FLT_MAX), maxPosition(-FLT_MAX);
+
+    #pragma omp parallel
+    {
+        glm::vec3 threadMin(FLT_MAX), threadMax(-FLT_MAX);
+        #pragma omp for schedule(dynamic, 1)
+        for (size_t partitionIdx = 0; partitionIdx < numPartitions; partitionIdx++) {
+            glm::vec3 partitionMin(FLT_MAX), partitionMax(-FLT_MAX);
+            for (size_t i = partitioning.partitionOffsets[partitionIdx];
+                    i < partitioning.partitionOffsets[partitionIdx + 1]; i++) {
+                for (const glm::vec3 &position : trajectories.getLinePositions(partitioning.lineOrder[i])) {
+                    partitionMin = glm::min(partitionMin, position);
+                    partitionMax = glm::max(partitionMax, position);
+                }
+            }
+            partitionSurfaceAreas[partitionIdx] = computeSurfaceArea(partitionMin, partitionMax);
+            threadMin = glm::min(threadMin, partitionMin);
+            threadMax = glm::max(threadMax, partitionMax);
+        }
+        #pragma omp critical
+        {
+            minPosition = glm::min(minPosition, threadMin);
+            maxPosition = glm::max(maxPosition, threadMax);
+        }
+    }
+
+    float totalSurfaceArea = computeSurfaceArea(minPosition, maxPosition);
+    if (totalSurfaceArea <= 0.0f) {
+        return 0.0f;
+    }
+    float sumSurfaceAreas = 0.0f;
+    for (float surfaceArea : partitionSurfaceAreas) {
+        sumSurfaceAreas += surfaceArea;
+    }
+    return sumSurfaceAreas / totalSurfaceArea;
+}
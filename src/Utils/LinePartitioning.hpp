@@ -0,0 +1,40 @@
+//
+// Created by christoph on 19.10.26.
+//
+
+#ifndef PIXELSYNCOIT_LINEPARTITIONING_HPP
+#define PIXELSYNCOIT_LINEPARTITIONING_HPP
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+#include "TrajectoryFile.hpp"
+
+/**
+ * Spatially coherent groups of lines. The lines are sorted by the Morton code of their centroid, and consecutive
+ * lines in this order are assigned to the same partition until it reaches the target number of primitives.
+ * Partition i consists of the lines lineOrder[partitionOffsets[i]], ..., lineOrder[partitionOffsets[i+1] - 1].
+ */
+struct LinePartitioning {
+    std::vector<uint32_t> lineOrder;
+    std::vector<size_t> partitionOffsets = { 0 };
+
+    inline size_t getNumPartitions() const { return partitionOffsets.size() - 1; }
+};
+
+/**
+ * Partitions the passed lines using a Morton sort of the line centroids.
+ * @param targetPointsPerPartition The number of points (i.e., tube nodes) after which a partition is closed. A line
+ * is never split, thus partitions may be slightly larger than this.
+ */
+void partitionLinesMorton(
+        const Trajectories &trajectories, size_t targetPointsPerPartition, LinePartitioning &partitioning);
+
+/**
+ * Returns the sum of the surface areas of the bounding boxes of all partitions divided by the surface area of the
+ * bounding box of all lines. Smaller values mean less overlap between the partitions.
+ */
+float computePartitionSurfaceAreaRatio(const Trajectories &trajectories, const LinePartitioning &partitioning);
+
+#endif //PIXELSYNCOIT_LINEPARTITIONING_HPP
@@ -0,0 +1,96 @@
+//
+// Created by christoph on 19.10.26.
+//
+
+#ifdef _WIN32
+#include <fstream>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+#include <Utils/File/Logfile.hpp>
+
+#include "MappedFile.hpp"
+
+MappedFile::~MappedFile()
+{
+    close();
+}
+
+bool MappedFile::open(const std::string &filename, bool writable)
+{
+    close();
+
+#ifdef _WIN32
+    std::ifstream file(filename.c_str(), std::ifstream::binary | std::ifstream::ate);
+    if (!file.is_open()) {
+        sgl::Logfile::get()->writeError(std::string() + "Error in MappedFile::open: File \"" + filename
+                + "\" not found.");
+        return false;
+    }
+    fileSize = size_t(file.tellg());
+    fileData.resize(fileSize);
+    file.seekg(0);
+    if (fileSize > 0 && !file.read(fileData.data(), fileSize)) {
+        sgl::Logfile::get()->writeError(std::string() + "Error in MappedFile::open: Couldn't read file \""
+                + filename + "\".");
+        fileData.clear();
+        fileSize = 0;
+        return false;
+    }
+    data = fileData.data();
+#else
+    int fileDescriptor = ::open(filename.c_str(), O_RDONLY);
+    if (fileDescriptor < 0) {
+        sgl::Logfile::get()->writeError(std::string() + "Error in MappedFile::open: File \"" + filename
+                + "\" not found.");
+        return false;
+    }
+    struct stat fileStat;
+    if (fstat(fileDescriptor, &fileStat) != 0) {
+        ::close(fileDescriptor);
+        sgl::Logfile::get()->writeError(std::string() + "Error in MappedFile::open: Couldn't stat file \""
+                + filename + "\".");
+        return false;
+    }
+    fileSize = size_t(fileStat.st_size);
+    if (fileSize > 0) {
+        int protection = writable ? PROT_READ | PROT_WRITE : PROT_READ;
+        void *mappedData = mmap(nullptr, fileSize, protection, MAP_PRIVATE, fileDescriptor, 0);
+        if (mappedData == MAP_FAILED) {
+            ::close(fileDescriptor);
+            fileSize = 0;
+            sgl::Logfile::get()->writeError(std::string() + "Error in MappedFile::open: Couldn't map file \""
+                    + filename + "\".");
+            return false;
+        }
+        data = static_cast<char*>(mappedData);
+        madvise(mappedData, fileSize, MADV_SEQUENTIAL);
+    }
+    // The mapping stays valid after closing the file descriptor.
+    ::close(fileDescriptor);
+#endif
+
+    isFileOpen = true;
+    isMappingWritable = writable;
+    return true;
+}
+
+void MappedFile::close()
+{
+#ifdef _WIN32
+    fileData.clear();
+    fileData.shrink_to_fit();
+#else
+    if (data != nullptr) {
+        munmap(data, fileSize);
+    }
+#endif
+    data = nullptr;
+    fileSize = 0;
+    isFileOpen = false;
+    isMappingWritable = false;
+}
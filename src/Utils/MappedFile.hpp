@@ -0,0 +1,51 @@
+//
+// Created by christoph on 19.10.26.
+//
+
+#ifndef PIXELSYNCOIT_MAPPEDFILE_HPP
+#define PIXELSYNCOIT_MAPPEDFILE_HPP
+
+#include <string>
+#include <vector>
+#include <cstddef>
+
+/**
+ * Maps a file into memory (mmap on POSIX systems, the file is read into memory on Windows). In contrast to reading
+ * the whole file into a buffer, only the pages actually accessed are loaded from disk, and the data can be viewed
+ * directly without copying it into separate arrays.
+ */
+class MappedFile
+{
+public:
+    MappedFile() = default;
+    MappedFile(const MappedFile&) = delete;
+    MappedFile &operator=(const MappedFile&) = delete;
+    ~MappedFile();
+
+    /**
+     * @param filename: The file to map.
+     * @param writable: Maps the file privately with write access (copy-on-write), i.e., changes to the data are
+     * never written back to the file.
+     * @return False if the file could not be opened or mapped.
+     */
+    bool open(const std::string &filename, bool writable = false);
+    void close();
+
+    inline bool isOpen() const { return isFileOpen; }
+    inline bool isWritable() const { return isMappingWritable; }
+    inline size_t getSize() const { return fileSize; }
+    inline const char *getData() const { return data; }
+    /// Only valid if the file was opened as writable.
+    inline char *getWritableData() { return isMappingWritable ? data : nullptr; }
+
+private:
+    bool isFileOpen = false;
+    bool isMappingWritable = false;
+    size_t fileSize = 0;
+    char *data = nullptr;
+#ifdef _WIN32
+    std::vector<char> fileData;
+#endif
+};
+
+#endif //PIXELSYNCOIT_MAPPEDFILE_HPP
@@ -0,0 +1,298 @@
+//
+// Created by christoph on 19.10.26.
+//
+
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+
+#include "MeshCompression.hpp"
+
+const size_t BLOCK_HEADER_SIZE = 2 * sizeof(uint32_t);
+const size_t QUANTIZATION_HEADER_SIZE = 6 * sizeof(float);
+
+std::string TubeMeshEncodings::toString() const
+{
+    return "positions=" + std::to_string(int(positionEncoding)) + ";normals=" + std::to_string(int(normalEncoding))
+            + ";indices=" + std::to_string(int(indexEncoding));
+}
+
+size_t getMeshEncodingElementSize(BinaryMeshEncoding encoding)
+{
+    switch (encoding) {
+        case BINARY_MESH_ENCODING_QUANTIZED_POSITIONS:
+        case BINARY_MESH_ENCODING_OCTAHEDRAL_NORMALS:
+            return 3 * sizeof(float);
+        case BINARY_MESH_ENCODING_DELTA_VARINT:
+            return sizeof(uint32_t);
+        default:
+            return 0;
+    }
+}
+
+bool getMeshEncodedArraySize(BinaryMeshEncoding encoding, size_t numElements, size_t &encodedSize)
+{
+    const size_t numBlocks = (numElements + MESH_ENCODING_BLOCK_SIZE - 1) / MESH_ENCODING_BLOCK_SIZE;
+    if (encoding == BINARY_MESH_ENCODING_QUANTIZED_POSITIONS) {
+        encodedSize = numBlocks * (BLOCK_HEADER_SIZE + QUANTIZATION_HEADER_SIZE) + numElements * 3 * sizeof(uint16_t);
+        return true;
+    } else if (encoding == BINARY_MESH_ENCODING_OCTAHEDRAL_NORMALS) {
+        encodedSize = numBlocks * BLOCK_HEADER_SIZE + numElements * 2 * sizeof(int16_t);
+        return true;
+    }
+    return false;
+}
+
+template<class T>
+static inline T loadUnaligned(const uint8_t *data)
+{
+    T value;
+    memcpy(&value, data, sizeof(T));
+    return value;
+}
+
+template<class T>
+static inline void storeUnaligned(uint8_t *data, T value)
+{
+    memcpy(data, &value, sizeof(T));
+}
+
+
+// ---------------------------------------------- Encoding of one block ----------------------------------------------
+
+static void encodeQuantizedPositions(const float *positions, size_t n, std::vector<uint8_t> &payload)
+{
+    float minPos[3] = { INFINITY, INFINITY, INFINITY };
+    float maxPos[3] = { -INFINITY, -INFINITY, -INFINITY };
+    for (size_t i = 0; i < n; i++) {
+        for (int c = 0; c < 3; c++) {
+            minPos[c] = std::min(minPos[c], positions[i*3 + c]);
+            maxPos[c] = std::max(maxPos[c], positions[i*3 + c]);
+        }
+    }
+
+    // Store the minimum and the size of one quantization step, such that decoding is a single multiply-add.
+    float stepSize[3], invStepSize[3];
+    for (int c = 0; c < 3; c++) {
+        float extent = maxPos[c] - minPos[c];
+        stepSize[c] = extent / 65535.0f;
+        invStepSize[c] = extent > 0.0f ? 65535.0f / extent : 0.0f;
+    }
+
+    payload.resize(QUANTIZATION_HEADER_SIZE + n * 3 * sizeof(uint16_t));
+    memcpy(payload.data(), minPos, sizeof(minPos));
+    memcpy(payload.data() + sizeof(minPos), stepSize, sizeof(stepSize));
+    uint8_t *quantizedData = payload.data() + QUANTIZATION_HEADER_SIZE;
+    for (size_t i = 0; i < n * 3; i++) {
+        const int c = int(i % 3);
+        float value = (positions[i] - minPos[c]) * invStepSize[c];
+        storeUnaligned<uint16_t>(quantizedData + i * sizeof(uint16_t),
+                uint16_t(std::min(std::max(value, 0.0f), 65535.0f) + 0.5f));
+    }
+}
+
+static inline int16_t packSnorm16(float value)
+{
+    value = std::min(std::max(value, -1.0f), 1.0f) * 32767.0f;
+    return int16_t(value >= 0.0f ? value + 0.5f : value - 0.5f);
+}
+
+static void encodeOctahedralNormals(const float *normals, size_t n, std::vector<uint8_t> &payload)
+{
+    payload.resize(n * 2 * sizeof(int16_t));
+    for (size_t i = 0; i < n; i++) {
+        float x = normals[i*3], y = normals[i*3 + 1], z = normals[i*3 + 2];
+        float l1Norm = std::fabs(x) + std::fabs(y) + std::fabs(z);
+        float u = 0.0f, v = 0.0f;
+        if (l1Norm > 0.0f) {
+            u = x / l1Norm;
+            v = y / l1Norm;
+            if (z < 0.0f) {
+                // Fold the lower hemisphere over the diagonals
+                float foldedU = (1.0f - std::fabs(v)) * (u >= 0.0f ? 1.0f : -1.0f);
+                float foldedV = (1.0f - std::fabs(u)) * (v >= 0.0f ? 1.0f : -1.0f);
+                u = foldedU;
+                v = foldedV;
+            }
+        }
+        storeUnaligned<int16_t>(payload.data() + i * 4, packSnorm16(u));
+        storeUnaligned<int16_t>(payload.data() + i * 4 + 2, packSnorm16(v));
+    }
+}
+
+static void encodeDeltaVarint(const uint32_t *indices, size_t n, std::vector<uint8_t> &payload)
+{
+    payload.reserve(n * 2);
+    uint32_t lastIndex = 0;
+    for (size_t i = 0; i < n; i++) {
+        int64_t delta = int64_t(indices[i]) - int64_t(lastIndex);
+        uint64_t zigzag = (uint64_t(delta) << 1u) ^ uint64_t(delta >> 63);
+        while (zigzag >= 0x80u) {
+            payload.push_back(uint8_t(zigzag | 0x80u));
+            zigzag >>= 7u;
+        }
+        payload.push_back(uint8_t(zigzag));
+        lastIndex = indices[i];
+    }
+}
+
+
+// ---------------------------------------------- Decoding of one block ----------------------------------------------
+
+static bool decodeQuantizedPositions(const uint8_t *payload, size_t payloadSize, size_t n, float *positions)
+{
+    if (payloadSize != QUANTIZATION_HEADER_SIZE + n * 3 * sizeof(uint16_t)) {
+        return false;
+    }
+    float minPos[3], stepSize[3];
+    memcpy(minPos, payload, sizeof(minPos));
+    memcpy(stepSize, payload + sizeof(minPos), sizeof(stepSize));
+    const uint8_t *quantizedData = payload + QUANTIZATION_HEADER_SIZE;
+    const float minX = minPos[0], minY = minPos[1], minZ = minPos[2];
+    const float stepX = stepSize[0], stepY = stepSize[1], stepZ = stepSize[2];
+    #pragma omp simd
+    for (size_t i = 0; i < n; i++) {
+        positions[i*3] = minX + float(loadUnaligned<uint16_t>(quantizedData + i * 6)) * stepX;
+        positions[i*3 + 1] = minY + float(loadUnaligned<uint16_t>(quantizedData + i * 6 + 2)) * stepY;
+        positions[i*3 + 2] = minZ + float(loadUnaligned<uint16_t>(quantizedData + i * 6 + 4)) * stepZ;
+    }
+    return true;
+}
+
+static bool decodeOctahedralNormals(const uint8_t *payload, size_t payloadSize, size_t n, float *normals)
+{
+    if (payloadSize != n * 2 * sizeof(int16_t)) {
+        return false;
+    }
+    const float scale = 1.0f / 32767.0f;
+    #pragma omp simd
+    for (size_t i = 0; i < n; i++) {
+        float x = std::max(float(loadUnaligned<int16_t>(payload + i * 4)) * scale, -1.0f);
+        float y = std::max(float(loadUnaligned<int16_t>(payload + i * 4 + 2)) * scale, -1.0f);
+        float z = 1.0f - std::fabs(x) - std::fabs(y);
+        float t = std::max(-z, 0.0f);
+        x += x >= 0.0f ? -t : t;
+        y += y >= 0.0f ? -t : t;
+        float invLength = 1.0f / std::sqrt(x * x + y * y + z * z);
+        normals[i*3] = x * invLength;
+        normals[i*3 + 1] = y * invLength;
+        normals[i*3 + 2] = z * invLength;
+    }
+    return true;
+}
+
+static bool decodeDeltaVarint(const uint8_t *payload, size_t payloadSize, size_t n, uint32_t *indices)
+{
+    size_t offset = 0;
+    uint32_t lastIndex = 0;
+    for (size_t i = 0; i < n; i++) {
+        uint64_t zigzag = 0;
+        uint32_t shift = 0;
+        uint8_t byte;
+        do {
+            if (offset >= payloadSize || shift > 35) {
+                return false;
+            }
+            byte = payload[offset++];
+            zigzag |= uint64_t(byte & 0x7Fu) << shift;
+            shift += 7;
+        } while (byte & 0x80u);
+        int64_t delta = int64_t(zigzag >> 1u) ^ -int64_t(zigzag & 1u);
+        lastIndex = uint32_t(int64_t(lastIndex) + delta);
+        indices[i] = lastIndex;
+    }
+    return offset == payloadSize;
+}
+
+
+// ---------------------------------------------- Arrays of blocks ----------------------------------------------
+
+void encodeMeshArray(
+        BinaryMeshEncoding encoding, const void *data, size_t numElements, std::vector<uint8_t> &encodedData)
+{
+    const size_t numBlocks = (numElements + MESH_ENCODING_BLOCK_SIZE - 1) / MESH_ENCODING_BLOCK_SIZE;
+    std::vector<std::vector<uint8_t>> blockPayloads(numBlocks);
+    #pragma omp parallel for schedule(dynamic)
+    for (size_t blockIdx = 0; blockIdx < numBlocks; blockIdx++) {
+        const size_t firstElement = blockIdx * MESH_ENCODING_BLOCK_SIZE;
+        const size_t n = std::min(MESH_ENCODING_BLOCK_SIZE, numElements - firstElement);
+        if (encoding == BINARY_MESH_ENCODING_QUANTIZED_POSITIONS) {
+            encodeQuantizedPositions((const float*)data + firstElement * 3, n, blockPayloads[blockIdx]);
+        } else if (encoding == BINARY_MESH_ENCODING_OCTAHEDRAL_NORMALS) {
+            encodeOctahedralNormals((const float*)data + firstElement * 3, n, blockPayloads[blockIdx]);
+        } else if (encoding == BINARY_MESH_ENCODING_DELTA_VARINT) {
+            encodeDeltaVarint((const uint32_t*)data + firstElement, n, blockPayloads[blockIdx]);
+        }
+    }
+
+    size_t encodedSize = encodedData.size();
+    for (const std::vector<uint8_t> &payload : blockPayloads) {
+        encodedSize += BLOCK_HEADER_SIZE + payload.size();
+    }
+    encodedData.reserve(encodedSize);
+    for (size_t blockIdx = 0; blockIdx < numBlocks; blockIdx++) {
+        const std::vector<uint8_t> &payload = blockPayloads[blockIdx];
+        const size_t n = std::min(MESH_ENCODING_BLOCK_SIZE, numElements - blockIdx * MESH_ENCODING_BLOCK_SIZE);
+        uint8_t header[BLOCK_HEADER_SIZE];
+        storeUnaligned<uint32_t>(header, uint32_t(n));
+        storeUnaligned<uint32_t>(header + sizeof(uint32_t), uint32_t(payload.size()));
+        encodedData.insert(encodedData.end(), header, header + BLOCK_HEADER_SIZE);
+        encodedData.insert(encodedData.end(), payload.begin(), payload.end());
+    }
+}
+
+bool decodeMeshArray(
+        BinaryMeshEncoding encoding, const uint8_t *encodedData, size_t encodedSize,
+        size_t numElements, void *decodedData)
+{
+    const size_t elementSize = getMeshEncodingElementSize(encoding);
+    if (elementSize == 0) {
+        return false;
+    }
+
+    // The block headers are chained, thus the block table is built sequentially (one read per block).
+    std::vector<size_t> blockOffsets;
+    std::vector<size_t> blockFirstElements;
+    size_t offset = 0;
+    size_t numBlockElements = 0;
+    while (offset < encodedSize) {
+        if (encodedSize - offset < BLOCK_HEADER_SIZE) {
+            return false;
+        }
+        size_t n = loadUnaligned<uint32_t>(encodedData + offset);
+        size_t payloadSize = loadUnaligned<uint32_t>(encodedData + offset + sizeof(uint32_t));
+        if (n > numElements - numBlockElements || payloadSize > encodedSize - offset - BLOCK_HEADER_SIZE) {
+            return false;
+        }
+        blockOffsets.push_back(offset);
+        blockFirstElements.push_back(numBlockElements);
+        numBlockElements += n;
+        offset += BLOCK_HEADER_SIZE + payloadSize;
+    }
+    if (numBlockElements != numElements) {
+        return false;
+    }
+
+    const size_t numBlocks = blockOffsets.size();
+    int numCorruptBlocks = 0;
+    #pragma omp parallel for schedule(dynamic) reduction(+:numCorruptBlocks)
+    for (size_t blockIdx = 0; blockIdx < numBlocks; blockIdx++) {
+        const uint8_t *blockData = encodedData + blockOffsets[blockIdx];
+        const size_t n = loadUnaligned<uint32_t>(blockData);
+        const size_t payloadSize = loadUnaligned<uint32_t>(blockData + sizeof(uint32_t));
+        const uint8_t *payload = blockData + BLOCK_HEADER_SIZE;
+        uint8_t *blockOutput = (uint8_t*)decodedData + blockFirstElements[blockIdx] * elementSize;
+        bool isValid = false;
+        if (encoding == BINARY_MESH_ENCODING_QUANTIZED_POSITIONS) {
+            isValid = decodeQuantizedPositions(payload, payloadSize, n, (float*)blockOutput);
+        } else if (encoding == BINARY_MESH_ENCODING_OCTAHEDRAL_NORMALS) {
+            isValid = decodeOctahedralNormals(payload, payloadSize, n, (float*)blockOutput);
+        } else if (encoding == BINARY_MESH_ENCODING_DELTA_VARINT) {
+            isValid = decodeDeltaVarint(payload, payloadSize, n, (uint32_t*)blockOutput);
+        }
+        if (!isValid) {
+            numCorruptBlocks++;
+        }
+    }
+    return numCorruptBlocks == 0;
+}
@@ -0,0 +1,66 @@
+//
+// Created by christoph on 19.10.26.
+//
+
+#ifndef PIXELSYNCOIT_MESHCOMPRESSION_HPP
+#define PIXELSYNCOIT_MESHCOMPRESSION_HPP
+
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <cstddef>
+
+/**
+ * Optional encodings of the arrays of a binmesh submesh (since format version 6). Encoded arrays consist of independent
+ * blocks of at most MESH_ENCODING_BLOCK_SIZE elements, such that they can be encoded and decoded in parallel.
+ * Each block starts with its number of elements and the size of its payload in bytes (both uint32).
+ */
+enum BinaryMeshEncoding : uint32_t {
+    BINARY_MESH_ENCODING_NONE = 0,
+    // vec3 float positions -> 3x unorm16 relative to the bounding box of the block (lossy)
+    BINARY_MESH_ENCODING_QUANTIZED_POSITIONS = 1,
+    // Normalized vec3 float normals -> 2x snorm16 octahedral coordinates (lossy)
+    BINARY_MESH_ENCODING_OCTAHEDRAL_NORMALS = 2,
+    // uint32 indices -> zigzag-coded differences to the previous index as LEB128 varints (lossless)
+    BINARY_MESH_ENCODING_DELTA_VARINT = 3
+};
+const size_t MESH_ENCODING_BLOCK_SIZE = 65536;
+
+/**
+ * The encodings of the positions, normals and indices of the tube meshes created by
+ * convertTrajectoryDataToBinaryTriangleMesh and convertHairDataToBinaryTriangleMesh. By default, no array is encoded.
+ * The encodings are opt-in via the GUI and are part of the asset cache key of the converted meshes. Unsupported
+ * encodings of an array are treated like BINARY_MESH_ENCODING_NONE.
+ */
+struct TubeMeshEncodings
+{
+    BinaryMeshEncoding positionEncoding = BINARY_MESH_ENCODING_NONE;
+    BinaryMeshEncoding normalEncoding = BINARY_MESH_ENCODING_NONE;
+    BinaryMeshEncoding indexEncoding = BINARY_MESH_ENCODING_NONE;
+
+    /// Returns e.g. "positions=1;normals=2;indices=3" (used as part of the asset cache key of converted meshes).
+    std::string toString() const;
+};
+
+/// Returns the size of one (decoded) element in bytes, or 0 for BINARY_MESH_ENCODING_NONE.
+size_t getMeshEncodingElementSize(BinaryMeshEncoding encoding);
+
+/**
+ * Computes the size in bytes of numElements encoded elements (as written by one call to encodeMeshArray).
+ * @return False if the size depends on the data (BINARY_MESH_ENCODING_DELTA_VARINT).
+ */
+bool getMeshEncodedArraySize(BinaryMeshEncoding encoding, size_t numElements, size_t &encodedSize);
+
+/// Appends the encoded form of the passed elements to encodedData.
+void encodeMeshArray(
+        BinaryMeshEncoding encoding, const void *data, size_t numElements, std::vector<uint8_t> &encodedData);
+
+/**
+ * Decodes an encoded array of numElements elements to decodedData.
+ * @return False if the encoded data is corrupt.
+ */
+bool decodeMeshArray(
+        BinaryMeshEncoding encoding, const uint8_t *encodedData, size_t encodedSize,
+        size_t numElements, void *decodedData);
+
+#endif //PIXELSYNCOIT_MESHCOMPRESSION_HPP
@@ -6,6 +6,7 @@
  */
 
 #include <fstream>
+#include <cassert>
 #include <algorithm>
 #include <random>
 #include <chrono>
@@ -13,6 +14,7 @@
 
 #include <boost/algorithm/string/predicate.hpp>
 #include <glm/glm.hpp>
+#include <GL/glew.h>
 
 #include <Utils/Events/Stream/Stream.hpp>
 #include <Utils/File/Logfile.hpp>
@@ -22,63 +24,439 @@
 #include <Graphics/Renderer.hpp>
 
 #include "ImportanceCriteria.hpp"
+#include "MortonCode.hpp"
 #include "MeshSerializer.hpp"
 
 using namespace std;
 using namespace sgl;
 
-const uint32_t MESH_FORMAT_VERSION = 4u;
+const uint32_t MESH_FORMAT_VERSION = 6u;
+// Version 4 files (without attribute value ranges) and version 5 files (without encodings) can still be read.
+const uint32_t MESH_FORMAT_VERSION_NO_ATTRIBUTE_RANGE = 4u;
+const uint32_t MESH_FORMAT_VERSION_NO_ENCODING = 5u;
 
-void writeMesh3D(const std::string &filename, const BinaryMesh &mesh) {
-#ifndef __MINGW32__
-    std::ofstream file(filename.c_str(), std::ofstream::binary);
-    if (!file.is_open()) {
-        Logfile::get()->writeError(std::string() + "Error in writeMesh3D: File \"" + filename + "\" not found.");
+static inline bool isUnorm16ScalarAttribute(const BinaryMeshAttribute &attribute) {
+    return attribute.numComponents == 1 && attribute.attributeFormat == ATTRIB_UNSIGNED_SHORT;
+}
+
+bool writeMesh3D(const std::string &filename, const BinaryMesh &mesh) {
+    BinaryMeshStreamWriter writer;
+    if (!writer.open(filename)) {
+        return false;
+    }
+    for (const BinarySubMesh &submesh : mesh.submeshes) {
+        writer.writeSubmesh(submesh);
+    }
+    return writer.close();
+}
+
+
+static inline bool seekFile(FILE *file, uint64_t offset, int origin) {
+#ifdef __MINGW32__
+    return fseeko64(file, int64_t(offset), origin) == 0;
+#else
+    return fseeko(file, off_t(offset), origin) == 0;
+#endif
+}
+
+BinaryMeshStreamWriter::~BinaryMeshStreamWriter() {
+    if (file) {
+        close();
+    }
+}
+
+bool BinaryMeshStreamWriter::open(const std::string &filename) {
+    this->filename = filename;
+    file = fopen(filename.c_str(), "wb");
+    if (file == NULL) {
+        Logfile::get()->writeError(std::string() + "Error in BinaryMeshStreamWriter::open: Couldn't create file \""
+                + filename + "\".");
+        return false;
+    }
+    writeFailed = false;
+    numSubmeshes = 0;
+    filePosition = 0;
+    writeUint32(MESH_FORMAT_VERSION);
+    writeUint32(0u); // Number of submeshes, patched in close
+    return !writeFailed;
+}
+
+bool BinaryMeshStreamWriter::close() {
+    if (!file) {
+        return false;
+    }
+    if (isSubmeshOpen) {
+        endSubmesh();
+    }
+    seek(sizeof(uint32_t));
+    writeUint32(numSubmeshes);
+    if (fclose(file) != 0) {
+        writeFailed = true;
+    }
+    file = nullptr;
+    arrays.clear();
+
+    if (writeFailed) {
+        Logfile::get()->writeError(std::string() + "Error in BinaryMeshStreamWriter::close: Writing \""
+                + filename + "\" failed.");
+        remove(filename.c_str());
+        return false;
+    }
+    return true;
+}
+
+void BinaryMeshStreamWriter::write(const void *data, size_t numBytes) {
+    if (numBytes > 0 && fwrite(data, 1, numBytes, file) != numBytes) {
+        writeFailed = true;
+    }
+    filePosition += numBytes;
+}
+
+void BinaryMeshStreamWriter::writeUint32(uint32_t value) {
+    write(&value, sizeof(uint32_t));
+}
+
+void BinaryMeshStreamWriter::writeString(const std::string &str) {
+    writeUint32(uint32_t(str.size()));
+    write(str.data(), str.size());
+}
+
+void BinaryMeshStreamWriter::seek(uint64_t fileOffset) {
+    if (fileOffset == filePosition) {
         return;
     }
- #else
-    FILE *fileptr = fopen(filename.c_str(), "wb");
-    if (fileptr == NULL) {
-        Logfile::get()->writeError(std::string() + "Error in writeMesh3D: File \"" + filename + "\" not found.");
+    if (!seekFile(file, fileOffset, SEEK_SET)) {
+        writeFailed = true;
+    }
+    filePosition = fileOffset;
+}
+
+void BinaryMeshStreamWriter::beginSubmesh(
+        const ObjMaterial &material, sgl::VertexMode vertexMode, size_t numIndices) {
+    if (isSubmeshOpen) {
+        endSubmesh();
+    }
+    this->material = material;
+    this->vertexMode = vertexMode;
+    isSubmeshOpen = true;
+    hasSubmeshDataBegun = false;
+    numArrayHeadersWritten = 0;
+    uniforms.clear();
+    arrays.clear();
+    ArrayState indexArray;
+    indexArray.attributeFormat = ATTRIB_UNSIGNED_INT;
+    indexArray.numBytes = uint64_t(numIndices) * sizeof(uint32_t);
+    arrays.push_back(indexArray);
+}
+
+size_t BinaryMeshStreamWriter::addAttribute(
+        const std::string &name, sgl::VertexAttributeFormat attributeFormat, uint32_t numComponents,
+        size_t numBytes, BinaryMeshEncoding encoding) {
+    assert(isSubmeshOpen && !hasSubmeshDataBegun);
+    ArrayState attribute;
+    attribute.name = name;
+    attribute.attributeFormat = attributeFormat;
+    attribute.numComponents = numComponents;
+    attribute.numBytes = numBytes;
+    attribute.isUnorm16Scalar = numComponents == 1 && attributeFormat == ATTRIB_UNSIGNED_SHORT;
+    bool isFloatVec3 = attributeFormat == ATTRIB_FLOAT && numComponents == 3;
+    if ((encoding == BINARY_MESH_ENCODING_QUANTIZED_POSITIONS || encoding == BINARY_MESH_ENCODING_OCTAHEDRAL_NORMALS)
+            && isFloatVec3) {
+        attribute.encoding = encoding;
+    }
+    arrays.push_back(attribute);
+    return arrays.size() - 2;
+}
+
+void BinaryMeshStreamWriter::setIndexEncoding(BinaryMeshEncoding encoding) {
+    assert(isSubmeshOpen && !hasSubmeshDataBegun);
+    arrays.front().encoding = encoding == BINARY_MESH_ENCODING_DELTA_VARINT ? encoding : BINARY_MESH_ENCODING_NONE;
+}
+
+void BinaryMeshStreamWriter::addUniform(const BinaryMeshUniform &uniform) {
+    assert(isSubmeshOpen);
+    uniforms.push_back(uniform);
+}
+
+void BinaryMeshStreamWriter::addUniforms(const std::vector<BinaryMeshUniform> &uniforms) {
+    assert(isSubmeshOpen);
+    this->uniforms.insert(this->uniforms.end(), uniforms.begin(), uniforms.end());
+}
+
+void BinaryMeshStreamWriter::appendIndices(const uint32_t *indices, size_t numIndices) {
+    appendArrayData(0, indices, numIndices * sizeof(uint32_t));
+}
+
+void BinaryMeshStreamWriter::appendAttributeData(size_t attributeIndex, const void *data, size_t numBytes) {
+    appendArrayData(attributeIndex + 1, data, numBytes);
+}
+
+void BinaryMeshStreamWriter::finishIndices() {
+    finishArray(0);
+}
+
+void BinaryMeshStreamWriter::finishAttribute(size_t attributeIndex) {
+    finishArray(attributeIndex + 1);
+}
+
+void BinaryMeshStreamWriter::beginSubmeshData() {
+    if (hasSubmeshDataBegun) {
         return;
     }
- #endif
+    hasSubmeshDataBegun = true;
+    for (ArrayState &array : arrays) {
+        if (array.encoding == BINARY_MESH_ENCODING_NONE) {
+            array.numFileBytes = array.numBytes;
+            array.hasKnownFileSize = true;
+        } else {
+            size_t numElements = size_t(array.numBytes / getMeshEncodingElementSize(array.encoding));
+            size_t encodedSize = 0;
+            array.hasKnownFileSize = getMeshEncodedArraySize(array.encoding, numElements, encodedSize);
+            array.numFileBytes = encodedSize;
+        }
+    }
 
-    sgl::BinaryWriteStream stream;
-    stream.write((uint32_t)MESH_FORMAT_VERSION);
-    stream.write((uint32_t)mesh.submeshes.size());
+    // A new submesh always starts at the end of the file.
+    submeshFileOffset = filePosition;
+    write(&material, sizeof(ObjMaterial));
+    writeUint32(uint32_t(vertexMode));
+    writeArrayHeaders();
+}
 
-    for (const BinarySubMesh &submesh : mesh.submeshes) {
-        stream.write(submesh.material);
-        stream.write((uint32_t)submesh.vertexMode);
-        stream.writeArray(submesh.indices);
+uint64_t BinaryMeshStreamWriter::getArrayEndFileOffset(size_t arrayIndex) {
+    const ArrayState &array = arrays.at(arrayIndex);
+    return array.dataFileOffset + array.numFileBytes + (arrayIndex == 0 ? sizeof(uint32_t) : 2 * sizeof(float));
+}
 
-        // Write attributes
-        stream.write((uint32_t)submesh.attributes.size());
-        for (const BinaryMeshAttribute &attribute : submesh.attributes) {
-            stream.write(attribute.name);
-            stream.write((uint32_t)attribute.attributeFormat);
-            stream.write((uint32_t)attribute.numComponents);
-            stream.writeArray(attribute.data);
+void BinaryMeshStreamWriter::writeArrayHeaders() {
+    while (numArrayHeadersWritten < arrays.size()) {
+        const size_t arrayIndex = numArrayHeadersWritten;
+        uint64_t headerFileOffset;
+        if (arrayIndex == 0) {
+            headerFileOffset = submeshFileOffset + sizeof(ObjMaterial) + sizeof(uint32_t);
+        } else if (arrays.at(arrayIndex - 1).hasKnownFileSize) {
+            headerFileOffset = getArrayEndFileOffset(arrayIndex - 1);
+        } else {
+            break;
         }
 
-        // Write uniforms
-        stream.write((uint32_t)submesh.uniforms.size());
-        for (const BinaryMeshUniform &uniform : submesh.uniforms) {
-            stream.write(uniform.name);
-            stream.write((uint32_t)uniform.attributeFormat);
-            stream.write((uint32_t)uniform.numComponents);
-            stream.writeArray(uniform.data);
+        ArrayState &array = arrays.at(arrayIndex);
+        // The index array stores the number of indices, attributes store the number of bytes (like writeArray).
+        uint64_t arraySize = arrayIndex == 0 ? array.numBytes / sizeof(uint32_t) : array.numBytes;
+        if (arraySize > uint64_t(UINT32_MAX) || array.numFileBytes > uint64_t(UINT32_MAX)) {
+            Logfile::get()->writeError(std::string() + "Error in BinaryMeshStreamWriter::writeArrayHeaders: Array "
+                    + "too large for the binmesh format in \"" + filename + "\".");
+            writeFailed = true;
+        }
+        seek(headerFileOffset);
+        if (arrayIndex > 0) {
+            writeString(array.name);
+            writeUint32(uint32_t(array.attributeFormat));
+            writeUint32(array.numComponents);
         }
+        writeUint32(uint32_t(array.encoding));
+        writeUint32(uint32_t(arraySize));
+        if (array.encoding != BINARY_MESH_ENCODING_NONE) {
+            writeUint32(uint32_t(array.numFileBytes)); // Patched in finishArray if it depends on the data
+        }
+        array.dataFileOffset = filePosition;
+        array.isHeaderWritten = true;
+        numArrayHeadersWritten++;
     }
+}
 
-#ifndef __MINGW32__
-    file.write((const char*)stream.getBuffer(), stream.getSize());
-    file.close();
-#else
-    fwrite((const void*)stream.getBuffer(), stream.getSize(), 1, fileptr);
-    fclose(fileptr);
-#endif
+void BinaryMeshStreamWriter::appendArrayData(size_t arrayIndex, const void *data, size_t numBytes) {
+    assert(isSubmeshOpen && arrayIndex < arrays.size());
+    beginSubmeshData();
+    ArrayState &array = arrays.at(arrayIndex);
+    if (array.isFinished) {
+        Logfile::get()->writeError(std::string() + "Error in BinaryMeshStreamWriter::appendArrayData: Data "
+                + "appended to an already finished array of \"" + filename + "\".");
+        writeFailed = true;
+        return;
+    }
+    if (!array.isHeaderWritten) {
+        Logfile::get()->writeError(std::string() + "Error in BinaryMeshStreamWriter::appendArrayData: Attribute "
+                + "data appended before the delta varint encoded indices were finished in \"" + filename + "\".");
+        writeFailed = true;
+        return;
+    }
+    if (numBytes == 0) {
+        return;
+    }
+    if (array.numAppendedBytes + numBytes > array.numBytes) {
+        Logfile::get()->writeError(std::string() + "Error in BinaryMeshStreamWriter::appendArrayData: More data "
+                + "appended to an array than passed up front in \"" + filename + "\".");
+        writeFailed = true;
+        return;
+    }
+    const size_t elementSize = getMeshEncodingElementSize(array.encoding);
+    if (elementSize != 0 && numBytes % elementSize != 0) {
+        Logfile::get()->writeError(std::string() + "Error in BinaryMeshStreamWriter::appendArrayData: Partial "
+                + "element appended to an encoded array of \"" + filename + "\".");
+        writeFailed = true;
+        return;
+    }
+
+    if (array.isUnorm16Scalar) {
+        const uint16_t *values = (const uint16_t*)data;
+        const size_t numValues = numBytes / sizeof(uint16_t);
+        uint16_t minUnorm = array.minUnorm;
+        uint16_t maxUnorm = array.maxUnorm;
+        #pragma omp parallel for simd reduction(min:minUnorm) reduction(max:maxUnorm)
+        for (size_t i = 0; i < numValues; i++) {
+            minUnorm = std::min(minUnorm, values[i]);
+            maxUnorm = std::max(maxUnorm, values[i]);
+        }
+        array.minUnorm = minUnorm;
+        array.maxUnorm = maxUnorm;
+    }
+    array.numAppendedBytes += numBytes;
+
+    if (array.encoding == BINARY_MESH_ENCODING_NONE) {
+        writeArrayData(array, data, numBytes);
+        return;
+    }
+
+    // All blocks except for the last one are full, such that the encoded size is independent of the chunk sizes.
+    const uint8_t *bytes = (const uint8_t*)data;
+    size_t numElements = numBytes / elementSize;
+    if (!array.incompleteBlock.empty()) {
+        const size_t numBlockElements = array.incompleteBlock.size() / elementSize;
+        const size_t numNewElements = std::min(numElements, MESH_ENCODING_BLOCK_SIZE - numBlockElements);
+        array.incompleteBlock.insert(array.incompleteBlock.end(), bytes, bytes + numNewElements * elementSize);
+        bytes += numNewElements * elementSize;
+        numElements -= numNewElements;
+        if (numBlockElements + numNewElements < MESH_ENCODING_BLOCK_SIZE) {
+            return;
+        }
+        encodeArrayData(array, array.incompleteBlock.data(), MESH_ENCODING_BLOCK_SIZE);
+        array.incompleteBlock.clear();
+    }
+    const size_t numFullBlockElements = numElements / MESH_ENCODING_BLOCK_SIZE * MESH_ENCODING_BLOCK_SIZE;
+    if (numFullBlockElements > 0) {
+        encodeArrayData(array, bytes, numFullBlockElements);
+    }
+    array.incompleteBlock.insert(
+            array.incompleteBlock.end(), bytes + numFullBlockElements * elementSize, bytes + numElements * elementSize);
+}
+
+void BinaryMeshStreamWriter::encodeArrayData(ArrayState &array, const void *data, size_t numElements) {
+    encodedData.clear();
+    encodeMeshArray(array.encoding, data, numElements, encodedData);
+    writeArrayData(array, encodedData.data(), encodedData.size());
+}
+
+void BinaryMeshStreamWriter::writeArrayData(ArrayState &array, const void *data, size_t numBytes) {
+    if (array.hasKnownFileSize && array.numWrittenBytes + numBytes > array.numFileBytes) {
+        writeFailed = true;
+        return;
+    }
+    seek(array.dataFileOffset + array.numWrittenBytes);
+    write(data, numBytes);
+    array.numWrittenBytes += numBytes;
+}
+
+void BinaryMeshStreamWriter::finishArray(size_t arrayIndex) {
+    assert(isSubmeshOpen && arrayIndex < arrays.size());
+    beginSubmeshData();
+    ArrayState &array = arrays.at(arrayIndex);
+    if (array.isFinished) {
+        return;
+    }
+    if (!array.isHeaderWritten) {
+        Logfile::get()->writeError(std::string() + "Error in BinaryMeshStreamWriter::finishArray: Attribute "
+                + "finished before the delta varint encoded indices were finished in \"" + filename + "\".");
+        writeFailed = true;
+        return;
+    }
+    if (array.numAppendedBytes != array.numBytes) {
+        Logfile::get()->writeError(std::string() + "Error in BinaryMeshStreamWriter::finishArray: The size of "
+                + "the data appended to an array differs from the size passed up front in \"" + filename + "\".");
+        writeFailed = true;
+    }
+    if (!array.incompleteBlock.empty()) {
+        encodeArrayData(
+                array, array.incompleteBlock.data(),
+                array.incompleteBlock.size() / getMeshEncodingElementSize(array.encoding));
+        std::vector<uint8_t>().swap(array.incompleteBlock);
+    }
+
+    if (!array.hasKnownFileSize) {
+        array.numFileBytes = array.numWrittenBytes;
+        array.hasKnownFileSize = true;
+        if (array.numFileBytes > uint64_t(UINT32_MAX)) {
+            Logfile::get()->writeError(std::string() + "Error in BinaryMeshStreamWriter::finishArray: Array too "
+                    + "large for the binmesh format in \"" + filename + "\".");
+            writeFailed = true;
+        }
+        seek(array.dataFileOffset - sizeof(uint32_t));
+        writeUint32(uint32_t(array.numFileBytes));
+    } else if (array.numWrittenBytes != array.numFileBytes) {
+        writeFailed = true;
+    }
+
+    seek(array.dataFileOffset + array.numFileBytes);
+    if (arrayIndex == 0) {
+        writeUint32(uint32_t(arrays.size() - 1)); // Number of attributes
+    } else {
+        float minValue = 0.0f, maxValue = 1.0f;
+        if (array.isUnorm16Scalar) {
+            if (array.numBytes == 0) {
+                minValue = 0.0f;
+                maxValue = 0.0f;
+            } else {
+                minValue = float(array.minUnorm) / 65535.0f;
+                maxValue = float(array.maxUnorm) / 65535.0f;
+            }
+        }
+        write(&minValue, sizeof(float));
+        write(&maxValue, sizeof(float));
+    }
+    array.isFinished = true;
+    writeArrayHeaders();
+}
+
+void BinaryMeshStreamWriter::endSubmesh() {
+    assert(isSubmeshOpen);
+    beginSubmeshData();
+    for (size_t i = 0; i < arrays.size(); i++) {
+        finishArray(i);
+    }
+
+    seek(getArrayEndFileOffset(arrays.size() - 1));
+    writeUint32(uint32_t(uniforms.size()));
+    for (const BinaryMeshUniform &uniform : uniforms) {
+        writeString(uniform.name);
+        writeUint32(uint32_t(uniform.attributeFormat));
+        writeUint32(uniform.numComponents);
+        writeUint32(uint32_t(uniform.data.size()));
+        write(uniform.data.data(), uniform.data.size());
+    }
+
+    uniforms.clear();
+    arrays.clear();
+    isSubmeshOpen = false;
+    numSubmeshes++;
+}
+
+void BinaryMeshStreamWriter::writeSubmesh(const BinarySubMesh &submesh) {
+    beginSubmesh(submesh.material, submesh.vertexMode, submesh.indices.size());
+    setIndexEncoding(submesh.indexEncoding);
+    for (const BinaryMeshAttribute &attribute : submesh.attributes) {
+        addAttribute(
+                attribute.name, attribute.attributeFormat, attribute.numComponents, attribute.data.size(),
+                attribute.encoding);
+    }
+    addUniforms(submesh.uniforms);
+    appendIndices(submesh.indices.data(), submesh.indices.size());
+    finishIndices();
+    for (size_t i = 0; i < submesh.attributes.size(); i++) {
+        const std::vector<uint8_t> &data = submesh.attributes.at(i).data;
+        appendAttributeData(i, data.data(), data.size());
+        finishAttribute(i);
+    }
+    endSubmesh();
 }
 
 void readMesh3D(const std::string &filename, BinaryMesh &mesh) {
@@ -118,7 +496,8 @@ void readMesh3D(const std::string &filename, BinaryMesh &mesh) {
     sgl::BinaryReadStream stream(buffer, size);
     uint32_t version;
     stream.read(version);
-    if (version != MESH_FORMAT_VERSION) {
+    if (version != MESH_FORMAT_VERSION && version != MESH_FORMAT_VERSION_NO_ENCODING
+            && version != MESH_FORMAT_VERSION_NO_ATTRIBUTE_RANGE) {
         Logfile::get()->writeError(std::string() + "Error in readMesh3D: Invalid version in file \""
                 + filename + "\".");
         return;
@@ -127,6 +506,7 @@ void readMesh3D(const std::string &filename, BinaryMesh &mesh) {
     uint32_t numSubmeshes;
     stream.read(numSubmeshes);
     mesh.submeshes.resize(numSubmeshes);
+    std::vector<uint8_t> encodedData;
 
     for (uint32_t i = 0; i < numSubmeshes; i++) {
         BinarySubMesh &submesh = mesh.submeshes.at(i);
@@ -134,7 +514,26 @@ void readMesh3D(const std::string &filename, BinaryMesh &mesh) {
         uint32_t vertexMode;
         stream.read(vertexMode);
         submesh.vertexMode = (sgl::VertexMode)vertexMode;
-        stream.readArray(mesh.submeshes.at(i).indices);
+        if (version >= MESH_FORMAT_VERSION) {
+            uint32_t indexEncoding;
+            stream.read(indexEncoding);
+            submesh.indexEncoding = (BinaryMeshEncoding)indexEncoding;
+        }
+        if (submesh.indexEncoding == BINARY_MESH_ENCODING_NONE) {
+            stream.readArray(submesh.indices);
+        } else {
+            uint32_t numIndices;
+            stream.read(numIndices);
+            stream.readArray(encodedData);
+            submesh.indices.resize(numIndices);
+            if (!decodeMeshArray(submesh.indexEncoding, encodedData.data(), encodedData.size(),
+                    numIndices, submesh.indices.data())) {
+                Logfile::get()->writeError(std::string() + "Error in readMesh3D: Corrupt indices in file \""
+                        + filename + "\".");
+                mesh.submeshes.clear();
+                return;
+            }
+        }
 
         // Read attributes
         uint32_t numAttributes;
@@ -148,7 +547,36 @@ void readMesh3D(const std::string &filename, BinaryMesh &mesh) {
             stream.read(format);
             attribute.attributeFormat = (sgl::VertexAttributeFormat)format;
             stream.read(attribute.numComponents);
-            stream.readArray(attribute.data);
+            if (version >= MESH_FORMAT_VERSION) {
+                uint32_t encoding;
+                stream.read(encoding);
+                attribute.encoding = (BinaryMeshEncoding)encoding;
+            }
+            if (attribute.encoding == BINARY_MESH_ENCODING_NONE) {
+                stream.readArray(attribute.data);
+            } else {
+                uint32_t numBytes;
+                stream.read(numBytes);
+                stream.readArray(encodedData);
+                const size_t elementSize = getMeshEncodingElementSize(attribute.encoding);
+                attribute.data.resize(numBytes);
+                if (elementSize == 0 || numBytes % elementSize != 0
+                        || !decodeMeshArray(attribute.encoding, encodedData.data(), encodedData.size(),
+                                numBytes / elementSize, attribute.data.data())) {
+                    Logfile::get()->writeError(std::string() + "Error in readMesh3D: Corrupt attribute \""
+                            + attribute.name + "\" in file \"" + filename + "\".");
+                    mesh.submeshes.clear();
+                    return;
+                }
+            }
+
+            if (version != MESH_FORMAT_VERSION_NO_ATTRIBUTE_RANGE) {
+                stream.read(attribute.minValue);
+                stream.read(attribute.maxValue);
+            } else if (isUnorm16ScalarAttribute(attribute)) {
+                computeUnorm16ArrayRange((const uint16_t*)attribute.data.data(),
+                        attribute.data.size() / sizeof(uint16_t), attribute.minValue, attribute.maxValue);
+            }
         }
 
         // Read uniforms
@@ -174,6 +602,197 @@ void readMesh3D(const std::string &filename, BinaryMesh &mesh) {
 
 
 
+void setSubmeshChunks(BinarySubMesh &submesh, const std::vector<BinaryMeshChunk> &chunks)
+{
+    BinaryMeshUniform rangesUniform;
+    rangesUniform.name = "chunkElementRanges";
+    rangesUniform.attributeFormat = ATTRIB_UNSIGNED_INT;
+    rangesUniform.numComponents = 2;
+    rangesUniform.data.resize(chunks.size() * 2 * sizeof(uint32_t));
+    uint32_t *ranges = (uint32_t*)rangesUniform.data.data();
+
+    BinaryMeshUniform boundingBoxesUniform;
+    boundingBoxesUniform.name = "chunkBoundingBoxes";
+    boundingBoxesUniform.attributeFormat = ATTRIB_FLOAT;
+    boundingBoxesUniform.numComponents = 3;
+    boundingBoxesUniform.data.resize(chunks.size() * 2 * sizeof(glm::vec3));
+    glm::vec3 *boundingBoxes = (glm::vec3*)boundingBoxesUniform.data.data();
+
+    for (size_t i = 0; i < chunks.size(); i++) {
+        ranges[i*2] = chunks.at(i).firstElement;
+        ranges[i*2+1] = chunks.at(i).numElements;
+        boundingBoxes[i*2] = chunks.at(i).boundingBox.getMinimum();
+        boundingBoxes[i*2+1] = chunks.at(i).boundingBox.getMaximum();
+    }
+
+    // Replace old chunk data
+    for (auto it = submesh.uniforms.begin(); it != submesh.uniforms.end();) {
+        if (it->name == rangesUniform.name || it->name == boundingBoxesUniform.name) {
+            it = submesh.uniforms.erase(it);
+        } else {
+            it++;
+        }
+    }
+    submesh.uniforms.push_back(rangesUniform);
+    submesh.uniforms.push_back(boundingBoxesUniform);
+}
+
+bool getSubmeshChunks(const BinarySubMesh &submesh, std::vector<BinaryMeshChunk> &chunks)
+{
+    const BinaryMeshUniform *rangesUniform = nullptr;
+    const BinaryMeshUniform *boundingBoxesUniform = nullptr;
+    for (const BinaryMeshUniform &uniform : submesh.uniforms) {
+        if (uniform.name == "chunkElementRanges") {
+            rangesUniform = &uniform;
+        } else if (uniform.name == "chunkBoundingBoxes") {
+            boundingBoxesUniform = &uniform;
+        }
+    }
+    if (rangesUniform == nullptr || boundingBoxesUniform == nullptr) {
+        return false;
+    }
+
+    size_t numChunks = rangesUniform->data.size() / (2 * sizeof(uint32_t));
+    if (boundingBoxesUniform->data.size() != numChunks * 2 * sizeof(glm::vec3)) {
+        Logfile::get()->writeError("Error in getSubmeshChunks: Inconsistent chunk uniforms.");
+        return false;
+    }
+    const uint32_t *ranges = (const uint32_t*)rangesUniform->data.data();
+    const glm::vec3 *boundingBoxes = (const glm::vec3*)boundingBoxesUniform->data.data();
+    chunks.resize(numChunks);
+    for (size_t i = 0; i < numChunks; i++) {
+        chunks.at(i).firstElement = ranges[i*2];
+        chunks.at(i).numElements = ranges[i*2+1];
+        chunks.at(i).boundingBox = sgl::AABB3(boundingBoxes[i*2], boundingBoxes[i*2+1]);
+    }
+    return true;
+}
+
+void sortPrimitivesSpatially(BinarySubMesh &submesh)
+{
+    uint32_t verticesPerPrimitive;
+    if (submesh.vertexMode == VERTEX_MODE_LINES) {
+        verticesPerPrimitive = 2;
+    } else if (submesh.vertexMode == VERTEX_MODE_TRIANGLES) {
+        verticesPerPrimitive = 3;
+    } else {
+        return;
+    }
+
+    const glm::vec3 *positions = nullptr;
+    size_t numVertices = 0;
+    for (const BinaryMeshAttribute &attribute : submesh.attributes) {
+        if (attribute.name == "vertexPosition" && attribute.attributeFormat == ATTRIB_FLOAT
+                && attribute.numComponents == 3) {
+            positions = (const glm::vec3*)attribute.data.data();
+            numVertices = attribute.data.size() / sizeof(glm::vec3);
+        }
+    }
+    if (positions == nullptr || numVertices == 0 || submesh.indices.empty()) {
+        return;
+    }
+
+    AABB3 aabb(glm::vec3(FLT_MAX), glm::vec3(-FLT_MAX));
+    for (size_t i = 0; i < numVertices; i++) {
+        aabb.combine(positions[i]);
+    }
+    const glm::vec3 extent = glm::max(aabb.getExtent() * 2.0f, glm::vec3(1e-6f));
+
+    // Sort the primitives by the Morton code of their centroid.
+    const size_t numPrimitives = submesh.indices.size() / verticesPerPrimitive;
+    const float primitiveWeight = 1.0f / float(verticesPerPrimitive);
+    std::vector<std::pair<uint64_t, uint32_t>> primitiveKeys(numPrimitives);
+    #pragma omp parallel for
+    for (size_t i = 0; i < numPrimitives; i++) {
+        glm::vec3 centroid(0.0f);
+        for (uint32_t j = 0; j < verticesPerPrimitive; j++) {
+            centroid += positions[submesh.indices[i * verticesPerPrimitive + j]];
+        }
+        centroid *= primitiveWeight;
+        primitiveKeys[i] = std::make_pair(computeMortonCode3D((centroid - aabb.min) / extent), uint32_t(i));
+    }
+    std::sort(primitiveKeys.begin(), primitiveKeys.end());
+
+    std::vector<uint32_t> sortedIndices(numPrimitives * verticesPerPrimitive);
+    #pragma omp parallel for
+    for (size_t i = 0; i < numPrimitives; i++) {
+        const size_t oldPrimitive = primitiveKeys[i].second;
+        for (uint32_t j = 0; j < verticesPerPrimitive; j++) {
+            sortedIndices[i * verticesPerPrimitive + j] = submesh.indices[oldPrimitive * verticesPerPrimitive + j];
+        }
+    }
+    submesh.indices.swap(sortedIndices);
+}
+
+bool computeSubmeshChunks(
+        const BinarySubMesh &submesh, uint32_t maxPrimitivesPerChunk, std::vector<BinaryMeshChunk> &chunks)
+{
+    chunks.clear();
+    uint32_t verticesPerPrimitive;
+    if (submesh.vertexMode == VERTEX_MODE_POINTS) {
+        verticesPerPrimitive = 1;
+    } else if (submesh.vertexMode == VERTEX_MODE_LINES) {
+        verticesPerPrimitive = 2;
+    } else if (submesh.vertexMode == VERTEX_MODE_TRIANGLES) {
+        verticesPerPrimitive = 3;
+    } else {
+        // Strips and fans can't be split at arbitrary elements.
+        return false;
+    }
+
+    const glm::vec3 *positions = nullptr;
+    size_t numVertices = 0;
+    for (const BinaryMeshAttribute &attribute : submesh.attributes) {
+        if (attribute.name == "vertexPosition" && attribute.attributeFormat == ATTRIB_FLOAT
+                && attribute.numComponents == 3) {
+            positions = (const glm::vec3*)attribute.data.data();
+            numVertices = attribute.data.size() / sizeof(glm::vec3);
+        }
+    }
+    if (positions == nullptr) {
+        return false;
+    }
+
+    const bool hasIndices = !submesh.indices.empty();
+    const size_t numElements = hasIndices ? submesh.indices.size() : numVertices;
+    const size_t elementsPerChunk = size_t(maxPrimitivesPerChunk) * verticesPerPrimitive;
+    const size_t numChunks = (numElements + elementsPerChunk - 1) / elementsPerChunk;
+    chunks.resize(numChunks);
+
+    #pragma omp parallel for
+    for (size_t chunkIdx = 0; chunkIdx < numChunks; chunkIdx++) {
+        BinaryMeshChunk &chunk = chunks.at(chunkIdx);
+        const size_t firstElement = chunkIdx * elementsPerChunk;
+        const size_t lastElement = std::min(firstElement + elementsPerChunk, numElements);
+        chunk.firstElement = uint32_t(firstElement);
+        chunk.numElements = uint32_t(lastElement - firstElement);
+        glm::vec3 minPosition(FLT_MAX), maxPosition(-FLT_MAX);
+        for (size_t i = firstElement; i < lastElement; i++) {
+            const glm::vec3 &position = positions[hasIndices ? submesh.indices[i] : i];
+            minPosition = glm::min(minPosition, position);
+            maxPosition = glm::max(maxPosition, position);
+        }
+        chunk.boundingBox = AABB3(minPosition, maxPosition);
+    }
+    return true;
+}
+
+
+const std::vector<float> &ImportanceCriterionAttribute::getAttributes()
+{
+    if (attributes.size() != attributesUnorm.size()) {
+        unpackUnorm16Array(attributesUnorm.data(), attributesUnorm.size(), attributes);
+    }
+    return attributes;
+}
+
+void ImportanceCriterionAttribute::releaseAttributes()
+{
+    attributes.clear();
+    attributes.shrink_to_fit();
+}
+
+
 void MeshRenderer::render(sgl::ShaderProgramPtr passShader, bool isGBufferPass, int attributeIndex)
 {
     if (useProgrammableFetch) {
@@ -206,7 +825,52 @@ void MeshRenderer::render(sgl::ShaderProgramPtr passShader, bool isGBufferPass,
                 passShader->setUniform("opacity", materials.at(i).opacity);
             }
         }
-        Renderer->render(shaderAttributes.at(i), passShader);
+
+        if (i < drawnIndexCounts.size() && drawnIndexCounts.at(i) >= 0) {
+            // Only a prefix of the index buffer is used (e.g., the point selection of the level of detail hierarchy).
+            if (drawnIndexCounts.at(i) > 0) {
+                ShaderAttributesPtr &renderData = shaderAttributes.at(i);
+                GLenum primitiveMode = renderData->getVertexMode() == VERTEX_MODE_POINTS ? GL_POINTS
+                        : renderData->getVertexMode() == VERTEX_MODE_LINES ? GL_LINES : GL_TRIANGLES;
+                renderData->bind(passShader);
+                glDrawElements(primitiveMode, GLsizei(drawnIndexCounts.at(i)), GL_UNSIGNED_INT, NULL);
+            }
+            continue;
+        }
+
+        const std::vector<BinaryMeshChunk> &chunks = chunkDrawRanges.at(i);
+        if (chunks.empty()) {
+            Renderer->render(shaderAttributes.at(i), passShader);
+            continue;
+        }
+
+        // Draw the index ranges of all visible chunks with one call. Consecutive visible chunks are merged.
+        multiDrawCounts.clear();
+        multiDrawOffsets.clear();
+        const uint32_t chunkOffset = submeshChunkOffsets.at(i);
+        uint32_t lastElementEnd = 0;
+        for (size_t j = 0; j < chunks.size(); j++) {
+            if (isChunkCullingActive && !chunkVisibility.at(chunkOffset + j)) {
+                continue;
+            }
+            const BinaryMeshChunk &chunk = chunks.at(j);
+            if (!multiDrawCounts.empty() && chunk.firstElement == lastElementEnd) {
+                multiDrawCounts.back() += int32_t(chunk.numElements);
+            } else {
+                multiDrawCounts.push_back(int32_t(chunk.numElements));
+                multiDrawOffsets.push_back((const void*)(sizeof(uint32_t) * size_t(chunk.firstElement)));
+            }
+            lastElementEnd = chunk.firstElement + chunk.numElements;
+        }
+        if (multiDrawCounts.empty()) {
+            continue;
+        }
+        ShaderAttributesPtr &renderData = shaderAttributes.at(i);
+        GLenum primitiveMode = renderData->getVertexMode() == VERTEX_MODE_LINES ? GL_LINES : GL_TRIANGLES;
+        renderData->bind(passShader);
+        glMultiDrawElements(
+                primitiveMode, (const GLsizei*)multiDrawCounts.data(), GL_UNSIGNED_INT, multiDrawOffsets.data(),
+                GLsizei(multiDrawCounts.size()));
     }
 }
 
@@ -217,6 +881,17 @@ void MeshRenderer::setNewShader(sgl::ShaderProgramPtr newShader)
     }
 }
 
+size_t MeshRenderer::cullChunks(const glm::mat4 &mvpMatrix)
+{
+    isChunkCullingActive = true;
+    return chunkBVH.cullChunks(mvpMatrix, chunkVisibility);
+}
+
+void MeshRenderer::resetChunkCulling()
+{
+    isChunkCullingActive = false;
+}
+
 
 sgl::AABB3 computeAABB(const std::vector<glm::vec3> &vertices)
 {
@@ -333,7 +1008,7 @@ struct LinePointData
 };
 
 MeshRenderer parseMesh3D(const std::string &filename, sgl::ShaderProgramPtr shader, bool shuffleData,
-        bool useProgrammableFetch, bool programmableFetchUseAoS, float lineRadius)
+        bool useProgrammableFetch, bool programmableFetchUseAoS, float lineRadius, bool sortPrimitivesForCulling)
 {
     MeshRenderer meshRenderer(useProgrammableFetch);
     BinaryMesh mesh;
@@ -354,11 +1029,33 @@ MeshRenderer parseMesh3D(const std::string &filename, sgl::ShaderProgramPtr shad
     // Importance criterion attributes are bound to location 3 and onwards in vertex shader
     //int importanceCriterionLocationCounter = 3;
 
+    // Bounding boxes of the chunks of all submeshes
+    std::vector<AABB3> chunkBoundingBoxes;
+
 
     // Iterate over all submeshes and create rendering data
     for (size_t i = 0; i < mesh.submeshes.size(); i++) {
         BinarySubMesh &submesh = mesh.submeshes.at(i);
         ShaderAttributesPtr renderData = ShaderManager->createShaderAttributes(shader);
+
+        // Chunks for view dependent queries and culling (stored in the file or computed on the fly). Indexed line
+        // and triangle meshes are drawn per chunk. Sorting their primitives spatially first is opt-in, as it changes
+        // the primitive order (and with it the result of order dependent techniques).
+        std::vector<BinaryMeshChunk> chunks;
+        bool hasChunks = getSubmeshChunks(submesh, chunks);
+        const bool drawChunks = !useProgrammableFetch && !shuffleData && submesh.indices.size() > 0
+                && (submesh.vertexMode == VERTEX_MODE_LINES || submesh.vertexMode == VERTEX_MODE_TRIANGLES);
+        if (!hasChunks && drawChunks && sortPrimitivesForCulling) {
+            sortPrimitivesSpatially(submesh);
+        }
+        if (!hasChunks) {
+            hasChunks = computeSubmeshChunks(submesh, DEFAULT_PRIMITIVES_PER_CHUNK, chunks);
+        }
+        meshRenderer.submeshChunkOffsets.push_back(uint32_t(chunkBoundingBoxes.size()));
+        for (const BinaryMeshChunk &chunk : chunks) {
+            chunkBoundingBoxes.push_back(chunk.boundingBox);
+        }
+
         if (!useProgrammableFetch) {
             renderData->setVertexMode(submesh.vertexMode);
         } else {
@@ -416,49 +1113,42 @@ MeshRenderer parseMesh3D(const std::string &filename, sgl::ShaderProgramPtr shad
             BinaryMeshAttribute &meshAttribute = submesh.attributes.at(j);
             GeometryBufferPtr attributeBuffer;
 
-            // Assume only one component means importance criterion like vorticity, line width, ...
-            if (meshAttribute.numComponents == 1) {
+            // Assume one unorm16 component means importance criterion like vorticity, line width, ...
+            // The unorm16 data is uploaded as-is; the value range is stored in the file.
+            if (isUnorm16ScalarAttribute(meshAttribute)) {
                 ImportanceCriterionAttribute importanceCriterionAttribute;
                 importanceCriterionAttribute.name = meshAttribute.name;
+                importanceCriterionAttribute.minAttribute = meshAttribute.minValue;
+                importanceCriterionAttribute.maxAttribute = meshAttribute.maxValue;
 
-                // Copy values to mesh renderer data structure
-                uint16_t *attributeValuesUnorm = (uint16_t*)&meshAttribute.data.front();
                 size_t numAttributeValues = meshAttribute.data.size() / sizeof(uint16_t);
-                unpackUnorm16Array(attributeValuesUnorm, numAttributeValues, importanceCriterionAttribute.attributes);
-
-                // Compute minimum and maximum value
-                float minValue = FLT_MAX, maxValue = 0.0f;
-                #pragma omp parallel for reduction(min:minValue) reduction(max:maxValue)
-                for (size_t k = 0; k < numAttributeValues; k++) {
-                    minValue = std::min(minValue, importanceCriterionAttribute.attributes[k]);
-                    maxValue = std::max(maxValue, importanceCriterionAttribute.attributes[k]);
-                }
-                importanceCriterionAttribute.minAttribute = minValue;
-                importanceCriterionAttribute.maxAttribute = maxValue;
-
-                meshRenderer.importanceCriterionAttributes.push_back(importanceCriterionAttribute);
+                importanceCriterionAttribute.attributesUnorm.resize(numAttributeValues);
+                memcpy(importanceCriterionAttribute.attributesUnorm.data(), meshAttribute.data.data(),
+                        meshAttribute.data.size());
 
                 // SSBOs can't directly perform process uint16_t -> float :(
                 if (useProgrammableFetch && !programmableFetchUseAoS) {
+                    const std::vector<float> &attributeValues = importanceCriterionAttribute.getAttributes();
                     attributeBuffer = Renderer->createGeometryBuffer(
-                            numAttributeValues*sizeof(float), (void*)&importanceCriterionAttribute.attributes.front(),
+                            numAttributeValues*sizeof(float), (void*)&attributeValues.front(),
                             SHADER_STORAGE_BUFFER);
+                    importanceCriterionAttribute.releaseAttributes();
                 } else if (useProgrammableFetch) {
                     int attributeIndex = sgl::fromString<int>(meshAttribute.name.substr(15));
                     if (attributeIndex >= vertexAttributeData.size()) {
                         vertexAttributeData.resize(attributeIndex+1);
                     }
-                    vertexAttributeData.at(attributeIndex).resize(numAttributeValues);
-                    for (size_t k = 0; k < numAttributeValues; k++) {
-                        vertexAttributeData.at(attributeIndex).at(k) = importanceCriterionAttribute.attributes[k];
-                    }
+                    unpackUnorm16Array(importanceCriterionAttribute.attributesUnorm.data(), numAttributeValues,
+                            vertexAttributeData.at(attributeIndex));
                 }
+
+                meshRenderer.importanceCriterionAttributes.push_back(importanceCriterionAttribute);
             }
 
             BufferType bufferType = useProgrammableFetch ? SHADER_STORAGE_BUFFER : VERTEX_BUFFER;
 
             if (!(useProgrammableFetch && programmableFetchUseAoS)
-                && !(meshAttribute.numComponents == 1 && useProgrammableFetch)
+                && !(isUnorm16ScalarAttribute(meshAttribute) && useProgrammableFetch)
                 && !(meshAttribute.numComponents == 3 && useProgrammableFetch)) {
                 attributeBuffer = Renderer->createGeometryBuffer(
                         meshAttribute.data.size(), (void*)&meshAttribute.data.front(), bufferType);
@@ -478,7 +1168,7 @@ MeshRenderer parseMesh3D(const std::string &filename, sgl::ShaderProgramPtr shad
             }
 
             if (!useProgrammableFetch) {
-                if (meshAttribute.numComponents == 1) {
+                if (isUnorm16ScalarAttribute(meshAttribute)) {
                     // Importance criterion attributes are bound to location 3 and onwards in vertex shader
                     renderData->addGeometryBufferOptional(
                             attributeBuffer, meshAttribute.name.c_str(), meshAttribute.attributeFormat,
@@ -549,10 +1239,20 @@ MeshRenderer parseMesh3D(const std::string &filename, sgl::ShaderProgramPtr shad
             }
         }
 
+        // The chunks are index ranges in the index buffer of the submesh (drawn with glMultiDrawElements).
+        if (drawChunks && hasChunks) {
+            meshRenderer.chunkDrawRanges.push_back(chunks);
+        } else {
+            meshRenderer.chunkDrawRanges.push_back(std::vector<BinaryMeshChunk>());
+        }
+
         shaderAttributes.push_back(renderData);
         materials.push_back(mesh.submeshes.at(i).material);
+        meshRenderer.submeshUniforms.push_back(std::move(submesh.uniforms));
     }
 
+    meshRenderer.submeshChunkOffsets.push_back(uint32_t(chunkBoundingBoxes.size()));
+    meshRenderer.chunkBVH.build(chunkBoundingBoxes);
     meshRenderer.boundingBox = totalBoundingBox;
     meshRenderer.boundingSphere = sgl::Sphere(totalBoundingBox.getCenter(), glm::length(totalBoundingBox.getExtent()));
 
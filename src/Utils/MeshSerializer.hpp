@@ -11,11 +11,15 @@
 #include <glm/glm.hpp>
 #include <vector>
 #include <set>
+#include <cstdio>
 
 #include <Math/Geometry/AABB3.hpp>
 #include <Math/Geometry/Sphere.hpp>
 #include <Graphics/Shader/ShaderAttributes.hpp>
 
+#include "ChunkBVH.hpp"
+#include "MeshCompression.hpp"
+
 /**
  * Parsing text-based mesh files, like .obj files, is really slow compared to binary formats.
  * The utility functions below serialize 3D mesh data to a file/read the data back from such a file.
@@ -66,6 +70,12 @@ struct ObjMesh
  *  - Die number of components, e.g. 3 for a vector containing three elements or 1 for a scalar value.
  *  - The actual attribute data as an array of bytes. It is expected that the number of vertices is the same for each attribute.
  *    The number of vertices can be explicitly computed by "data.size() / numComponents / dataFormatNumBytes".
+ *  - (Since format version 5) The minimum and maximum normalized value of scalar unorm16 attributes (importance
+ *    criteria), such that the data can be uploaded to the GPU without unpacking it on the CPU first.
+ *
+ * (Since format version 6) The indices and each vertex attribute are preceded by their encoding (BinaryMeshEncoding).
+ * Encoded arrays store the decoded number of elements (indices) or bytes (attributes) followed by the encoded bytes.
+ * Arrays are decoded when the mesh is read, i.e., the data in BinarySubMesh/BinaryMeshAttribute is always decoded.
  *
  * A uniform attribute is an attribute constant over all vertices.
  */
@@ -76,6 +86,11 @@ struct BinaryMeshAttribute
     sgl::VertexAttributeFormat attributeFormat;
     uint32_t numComponents;
     std::vector<uint8_t> data;
+    // Range of the normalized values for 1-component unorm16 attributes (computed by writeMesh3D).
+    float minValue = 0.0f;
+    float maxValue = 1.0f;
+    // Encoding of the data in the file (the data in memory is always decoded).
+    BinaryMeshEncoding encoding = BINARY_MESH_ENCODING_NONE;
 };
 
 struct BinaryMeshUniform
@@ -93,6 +108,7 @@ struct BinarySubMesh
     std::vector<uint32_t> indices;
     std::vector<BinaryMeshAttribute> attributes;
     std::vector<BinaryMeshUniform> uniforms;
+    BinaryMeshEncoding indexEncoding = BINARY_MESH_ENCODING_NONE; // Encoding of the indices in the file
 };
 
 struct BinaryMesh
@@ -100,11 +116,140 @@ struct BinaryMesh
     std::vector<BinarySubMesh> submeshes;
 };
 
+/**
+ * A spatially coherent range of elements of a submesh (vertices for meshes without indices, indices otherwise)
+ * together with its bounding box. Chunks are stored in the uniforms "chunkElementRanges" (uvec2: first element,
+ * number of elements) and "chunkBoundingBoxes" (two vec3 per chunk: minimum, maximum) and allow for culling parts
+ * of a submesh on the CPU.
+ */
+struct BinaryMeshChunk
+{
+    uint32_t firstElement;
+    uint32_t numElements;
+    sgl::AABB3 boundingBox;
+};
+
+/// Stores the passed chunks in the uniforms of the submesh (see BinaryMeshChunk).
+void setSubmeshChunks(BinarySubMesh &submesh, const std::vector<BinaryMeshChunk> &chunks);
+
+/// Returns false if the submesh has no chunk uniforms.
+bool getSubmeshChunks(const BinarySubMesh &submesh, std::vector<BinaryMeshChunk> &chunks);
+
+/// Reorders the primitives of an indexed line or triangle submesh along a Morton curve (of their centroids).
+void sortPrimitivesSpatially(BinarySubMesh &submesh);
+
+/**
+ * Splits the elements of a submesh in their current order into chunks of at most maxPrimitivesPerChunk points, lines
+ * or triangles and computes their bounding boxes. Returns false for other vertex modes or if the submesh has no
+ * vertex positions.
+ */
+bool computeSubmeshChunks(
+        const BinarySubMesh &submesh, uint32_t maxPrimitivesPerChunk, std::vector<BinaryMeshChunk> &chunks);
+const uint32_t DEFAULT_PRIMITIVES_PER_CHUNK = 4096;
+
 /**
  * Writes a mesh to a binary file. The mesh data vectors may also be empty (i.e. size 0).
  * @param indices, vertices, texcoords, normals: The mesh data.
+ * @return False if the file couldn't be written.
  */
-void writeMesh3D(const std::string &filename, const BinaryMesh &mesh);
+bool writeMesh3D(const std::string &filename, const BinaryMesh &mesh);
+
+/**
+ * Writes a binmesh file incrementally, such that converters don't need to hold the whole mesh in memory.
+ * The sizes of the indices and of all attributes of a submesh are passed up front (e.g., computed by a counting pass
+ * of the converter). Thus, the headers are written with their final values and the data of each array is written
+ * directly to its final position in the file. The indices and the attribute data can be appended in chunks and in any
+ * order. Only the attribute value ranges are patched in once an array is finished.
+ * Encoded arrays are encoded in blocks of MESH_ENCODING_BLOCK_SIZE elements (at most one incomplete block per array is
+ * held in memory). The size of delta varint encoded indices depends on the data, thus the attribute data can only be
+ * appended after the indices were finished in this case.
+ *
+ * Usage: open, { beginSubmesh, addAttribute/addUniform*, { appendIndices | appendAttributeData }*, endSubmesh }*, close
+ */
+class BinaryMeshStreamWriter
+{
+public:
+    BinaryMeshStreamWriter() {}
+    ~BinaryMeshStreamWriter();
+    BinaryMeshStreamWriter(const BinaryMeshStreamWriter&) = delete;
+    BinaryMeshStreamWriter &operator=(const BinaryMeshStreamWriter&) = delete;
+
+    bool open(const std::string &filename);
+    /// Returns false if writing the file failed. In this case, the incomplete file is removed.
+    bool close();
+
+    void beginSubmesh(const ObjMaterial &material, sgl::VertexMode vertexMode, size_t numIndices);
+    /**
+     * Adds a vertex attribute of numBytes bytes to the current submesh and returns its index. Must be called before
+     * appending data. Quantized positions and octahedral normals are supported for float vec3 attributes only. If an
+     * encoding isn't supported for the attribute, the data is stored unencoded.
+     */
+    size_t addAttribute(
+            const std::string &name, sgl::VertexAttributeFormat attributeFormat, uint32_t numComponents,
+            size_t numBytes, BinaryMeshEncoding encoding = BINARY_MESH_ENCODING_NONE);
+    /// Only BINARY_MESH_ENCODING_DELTA_VARINT is supported for indices. Must be called before appending data.
+    void setIndexEncoding(BinaryMeshEncoding encoding);
+    void addUniform(const BinaryMeshUniform &uniform);
+    void addUniforms(const std::vector<BinaryMeshUniform> &uniforms);
+    void appendIndices(const uint32_t *indices, size_t numIndices);
+    /// numBytes must be a multiple of the size of one attribute value (of one vertex for encoded attributes).
+    void appendAttributeData(size_t attributeIndex, const void *data, size_t numBytes);
+    /// No more data is appended to the indices/the attribute of the current submesh.
+    void finishIndices();
+    void finishAttribute(size_t attributeIndex);
+    void endSubmesh();
+
+    /// Writes a submesh that is stored in memory (as done by writeMesh3D).
+    void writeSubmesh(const BinarySubMesh &submesh);
+
+private:
+    /// The indices (index 0) or a vertex attribute (index i + 1) of the current submesh.
+    struct ArrayState {
+        std::string name;
+        sgl::VertexAttributeFormat attributeFormat;
+        uint32_t numComponents = 1;
+        BinaryMeshEncoding encoding = BINARY_MESH_ENCODING_NONE;
+        uint64_t numBytes = 0; ///< Size of the decoded data (passed up front).
+        uint64_t numFileBytes = 0; ///< Size of the data in the file (only known up front if hasKnownFileSize).
+        bool hasKnownFileSize = true;
+        uint64_t dataFileOffset = 0; ///< Position of the data in the output file (valid once the header is written).
+        bool isHeaderWritten = false;
+        uint64_t numAppendedBytes = 0;
+        uint64_t numWrittenBytes = 0;
+        std::vector<uint8_t> incompleteBlock; ///< Appended elements of an encoded array not yet forming a full block.
+        bool isFinished = false;
+        bool isUnorm16Scalar = false;
+        uint16_t minUnorm = 0xFFFFu, maxUnorm = 0u;
+    };
+    void write(const void *data, size_t numBytes);
+    void writeUint32(uint32_t value);
+    void writeString(const std::string &str);
+    void seek(uint64_t fileOffset);
+    void beginSubmeshData();
+    /// Writes the headers of all arrays whose position in the file is known.
+    void writeArrayHeaders();
+    void appendArrayData(size_t arrayIndex, const void *data, size_t numBytes);
+    void writeArrayData(ArrayState &array, const void *data, size_t numBytes);
+    void encodeArrayData(ArrayState &array, const void *data, size_t numElements);
+    void finishArray(size_t arrayIndex);
+    /// Position behind the array and its trailer (the number of attributes or the attribute value range).
+    uint64_t getArrayEndFileOffset(size_t arrayIndex);
+
+    FILE *file = nullptr;
+    std::string filename;
+    bool writeFailed = false;
+    uint32_t numSubmeshes = 0;
+    uint64_t filePosition = 0;
+    uint64_t submeshFileOffset = 0;
+    bool isSubmeshOpen = false;
+    bool hasSubmeshDataBegun = false;
+    ObjMaterial material;
+    sgl::VertexMode vertexMode;
+    std::vector<ArrayState> arrays;
+    std::vector<BinaryMeshUniform> uniforms;
+    size_t numArrayHeadersWritten = 0;
+    std::vector<uint8_t> encodedData;
+};
 
 /**
  * Reads a mesh from a binary file. The mesh data vectors may also be empty (i.e. size 0).
@@ -112,11 +257,23 @@ void writeMesh3D(const std::string &filename, const BinaryMesh &mesh);
  */
 void readMesh3D(const std::string &filename, BinaryMesh &mesh);
 
+/**
+ * Scalar attribute of a mesh (e.g. vorticity) stored as unorm16 data. The data is only unpacked to floating point
+ * values if getAttributes is called (e.g. for computing the histogram of the transfer function window).
+ */
 struct ImportanceCriterionAttribute {
     std::string name;
-    std::vector<float> attributes;
+    std::vector<uint16_t> attributesUnorm;
     float minAttribute;
     float maxAttribute;
+
+    /// Returns the unpacked attribute values in [0, 1]. They are computed on first use.
+    const std::vector<float> &getAttributes();
+    /// Releases the unpacked attribute values.
+    void releaseAttributes();
+
+private:
+    std::vector<float> attributes;
 };
 
 // For programmable vertex fetching/pulling
@@ -137,7 +294,27 @@ public:
     // attributeIndex: For programmable vertex fetching/pulling. We need to bind the correct line attribute SSBO!
     void render(sgl::ShaderProgramPtr passShader, bool isGBufferPass, int attributeIndex);
     void setNewShader(sgl::ShaderProgramPtr newShader);
+    /// Only the chunks intersecting the view frustum are drawn in the following calls to render.
+    /// Returns the number of visible chunks.
+    size_t cullChunks(const glm::mat4 &mvpMatrix);
+    /// All chunks are drawn in the following calls to render (e.g., for shadow map passes).
+    void resetChunkCulling();
+    /// Only the first numIndices indices of the index buffer of the submesh are drawn (-1: all indices).
+    void setDrawnIndexCount(size_t submeshIndex, int numIndices) {
+        if (drawnIndexCounts.size() <= submeshIndex) {
+            drawnIndexCounts.resize(submeshIndex + 1, -1);
+        }
+        drawnIndexCounts.at(submeshIndex) = numIndices;
+    }
     bool isLoaded() { return shaderAttributes.size() > 0; }
+    bool isDrawnInChunks() {
+        for (const std::vector<BinaryMeshChunk> &chunks : chunkDrawRanges) {
+            if (!chunks.empty()) {
+                return true;
+            }
+        }
+        return false;
+    }
     bool hasAttributeWithName(const std::string &name) {
         return shaderAttributeNames.find(name) != shaderAttributeNames.end();
     }
@@ -150,15 +327,31 @@ public:
     sgl::AABB3 boundingBox;
     sgl::Sphere boundingSphere;
     std::vector<ImportanceCriterionAttribute> importanceCriterionAttributes;
+    std::vector<std::vector<BinaryMeshUniform>> submeshUniforms; // Additional data per submesh (e.g., chunks)
+    ChunkBVH chunkBVH; // Hierarchy over the chunks of all submeshes
+    std::vector<uint32_t> submeshChunkOffsets; // Index of the first chunk of each submesh in chunkBVH
+    std::vector<std::vector<BinaryMeshChunk>> chunkDrawRanges; // Per submesh, empty if drawn in one piece
+    std::vector<uint8_t> chunkVisibility;
+    bool isChunkCullingActive = false;
+    std::vector<int> drawnIndexCounts; // Per submesh, -1 or missing if all indices are drawn
+
+private:
+    // Index ranges of the visible chunks passed to glMultiDrawElements (reused between frames)
+    std::vector<int32_t> multiDrawCounts;
+    std::vector<const void*> multiDrawOffsets;
 };
 
 
 /**
  * Uses readMesh3D to read the mesh data from a file and assigns the data to a ShaderAttributesPtr object.
  * @param shader: The shader to use for the mesh.
+ * @param sortPrimitivesForCulling: Whether to reorder the primitives of submeshes without stored chunks spatially
+ * (see sortPrimitivesSpatially) before computing their chunks. This makes the chunks more compact for frustum culling,
+ * but changes the primitive order seen by the OIT algorithms.
  * @return: The loaded mesh stored in a ShaderAttributes object.
  */
 MeshRenderer parseMesh3D(const std::string &filename, sgl::ShaderProgramPtr shader, bool shuffleData = false,
-        bool useProgrammableFetch = false, bool programmableFetchUseAoS = true, float lineRadius = 0.001f);
+        bool useProgrammableFetch = false, bool programmableFetchUseAoS = true, float lineRadius = 0.001f,
+        bool sortPrimitivesForCulling = false);
 
 #endif /* UTILS_MESHSERIALIZER_HPP_ */
@@ -0,0 +1,35 @@
+//
+// Created by christoph on 19.10.26.
+//
+
+#ifndef PIXELSYNCOIT_MORTONCODE_HPP
+#define PIXELSYNCOIT_MORTONCODE_HPP
+
+#include <cstdint>
+#include <glm/glm.hpp>
+
+/// Inserts two zero bits between each of the lower 21 bits of x.
+inline uint64_t expandBitsMorton3D(uint64_t x)
+{
+    x &= 0x1FFFFFull;
+    x = (x | (x << 32u)) & 0x1F00000000FFFFull;
+    x = (x | (x << 16u)) & 0x1F0000FF0000FFull;
+    x = (x | (x << 8u)) & 0x100F00F00F00F00Full;
+    x = (x | (x << 4u)) & 0x10C30C30C30C30C3ull;
+    x = (x | (x << 2u)) & 0x1249249249249249ull;
+    return x;
+}
+
+/**
+ * Computes the 63-bit Morton code (Z-order curve index) of a position with 21 bits per axis.
+ * @param normalizedPosition The position mapped to [0, 1]^3 (values outside are clamped).
+ */
+inline uint64_t computeMortonCode3D(const glm::vec3 &normalizedPosition)
+{
+    const float scale = float((1u << 21u) - 1u);
+    glm::vec3 p = glm::clamp(normalizedPosition, glm::vec3(0.0f), glm::vec3(1.0f)) * scale;
+    return (expandBitsMorton3D(uint64_t(p.x)) << 2u) | (expandBitsMorton3D(uint64_t(p.y)) << 1u)
+            | expandBitsMorton3D(uint64_t(p.z));
+}
+
+#endif //PIXELSYNCOIT_MORTONCODE_HPP
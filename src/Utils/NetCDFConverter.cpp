@@ -8,6 +8,10 @@
 #include <fstream>
 #include <iomanip>
 #include <cassert>
+#include <cfloat>
+#include <cmath>
+#include <cstdint>
+#include <algorithm>
 
 #include <glm/glm.hpp>
 #include <netcdf.h>
@@ -211,55 +215,73 @@ void loadFloatArray3D(int ncid, const char *varname, size_t zstart, size_t ystar
 
 
 
-Trajectories convertLatLonToCartesian(float *lat, float *lon, float *pressure, size_t trajectoryDim,
-        size_t timeDim) {
-    Trajectories trajectories;
-    trajectories.reserve(timeDim);
-
-    float minPressure = FLT_MAX;
-    float maxPressure = -FLT_MAX;
-    //float minPressure = 1200.0f;
-    //float maxPressure = 0.0001f;
-	#pragma omp parallel for reduction(min:minPressure) reduction(max:maxPressure)
-	for (size_t idx = 0; idx < trajectoryDim*timeDim; idx++) {
-	    if (pressure[idx] > 0.0f) {
-            minPressure = std::min(minPressure, pressure[idx]);
-	    }
-		maxPressure = std::max(maxPressure, pressure[idx]);
-	}
-	float logMinPressure = log(minPressure);
-	float logMaxPressure = log(maxPressure);
-
-    for (int trajectoryIndex = 0; trajectoryIndex < trajectoryDim; trajectoryIndex++) {
-        Trajectory trajectory;
-        trajectory.attributes.resize(1);
-        std::vector<glm::vec3> &cartesianCoords = trajectory.positions;
-        std::vector<float> &pressureAttr = trajectory.attributes.at(0);
-        cartesianCoords.reserve(trajectoryDim);
-        pressureAttr.reserve(trajectoryDim);
-        for (int i = 0; i < timeDim; i++) {
-            int index = i + trajectoryIndex*timeDim;
-            float pressureAtIdx = pressure[index];
-            if (pressureAtIdx <= 0.0f) {
-                continue;
-            }
-            //float normalizedPressure = (pressureAtIdx - minPressure) / (maxPressure - minPressure);
-            float normalizedLogPressure = (log(pressureAtIdx) - logMaxPressure) / (logMinPressure - logMaxPressure);
-            float x = lat[index]/100.0f;
-            float y = normalizedLogPressure;
-            float z = lon[index]/100.0f;
-
-            glm::vec3 cartesianCoord = glm::vec3(x, y, z);
+/**
+ * Reads a block of a 3D floating point variable (hyperslab) into a preallocated array.
+ * @param ncid The NetCDF file ID.
+ * @param varid The variable ID queried by nc_inq_varid.
+ * @param zstart Start index in the first dimension.
+ * @param ystart Start index in the second dimension.
+ * @param xstart Start index in the third dimension.
+ * @param zlen Number of values to read in the first dimension.
+ * @param ylen Number of values to read in the second dimension.
+ * @param xlen Number of values to read in the third dimension.
+ * @param array The array to store zlen * ylen * xlen values in.
+ */
+void readFloatArray3DBlock(int ncid, int varid, size_t zstart, size_t ystart, size_t xstart,
+        size_t zlen, size_t ylen, size_t xlen, float *array)
+{
+    size_t startp[] = {zstart, ystart, xstart};
+    size_t countp[] = {zlen, ylen, xlen};
+    myassert(nc_get_vara_float(ncid, varid, startp, countp, array) == 0);
+}
 
-            cartesianCoords.push_back(cartesianCoord);
-            pressureAttr.push_back(pressureAtIdx);
+/**
+ * Converts a block of trajectories from lat/lon/pressure to Cartesian coordinates (in parallel). Points with a
+ * pressure <= 0 are invalid and skipped.
+ * @param lineIndices For each trajectory in the block the index of its output line or -1 if it is empty.
+ */
+void convertLatLonToCartesianBlock(const float *lat, const float *lon, const float *pressure,
+        size_t blockNumTrajectories, size_t timeDim, const int64_t *lineIndices,
+        float logMinPressure, float logMaxPressure, Trajectories &trajectories)
+{
+    const float logPressureScale = 1.0f / (logMinPressure - logMaxPressure);
+    #pragma omp parallel for schedule(dynamic, 16)
+    for (size_t blockTrajectoryIndex = 0; blockTrajectoryIndex < blockNumTrajectories; blockTrajectoryIndex++) {
+        const int64_t lineIndex = lineIndices[blockTrajectoryIndex];
+        if (lineIndex < 0) {
+            continue;
         }
-
-        if (!trajectory.positions.empty()) {
-            trajectories.push_back(trajectory);
+        const size_t inputOffset = blockTrajectoryIndex * timeDim;
+        const size_t lineNumPoints = trajectories.getLineNumPoints(lineIndex);
+        glm::vec3 *cartesianCoords = trajectories.positions.data() + trajectories.getLineOffset(lineIndex);
+        float *pressureAttr = trajectories.attributes.at(0).data() + trajectories.getLineOffset(lineIndex);
+
+        if (lineNumPoints == timeDim) {
+            // Common case: All points are valid, no compaction necessary.
+            #pragma omp simd
+            for (size_t i = 0; i < timeDim; i++) {
+                const size_t index = inputOffset + i;
+                const float pressureAtIdx = pressure[index];
+                const float normalizedLogPressure = (std::log(pressureAtIdx) - logMaxPressure) * logPressureScale;
+                cartesianCoords[i] = glm::vec3(lat[index] / 100.0f, normalizedLogPressure, lon[index] / 100.0f);
+                pressureAttr[i] = pressureAtIdx;
+            }
+        } else {
+            size_t outputIndex = 0;
+            for (size_t i = 0; i < timeDim; i++) {
+                const size_t index = inputOffset + i;
+                const float pressureAtIdx = pressure[index];
+                if (pressureAtIdx <= 0.0f) {
+                    continue;
+                }
+                const float normalizedLogPressure = (std::log(pressureAtIdx) - logMaxPressure) * logPressureScale;
+                cartesianCoords[outputIndex] = glm::vec3(
+                        lat[index] / 100.0f, normalizedLogPressure, lon[index] / 100.0f);
+                pressureAttr[outputIndex] = pressureAtIdx;
+                outputIndex++;
+            }
         }
     }
-    return trajectories;
 }
 
 /**
@@ -285,16 +307,17 @@ void exportObjFile(Trajectories &trajectories, const std::string &filename)
 
     size_t trajectoryFileIndex = 0;
     for (size_t trajectoryIndex = 0; trajectoryIndex < trajectories.size(); trajectoryIndex++) {
-        Trajectory &trajectory = trajectories.at(trajectoryIndex);
-        size_t trajectorySize = trajectory.positions.size();
+        ArrayView<glm::vec3> positions = trajectories.getLinePositions(trajectoryIndex);
+        ArrayView<float> attributes = trajectories.getLineAttribute(trajectoryIndex, 0);
+        size_t trajectorySize = positions.size();
         if (trajectorySize < 2) {
             continue;
         }
 
         for (size_t i = 0; i < trajectorySize; i++) {
-            glm::vec3 &v = trajectory.positions.at(i);
+            glm::vec3 &v = positions[i];
             outfile << "v " << std::setprecision(5) << v.x << " " << v.y << " " << v.z << "\n";
-            outfile << "vt " << std::setprecision(5) << trajectory.attributes.at(0).at(i) << "\n";
+            outfile << "vt " << std::setprecision(5) << attributes[i] << "\n";
         }
 
         outfile << "g line" << trajectoryFileIndex << "\n";
@@ -326,24 +349,70 @@ Trajectories loadNetCdfFile(const std::string &filename)
     // Load dimension data
     size_t timeDim = getDim(ncid, "time");
     size_t trajectoryDim = getDim(ncid, "trajectory");
-    size_t ensembleDim = getDim(ncid, "ensemble");
-    size_t startLonDim = getDim(ncid, "start_lon");
-    size_t startLatDim = getDim(ncid, "start_lat");
-    size_t timeIntervalDim = getDim(ncid, "time_interval");
-
-    // Load data arrays
-    double *time = NULL;
-    float *lon = NULL, *lat = NULL, *pressure = NULL, *startLon = NULL, *startLat = NULL, *timeInterval = NULL;
-    loadDoubleArray1D(ncid, "time", timeDim, &time);
-    loadFloatArray3D(ncid, "lon", 1, trajectoryDim, timeDim, &lon);
-    loadFloatArray3D(ncid, "lat", 1, trajectoryDim, timeDim, &lat);
-    loadFloatArray3D(ncid, "pressure", 1, trajectoryDim, timeDim, &pressure);
-    loadFloatArray1D(ncid, "start_lon", startLonDim, &startLon);
-    loadFloatArray1D(ncid, "start_lat", startLatDim, &startLat);
-    loadFloatArray1D(ncid, "time_interval", timeIntervalDim, &timeInterval);
-
-
-    trajectories = convertLatLonToCartesian(lat, lon, pressure, trajectoryDim, timeDim);
+
+    int lonVarid, latVarid, pressureVarid;
+    myassert(nc_inq_varid(ncid, "lon", &lonVarid) == 0);
+    myassert(nc_inq_varid(ncid, "lat", &latVarid) == 0);
+    myassert(nc_inq_varid(ncid, "pressure", &pressureVarid) == 0);
+
+    // The trajectories of the first ensemble member are streamed in blocks (hyperslabs) of at most
+    // NETCDF_BLOCK_NUM_VALUES values per variable. Thus, the memory needed in addition to the output is bounded
+    // independently of the number of trajectories.
+    const size_t NETCDF_BLOCK_NUM_VALUES = size_t(1) << 22;
+    const size_t blockNumTrajectoriesMax = std::max(
+            NETCDF_BLOCK_NUM_VALUES / std::max(timeDim, size_t(1)), size_t(1));
+    std::vector<float> lat(blockNumTrajectoriesMax * timeDim);
+    std::vector<float> lon(blockNumTrajectoriesMax * timeDim);
+    std::vector<float> pressure(blockNumTrajectoriesMax * timeDim);
+
+    // Pass 1: Stream the pressure to compute its range and the number of valid points of each trajectory.
+    float minPressure = FLT_MAX;
+    float maxPressure = -FLT_MAX;
+    std::vector<size_t> trajectoryNumPoints(trajectoryDim);
+    for (size_t blockStart = 0; blockStart < trajectoryDim; blockStart += blockNumTrajectoriesMax) {
+        const size_t blockNumTrajectories = std::min(blockNumTrajectoriesMax, trajectoryDim - blockStart);
+        readFloatArray3DBlock(ncid, pressureVarid, 0, blockStart, 0, 1, blockNumTrajectories, timeDim,
+                pressure.data());
+        #pragma omp parallel for reduction(min:minPressure) reduction(max:maxPressure)
+        for (size_t blockTrajectoryIndex = 0; blockTrajectoryIndex < blockNumTrajectories; blockTrajectoryIndex++) {
+            size_t numValidPoints = 0;
+            for (size_t i = 0; i < timeDim; i++) {
+                float pressureAtIdx = pressure[blockTrajectoryIndex * timeDim + i];
+                if (pressureAtIdx > 0.0f) {
+                    minPressure = std::min(minPressure, pressureAtIdx);
+                    numValidPoints++;
+                }
+                maxPressure = std::max(maxPressure, pressureAtIdx);
+            }
+            trajectoryNumPoints[blockStart + blockTrajectoryIndex] = numValidPoints;
+        }
+    }
+    float logMinPressure = log(minPressure);
+    float logMaxPressure = log(maxPressure);
+
+    // Allocate the output for all non-empty trajectories.
+    std::vector<int64_t> lineIndices(trajectoryDim, -1);
+    std::vector<size_t> lineNumPoints;
+    for (size_t trajectoryIndex = 0; trajectoryIndex < trajectoryDim; trajectoryIndex++) {
+        if (trajectoryNumPoints[trajectoryIndex] > 0) {
+            lineIndices[trajectoryIndex] = int64_t(lineNumPoints.size());
+            lineNumPoints.push_back(trajectoryNumPoints[trajectoryIndex]);
+        }
+    }
+    trajectories.allocateLines(lineNumPoints, 1);
+
+    // Pass 2: Stream lat, lon and pressure and convert them directly into the output arrays.
+    for (size_t blockStart = 0; blockStart < trajectoryDim; blockStart += blockNumTrajectoriesMax) {
+        const size_t blockNumTrajectories = std::min(blockNumTrajectoriesMax, trajectoryDim - blockStart);
+        readFloatArray3DBlock(ncid, latVarid, 0, blockStart, 0, 1, blockNumTrajectories, timeDim, lat.data());
+        readFloatArray3DBlock(ncid, lonVarid, 0, blockStart, 0, 1, blockNumTrajectories, timeDim, lon.data());
+        readFloatArray3DBlock(ncid, pressureVarid, 0, blockStart, 0, 1, blockNumTrajectories, timeDim,
+                pressure.data());
+        convertLatLonToCartesianBlock(
+                lat.data(), lon.data(), pressure.data(), blockNumTrajectories, timeDim, lineIndices.data() + blockStart,
+                logMinPressure, logMaxPressure, trajectories);
+    }
+
     std::string outputFilename = filename.substr(0, filename.find_last_of(".")) + ".obj";
     //exportObjFile(trajectories, outputFilename);
 
@@ -351,14 +420,5 @@ Trajectories loadNetCdfFile(const std::string &filename)
     // Close the file
     myassert(nc_close(ncid) == NC_NOERR);
 
-    SAFE_DELETE_ARRAY(time);
-    SAFE_DELETE_ARRAY(lon);
-    SAFE_DELETE_ARRAY(lat);
-    SAFE_DELETE_ARRAY(pressure);
-    SAFE_DELETE_ARRAY(startLon);
-    SAFE_DELETE_ARRAY(startLat);
-    SAFE_DELETE_ARRAY(timeInterval);
-
     return trajectories;
 }
-
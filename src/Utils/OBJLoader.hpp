@@ -17,8 +17,9 @@
  *
  * @param objFilename: The input .obj file.
  * @param binaryFilename: The filename of the binary output file.
+ * @return False if the input couldn't be read or the output couldn't be written.
  */
-void convertObjMeshToBinary(
+bool convertObjMeshToBinary(
         const std::string &objFilename,
         const std::string &binaryFilename);
 
@@ -0,0 +1,42 @@
+//
+// Created by christoph on 19.10.26.
+//
+
+#include <cstring>
+#include <Graphics/Texture/Bitmap.hpp>
+
+#include "Performance/InternalState.hpp"
+#include "OfflineRendering.hpp"
+
+std::string getModelFilenameFromDisplayName(const std::string &modelName)
+{
+    for (int i = 0; i < NUM_MODELS; i++) {
+        if (MODEL_DISPLAYNAMES[i] == modelName) {
+            return MODEL_FILENAMES[i];
+        }
+    }
+    return "";
+}
+
+AsyncFrameWriter::~AsyncFrameWriter()
+{
+    wait();
+}
+
+void AsyncFrameWriter::writeFrame(const uint32_t *imageData, int width, int height, const std::string &filename)
+{
+    // The image of the renderer is usually only valid until the next frame, thus it is copied first.
+    sgl::BitmapPtr bitmap(new sgl::Bitmap(width, height, 32));
+    memcpy(bitmap->getPixels(), imageData, sizeof(uint32_t) * width * height);
+    wait();
+    imageWriteFuture = std::async(std::launch::async, [bitmap, filename]() {
+        bitmap->savePNG(filename.c_str(), true);
+    });
+}
+
+void AsyncFrameWriter::wait()
+{
+    if (imageWriteFuture.valid()) {
+        imageWriteFuture.wait();
+    }
+}
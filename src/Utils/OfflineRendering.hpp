@@ -0,0 +1,45 @@
+//
+// Created by christoph on 19.10.26.
+//
+
+#ifndef PIXELSYNCOIT_OFFLINERENDERING_HPP
+#define PIXELSYNCOIT_OFFLINERENDERING_HPP
+
+#include <string>
+#include <future>
+#include <cstdint>
+#include <cmath>
+
+/*
+ * Helpers for rendering the frames of a camera path without the main window (see runRayTracingBatch). The camera
+ * settings are the same as in the main application, such that the images can be compared to its screenshots.
+ */
+
+/// The vertical field of view of the camera of the main application.
+inline float getDefaultCameraFovy() { return std::atan(1.0f / 2.0f) * 2.0f; }
+
+/// Returns the file name of the model with the passed display name (see MODEL_DISPLAYNAMES), or "" if unknown.
+std::string getModelFilenameFromDisplayName(const std::string &modelName);
+
+/**
+ * Encodes the rendered frames as PNG images on a separate thread while the next frame is rendered. At most one image
+ * is encoded at a time.
+ */
+class AsyncFrameWriter
+{
+public:
+    ~AsyncFrameWriter();
+
+    /**
+     * Copies the passed RGBA8 image (rows stored bottom-up like glReadPixels) and stores it as a PNG image.
+     * Waits until the previous image has been written.
+     */
+    void writeFrame(const uint32_t *imageData, int width, int height, const std::string &filename);
+    /// Waits until the last image has been written.
+    void wait();
+
+private:
+    std::future<void> imageWriteFuture;
+};
+
+#endif //PIXELSYNCOIT_OFFLINERENDERING_HPP
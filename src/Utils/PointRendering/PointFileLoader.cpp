@@ -26,47 +26,311 @@
  * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include <cstdio>
+#include <cassert>
+#include <cstring>
+#include <cfloat>
+#include <chrono>
+#include <algorithm>
+#include <functional>
 #include <boost/algorithm/string/predicate.hpp>
 #include <Utils/File/Logfile.hpp>
+#include <Utils/Convert.hpp>
 #include "import_uintah.h"
 #include "import_cosmic_web.h"
 #include "../MeshSerializer.hpp"
 #include "../ImportanceCriteria.hpp"
+#include "../MortonCode.hpp"
+#include "PointLODHierarchy.hpp"
 #include "PointFileLoader.hpp"
 
 // timestep.xml -> uintah
 // .dat -> cosmic_web
 
-void convertPointDataSetToBinmesh(
-        const std::string &inputFilename,
-        const std::string &binaryFilename) {
-    sgl::Logfile::get()->writeInfo(std::string() + "Loading point data from \"" + inputFilename + "\"...");
+typedef std::function<void(const pl::ParticleModel&)> ParticleChunkCallback;
 
-    pl::ParticleModel particleModel;
+/// Streams the data set chunk by chunk (patches for Uintah data sets). Returns false for unknown file types.
+static bool forEachParticleChunk(const std::string &inputFilename, const ParticleChunkCallback &callback)
+{
     if (boost::ends_with(inputFilename, "timestep.xml")) {
-        pl::import_uintah(pl::FileName(inputFilename), particleModel);
+        pl::import_uintah_patches(pl::FileName(inputFilename), callback);
     } else if (boost::ends_with(inputFilename, ".dat")) {
-        pl::import_cosmic_web(pl::FileName(inputFilename), particleModel);
+        const size_t MAX_CHUNK_PARTICLES = 1u << 20u;
+        pl::import_cosmic_web_chunks(pl::FileName(inputFilename), MAX_CHUNK_PARTICLES, callback);
     } else {
-        sgl::Logfile::get()->writeError(
-                std::string() + "Error: Unknown point data set file association for \""
-                + inputFilename + "\"!");
-        return;
+        return false;
     }
+    return true;
+}
 
-    auto positions = static_cast<pl::DataT<float>*>(particleModel["positions"].get());
-    size_t numPoints = positions->size() / 3;
-    glm::vec3 *positionValues = (glm::vec3*)positions->data.data();
+/**
+ * Extracts the positions (with swapped x and y axis) and the point attribute (velocity magnitude, or zero if the
+ * data set has no velocities) from a particle chunk.
+ */
+static void extractParticleChunk(
+        const pl::ParticleModel &chunk, std::vector<glm::vec3> &positions, std::vector<float> &attributes)
+{
+    positions.clear();
+    attributes.clear();
+    auto positionsIt = chunk.find("positions");
+    if (positionsIt == chunk.end()) {
+        return;
+    }
+    auto positionData = static_cast<pl::DataT<float>*>(positionsIt->second.get());
+    const size_t numPoints = positionData->size() / 3;
+    const glm::vec3 *positionValues = (const glm::vec3*)positionData->data.data();
+    positions.resize(numPoints);
+    attributes.resize(numPoints, 0.0f);
 
-    // Compute the bounding box.
-    sgl::AABB3 aabb;
+    #pragma omp parallel for
     for (size_t i = 0; i < numPoints; i++) {
-        glm::vec3& position = positionValues[i];
+        glm::vec3 position = positionValues[i];
+        positions[i] = glm::vec3(position.y, position.x, position.z);
+    }
+
+    auto velocitiesIt = chunk.find("velocities");
+    auto uIt = chunk.find("p.u"), vIt = chunk.find("p.v"), wIt = chunk.find("p.w");
+    if (velocitiesIt != chunk.end()) {
+        // Cosmic web data set.
+        // Compute velocity magnitudes as the vertex attribute.
+        auto velocities = static_cast<pl::DataT<float>*>(velocitiesIt->second.get());
+        assert(numPoints == velocities->size() / 3);
+        const glm::vec3 *velocityValues = (const glm::vec3*)velocities->data.data();
+        #pragma omp parallel for
+        for (size_t i = 0; i < numPoints; i++) {
+            attributes[i] = glm::length(velocityValues[i]);
+        }
+    } else if (uIt != chunk.end() && vIt != chunk.end() && wIt != chunk.end()) {
+        // Uintah data set.
+        // Compute velocity magnitudes as the vertex attribute.
+        const double *uValues = static_cast<pl::DataT<double>*>(uIt->second.get())->data.data();
+        const double *vValues = static_cast<pl::DataT<double>*>(vIt->second.get())->data.data();
+        const double *wValues = static_cast<pl::DataT<double>*>(wIt->second.get())->data.data();
+        assert(numPoints == uIt->second->size());
+        #pragma omp parallel for
+        for (size_t i = 0; i < numPoints; i++) {
+            attributes[i] = glm::length(glm::vec3(uValues[i], vValues[i], wValues[i]));
+        }
+    }
+}
 
-        float tempZ = position.x;
-        position.x = position.y;
-        position.y = tempZ;
-        aabb.combine(position);
+/// A point record of the temporary spill file used for sorting the points along the Morton curve.
+struct PointRecord
+{
+    uint64_t mortonCode;
+    glm::vec3 position;
+    uint16_t attribute;
+};
+
+/// Seeks with 64-bit offsets (also on Windows, where long is only 32 bits wide).
+static inline int seekFile64(FILE *file, uint64_t offset)
+{
+#ifdef _WIN32
+    return _fseeki64(file, int64_t(offset), SEEK_SET);
+#else
+    return fseeko(file, off_t(offset), SEEK_SET);
+#endif
+}
+
+/**
+ * Buckets of points with the same Morton code prefix. At level 0, the prefix has NUM_BUCKET_BITS bits (i.e., the
+ * octree cell at level NUM_BUCKET_BITS/3), each further level uses the next NUM_BUCKET_BITS bits of the Morton code.
+ * Only one page per bucket is kept in memory, full pages are appended to a temporary file.
+ */
+class PointBucketSpillFile
+{
+public:
+    static const uint32_t NUM_BUCKET_BITS = 9;
+    static const uint32_t NUM_BUCKETS = 1u << NUM_BUCKET_BITS;
+    static const uint32_t MAX_LEVEL = 63u / NUM_BUCKET_BITS - 1u;
+    static const size_t RECORDS_PER_PAGE = 4096;
+
+    PointBucketSpillFile(uint32_t level = 0) : level(level), bucketBuffers(NUM_BUCKETS), bucketPages(NUM_BUCKETS) {
+        file = tmpfile();
+    }
+    ~PointBucketSpillFile() {
+        if (file) {
+            fclose(file);
+        }
+    }
+    bool isOpen() { return file != nullptr; }
+    /// Returns true if writing to or reading from the temporary file failed (e.g., because the disk is full).
+    bool hasFailed() { return failed; }
+    uint32_t getLevel() { return level; }
+
+    uint32_t getBucketIndex(uint64_t mortonCode) {
+        return uint32_t(mortonCode >> (63u - NUM_BUCKET_BITS * (level + 1u))) & (NUM_BUCKETS - 1u);
+    }
+
+    void add(const PointRecord &record) {
+        uint32_t bucketIndex = getBucketIndex(record.mortonCode);
+        std::vector<PointRecord> &buffer = bucketBuffers.at(bucketIndex);
+        if (buffer.empty()) {
+            buffer.reserve(RECORDS_PER_PAGE);
+        }
+        buffer.push_back(record);
+        if (buffer.size() == RECORDS_PER_PAGE) {
+            flushBucket(bucketIndex);
+        }
+    }
+
+    size_t getBucketSize(uint32_t bucketIndex) {
+        size_t numRecords = bucketBuffers.at(bucketIndex).size();
+        for (const std::pair<uint64_t, size_t> &page : bucketPages.at(bucketIndex)) {
+            numRecords += page.second;
+        }
+        return numRecords;
+    }
+
+    /**
+     * Reads the points of a bucket (in the order they were added) in batches of at most maxBatchSize points, so that
+     * the memory needed doesn't depend on the distribution of the points.
+     * @return False if reading the temporary file failed.
+     */
+    bool readBucket(
+            uint32_t bucketIndex, size_t maxBatchSize, std::vector<PointRecord> &records,
+            const std::function<void(std::vector<PointRecord>&)> &batchCallback) {
+        assert(maxBatchSize >= RECORDS_PER_PAGE);
+        flushBucket(bucketIndex);
+        records.clear();
+        for (const std::pair<uint64_t, size_t> &page : bucketPages.at(bucketIndex)) {
+            if (records.size() + page.second > maxBatchSize) {
+                batchCallback(records);
+                records.clear();
+            }
+            size_t oldSize = records.size();
+            records.resize(oldSize + page.second);
+            if (failed || seekFile64(file, page.first) != 0
+                    || fread(&records[oldSize], sizeof(PointRecord), page.second, file) != page.second) {
+                sgl::Logfile::get()->writeError("Error in PointBucketSpillFile::readBucket: Read failed.");
+                failed = true;
+                return false;
+            }
+        }
+        if (!records.empty()) {
+            batchCallback(records);
+        }
+        return true;
+    }
+
+private:
+    void flushBucket(uint32_t bucketIndex) {
+        std::vector<PointRecord> &buffer = bucketBuffers.at(bucketIndex);
+        if (buffer.empty() || failed) {
+            return;
+        }
+        bucketPages.at(bucketIndex).push_back(std::make_pair(fileSize, buffer.size()));
+        if (seekFile64(file, fileSize) != 0
+                || fwrite(buffer.data(), sizeof(PointRecord), buffer.size(), file) != buffer.size()) {
+            sgl::Logfile::get()->writeError("Error in PointBucketSpillFile::flushBucket: Write failed.");
+            failed = true;
+        }
+        fileSize += buffer.size() * sizeof(PointRecord);
+        buffer.clear();
+        buffer.shrink_to_fit();
+    }
+
+    uint32_t level;
+    FILE *file = nullptr;
+    uint64_t fileSize = 0;
+    bool failed = false;
+    std::vector<std::vector<PointRecord>> bucketBuffers;
+    std::vector<std::vector<std::pair<uint64_t, size_t>>> bucketPages; ///< Offset and number of records
+};
+
+/// Maximum number of points sorted in memory at once (~100MiB of point records).
+static const size_t MAX_POINTS_PER_SORTED_BATCH = size_t(1) << 22u;
+
+/**
+ * Passes the points of a bucket to the callback in Morton order (in batches of at most MAX_POINTS_PER_SORTED_BATCH
+ * points). Buckets with more points are split by the next bits of the Morton code recursively.
+ * @return False if the temporary files couldn't be written or read.
+ */
+static bool forEachSortedBucketBatch(
+        PointBucketSpillFile &spillFile, uint32_t bucketIndex, std::vector<PointRecord> &records,
+        const std::function<void(std::vector<PointRecord>&)> &batchCallback)
+{
+    if (spillFile.getBucketSize(bucketIndex) <= MAX_POINTS_PER_SORTED_BATCH) {
+        return spillFile.readBucket(bucketIndex, MAX_POINTS_PER_SORTED_BATCH, records,
+                [&batchCallback](std::vector<PointRecord> &bucketRecords) {
+            std::sort(bucketRecords.begin(), bucketRecords.end(), [](const PointRecord &a, const PointRecord &b) {
+                return a.mortonCode < b.mortonCode;
+            });
+            batchCallback(bucketRecords);
+        });
+    }
+    if (spillFile.getLevel() == PointBucketSpillFile::MAX_LEVEL) {
+        // All bits of the Morton code were used, i.e., all points of the bucket have the same Morton code.
+        return spillFile.readBucket(bucketIndex, MAX_POINTS_PER_SORTED_BATCH, records, batchCallback);
+    }
+
+    PointBucketSpillFile subBucketFile(spillFile.getLevel() + 1);
+    if (!subBucketFile.isOpen()) {
+        sgl::Logfile::get()->writeError("Error in forEachSortedBucketBatch: Could not create temporary file.");
+        return false;
+    }
+    bool readSucceeded = spillFile.readBucket(bucketIndex, MAX_POINTS_PER_SORTED_BATCH, records,
+            [&subBucketFile](std::vector<PointRecord> &bucketRecords) {
+        for (const PointRecord &record : bucketRecords) {
+            subBucketFile.add(record);
+        }
+    });
+    if (!readSucceeded || subBucketFile.hasFailed()) {
+        return false;
+    }
+    for (uint32_t subBucketIndex = 0; subBucketIndex < PointBucketSpillFile::NUM_BUCKETS; subBucketIndex++) {
+        if (!forEachSortedBucketBatch(subBucketFile, subBucketIndex, records, batchCallback)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool convertPointDataSetToBinmesh(
+        const std::string &inputFilename,
+        const std::string &binaryFilename) {
+    sgl::Logfile::get()->writeInfo(std::string() + "Loading point data from \"" + inputFilename + "\"...");
+    auto start = std::chrono::system_clock::now();
+
+    // Pass 1: Compute the bounding box, the attribute range and the number of points.
+    sgl::AABB3 aabb(glm::vec3(FLT_MAX), glm::vec3(-FLT_MAX));
+    float minAttribute = FLT_MAX, maxAttribute = -FLT_MAX;
+    size_t numPoints = 0;
+    std::vector<glm::vec3> chunkPositions;
+    std::vector<float> chunkAttributes;
+    bool isKnownFileType = forEachParticleChunk(inputFilename, [&](const pl::ParticleModel &chunk) {
+        extractParticleChunk(chunk, chunkPositions, chunkAttributes);
+        const glm::vec3 *positions = chunkPositions.data();
+        const float *attributes = chunkAttributes.data();
+        float minX = aabb.min.x, minY = aabb.min.y, minZ = aabb.min.z;
+        float maxX = aabb.max.x, maxY = aabb.max.y, maxZ = aabb.max.z;
+        float minAttr = minAttribute, maxAttr = maxAttribute;
+        #pragma omp parallel for reduction(min:minX,minY,minZ,minAttr) reduction(max:maxX,maxY,maxZ,maxAttr)
+        for (size_t i = 0; i < chunkPositions.size(); i++) {
+            minX = std::min(minX, positions[i].x);
+            minY = std::min(minY, positions[i].y);
+            minZ = std::min(minZ, positions[i].z);
+            maxX = std::max(maxX, positions[i].x);
+            maxY = std::max(maxY, positions[i].y);
+            maxZ = std::max(maxZ, positions[i].z);
+            minAttr = std::min(minAttr, attributes[i]);
+            maxAttr = std::max(maxAttr, attributes[i]);
+        }
+        aabb = sgl::AABB3(glm::vec3(minX, minY, minZ), glm::vec3(maxX, maxY, maxZ));
+        minAttribute = minAttr;
+        maxAttribute = maxAttr;
+        numPoints += chunkPositions.size();
+    });
+    if (!isKnownFileType) {
+        sgl::Logfile::get()->writeError(
+                std::string() + "Error: Unknown point data set file association for \""
+                + inputFilename + "\"!");
+        return false;
+    }
+    if (numPoints == 0) {
+        sgl::Logfile::get()->writeError(
+                std::string() + "Error in convertPointDataSetToBinmesh: No points in \"" + inputFilename + "\".");
+        return false;
     }
 
     // Find the maximum axis of the box.
@@ -74,86 +338,137 @@ void convertPointDataSetToBinmesh(
     for (size_t i = 0; i < 3; i++) {
         largestAxis = std::max(largestAxis, aabb.getExtent()[i]);
     }
+    // Morton codes are computed relative to the bounding box of the normalized points.
+    const glm::vec3 center = aabb.getCenter();
+    const glm::vec3 normalizedMin = (aabb.min - center) / largestAxis;
+    const glm::vec3 normalizedExtent = glm::max((aabb.max - aabb.min) / largestAxis, glm::vec3(1e-6f));
+    const float attributeScale = maxAttribute > minAttribute ? 65535.0f / (maxAttribute - minAttribute) : 0.0f;
 
-    // Now normalize the data range.
-    #pragma omp parallel for
-    for (size_t i = 0; i < numPoints; i++) {
-        glm::vec3 oldPoint = positionValues[i];
-        positionValues[i] = (oldPoint - aabb.getCenter()) / largestAxis;
+    // Pass 2: Normalize the points, pack the attribute and distribute the points to the Morton code buckets.
+    PointBucketSpillFile spillFile;
+    if (!spillFile.isOpen()) {
+        sgl::Logfile::get()->writeError("Error in convertPointDataSetToBinmesh: Could not create temporary file.");
+        return false;
+    }
+    std::vector<PointRecord> chunkRecords;
+    forEachParticleChunk(inputFilename, [&](const pl::ParticleModel &chunk) {
+        extractParticleChunk(chunk, chunkPositions, chunkAttributes);
+        chunkRecords.resize(chunkPositions.size());
+        #pragma omp parallel for
+        for (size_t i = 0; i < chunkPositions.size(); i++) {
+            PointRecord &record = chunkRecords[i];
+            record.position = (chunkPositions[i] - center) / largestAxis;
+            record.mortonCode = computeMortonCode3D((record.position - normalizedMin) / normalizedExtent);
+            record.attribute = uint16_t(glm::clamp(
+                    (chunkAttributes[i] - minAttribute) * attributeScale, 0.0f, 65535.0f) + 0.5f);
+        }
+        for (const PointRecord &record : chunkRecords) {
+            spillFile.add(record);
+        }
+    });
+    if (spillFile.hasFailed()) {
+        sgl::Logfile::get()->writeError(std::string() + "Error in convertPointDataSetToBinmesh: Could not write the "
+                + "temporary file for \"" + inputFilename + "\".");
+        return false;
     }
 
-    // Create a binary mesh from the data.
-    BinaryMesh binaryMesh;
-    binaryMesh.submeshes.resize(1);
-
-    BinarySubMesh &binarySubmesh = binaryMesh.submeshes.at(0);
+    // Create a binary mesh from the data. The original points are kept in memory for building the level of detail
+    // hierarchy; the mesh itself is streamed to the file.
+    BinarySubMesh binarySubmesh;
     binarySubmesh.vertexMode = sgl::VERTEX_MODE_POINTS;
+    std::vector<glm::vec3> positionValuesVector(numPoints);
+    std::vector<uint16_t> attributeValuesVector(numPoints);
+    glm::vec3 *positionValues = positionValuesVector.data();
+    uint16_t *attributeValues = attributeValuesVector.data();
 
-    BinaryMeshAttribute positionAttribute;
-    positionAttribute.name = "vertexPosition";
-    positionAttribute.attributeFormat = sgl::ATTRIB_FLOAT;
-    positionAttribute.numComponents = 3;
-    positionAttribute.data.resize(numPoints * sizeof(glm::vec3));
-    memcpy(&positionAttribute.data.front(), positions->data.data(), numPoints * sizeof(glm::vec3));
-    binarySubmesh.attributes.push_back(positionAttribute);
-
-    BinaryMeshAttribute vertexAttribute;
-    vertexAttribute.name = "vertexAttribute0";
-    vertexAttribute.attributeFormat = sgl::ATTRIB_UNSIGNED_SHORT;
-    vertexAttribute.numComponents = 1;
-    std::vector<uint16_t> vertexAttributeData(numPoints, 0u); // Just zero if no other attribute exists
-    if (particleModel.find("velocities") != particleModel.end()) {
-        // Cosmic web data set.
-        // Compute velocity magnitudes as the vertex attribute.
-        auto velocities = static_cast<pl::DataT<float>*>(particleModel["velocities"].get());
-        assert(numPoints == velocities->size() / 3);
-        glm::vec3 *velocityValues = (glm::vec3*)velocities->data.data();
-
-        std::vector<float> velocityMagnitudes(numPoints);
-        #pragma omp parallel for
-        for (size_t i = 0; i < numPoints; i++) {
-            velocityMagnitudes[i] = glm::length(velocityValues[i]);
+    // Pass 3 (over the temporary file): Sort each bucket by the Morton code and emit spatial chunks.
+    const size_t MAX_POINTS_PER_CHUNK = 1u << 16u;
+    const uint32_t MAX_POINTS_PER_LOD_LEAF = 1024;
+    std::vector<BinaryMeshChunk> chunks;
+    std::vector<PointRecord> bucketRecords;
+    size_t pointOffset = 0;
+    auto emitChunks = [&](std::vector<PointRecord> &sortedRecords) {
+        for (size_t chunkStart = 0; chunkStart < sortedRecords.size(); chunkStart += MAX_POINTS_PER_CHUNK) {
+            size_t chunkEnd = std::min(chunkStart + MAX_POINTS_PER_CHUNK, sortedRecords.size());
+            BinaryMeshChunk chunk;
+            chunk.firstElement = uint32_t(pointOffset + chunkStart);
+            chunk.numElements = uint32_t(chunkEnd - chunkStart);
+            chunk.boundingBox = sgl::AABB3(glm::vec3(FLT_MAX), glm::vec3(-FLT_MAX));
+            for (size_t i = chunkStart; i < chunkEnd; i++) {
+                const PointRecord &record = sortedRecords[i];
+                positionValues[pointOffset + i] = record.position;
+                attributeValues[pointOffset + i] = record.attribute;
+                chunk.boundingBox.combine(record.position);
+            }
+            chunks.push_back(chunk);
         }
-        packUnorm16Array(velocityMagnitudes, vertexAttributeData);
-    } else if (particleModel.find("p.u") != particleModel.end() && particleModel.find("p.v") != particleModel.end()
-            && particleModel.find("p.w") != particleModel.end()) {
-        // Cosmic web data set.
-        // Compute velocity magnitudes as the vertex attribute.
-        auto us = static_cast<pl::DataT<double>*>(particleModel["p.u"].get());
-        auto vs = static_cast<pl::DataT<double>*>(particleModel["p.v"].get());
-        auto ws = static_cast<pl::DataT<double>*>(particleModel["p.w"].get());
-        //assert(numPoints == rhos->size());
-        double *uValues = (double*)us->data.data();
-        double *vValues = (double*)vs->data.data();
-        double *wValues = (double*)ws->data.data();
-
-        std::vector<float> velocityMagnitudes(numPoints);
-        #pragma omp parallel for
-        for (size_t i = 0; i < numPoints; i++) {
-            velocityMagnitudes[i] = glm::length(glm::vec3(uValues[i], vValues[i], wValues[i]));
+        pointOffset += sortedRecords.size();
+    };
+    for (uint32_t bucketIndex = 0; bucketIndex < PointBucketSpillFile::NUM_BUCKETS; bucketIndex++) {
+        if (!forEachSortedBucketBatch(spillFile, bucketIndex, bucketRecords, emitChunks)) {
+            sgl::Logfile::get()->writeError(std::string() + "Error in convertPointDataSetToBinmesh: Could not "
+                    + "access the temporary file for \"" + inputFilename + "\".");
+            return false;
         }
-        packUnorm16Array(velocityMagnitudes, vertexAttributeData);
     }
-    vertexAttribute.data.resize(vertexAttributeData.size() * sizeof(uint16_t));
-    memcpy(&vertexAttribute.data.front(), &vertexAttributeData.front(), vertexAttributeData.size() * sizeof(uint16_t));
-    binarySubmesh.attributes.push_back(vertexAttribute);
+    assert(pointOffset == numPoints);
+    setSubmeshChunks(binarySubmesh, chunks);
 
-    // TODO: Test
-    /*BinaryMeshAttribute positionAttribute;
-    positionAttribute.name = "vertexPosition";
-    positionAttribute.attributeFormat = sgl::ATTRIB_FLOAT;
-    positionAttribute.numComponents = 3;
-    positionAttribute.data.resize(1 * sizeof(glm::vec3), 0u);
-    binarySubmesh.attributes.push_back(positionAttribute);
+    // Build the level of detail hierarchy and append one representative splat per node after the original points.
+    std::vector<PointLODNode> lodNodes;
+    std::vector<glm::vec3> representativePositions;
+    std::vector<uint16_t> representativeAttributes;
+    std::vector<float> representativeRadii;
+    buildPointLODHierarchy(
+            positionValues, attributeValues, uint32_t(numPoints), normalizedMin, normalizedExtent,
+            MAX_POINTS_PER_LOD_LEAF, lodNodes, representativePositions, representativeAttributes, representativeRadii);
+    const size_t numRepresentatives = lodNodes.size();
+    setPointLODNodes(binarySubmesh, lodNodes);
 
-    BinaryMeshAttribute vertexAttribute;
-    vertexAttribute.name = "vertexAttribute0";
-    vertexAttribute.attributeFormat = sgl::ATTRIB_UNSIGNED_SHORT;
-    vertexAttribute.numComponents = 1;
-    vertexAttribute.data.resize(1 * sizeof(uint16_t), 0u);
-    binarySubmesh.attributes.push_back(vertexAttribute);*/
+    BinaryMeshStreamWriter writer;
+    if (!writer.open(binaryFilename)) {
+        return false;
+    }
+    const size_t numVertices = numPoints + numRepresentatives;
+    writer.beginSubmesh(binarySubmesh.material, binarySubmesh.vertexMode, 0);
+    writer.addUniforms(binarySubmesh.uniforms);
+    size_t positionAttributeIndex = writer.addAttribute(
+            "vertexPosition", sgl::ATTRIB_FLOAT, 3, numVertices * sizeof(glm::vec3));
+    size_t vertexAttributeIndex = writer.addAttribute(
+            "vertexAttribute0", sgl::ATTRIB_UNSIGNED_SHORT, 1, numVertices * sizeof(uint16_t));
+    // Original points use the global point radius (0), representatives are enlarged to cover their subtree.
+    size_t radiusAttributeIndex = writer.addAttribute(
+            "vertexPointRadius", sgl::ATTRIB_FLOAT, 1, numVertices * sizeof(float));
+    writer.finishIndices();
+
+    // Representatives are stored after the original points.
+    writer.appendAttributeData(positionAttributeIndex, positionValues, numPoints * sizeof(glm::vec3));
+    writer.appendAttributeData(positionAttributeIndex, representativePositions.data(),
+            numRepresentatives * sizeof(glm::vec3));
+    writer.finishAttribute(positionAttributeIndex);
+    writer.appendAttributeData(vertexAttributeIndex, attributeValues, numPoints * sizeof(uint16_t));
+    writer.appendAttributeData(vertexAttributeIndex, representativeAttributes.data(),
+            numRepresentatives * sizeof(uint16_t));
+    writer.finishAttribute(vertexAttributeIndex);
+    std::vector<float> zeroRadii(std::min(numPoints, size_t(1u << 20u)), 0.0f);
+    for (size_t pointStart = 0; pointStart < numPoints; pointStart += zeroRadii.size()) {
+        size_t numChunkPoints = std::min(zeroRadii.size(), numPoints - pointStart);
+        writer.appendAttributeData(radiusAttributeIndex, zeroRadii.data(), numChunkPoints * sizeof(float));
+    }
+    writer.appendAttributeData(radiusAttributeIndex, representativeRadii.data(),
+            numRepresentatives * sizeof(float));
+    writer.finishAttribute(radiusAttributeIndex);
+
+    auto end = std::chrono::system_clock::now();
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(end - start);
+    sgl::Logfile::get()->writeInfo(std::string() + "Summary: " + sgl::toString(numPoints) + " points, "
+            + sgl::toString(chunks.size()) + " chunks, "
+            + sgl::toString(numRepresentatives) + " level of detail nodes, conversion time: " + std::to_string(elapsed.count()) + "ms");
 
     sgl::Logfile::get()->writeInfo(std::string() + "Writing binary mesh...");
-    writeMesh3D(binaryFilename, binaryMesh);
+    if (!writer.close()) {
+        return false;
+    }
     sgl::Logfile::get()->writeInfo(std::string() + "Finished writing binary mesh.");
-}
\ No newline at end of file
+    return true;
+}
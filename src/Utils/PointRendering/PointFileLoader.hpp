@@ -30,13 +30,19 @@
 #define PIXELSYNCOIT_POINTFILELOADER_HPP
 
 /**
+ * Converts a point data set to a binary mesh. The data set is streamed twice (once for the bounding box and
+ * attribute range, once for normalizing the points), such that the input data set is never fully in memory.
+ * The points are reordered along a Morton curve using a temporary bucket file and split into spatially coherent
+ * chunks stored with the submesh (see BinaryMeshChunk). Additionally, a level of detail octree with one
+ * representative splat per node is built (see PointLODHierarchy).
  * File associations:
  * - timestep.xml -> uintah data set
  * - .dat -> cosmic_web data set
  * @param inputFilename The file name of the input data set.
  * @param binaryFilename: The file name of the binary output file.
+ * @return False if the input couldn't be read or the output couldn't be written.
  */
-void convertPointDataSetToBinmesh(
+bool convertPointDataSetToBinmesh(
         const std::string &inputFilename,
         const std::string &binaryFilename);
 
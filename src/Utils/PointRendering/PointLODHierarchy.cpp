@@ -0,0 +1,275 @@
+//
+// Created by christoph on 19.10.26.
+//
+
+#include <queue>
+#include <cstring>
+#include <cfloat>
+#include <cmath>
+#include <algorithm>
+#include <Utils/File/Logfile.hpp>
+#include <Graphics/Shader/ShaderAttributes.hpp>
+
+#include "../MortonCode.hpp"
+#include "../Frustum.hpp"
+#include "PointLODHierarchy.hpp"
+
+static_assert(sizeof(PointLODNode) == 14 * sizeof(uint32_t), "PointLODNode must be tightly packed");
+
+void buildPointLODHierarchy(
+        const glm::vec3 *positions, const uint16_t *attributes, uint32_t numPoints,
+        const glm::vec3 &mortonMin, const glm::vec3 &mortonExtent, uint32_t maxPointsPerLeaf,
+        std::vector<PointLODNode> &nodes, std::vector<glm::vec3> &representativePositions,
+        std::vector<uint16_t> &representativeAttributes, std::vector<float> &representativeRadii)
+{
+    nodes.clear();
+    representativePositions.clear();
+    representativeAttributes.clear();
+    representativeRadii.clear();
+    if (numPoints == 0) {
+        return;
+    }
+
+    // The Morton codes are recomputed on demand instead of storing them for all points.
+    auto getMortonCode = [&](uint32_t i) {
+        return computeMortonCode3D((positions[i] - mortonMin) / mortonExtent);
+    };
+
+    // 1. Build the octree in breadth-first order by splitting the point ranges at the next three Morton code bits.
+    PointLODNode root;
+    root.firstChild = 0;
+    root.numChildren = 0;
+    root.firstPoint = 0;
+    root.numPoints = numPoints;
+    nodes.push_back(root);
+    std::vector<uint32_t> nodeLevels = { 0 };
+    for (size_t nodeIdx = 0; nodeIdx < nodes.size(); nodeIdx++) {
+        const uint32_t firstPoint = nodes.at(nodeIdx).firstPoint;
+        const uint32_t endPoint = firstPoint + nodes.at(nodeIdx).numPoints;
+        const uint32_t level = nodeLevels.at(nodeIdx);
+        if (endPoint - firstPoint <= maxPointsPerLeaf || level >= 21) {
+            continue;
+        }
+
+        // All points of the node share the Morton code prefix, thus the next three bits are sorted.
+        const uint32_t shift = 60 - 3 * level;
+        const uint32_t firstChild = uint32_t(nodes.size());
+        uint32_t childBegin = firstPoint;
+        while (childBegin < endPoint) {
+            const uint64_t octant = (getMortonCode(childBegin) >> shift) & 7ull;
+            uint32_t lower = childBegin + 1, upper = endPoint;
+            while (lower < upper) {
+                uint32_t middle = lower + (upper - lower) / 2;
+                if (((getMortonCode(middle) >> shift) & 7ull) <= octant) {
+                    lower = middle + 1;
+                } else {
+                    upper = middle;
+                }
+            }
+
+            PointLODNode child;
+            child.firstChild = 0;
+            child.numChildren = 0;
+            child.firstPoint = childBegin;
+            child.numPoints = lower - childBegin;
+            nodes.push_back(child);
+            nodeLevels.push_back(level + 1);
+            childBegin = lower;
+        }
+        nodes.at(nodeIdx).firstChild = firstChild;
+        nodes.at(nodeIdx).numChildren = uint32_t(nodes.size()) - firstChild;
+    }
+
+    // 2. Aggregate the leaves directly from their points.
+    const size_t numNodes = nodes.size();
+    std::vector<glm::dvec3> centroids(numNodes);
+    std::vector<double> attributeSums(numNodes, 0.0);
+    std::vector<double> squaredDistanceSums(numNodes, 0.0);
+    #pragma omp parallel for schedule(dynamic)
+    for (size_t nodeIdx = 0; nodeIdx < numNodes; nodeIdx++) {
+        PointLODNode &node = nodes[nodeIdx];
+        if (node.numChildren != 0) {
+            continue;
+        }
+        const uint32_t endPoint = node.firstPoint + node.numPoints;
+        glm::vec3 minPosition(FLT_MAX), maxPosition(-FLT_MAX);
+        glm::dvec3 positionSum(0.0);
+        double attributeSum = 0.0;
+        for (uint32_t i = node.firstPoint; i < endPoint; i++) {
+            minPosition = glm::min(minPosition, positions[i]);
+            maxPosition = glm::max(maxPosition, positions[i]);
+            positionSum += glm::dvec3(positions[i]);
+            attributeSum += attributes[i];
+        }
+        const glm::dvec3 centroid = positionSum / double(node.numPoints);
+        double squaredDistanceSum = 0.0, maxSquaredDistance = 0.0;
+        for (uint32_t i = node.firstPoint; i < endPoint; i++) {
+            glm::dvec3 diff = glm::dvec3(positions[i]) - centroid;
+            double squaredDistance = glm::dot(diff, diff);
+            squaredDistanceSum += squaredDistance;
+            maxSquaredDistance = std::max(maxSquaredDistance, squaredDistance);
+        }
+        node.boundingBoxMin = minPosition;
+        node.boundingBoxMax = maxPosition;
+        node.boundingRadius = float(std::sqrt(maxSquaredDistance));
+        centroids[nodeIdx] = centroid;
+        attributeSums[nodeIdx] = attributeSum;
+        squaredDistanceSums[nodeIdx] = squaredDistanceSum;
+    }
+
+    // 3. Aggregate the inner nodes bottom-up (children always have larger indices than their parents).
+    for (size_t nodeIdx = numNodes; nodeIdx-- > 0;) {
+        PointLODNode &node = nodes[nodeIdx];
+        if (node.numChildren == 0) {
+            continue;
+        }
+        const uint32_t endChild = node.firstChild + node.numChildren;
+        glm::dvec3 centroid(0.0);
+        node.boundingBoxMin = glm::vec3(FLT_MAX);
+        node.boundingBoxMax = glm::vec3(-FLT_MAX);
+        for (uint32_t childIdx = node.firstChild; childIdx < endChild; childIdx++) {
+            const PointLODNode &child = nodes[childIdx];
+            centroid += centroids[childIdx] * double(child.numPoints);
+            attributeSums[nodeIdx] += attributeSums[childIdx];
+            node.boundingBoxMin = glm::min(node.boundingBoxMin, child.boundingBoxMin);
+            node.boundingBoxMax = glm::max(node.boundingBoxMax, child.boundingBoxMax);
+        }
+        centroid /= double(node.numPoints);
+
+        // Parallel axis theorem for the sum of squared distances to the new centroid
+        double boundingRadius = 0.0;
+        for (uint32_t childIdx = node.firstChild; childIdx < endChild; childIdx++) {
+            const PointLODNode &child = nodes[childIdx];
+            glm::dvec3 diff = centroids[childIdx] - centroid;
+            squaredDistanceSums[nodeIdx] += squaredDistanceSums[childIdx] + double(child.numPoints) * glm::dot(diff, diff);
+            boundingRadius = std::max(boundingRadius, glm::length(diff) + double(child.boundingRadius));
+        }
+        node.boundingRadius = float(boundingRadius);
+        centroids[nodeIdx] = centroid;
+    }
+
+    // 4. Representative splats
+    representativePositions.resize(numNodes);
+    representativeAttributes.resize(numNodes);
+    representativeRadii.resize(numNodes);
+    #pragma omp parallel for
+    for (size_t nodeIdx = 0; nodeIdx < numNodes; nodeIdx++) {
+        PointLODNode &node = nodes[nodeIdx];
+        node.representativePosition = glm::vec3(centroids[nodeIdx]);
+        representativePositions[nodeIdx] = node.representativePosition;
+        representativeAttributes[nodeIdx] = uint16_t(attributeSums[nodeIdx] / double(node.numPoints) + 0.5);
+        representativeRadii[nodeIdx] = float(std::sqrt(squaredDistanceSums[nodeIdx] / double(node.numPoints)));
+    }
+}
+
+void setPointLODNodes(BinarySubMesh &submesh, const std::vector<PointLODNode> &nodes)
+{
+    BinaryMeshUniform nodesUniform;
+    nodesUniform.name = "pointLODNodes";
+    nodesUniform.attributeFormat = sgl::ATTRIB_UNSIGNED_INT;
+    nodesUniform.numComponents = sizeof(PointLODNode) / sizeof(uint32_t);
+    nodesUniform.data.resize(nodes.size() * sizeof(PointLODNode));
+    if (!nodes.empty()) {
+        memcpy(&nodesUniform.data.front(), &nodes.front(), nodesUniform.data.size());
+    }
+    submesh.uniforms.push_back(nodesUniform);
+}
+
+
+bool PointLODHierarchy::loadFromUniforms(const std::vector<BinaryMeshUniform> &uniforms)
+{
+    nodes.clear();
+    for (const BinaryMeshUniform &uniform : uniforms) {
+        if (uniform.name == "pointLODNodes") {
+            if (uniform.numComponents != sizeof(PointLODNode) / sizeof(uint32_t)
+                    || uniform.data.size() % sizeof(PointLODNode) != 0) {
+                sgl::Logfile::get()->writeError("Error in PointLODHierarchy::loadFromUniforms: Invalid node format.");
+                return false;
+            }
+            nodes.resize(uniform.data.size() / sizeof(PointLODNode));
+            if (!nodes.empty()) {
+                memcpy(&nodes.front(), &uniform.data.front(), uniform.data.size());
+            }
+            return !nodes.empty();
+        }
+    }
+    return false;
+}
+
+float PointLODHierarchy::computeScreenError(
+        const PointLODNode &node, const glm::mat4 &mvMatrix, float pixelsPerUnit) const
+{
+    float distance = -(mvMatrix * glm::vec4(node.representativePosition, 1.0f)).z;
+    if (distance <= node.boundingRadius) {
+        // The camera is (almost) inside of the node
+        return FLT_MAX;
+    }
+    return node.boundingRadius * pixelsPerUnit / distance;
+}
+
+PointLODSelectionStatistics PointLODHierarchy::selectPoints(
+        const glm::mat4 &mvpMatrix, const glm::mat4 &mvMatrix, float pixelsPerUnit,
+        size_t pointBudget, float maxScreenError, std::vector<uint32_t> &indices) const
+{
+    PointLODSelectionStatistics statistics;
+    indices.clear();
+    if (nodes.empty()) {
+        return statistics;
+    }
+
+    // Frustum planes in model space
+    glm::vec4 frustumPlanes[6];
+    extractFrustumPlanes(mvpMatrix, frustumPlanes);
+
+    const uint32_t numOriginalPoints = getNumOriginalPoints();
+    typedef std::pair<float, uint32_t> QueueEntry; // Screen error, node index
+    std::priority_queue<QueueEntry> queue;
+    if (isBoxInFrustum(nodes.front().boundingBoxMin, nodes.front().boundingBoxMax, frustumPlanes)) {
+        queue.push(QueueEntry(computeScreenError(nodes.front(), mvMatrix, pixelsPerUnit), 0));
+    }
+
+    // Every node in the queue will emit at least its representative.
+    size_t numCommittedPoints = 0;
+    std::vector<uint32_t> visibleChildren;
+    while (!queue.empty()) {
+        const QueueEntry entry = queue.top();
+        queue.pop();
+        const PointLODNode &node = nodes.at(entry.second);
+        statistics.numVisitedNodes++;
+
+        size_t refinementCost;
+        visibleChildren.clear();
+        if (node.numChildren == 0) {
+            refinementCost = node.numPoints;
+        } else {
+            for (uint32_t childIdx = node.firstChild; childIdx < node.firstChild + node.numChildren; childIdx++) {
+                const PointLODNode &child = nodes.at(childIdx);
+                if (isBoxInFrustum(child.boundingBoxMin, child.boundingBoxMax, frustumPlanes)) {
+                    visibleChildren.push_back(childIdx);
+                }
+            }
+            refinementCost = visibleChildren.size();
+        }
+
+        bool refine = entry.first > maxScreenError
+                && numCommittedPoints + queue.size() + refinementCost <= pointBudget;
+        if (refine && node.numChildren == 0) {
+            for (uint32_t i = node.firstPoint; i < node.firstPoint + node.numPoints; i++) {
+                indices.push_back(i);
+            }
+            numCommittedPoints += node.numPoints;
+        } else if (refine) {
+            for (uint32_t childIdx : visibleChildren) {
+                queue.push(QueueEntry(computeScreenError(nodes.at(childIdx), mvMatrix, pixelsPerUnit), childIdx));
+            }
+        } else {
+            indices.push_back(numOriginalPoints + entry.second);
+            numCommittedPoints++;
+            statistics.numRepresentatives++;
+            statistics.maxScreenError = std::max(statistics.maxScreenError, entry.first);
+        }
+    }
+
+    statistics.numEmittedPoints = indices.size();
+    return statistics;
+}
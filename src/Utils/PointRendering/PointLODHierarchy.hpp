@@ -0,0 +1,91 @@
+//
+// Created by christoph on 19.10.26.
+//
+
+#ifndef PIXELSYNCOIT_POINTLODHIERARCHY_HPP
+#define PIXELSYNCOIT_POINTLODHIERARCHY_HPP
+
+#include <vector>
+#include <cstdint>
+#include <glm/glm.hpp>
+
+#include "../MeshSerializer.hpp"
+
+/**
+ * A node of the level of detail octree of a point data set. The points are sorted along the Morton curve, thus the
+ * points of each subtree form a contiguous range. Each node has one representative splat (the centroid of its points
+ * with the mean attribute), which is stored after the original points in the vertex arrays of the submesh, i.e., the
+ * representative of node i has the vertex index "numOriginalPoints + i".
+ * The nodes are stored in breadth-first order in the submesh uniform "pointLODNodes" (14 uint32 values per node).
+ */
+struct PointLODNode
+{
+    glm::vec3 boundingBoxMin;
+    glm::vec3 boundingBoxMax;
+    glm::vec3 representativePosition;
+    float boundingRadius; ///< Maximum distance of a point of the subtree to representativePosition
+    uint32_t firstChild; ///< Children are stored contiguously
+    uint32_t numChildren; ///< 0 for leaf nodes
+    uint32_t firstPoint;
+    uint32_t numPoints;
+};
+
+/**
+ * Builds the level of detail octree for points sorted by computeMortonCode3D((position - mortonMin) / mortonExtent).
+ * @param positions, attributes: The Morton sorted points.
+ * @param maxPointsPerLeaf: Nodes with more points are subdivided.
+ * @param nodes: The nodes of the hierarchy (breadth-first order, root at index 0).
+ * @param representativePositions, representativeAttributes, representativeRadii: The representative splat per node.
+ * The radius is the root mean square distance of the points of the subtree to the centroid.
+ */
+void buildPointLODHierarchy(
+        const glm::vec3 *positions, const uint16_t *attributes, uint32_t numPoints,
+        const glm::vec3 &mortonMin, const glm::vec3 &mortonExtent, uint32_t maxPointsPerLeaf,
+        std::vector<PointLODNode> &nodes, std::vector<glm::vec3> &representativePositions,
+        std::vector<uint16_t> &representativeAttributes, std::vector<float> &representativeRadii);
+
+/// Stores the nodes in the uniform "pointLODNodes" of the submesh.
+void setPointLODNodes(BinarySubMesh &submesh, const std::vector<PointLODNode> &nodes);
+
+struct PointLODSelectionStatistics
+{
+    size_t numEmittedPoints = 0; ///< Original points and representative splats
+    size_t numRepresentatives = 0;
+    size_t numVisitedNodes = 0;
+    float maxScreenError = 0.0f; ///< Maximum projected bounding radius (in pixels) of the emitted representatives
+};
+
+/**
+ * Selects the points to render per frame: The octree is refined starting at the root in the order of the largest
+ * screen space error until either the error of all emitted representatives is below the threshold or the point
+ * budget is exhausted. Nodes outside of the view frustum are skipped.
+ */
+class PointLODHierarchy
+{
+public:
+    /// Returns false if the uniforms contain no level of detail data.
+    bool loadFromUniforms(const std::vector<BinaryMeshUniform> &uniforms);
+    inline bool isLoaded() const { return !nodes.empty(); }
+    inline const std::vector<PointLODNode> &getNodes() const { return nodes; }
+    inline uint32_t getNumOriginalPoints() const { return nodes.empty() ? 0 : nodes.front().numPoints; }
+
+    /**
+     * @param mvpMatrix, mvMatrix: The model-view-projection and model-view matrix.
+     * @param pixelsPerUnit: projectionMatrix[1][1] * viewportHeight / 2, i.e., the number of pixels an object of size
+     * one covers at distance one (multiplied by the scaling of the model matrix).
+     * @param pointBudget: The maximum number of emitted points (the cut through the tree never has fewer points than
+     * the number of visible children of the root).
+     * @param maxScreenError: Nodes with a projected bounding radius above this value (in pixels) are refined.
+     * @param indices: The vertex indices of the selected points.
+     */
+    PointLODSelectionStatistics selectPoints(
+            const glm::mat4 &mvpMatrix, const glm::mat4 &mvMatrix, float pixelsPerUnit,
+            size_t pointBudget, float maxScreenError, std::vector<uint32_t> &indices) const;
+
+private:
+    float computeScreenError(const PointLODNode &node, const glm::mat4 &mvMatrix, float pixelsPerUnit) const;
+
+    std::vector<PointLODNode> nodes;
+};
+
+#endif //PIXELSYNCOIT_POINTLODHIERARCHY_HPP
@@ -2,6 +2,7 @@
 #include <algorithm>
 #include <limits>
 #include <fstream>
+#include <stdexcept>
 #include "import_cosmic_web.h"
 
 using namespace pl;
@@ -32,14 +33,15 @@ std::ostream& operator<<(std::ostream &os, const CosmicWebHeader &h) {
 	return os;
 }
 
-void pl::import_cosmic_web(const FileName &file_name, ParticleModel &model) {
-	std::ifstream fin(file_name.c_str(), std::ios::binary);
+// Opens a brick file, reads its header and computes the offset of the brick
+void open_cosmic_web_brick(const FileName &file_name, std::ifstream &fin, CosmicWebHeader &header,
+		vec3f &offset) {
+	fin.open(file_name.c_str(), std::ios::binary);
 
 	if (!fin.good()) {
 		throw std::runtime_error("could not open particle data file " + file_name.file_name);
 	}
 
-	CosmicWebHeader header;
 	if (!fin.read(reinterpret_cast<char*>(&header), sizeof(CosmicWebHeader))) {
 		throw std::runtime_error("Failed to read header");
 	}
@@ -60,7 +62,14 @@ void pl::import_cosmic_web(const FileName &file_name, ParticleModel &model) {
 
 	// Each cell is 768x768x768 units
 	const float step = 768.f;
-	const vec3f offset(step * brick_x, step * brick_y, step * brick_z);
+	offset = vec3f(step * brick_x, step * brick_y, step * brick_z);
+}
+
+void pl::import_cosmic_web(const FileName &file_name, ParticleModel &model) {
+	std::ifstream fin;
+	CosmicWebHeader header;
+	vec3f offset;
+	open_cosmic_web_brick(file_name, fin, header, offset);
 
 	auto positions = std::make_shared<DataT<float>>();
 	auto velocities = std::make_shared<DataT<float>>();
@@ -91,3 +100,41 @@ void pl::import_cosmic_web(const FileName &file_name, ParticleModel &model) {
 	model["velocities"] = std::move(velocities);
 }
 
+
+void pl::import_cosmic_web_chunks(const FileName &file_name, const size_t max_particles,
+		const std::function<void(const ParticleModel&)> &callback) {
+	std::ifstream fin;
+	CosmicWebHeader header;
+	vec3f offset;
+	open_cosmic_web_brick(file_name, fin, header, offset);
+
+	const size_t num_particles = static_cast<size_t>(header.np_local);
+	std::vector<vec3f> file_data;
+	for (size_t first = 0; first < num_particles; first += max_particles) {
+		const size_t n = std::min(max_particles, num_particles - first);
+		file_data.resize(n * 2);
+		if (!fin.read(reinterpret_cast<char*>(file_data.data()), n * 2 * sizeof(vec3f))) {
+			throw std::runtime_error("Failed to read cosmic web file");
+		}
+
+		auto positions = std::make_shared<DataT<float>>();
+		auto velocities = std::make_shared<DataT<float>>();
+		positions->data.resize(n * 3);
+		velocities->data.resize(n * 3);
+		for (size_t i = 0; i < n; ++i) {
+			const vec3f position = file_data[i * 2] + offset;
+			const vec3f &velocity = file_data[i * 2 + 1];
+			positions->data[i * 3] = position.x;
+			positions->data[i * 3 + 1] = position.y;
+			positions->data[i * 3 + 2] = position.z;
+			velocities->data[i * 3] = velocity.x;
+			velocities->data[i * 3 + 1] = velocity.y;
+			velocities->data[i * 3 + 2] = velocity.z;
+		}
+
+		ParticleModel chunk;
+		chunk["positions"] = std::move(positions);
+		chunk["velocities"] = std::move(velocities);
+		callback(chunk);
+	}
+}
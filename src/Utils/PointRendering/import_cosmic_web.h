@@ -1,5 +1,6 @@
 #pragma once
 
+#include <functional>
 #include "types.h"
 
 namespace pl {
@@ -7,5 +8,9 @@ namespace pl {
 // Import a single brick of the cosmic web dataset into the model
 void import_cosmic_web(const FileName &file_name, ParticleModel &model);
 
+// Import a single brick in chunks of at most max_particles particles, which are passed to the callback
+void import_cosmic_web_chunks(const FileName &file_name, const size_t max_particles,
+		const std::function<void(const ParticleModel&)> &callback);
+
 }
 
@@ -4,8 +4,13 @@
 #include <stdexcept>
 #include <cstdlib>
 #include <cstdio>
+#include <cstring>
+#include <cstdint>
 #include <limits>
+#include <chrono>
+#include <unordered_map>
 #include "tinyxml2.h"
+#include "../MappedFile.hpp"
 #include "import_uintah.h"
 
 using namespace pl;
@@ -15,6 +20,23 @@ struct UintahPatch {
 	vec3f lower;
 };
 
+/* A contiguous block of particle data of one variable and patch in a Uintah data file.
+ * The blocks are collected from the XML files first, such that the output arrays can be
+ * allocated once and all blocks can be decoded in parallel afterwards.
+ */
+struct UintahVariableBlock {
+	std::string variable;
+	std::string type;
+	std::string file_name;
+	size_t file_index = 0;
+	size_t start = 0;
+	size_t end = 0;
+	size_t num_particles = 0;
+	size_t patch = 0;
+	// Index of the first particle of this block in the output array
+	size_t offset = 0;
+};
+
 bool uintah_is_big_endian = false;
 
 std::string tinyxml_error_string(const XMLError e){
@@ -58,94 +80,281 @@ std::string tinyxml_error_string(const XMLError e){
 			return "XML_SUCCESS";
 	}
 }
-double ntohd(double d){
-	double ret = 0;
-	char *in = reinterpret_cast<char*>(&d);
-	char *out = reinterpret_cast<char*>(&ret);
-	for (int i = 0; i < 8; ++i){
-		out[i] = in[7 - i];
-	}
-	return ret;
+inline uint32_t byte_swap(const uint32_t x){
+#if defined(__GNUC__) || defined(__clang__)
+	return __builtin_bswap32(x);
+#else
+	return ((x & 0xFF000000u) >> 24) | ((x & 0x00FF0000u) >> 8)
+		| ((x & 0x0000FF00u) << 8) | ((x & 0x000000FFu) << 24);
+#endif
 }
-float ntohf(float f){
-	float ret = 0;
-	char *in = reinterpret_cast<char*>(&f);
-	char *out = reinterpret_cast<char*>(&ret);
-	for (int i = 0; i < 4; ++i){
-		out[i] = in[3 - i];
-	}
-	return ret;
+inline uint64_t byte_swap(const uint64_t x){
+#if defined(__GNUC__) || defined(__clang__)
+	return __builtin_bswap64(x);
+#else
+	return (uint64_t(byte_swap(uint32_t(x))) << 32) | uint64_t(byte_swap(uint32_t(x >> 32)));
+#endif
 }
-bool read_particles(const FileName &file_name, Data *pos_data, const size_t num_particles,
-		const size_t start, const size_t end) {
-	auto *positions = static_cast<DataT<float>*>(pos_data);
-	assert(positions);
-	// TODO: Would mmap'ing the file at the start and keeping each new file we encounter
-	// mapped be faster than fopen/fread/fclose?
-	FILE *fp = fopen(file_name.file_name.c_str(), "rb");
-	if (!fp){
-		std::cout << "Failed to open Uintah data file '" << file_name << "'\n";
-		return false;
-	}
-	fseek(fp, start, SEEK_SET);
-	size_t len = end - start;
-	if (len != num_particles * sizeof(double) * 3){
-		std::cout << "Length of data != expected length of particle data\n";
-		return false;
-		fclose(fp);
+
+template<size_t N> struct UnsignedOfSize;
+template<> struct UnsignedOfSize<4> { using type = uint32_t; };
+template<> struct UnsignedOfSize<8> { using type = uint64_t; };
+
+/* Converts n values of type In stored at the (possibly unaligned) address src to the type Out.
+ * The loops only consist of unaligned loads, byte shuffles and conversions and are vectorized.
+ */
+template<typename In, typename Out>
+void decode_values(const char *src, const size_t n, Out *dst, const bool swap_endianness){
+	using Bits = typename UnsignedOfSize<sizeof(In)>::type;
+	if (swap_endianness){
+		#pragma omp simd
+		for (size_t i = 0; i < n; ++i){
+			Bits bits;
+			std::memcpy(&bits, src + i * sizeof(In), sizeof(In));
+			bits = byte_swap(bits);
+			In value;
+			std::memcpy(&value, &bits, sizeof(In));
+			dst[i] = static_cast<Out>(value);
+		}
+	} else {
+		#pragma omp simd
+		for (size_t i = 0; i < n; ++i){
+			In value;
+			std::memcpy(&value, src + i * sizeof(In), sizeof(In));
+			dst[i] = static_cast<Out>(value);
+		}
 	}
+}
 
-	double position[3];
-	for (size_t i = 0; i < num_particles; ++i){
-		if (fread(position, sizeof(position), 1, fp) != 1){
-			std::cout << "Error reading particle from file\n";
-			fclose(fp);
+// Size in bytes of a single particle of the variable type, or 0 if the type is unsupported
+size_t uintah_particle_size(const UintahVariableBlock &block){
+	if (block.variable == "positions"){
+		return 3 * sizeof(double);
+	} else if (block.type == "ParticleVariable<double>"){
+		return sizeof(double);
+	} else if (block.type == "ParticleVariable<float>"){
+		return sizeof(float);
+	} else if (block.type == "ParticleVariable<long64>"){
+		return sizeof(int64_t);
+	}
+	return 0;
+}
+std::shared_ptr<Data> make_uintah_array(const UintahVariableBlock &block){
+	if (block.variable == "positions" || block.type == "ParticleVariable<float>"){
+		return std::make_shared<DataT<float>>();
+	} else if (block.type == "ParticleVariable<double>"){
+		return std::make_shared<DataT<double>>();
+	}
+	return std::make_shared<DataT<int64_t>>();
+}
+// Appends num_particles particles to the array and returns the previous number of particles
+size_t grow_uintah_array(const UintahVariableBlock &block, Data *array, const size_t num_particles){
+	if (block.variable == "positions"){
+		auto &data = static_cast<DataT<float>*>(array)->data;
+		const size_t old_size = data.size() / 3;
+		data.resize(data.size() + num_particles * 3);
+		return old_size;
+	} else if (block.type == "ParticleVariable<float>"){
+		auto &data = static_cast<DataT<float>*>(array)->data;
+		const size_t old_size = data.size();
+		data.resize(data.size() + num_particles);
+		return old_size;
+	} else if (block.type == "ParticleVariable<double>"){
+		auto &data = static_cast<DataT<double>*>(array)->data;
+		const size_t old_size = data.size();
+		data.resize(data.size() + num_particles);
+		return old_size;
+	}
+	auto &data = static_cast<DataT<int64_t>*>(array)->data;
+	const size_t old_size = data.size();
+	data.resize(data.size() + num_particles);
+	return old_size;
+}
+void decode_uintah_block(const UintahVariableBlock &block, const char *src, Data *out){
+	if (block.variable == "positions"){
+		auto positions = static_cast<DataT<float>*>(out);
+		decode_values<double, float>(src, block.num_particles * 3,
+				positions->data.data() + block.offset * 3, uintah_is_big_endian);
+	} else if (block.type == "ParticleVariable<double>"){
+		auto attribs = static_cast<DataT<double>*>(out);
+		decode_values<double, double>(src, block.num_particles,
+				attribs->data.data() + block.offset, uintah_is_big_endian);
+	} else if (block.type == "ParticleVariable<float>"){
+		auto attribs = static_cast<DataT<float>*>(out);
+		decode_values<float, float>(src, block.num_particles,
+				attribs->data.data() + block.offset, uintah_is_big_endian);
+	} else if (block.type == "ParticleVariable<long64>"){
+		auto attribs = static_cast<DataT<int64_t>*>(out);
+		decode_values<int64_t, int64_t>(src, block.num_particles,
+				attribs->data.data() + block.offset, uintah_is_big_endian);
+	}
+}
+// Validates the block sizes and assigns each block the index of its data file in file_names
+bool index_uintah_blocks(std::vector<UintahVariableBlock> &blocks, std::vector<std::string> &file_names){
+	std::unordered_map<std::string, size_t> file_indices;
+	for (UintahVariableBlock &b : blocks){
+		const size_t particle_size = uintah_particle_size(b);
+		if (particle_size == 0){
+			continue;
+		}
+		if (b.end < b.start || b.end - b.start != b.num_particles * particle_size){
+			std::cout << "Length of data != expected length of particle data\n";
 			return false;
 		}
-		if (uintah_is_big_endian){
-			position[0] = ntohd(position[0]);
-			position[1] = ntohd(position[1]);
-			position[2] = ntohd(position[2]);
+		auto it = file_indices.find(b.file_name);
+		if (it == file_indices.end()){
+			it = file_indices.insert(std::make_pair(b.file_name, file_names.size())).first;
+			file_names.push_back(b.file_name);
 		}
-		positions->data.push_back(static_cast<float>(position[0]));
-		positions->data.push_back(static_cast<float>(position[1]));
-		positions->data.push_back(static_cast<float>(position[2]));
+		b.file_index = it->second;
 	}
-	fclose(fp);
 	return true;
 }
-template<typename In, typename Out = In>
-bool read_particle_attribute(const FileName &file_name, Data *attrib_data, const size_t num_particles,
-		const size_t start, const size_t end){
-	auto attribs = static_cast<DataT<Out>*>(attrib_data);
-	// TODO: Would mmap'ing the file at the start and keeping each new file we encounter
-	// mapped be faster than fopen/fread/fclose?
-	FILE *fp = fopen(file_name.file_name.c_str(), "rb");
-	if (!fp){
-		std::cout << "Failed to open Uintah data file '" << file_name << "'\n";
-		return false;
+/* Presizes the output arrays of all variables in the blocks once and assigns the blocks their output
+ * offsets in file order. Existing arrays in the model are appended to.
+ */
+std::unordered_map<std::string, Data*> allocate_uintah_arrays(std::vector<UintahVariableBlock> &blocks,
+		ParticleModel &model)
+{
+	std::unordered_map<std::string, size_t> num_particles_per_variable;
+	for (UintahVariableBlock &b : blocks){
+		if (uintah_particle_size(b) != 0){
+			size_t &num_variable_particles = num_particles_per_variable[b.variable];
+			b.offset = num_variable_particles;
+			num_variable_particles += b.num_particles;
+		}
+	}
+
+	std::unordered_map<std::string, Data*> output_arrays;
+	std::unordered_map<std::string, size_t> base_offsets;
+	for (const UintahVariableBlock &b : blocks){
+		if (uintah_particle_size(b) == 0 || output_arrays.find(b.variable) != output_arrays.end()){
+			continue;
+		}
+		if (model.find(b.variable) == model.end()){
+			model[b.variable] = make_uintah_array(b);
+		}
+		Data *array = model[b.variable].get();
+		base_offsets[b.variable] = grow_uintah_array(b, array, num_particles_per_variable[b.variable]);
+		output_arrays[b.variable] = array;
 	}
-	fseek(fp, start, SEEK_SET);
-	size_t len = end - start;
-	if (len != num_particles * sizeof(In)){
-		std::cout << "Length of data != expected length of particle data\n";
+	for (UintahVariableBlock &b : blocks){
+		if (uintah_particle_size(b) != 0){
+			b.offset += base_offsets[b.variable];
+		}
+	}
+	return output_arrays;
+}
+// Decodes the blocks in parallel from the mapped data files (indexed by UintahVariableBlock::file_index)
+bool decode_uintah_blocks(const std::vector<UintahVariableBlock> &blocks,
+		const std::vector<const MappedFile*> &files,
+		const std::unordered_map<std::string, Data*> &output_arrays)
+{
+	bool success = true;
+	#pragma omp parallel for schedule(dynamic)
+	for (size_t i = 0; i < blocks.size(); ++i){
+		const UintahVariableBlock &b = blocks[i];
+		if (uintah_particle_size(b) == 0){
+			continue;
+		}
+		const MappedFile *file = files[b.file_index];
+		if (b.end > file->getSize()){
+			#pragma omp critical
+			{
+				std::cout << "Error reading particle data from file '" << b.file_name << "'\n";
+				success = false;
+			}
+			continue;
+		}
+		decode_uintah_block(b, file->getData() + b.start, output_arrays.at(b.variable));
+	}
+	return success;
+}
+/* Allocates the output arrays of all variables once, maps each referenced data file once
+ * and decodes all blocks in parallel into their final position in the output arrays.
+ */
+bool read_uintah_blocks(std::vector<UintahVariableBlock> &blocks, ParticleModel &model){
+	std::vector<std::string> file_names;
+	if (!index_uintah_blocks(blocks, file_names)){
 		return false;
-		fclose(fp);
+	}
+	const bool has_positions = model.find("positions") != model.end();
+	std::unordered_map<std::string, Data*> output_arrays = allocate_uintah_arrays(blocks, model);
+	if (!has_positions && model.find("positions") != model.end()){
+		std::cout << "new positions array\n";
 	}
 
-	std::vector<In> data(num_particles, In());
-	if (fread(data.data(), sizeof(In), num_particles, fp) != num_particles){
-		std::cout << "Error reading particle attribute from file\n";
-		fclose(fp);
+	// Map each data file exactly once (read-only)
+	std::vector<MappedFile> files(file_names.size());
+	std::vector<const MappedFile*> file_ptrs(file_names.size());
+	for (size_t i = 0; i < file_names.size(); ++i){
+		if (!files[i].open(file_names[i])){
+			std::cout << "Failed to open Uintah data file '" << file_names[i] << "'\n";
+			return false;
+		}
+		file_ptrs[i] = &files[i];
+	}
+	return decode_uintah_blocks(blocks, file_ptrs, output_arrays);
+}
+/* Decodes the data file by data file and patch by patch. Only one data file is mapped at a time and
+ * only the particles of the patches of this file are kept in memory.
+ */
+bool stream_uintah_blocks(std::vector<UintahVariableBlock> &blocks,
+		const std::function<void(const ParticleModel&)> &callback)
+{
+	std::vector<std::string> file_names;
+	if (!index_uintah_blocks(blocks, file_names)){
 		return false;
 	}
-	fclose(fp);
-	std::transform(data.begin(), data.end(), std::back_inserter(attribs->data),
-			[](const In &t){ return static_cast<Out>(t); });
+
+	// Group the blocks by data file and patch (keeping the order of the patches in the file)
+	std::vector<std::vector<std::vector<UintahVariableBlock>>> file_patches(file_names.size());
+	std::vector<std::unordered_map<size_t, size_t>> patch_indices(file_names.size());
+	for (const UintahVariableBlock &b : blocks){
+		if (uintah_particle_size(b) == 0){
+			continue;
+		}
+		auto &patches = file_patches[b.file_index];
+		auto it = patch_indices[b.file_index].find(b.patch);
+		if (it == patch_indices[b.file_index].end()){
+			it = patch_indices[b.file_index].insert(std::make_pair(b.patch, patches.size())).first;
+			patches.push_back(std::vector<UintahVariableBlock>());
+		}
+		patches[it->second].push_back(b);
+	}
+
+	std::vector<const MappedFile*> file_ptrs(file_names.size(), nullptr);
+	for (size_t file_index = 0; file_index < file_names.size(); ++file_index){
+		MappedFile file;
+		if (!file.open(file_names[file_index])){
+			std::cout << "Failed to open Uintah data file '" << file_names[file_index] << "'\n";
+			return false;
+		}
+		file_ptrs[file_index] = &file;
+
+		auto &patches = file_patches[file_index];
+		std::vector<ParticleModel> patch_models(patches.size());
+		bool success = true;
+		#pragma omp parallel for schedule(dynamic)
+		for (size_t i = 0; i < patches.size(); ++i){
+			auto output_arrays = allocate_uintah_arrays(patches[i], patch_models[i]);
+			if (!decode_uintah_blocks(patches[i], file_ptrs, output_arrays)){
+				#pragma omp critical
+				success = false;
+			}
+		}
+		file_ptrs[file_index] = nullptr;
+		if (!success){
+			return false;
+		}
+		for (ParticleModel &patch_model : patch_models){
+			callback(patch_model);
+		}
+	}
 	return true;
 }
 bool read_uintah_particle_variable(const FileName &base_path, XMLElement *elem,
-		ParticleModel &model)
+		std::vector<UintahVariableBlock> &blocks)
 {
 	std::string type;
 	{
@@ -219,42 +428,25 @@ bool read_uintah_particle_variable(const FileName &base_path, XMLElement *elem,
 		}
 	}
 	if (num_particles > 0){
-		if (variable == "p.x") {
-			variable = "positions";
-		}
-		const bool need_new_array = model.find(variable) == model.end();
 		// Particle positions are p.x, rename them to position when we load them
 		// TODO: This should handle arbitrary ParticleVariable<Point> types
-		if (variable == "positions"){
-			if (need_new_array) {
-				std::cout << "new positions array\n";
-				model["positions"] = std::make_shared<DataT<float>>();
-			}
-			return read_particles(base_path.join(FileName(file_name)),
-					model["positions"].get(), num_particles, start, end);
-		} else if (type == "ParticleVariable<double>"){
-			if (need_new_array) {
-				model[variable] = std::make_shared<DataT<double>>();
-			}
-			return read_particle_attribute<double>(base_path.join(FileName(file_name)),
-					model[variable].get(), num_particles, start, end);
-		} else if (type == "ParticleVariable<float>"){
-			if (need_new_array) {
-				model[variable] = std::make_shared<DataT<float>>();
-			}
-			return read_particle_attribute<float>(base_path.join(FileName(file_name)),
-					model[variable].get(), num_particles, start, end);
-		} else if (type == "ParticleVariable<long64>"){
-			if (need_new_array) {
-				model[variable] = std::make_shared<DataT<int64_t>>();
-			}
-			return read_particle_attribute<int64_t>(base_path.join(FileName(file_name)),
-					model[variable].get(), num_particles, start, end);
+		if (variable == "p.x") {
+			variable = "positions";
 		}
+		UintahVariableBlock block;
+		block.variable = variable;
+		block.type = type;
+		block.file_name = base_path.join(FileName(file_name)).file_name;
+		block.start = start;
+		block.end = end;
+		block.num_particles = num_particles;
+		block.patch = patch;
+		blocks.push_back(block);
 	}
 	return true;
 }
-bool read_uintah_datafile(const FileName &file_name, XMLDocument &doc, ParticleModel &model){
+bool read_uintah_datafile(const FileName &file_name, XMLDocument &doc,
+		std::vector<UintahVariableBlock> &blocks){
 	XMLElement *node = doc.FirstChildElement("Uintah_Output");
 	const static std::string VAR_TYPE = "ParticleVariable";
 	for (XMLNode *c = node->FirstChild(); c; c = c->NextSibling()){
@@ -269,7 +461,7 @@ bool read_uintah_datafile(const FileName &file_name, XMLDocument &doc, ParticleM
 		}
 		std::string var_type = e->Attribute("type");
 		if (var_type.substr(0, VAR_TYPE.size()) == VAR_TYPE){
-			if (!read_uintah_particle_variable(file_name.path(), e, model)){
+			if (!read_uintah_particle_variable(file_name.path(), e, blocks)){
 				return false;
 			}
 		}
@@ -310,8 +502,9 @@ bool read_uintah_patches(XMLNode *node, std::vector<UintahPatch> &patches) {
 	return true;
 }
 bool read_uintah_timestep_data(const FileName &base_path, XMLNode *node,
-		ParticleModel &model)
+		std::vector<UintahVariableBlock> &blocks)
 {
+	std::vector<FileName> data_files;
 	for (XMLNode *c = node->FirstChild(); c; c = c->NextSibling()){
 		if (std::string(c->Value()) == "Datafile"){
 			XMLElement *e = c->ToElement();
@@ -324,24 +517,47 @@ bool read_uintah_timestep_data(const FileName &base_path, XMLNode *node,
 				std::cout << "Error parsing Uintah timestep data: Missing file href\n";
 				return false;
 			}
-			FileName data_file = base_path.join(FileName(std::string(href)));
-			std::cout << "Reading " << data_file << "\n";
-			XMLDocument doc;
-			XMLError err = doc.LoadFile(data_file.file_name.c_str());
-			if (err != XML_SUCCESS){
+			data_files.push_back(base_path.join(FileName(std::string(href))));
+		}
+	}
+
+	// The XML files of the data files are independent of each other and parsed in parallel
+	std::vector<std::vector<UintahVariableBlock>> data_file_blocks(data_files.size());
+	bool success = true;
+	#pragma omp parallel for schedule(dynamic)
+	for (size_t i = 0; i < data_files.size(); ++i){
+		const FileName &data_file = data_files[i];
+		XMLDocument doc;
+		XMLError err = doc.LoadFile(data_file.file_name.c_str());
+		if (err != XML_SUCCESS){
+			#pragma omp critical
+			{
 				std::cout << "Error loading Uintah data file '" << data_file << "': "
 					<< tinyxml_error_string(err) << "\n";
-				return false;
+				success = false;
 			}
-			if (!read_uintah_datafile(data_file, doc, model)){
+			continue;
+		}
+		if (!read_uintah_datafile(data_file, doc, data_file_blocks[i])){
+			#pragma omp critical
+			{
 				std::cout << "Error reading Uintah data file " << data_file << "\n";
-				return false;
+				success = false;
 			}
 		}
 	}
+	if (!success){
+		return false;
+	}
+	std::cout << "Read " << data_files.size() << " Uintah data file descriptions\n";
+
+	for (std::vector<UintahVariableBlock> &file_blocks : data_file_blocks){
+		blocks.insert(blocks.end(), file_blocks.begin(), file_blocks.end());
+	}
 	return true;
 }
-bool read_uintah_timestep(const FileName &file_name, XMLElement *node, ParticleModel &model){
+bool read_uintah_timestep(const FileName &file_name, XMLElement *node,
+		std::vector<UintahVariableBlock> &blocks){
 	std::vector<UintahPatch> patches;
 	for (XMLNode *c = node->FirstChild(); c; c = c->NextSibling()){
 		std::cout << c->Value() << "\n" << std::flush;
@@ -353,14 +569,14 @@ bool read_uintah_timestep(const FileName &file_name, XMLElement *node, ParticleM
 		}
 	}
 	XMLNode *c = node->FirstChildElement("Data");
-	if (!c || !read_uintah_timestep_data(file_name.path(), c, model)){
+	if (!c || !read_uintah_timestep_data(file_name.path(), c, blocks)){
 		return false;
 	}
 	return true;
 }
 
-void pl::import_uintah(const FileName &file_name, ParticleModel &model){
-	std::cout << "Importing Uintah data from " << file_name << "\n";
+// Reads the descriptions of all particle blocks referenced by the Uintah XML file
+void read_uintah_block_list(const FileName &file_name, std::vector<UintahVariableBlock> &blocks){
 	XMLDocument doc;
 	XMLError err = doc.LoadFile(file_name.file_name.c_str());
 	if (err != XML_SUCCESS){
@@ -369,12 +585,12 @@ void pl::import_uintah(const FileName &file_name, ParticleModel &model){
 		throw std::runtime_error("Failed to open XML file");
 	}
 	if (doc.FirstChildElement("Uintah_timestep")) {
-		if (!read_uintah_timestep(file_name, doc.FirstChildElement("Uintah_timestep"), model)) {
+		if (!read_uintah_timestep(file_name, doc.FirstChildElement("Uintah_timestep"), blocks)) {
 			std::cout << "Error reading Uintah timestep\n";
 			throw std::runtime_error("Failed to read Uintah timestep");
 		}
 	} else if (doc.FirstChildElement("Uintah_Output")) {
-		if (!read_uintah_datafile(file_name, doc, model)) {
+		if (!read_uintah_datafile(file_name, doc, blocks)) {
 			std::cout << "Error reading Uintah Output\n";
 			throw std::runtime_error("Failed to read Uintah output");
 		}
@@ -382,6 +598,20 @@ void pl::import_uintah(const FileName &file_name, ParticleModel &model){
 		std::cout << "Unrecognized UDA XML file!\n";
 		throw std::runtime_error("Failed to read Uintah data");
 	}
+}
+
+void pl::import_uintah(const FileName &file_name, ParticleModel &model){
+	std::cout << "Importing Uintah data from " << file_name << "\n";
+	const auto start_time = std::chrono::steady_clock::now();
+	std::vector<UintahVariableBlock> blocks;
+	read_uintah_block_list(file_name, blocks);
+	if (!read_uintah_blocks(blocks, model)) {
+		std::cout << "Error reading Uintah particle data\n";
+		throw std::runtime_error("Failed to read Uintah particle data");
+	}
+	const auto end_time = std::chrono::steady_clock::now();
+	std::cout << "Decoded " << blocks.size() << " Uintah particle blocks in "
+		<< std::chrono::duration<double>(end_time - start_time).count() << "s\n";
 	if (model.find("positions") != model.end()) {
 		auto positions = static_cast<DataT<float>*>(model["positions"].get());
 		std::cout << "Read Uintah data with " << positions->data.size() / 3 << " particles\n";
@@ -390,3 +620,14 @@ void pl::import_uintah(const FileName &file_name, ParticleModel &model){
 	}
 }
 
+void pl::import_uintah_patches(const FileName &file_name,
+		const std::function<void(const ParticleModel&)> &callback)
+{
+	std::cout << "Streaming Uintah data from " << file_name << "\n";
+	std::vector<UintahVariableBlock> blocks;
+	read_uintah_block_list(file_name, blocks);
+	if (!stream_uintah_blocks(blocks, callback)) {
+		std::cout << "Error reading Uintah particle data\n";
+		throw std::runtime_error("Failed to read Uintah particle data");
+	}
+}
@@ -2,11 +2,17 @@
 
 #include <string>
 #include <vector>
+#include <functional>
 #include "types.h"
 
 namespace pl {
 
 void import_uintah(const FileName &file_name, ParticleModel &model);
 
+// Import the data set patch by patch. The callback receives a model containing only the particles of one
+// patch, such that data sets larger than the main memory can be processed.
+void import_uintah_patches(const FileName &file_name,
+		const std::function<void(const ParticleModel&)> &callback);
+
 }
 
@@ -5,16 +5,79 @@
 #define _FILE_OFFSET_BITS 64
 
 #include <cstdio>
+#include <algorithm>
 #include <boost/algorithm/string/case_conv.hpp>
 #include <boost/algorithm/string/predicate.hpp>
 #include <Utils/File/Logfile.hpp>
 #include <Math/Geometry/AABB3.hpp>
-#include <Utils/Events/Stream/Stream.hpp>
 #include "NetCDFConverter.hpp"
+#include "BinLinesFile.hpp"
 #include "TrajectoryFile.hpp"
 #include <iostream>
 
-Trajectories loadTrajectoriesFromFile(const std::string &filename, TrajectoryType trajectoryType)
+void Trajectories::clear(size_t numAttributes)
+{
+    positions.clear();
+    attributes.clear();
+    attributes.resize(numAttributes);
+    lineOffsets.clear();
+    lineOffsets.push_back(0);
+}
+
+void Trajectories::reserve(size_t numLines, size_t numPoints)
+{
+    lineOffsets.reserve(numLines + 1);
+    positions.reserve(numPoints);
+    for (std::vector<float> &attribute : attributes) {
+        attribute.reserve(numPoints);
+    }
+}
+
+void Trajectories::allocateLines(const std::vector<size_t> &lineNumPoints, size_t numAttributes)
+{
+    clear(numAttributes);
+    lineOffsets.resize(lineNumPoints.size() + 1);
+    for (size_t i = 0; i < lineNumPoints.size(); i++) {
+        lineOffsets[i + 1] = lineOffsets[i] + lineNumPoints[i];
+    }
+    positions.resize(lineOffsets.back());
+    for (std::vector<float> &attribute : attributes) {
+        attribute.resize(lineOffsets.back());
+    }
+}
+
+void Trajectories::removeShortLines(size_t minNumPoints)
+{
+    // Compacts the arrays in place (the write position never overtakes the read position).
+    size_t numLinesNew = 0;
+    size_t numPointsNew = 0;
+    const size_t numLines = size();
+    for (size_t lineIdx = 0; lineIdx < numLines; lineIdx++) {
+        const size_t readOffset = lineOffsets[lineIdx];
+        const size_t numPoints = lineOffsets[lineIdx + 1] - readOffset;
+        if (numPoints < minNumPoints) {
+            continue;
+        }
+        if (readOffset != numPointsNew) {
+            std::copy(positions.begin() + readOffset, positions.begin() + readOffset + numPoints,
+                      positions.begin() + numPointsNew);
+            for (std::vector<float> &attribute : attributes) {
+                std::copy(attribute.begin() + readOffset, attribute.begin() + readOffset + numPoints,
+                          attribute.begin() + numPointsNew);
+            }
+        }
+        numPointsNew += numPoints;
+        numLinesNew++;
+        lineOffsets[numLinesNew] = numPointsNew;
+    }
+    lineOffsets.resize(numLinesNew + 1);
+    positions.resize(numPointsNew);
+    for (std::vector<float> &attribute : attributes) {
+        attribute.resize(numPointsNew);
+    }
+}
+
+Trajectories loadTrajectoriesFromFile(const std::string &filename, TrajectoryType trajectoryType, bool validate)
 {
     Trajectories trajectories;
 
@@ -24,14 +87,12 @@ Trajectories loadTrajectoriesFromFile(const std::string &filename, TrajectoryTyp
     } else if (boost::ends_with(lowerCaseFilename, ".nc")) {
         trajectories = loadTrajectoriesFromNetCdf(filename, trajectoryType);
     } else if (boost::ends_with(lowerCaseFilename, ".binlines")) {
-        trajectories = loadTrajectoriesFromBinLines(filename, trajectoryType);
+        trajectories = loadTrajectoriesFromBinLines(filename, trajectoryType, validate);
     }
 
     sgl::AABB3 boundingBox;
-    for (Trajectory &trajectory : trajectories) {
-        for (glm::vec3 &position : trajectory.positions) {
-            boundingBox.combine(position);
-        }
+    for (const glm::vec3 &position : trajectories.positions) {
+        boundingBox.combine(position);
     }
 
     bool isConvectionRolls = trajectoryType == TRAJECTORY_TYPE_CONVECTION_ROLLS_NEW;
@@ -53,13 +114,10 @@ Trajectories loadTrajectoriesFromFile(const std::string &filename, TrajectoryTyp
         minVec = glm::vec3(glm::min(boundingBox.getMinimum().x, std::min(boundingBox.getMinimum().y, boundingBox.getMinimum().z)));
         maxVec = glm::vec3(glm::max(boundingBox.getMaximum().x, std::max(boundingBox.getMaximum().y, boundingBox.getMaximum().z)));
 
-        for(const Trajectory& traj : trajectories)
+        for (const float &attr : trajectories.attributes[0])
         {
-            for (const float& attr : traj.attributes[0])
-            {
-                minAttr = std::min(minAttr, attr);
-                maxAttr = std::max(maxAttr, attr);
-            }
+            minAttr = std::min(minAttr, attr);
+            maxAttr = std::max(maxAttr, attr);
         }
 
     } else {
@@ -71,28 +129,25 @@ Trajectories loadTrajectoriesFromFile(const std::string &filename, TrajectoryTyp
     }
 
     if (isRings || isConvectionRolls || isCfdData || isUCLA) {
-        for (Trajectory &trajectory : trajectories) {
-            for (glm::vec3 &position : trajectory.positions) {
-                position = (position - minVec) / (maxVec - minVec);
-                if (isConvectionRolls || isCfdData) {
-                    glm::vec3 dims = glm::vec3(1);
-                    dims.y = boundingBox.getDimensions().y;
-                    position -= dims;
-                }
+        glm::vec3 *positions = trajectories.positions.data();
+        glm::vec3 dims = glm::vec3(1);
+        dims.y = boundingBox.getDimensions().y;
+        const bool shiftPositions = isConvectionRolls || isCfdData;
+        trajectories.forEachPointParallel([&](size_t i) {
+            positions[i] = (positions[i] - minVec) / (maxVec - minVec);
+            if (shiftPositions) {
+                positions[i] -= dims;
             }
-        }
+        });
     }
 
     // if UCLA --> normalize attributes
     if (isUCLA)
     {
-        for(Trajectory& traj : trajectories)
-        {
-            for (float& attr : traj.attributes[0])
-            {
-                attr = (attr - minAttr) / (maxAttr - minAttr);
-            }
-        }
+        float *attributes = trajectories.attributes[0].data();
+        trajectories.forEachPointParallel([&](size_t i) {
+            attributes[i] = (attributes[i] - minAttr) / (maxAttr - minAttr);
+        });
     }
 
     return trajectories;
@@ -104,6 +159,7 @@ Trajectories loadTrajectoriesFromObj(const std::string &filename, TrajectoryType
     bool isRings = trajectoryType == TRAJECTORY_TYPE_RINGS;
     bool isUCLA = trajectoryType == TRAJECTORY_TYPE_UCLA;
     Trajectories trajectories;
+    trajectories.clear(1);
 
     std::vector<glm::vec3> globalLineVertices;
     std::vector<float> globalLineVertexAttributes;
@@ -129,6 +185,7 @@ Trajectories loadTrajectoriesFromObj(const std::string &filename, TrajectoryType
     fclose(file);
     std::string lineBuffer;
     std::string numberString;
+    std::vector<uint32_t> currentLineIndices;
 
     for (size_t charPtr = 0; charPtr < length; ) {
         while (charPtr < length) {
@@ -180,7 +237,7 @@ Trajectories loadTrajectoriesFromObj(const std::string &filename, TrajectoryType
             globalLineVertices.push_back(position);
         } else if (command == 'l') {
             // Get indices of current path line
-            std::vector<uint32_t> currentLineIndices;
+            currentLineIndices.clear();
             for (size_t linePtr = 2; linePtr < lineBuffer.size(); linePtr++) {
                 char currentChar = lineBuffer.at(linePtr);
                 bool isWhitespace = currentChar == ' ' || currentChar == '\t';
@@ -196,11 +253,8 @@ Trajectories loadTrajectoriesFromObj(const std::string &filename, TrajectoryType
                 numberString.clear();
             }
 
-            Trajectory trajectory;
-
-            std::vector<float> pathLineVorticities;
-            trajectory.positions.reserve(currentLineIndices.size());
-            pathLineVorticities.reserve(currentLineIndices.size());
+            // The points are appended directly to the flat point arrays of the trajectories.
+            std::vector<float> &pathLineVorticities = trajectories.attributes.front();
             for (size_t i = 0; i < currentLineIndices.size(); i++) {
                 glm::vec3 pos = globalLineVertices.at(currentLineIndices.at(i));
 
@@ -210,13 +264,11 @@ Trajectories loadTrajectoriesFromObj(const std::string &filename, TrajectoryType
                     continue;
                 }
 
-                trajectory.positions.push_back(globalLineVertices.at(currentLineIndices.at(i)));
+                trajectories.positions.push_back(pos);
                 pathLineVorticities.push_back(globalLineVertexAttributes.at(currentLineIndices.at(i)));
             }
 
-            // Compute importance criteria
-            computeTrajectoryAttributes(
-                    trajectoryType, trajectory.positions, pathLineVorticities, trajectory.attributes);
+            // The importance criteria are computed for all trajectories in parallel after parsing
 
             // Line filtering for WCB trajectories
             //if (trajectoryType == TRAJECTORY_TYPE_WCB) {
@@ -225,7 +277,7 @@ Trajectories loadTrajectoriesFromObj(const std::string &filename, TrajectoryType
             //  }
             //}
 
-            trajectories.push_back(trajectory);
+            trajectories.lineOffsets.push_back(trajectories.positions.size());
         } else if (command = '#') {
             // Ignore comments
         } else {
@@ -235,13 +287,13 @@ Trajectories loadTrajectoriesFromObj(const std::string &filename, TrajectoryType
         lineBuffer.clear();
     }
 
+    // Compute importance criteria
+    computeTrajectoriesImportanceCriteria(trajectories, trajectoryType);
+
     // compute byte size of raw representation with 1 attribute for paper
     uint64_t byteSize = 0;
-    for (const auto& traj : trajectories)
-    {
-        byteSize += traj.positions.size() * sizeof(float) * 3;
-        byteSize += traj.attributes[0].size() * sizeof(float);
-    }
+    byteSize += trajectories.positions.size() * sizeof(float) * 3;
+    byteSize += trajectories.attributes[0].size() * sizeof(float);
 
     byteSize = byteSize / 1024 / 1024;
     std::cout << "Raw byte size of obj file: " << byteSize << "MB" << std::endl << std::flush;
@@ -252,64 +304,65 @@ Trajectories loadTrajectoriesFromObj(const std::string &filename, TrajectoryType
 Trajectories loadTrajectoriesFromNetCdf(const std::string &filename, TrajectoryType trajectoryType) {
     Trajectories trajectories = loadNetCdfFile(filename);
 
-    for (Trajectory &trajectory : trajectories) {
-        // Compute importance criteria
-        std::vector<float> oldAttributes = trajectory.attributes.at(0);
-        trajectory.attributes.clear();
-        computeTrajectoryAttributes(
-                trajectoryType, trajectory.positions, oldAttributes, trajectory.attributes);
-    }
+    // Compute importance criteria
+    computeTrajectoriesImportanceCriteria(trajectories, trajectoryType);
 
     return trajectories;
 }
 
-Trajectories loadTrajectoriesFromBinLines(const std::string &filename, TrajectoryType trajectoryType) {
-    Trajectories trajectories;
-
-    std::ifstream file(filename.c_str(), std::ifstream::binary);
-    if (!file.is_open()) {
-        sgl::Logfile::get()->writeError(std::string() + "Error in loadTrajectoriesFromBinLines: File \""
-                + filename + "\" not found.");
-        return trajectories;
+void computeTrajectoriesImportanceCriteria(Trajectories &trajectories, TrajectoryType trajectoryType) {
+    if (trajectories.attributes.empty()) {
+        return;
     }
-
-    file.seekg(0, file.end);
-    size_t size = file.tellg();
-    file.seekg(0);
-    char *buffer = new char[size];
-    file.read(buffer, size);
-
-    // Read format version
-    sgl::BinaryReadStream stream(buffer, size);
-    const uint32_t LINE_FILE_FORMAT_VERSION = 1u;
-    uint32_t versionNumber;
-    stream.read(versionNumber);
-    if (versionNumber != LINE_FILE_FORMAT_VERSION) {
-        sgl::Logfile::get()->writeError(std::string()
-                + "Error in loadTrajectoriesFromBinLines: Invalid magic number in file \"" + filename + "\".");
-        return trajectories;
+    const uint32_t criteriaMask = getImportanceCriteriaMask(trajectoryType);
+    const int numCriteria = getNumImportanceCriteria(criteriaMask);
+    const size_t numPoints = trajectories.getNumPoints();
+
+    // The raw attribute array is reused as the output array of the attribute criterion (may alias).
+    std::vector<float> rawAttributes = std::move(trajectories.attributes.at(0));
+    trajectories.attributes.clear();
+    trajectories.attributes.resize(numCriteria);
+    int outputIdx = 0;
+    if ((criteriaMask & IMPORTANCE_CRITERION_BIT_ATTRIBUTE) != 0) {
+        trajectories.attributes.at(0) = std::move(rawAttributes);
+        outputIdx++;
+    }
+    for (int i = outputIdx; i < numCriteria; i++) {
+        trajectories.attributes.at(i).resize(numPoints);
     }
+    const float *attributes = outputIdx > 0 ? trajectories.attributes.at(0).data() : rawAttributes.data();
 
+    trajectories.forEachLineParallel([&](size_t lineIdx) {
+        const size_t offset = trajectories.getLineOffset(lineIdx);
+        float *outputArrays[8];
+        for (int i = 0; i < numCriteria; i++) {
+            outputArrays[i] = trajectories.attributes.at(i).data() + offset;
+        }
+        computeImportanceCriteriaFused(
+                trajectories.getLineNumPoints(lineIdx), trajectories.positions.data() + offset,
+                attributes + offset, criteriaMask, outputArrays);
+    });
+}
 
+Trajectories loadTrajectoriesFromBinLines(
+        const std::string &filename, TrajectoryType trajectoryType, bool validate) {
+    Trajectories trajectories;
 
-    // Rest of header after format version
-    uint32_t numTrajectories, numAttributes, trajectoryNumPoints;
-    stream.read(numTrajectories);
-    stream.read(numAttributes);
-    trajectories.resize(numTrajectories);
+    // The file is memory-mapped, i.e., the line data is copied once (in parallel) from the mapping to the final flat
+    // arrays without an intermediate file buffer.
+    BinLinesFile binLinesFile;
+    if (!binLinesFile.open(filename)) {
+        return trajectories;
+    }
 
-    for (uint32_t trajectoryIndex = 0; trajectoryIndex < numTrajectories; trajectoryIndex++) {
-        Trajectory &currentTrajectory = trajectories.at(trajectoryIndex);
-        stream.read(trajectoryNumPoints);
-        currentTrajectory.positions.resize(trajectoryNumPoints);
-        stream.read((void*)&currentTrajectory.positions.front(), sizeof(glm::vec3)*trajectoryNumPoints);
-        currentTrajectory.attributes.resize(numAttributes);
-        for (uint32_t attributeIndex = 0; attributeIndex < numAttributes; attributeIndex++) {
-            std::vector<float> &currentAttribute = currentTrajectory.attributes.at(attributeIndex);
-            currentAttribute.resize(trajectoryNumPoints);
-            stream.read((void*)&currentAttribute.front(), sizeof(float)*trajectoryNumPoints);
+    if (validate) {
+        size_t numInvalidPoints = binLinesFile.countInvalidPoints();
+        if (numInvalidPoints > 0) {
+            sgl::Logfile::get()->writeInfo(std::string() + "Warning in loadTrajectoriesFromBinLines: File \""
+                    + filename + "\" contains " + std::to_string(numInvalidPoints) + " invalid points.");
         }
     }
 
+    binLinesFile.copyToTrajectories(trajectories);
     return trajectories;
 }
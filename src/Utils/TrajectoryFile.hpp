@@ -7,28 +7,127 @@
 
 #include <string>
 #include <vector>
+#include <cstddef>
 #include <glm/glm.hpp>
 #include "Utils/ImportanceCriteria.hpp"
 
-struct Trajectory {
+/**
+ * Non-owning view of a contiguous array (like std::span in C++20).
+ */
+template<class T>
+class ArrayView {
+public:
+    ArrayView() : ptr(nullptr), n(0) {}
+    ArrayView(T *ptr, size_t n) : ptr(ptr), n(n) {}
+
+    inline T *data() const { return ptr; }
+    inline size_t size() const { return n; }
+    inline bool empty() const { return n == 0; }
+    inline T &operator[](size_t i) const { return ptr[i]; }
+    inline T &front() const { return ptr[0]; }
+    inline T &back() const { return ptr[n-1]; }
+    inline T *begin() const { return ptr; }
+    inline T *end() const { return ptr + n; }
+
+private:
+    T *ptr;
+    size_t n;
+};
+
+/**
+ * Flat structure-of-arrays container for a set of trajectories (lines). The positions of all lines are stored in one
+ * array and each attribute in one array of the same size. Line i consists of the points [lineOffsets[i],
+ * lineOffsets[i+1]). Compared to one vector per line and attribute, this avoids millions of small allocations when
+ * loading large data sets and allows consumers to process all points in one pass.
+ */
+struct Trajectories {
     std::vector<glm::vec3> positions;
     std::vector<std::vector<float>> attributes;
-};
+    std::vector<size_t> lineOffsets = { 0 };
+
+    inline size_t size() const { return lineOffsets.size() - 1; }
+    inline bool empty() const { return lineOffsets.size() <= 1; }
+    inline size_t getNumPoints() const { return positions.size(); }
+    inline size_t getNumAttributes() const { return attributes.size(); }
+    inline size_t getLineOffset(size_t lineIdx) const { return lineOffsets[lineIdx]; }
+    inline size_t getLineNumPoints(size_t lineIdx) const { return lineOffsets[lineIdx+1] - lineOffsets[lineIdx]; }
 
-typedef std::vector<Trajectory> Trajectories;
+    // Per-line views of the point data
+    inline ArrayView<glm::vec3> getLinePositions(size_t lineIdx) {
+        return ArrayView<glm::vec3>(positions.data() + lineOffsets[lineIdx], getLineNumPoints(lineIdx));
+    }
+    inline ArrayView<const glm::vec3> getLinePositions(size_t lineIdx) const {
+        return ArrayView<const glm::vec3>(positions.data() + lineOffsets[lineIdx], getLineNumPoints(lineIdx));
+    }
+    inline ArrayView<float> getLineAttribute(size_t lineIdx, size_t attributeIdx) {
+        return ArrayView<float>(attributes[attributeIdx].data() + lineOffsets[lineIdx], getLineNumPoints(lineIdx));
+    }
+    inline ArrayView<const float> getLineAttribute(size_t lineIdx, size_t attributeIdx) const {
+        return ArrayView<const float>(
+                attributes[attributeIdx].data() + lineOffsets[lineIdx], getLineNumPoints(lineIdx));
+    }
+
+    /// Removes all lines and sets the number of attributes per point.
+    void clear(size_t numAttributes = 0);
+    void reserve(size_t numLines, size_t numPoints);
+    /**
+     * Allocates the point data of all lines at once (e.g., to fill the lines in parallel afterwards).
+     * @param lineNumPoints: The number of points of each line.
+     */
+    void allocateLines(const std::vector<size_t> &lineNumPoints, size_t numAttributes);
+    /// Removes all lines with less than minNumPoints points.
+    void removeShortLines(size_t minNumPoints);
+
+    /**
+     * Calls function(lineIdx) for all lines in parallel. The lines differ a lot in length, thus dynamic scheduling is
+     * used.
+     */
+    template<class Function>
+    void forEachLineParallel(Function function) const {
+        const size_t numLines = size();
+        #pragma omp parallel for schedule(dynamic, 64)
+        for (size_t lineIdx = 0; lineIdx < numLines; lineIdx++) {
+            function(lineIdx);
+        }
+    }
+
+    /// Calls function(pointIdx) for all points in parallel.
+    template<class Function>
+    void forEachPointParallel(Function function) const {
+        const size_t numPoints = getNumPoints();
+        #pragma omp parallel for
+        for (size_t pointIdx = 0; pointIdx < numPoints; pointIdx++) {
+            function(pointIdx);
+        }
+    }
+};
 
 /**
  * Selects loadTrajectoriesFromObj, loadTrajectoriesFromNetCdf or loadTrajectoriesFromBinLines depending on the file
  * endings and performs some normalization for special datasets (e.g. the rings dataset).
  * @param filename The name of the trajectory file to open.
+ * @param validate Whether to scan .binlines files for invalid points (see loadTrajectoriesFromBinLines).
  * @return The trajectories loaded from the file (empty if the file could not be opened).
  */
-Trajectories loadTrajectoriesFromFile(const std::string &filename, TrajectoryType trajectoryType);
+Trajectories loadTrajectoriesFromFile(
+        const std::string &filename, TrajectoryType trajectoryType, bool validate = false);
 
 Trajectories loadTrajectoriesFromObj(const std::string &filename, TrajectoryType trajectoryType);
 
 Trajectories loadTrajectoriesFromNetCdf(const std::string &filename, TrajectoryType trajectoryType);
 
-Trajectories loadTrajectoriesFromBinLines(const std::string &filename, TrajectoryType trajectoryType);
+/**
+ * Loads a memory-mapped .binlines file (see BinLinesFile).
+ * @param validate Whether to scan all points for invalid positions in parallel and print a warning if some are found
+ * (the line declared point counts are always checked against the file size).
+ */
+Trajectories loadTrajectoriesFromBinLines(
+        const std::string &filename, TrajectoryType trajectoryType, bool validate = false);
+
+/**
+ * Replaces the raw vertex attribute (stored in attributes[0]) of all trajectories by the importance criteria used for
+ * the passed trajectory type. The trajectories are processed in parallel using the fused importance criteria kernel.
+ */
+void computeTrajectoriesImportanceCriteria(Trajectories &trajectories, TrajectoryType trajectoryType);
 
 #endif //PIXELSYNCOIT_TRAJECTORYFILE_HPP
@@ -20,7 +20,8 @@
 
 using namespace sgl;
 
-static std::vector<glm::vec2> circlePoints2D;
+// Thread-local, as trajectories may be converted on the background threads of the asset cache
+static thread_local std::vector<glm::vec2> circlePoints2D;
 
 void getPointsOnCircle(std::vector<glm::vec2> &points, const glm::vec2 &center, float radius, int numSegments)
 {
@@ -46,6 +47,48 @@ void initializeCircleData(int numSegments, float radius)
     getPointsOnCircle(circlePoints2D, glm::vec2(0.0f, 0.0f), radius, numSegments);
 }
 
+void createTubeIndices(uint32_t numNodes, uint32_t numCirclePoints, uint32_t firstVertex, uint32_t *indices)
+{
+    uint32_t *index = indices;
+    for (uint32_t i = 0; i + 1 < numNodes; i++) {
+        const uint32_t current = firstVertex + i * numCirclePoints;
+        const uint32_t next = current + numCirclePoints;
+        for (uint32_t j = 0; j < numCirclePoints; j++) {
+            const uint32_t jNext = (j + 1) % numCirclePoints;
+            *index++ = current + j;
+            *index++ = current + jNext;
+            *index++ = next + jNext;
+            *index++ = current + j;
+            *index++ = next + jNext;
+            *index++ = next + j;
+        }
+    }
+}
+
+void writeTubeIndices(
+        BinaryMeshStreamWriter &writer, const std::vector<size_t> &vertexOffsets, uint32_t numCirclePoints)
+{
+    const size_t TUBES_PER_BLOCK = 16384;
+    const size_t numTubes = vertexOffsets.size() - 1;
+    std::vector<uint32_t> blockIndices;
+    for (size_t blockStart = 0; blockStart < numTubes; blockStart += TUBES_PER_BLOCK) {
+        const size_t blockEnd = std::min(blockStart + TUBES_PER_BLOCK, numTubes);
+        blockIndices.clear();
+        for (size_t i = blockStart; i < blockEnd; i++) {
+            const size_t numNodes = (vertexOffsets[i + 1] - vertexOffsets[i]) / numCirclePoints;
+            if (numNodes <= 1) {
+                continue;
+            }
+            const size_t indexOffset = blockIndices.size();
+            blockIndices.resize(indexOffset + (numNodes - 1) * numCirclePoints * 6);
+            createTubeIndices(
+                    uint32_t(numNodes), numCirclePoints, uint32_t(vertexOffsets[i]), blockIndices.data() + indexOffset);
+        }
+        writer.appendIndices(blockIndices.data(), blockIndices.size());
+    }
+    writer.finishIndices();
+}
+
 /**
  * Returns a oriented and shifted copy of a 2D circle in 3D space.
  * The number
@@ -233,15 +276,57 @@ void createTubeRenderData(const std::vector<glm::vec3> &pathLineCenters,
         vertexAttributes.clear();
     }
 }
-void createTubeRenderData(const std::vector<glm::vec3> &pathLineCenters,
-                          std::vector<std::vector<float>> &importanceCriteriaLine,
+/**
+ * Computes the tangent of the tube node at the point i of a line. Returns false if no tube node is created for the
+ * point, i.e., if the point is invalid (used in many scientific datasets to indicate invalid lines) or if it is almost
+ * identical to the next point.
+ */
+static bool computeTubeNodeTangent(const ArrayView<const glm::vec3> &pathLineCenters, int i, glm::vec3 &tangent)
+{
+    const int n = (int)pathLineCenters.size();
+    const glm::vec3 &center = pathLineCenters[i];
+
+    // Remove invalid line points (used in many scientific datasets to indicate invalid lines).
+    const float MAX_VAL = 1e10;
+    if (std::fabs(center.x) > MAX_VAL || std::fabs(center.y) > MAX_VAL || std::fabs(center.z) > MAX_VAL) {
+        return false;
+    }
+
+    if (i == 0) {
+        // First node
+        tangent = pathLineCenters[i+1] - pathLineCenters[i];
+    } else if (i == n-1) {
+        // Last node
+        tangent = pathLineCenters[i] - pathLineCenters[i-1];
+    } else {
+        // Node with two neighbors - use both normals
+        tangent = pathLineCenters[i+1] - pathLineCenters[i];
+    }
+
+    float lineSegmentLength = glm::length(tangent);
+    if (lineSegmentLength < 0.0001f) {
+        // In case the two vertices are almost identical, just skip this path line segment
+        return false;
+    }
+    tangent = glm::normalize(tangent);
+    return true;
+}
+
+/**
+ * Creates the tube of the line lineIdx of the passed trajectories.
+ * @param importanceCriteriaVertex: The (output) per-vertex importance criteria (one array per trajectory attribute).
+ */
+void createTubeRenderData(const Trajectories &trajectories,
+                          size_t lineIdx,
                           std::vector<glm::vec3> &vertices,
                           std::vector<glm::vec3> &normals,
                           std::vector<std::vector<float>> &importanceCriteriaVertex,
                           std::vector<uint32_t> &indices)
 {
+    ArrayView<const glm::vec3> pathLineCenters = trajectories.getLinePositions(lineIdx);
+    const size_t lineOffset = trajectories.getLineOffset(lineIdx);
     int n = (int)pathLineCenters.size();
-    int numImportanceCriteria = (int)importanceCriteriaLine.size();
+    int numImportanceCriteria = (int)trajectories.getNumAttributes();
     if (n < 2) {
         sgl::Logfile::get()->writeError("Error in createTube: n < 2");
         return;
@@ -264,45 +349,20 @@ void createTubeRenderData(const std::vector<glm::vec3> &pathLineCenters,
     // First, create a list of tube nodes
     glm::vec3 lastNormal = glm::vec3(1.0f, 0.0f, 0.0f);
     for (int i = 0; i < n; i++) {
-        glm::vec3 center = pathLineCenters.at(i);
-
-        // Remove invalid line points (used in many scientific datasets to indicate invalid lines).
-        const float MAX_VAL = 1e10;
-        if (std::fabs(center.x) > MAX_VAL || std::fabs(center.y) > MAX_VAL || std::fabs(center.z) > MAX_VAL) {
-            continue;
-        }
-
         glm::vec3 tangent;
-        if (i == 0) {
-            // First node
-            tangent = pathLineCenters.at(i+1) - pathLineCenters.at(i);
-        } else if (i == n-1) {
-            // Last node
-            tangent = pathLineCenters.at(i) - pathLineCenters.at(i-1);
-        } else {
-            // Node with two neighbors - use both normals
-            tangent = pathLineCenters.at(i+1) - pathLineCenters.at(i);
-            //normal += pathLineCenters.at(i) - pathLineCenters.at(i-1);
-        }
-
-        float lineSegmentLength = glm::length(tangent);
-
-        if (lineSegmentLength < 0.0001f) {
-            //normal = glm::vec3(1.0f, 0.0f, 0.0f);
-            // In case the two vertices are almost identical, just skip this path line segment
+        if (!computeTubeNodeTangent(pathLineCenters, i, tangent)) {
             continue;
         }
-        tangent = glm::normalize(tangent);
 
         TubeNode node;
-        node.center = pathLineCenters.at(i);
+        node.center = pathLineCenters[i];
         node.tangent = tangent;
         insertOrientedCirclePoints(vertices, normals, node.center, node.tangent, lastNormal);
         node.circleIndices.reserve(circlePoints2D.size());
         for (int j = 0; j < circlePoints2D.size(); j++) {
             node.circleIndices.push_back(j + numVertexPts*circlePoints2D.size());
             for (int k = 0; k < numImportanceCriteria; k++) {
-                importanceCriteriaVertex.at(k).push_back(importanceCriteriaLine.at(k).at(i));
+                importanceCriteriaVertex.at(k).push_back(trajectories.attributes[k][lineOffset + i]);
             }
         }
         tubeNodes.push_back(node);
@@ -363,11 +423,12 @@ void createTubeRenderData<uint32_t>(const std::vector<glm::vec3> &pathLineCenter
 
 
 
-void convertTrajectoryDataToBinaryTriangleMesh(
+bool convertTrajectoryDataToBinaryTriangleMesh(
         TrajectoryType trajectoryType,
         const std::string &trajectoriesFilename,
         const std::string &binaryFilename,
-        float lineRadius)
+        float lineRadius,
+        const TubeMeshEncodings &encodings)
 {
     auto start = std::chrono::system_clock::now();
 
@@ -379,117 +440,162 @@ void convertTrajectoryDataToBinaryTriangleMesh(
         initializeCircleData(3, lineRadius);
     }
 
-    BinaryMesh binaryMesh;
-    binaryMesh.submeshes.push_back(BinarySubMesh());
-    BinarySubMesh &submesh = binaryMesh.submeshes.front();
-    submesh.vertexMode = VERTEX_MODE_TRIANGLES;
-
-    std::vector<glm::vec3> globalVertexPositions;
-    std::vector<glm::vec3> globalNormals;
-    std::vector<std::vector<float>> globalImportanceCriteria;
-    std::vector<uint32_t> globalIndices;
-
-    uint32_t numLines = 0;
-    uint32_t numLineSegments = 0;
-
-
-    Trajectories trajectories = loadTrajectoriesFromFile(trajectoriesFilename, trajectoryType);
-
-    for (size_t i = 0; i < trajectories.size(); i++) {
-        Trajectory &trajectory = trajectories.at(i);
-
-        numLines++;
-        numLineSegments += trajectory.positions.size() - 1;
-
-        // Create tube render data
-        std::vector<glm::vec3> localVertices;
-        std::vector<std::vector<float>> importanceCriteriaVertex;
-        std::vector<glm::vec3> localNormals;
-        std::vector<uint32_t> localIndices;
-        createTubeRenderData(trajectory.positions, trajectory.attributes, localVertices, localNormals,
-                             importanceCriteriaVertex, localIndices);
-
-        // Local -> global
-        if (localVertices.size() > 0) {
-            for (size_t i = 0; i < localIndices.size(); i++) {
-                globalIndices.push_back(localIndices.at(i) + globalVertexPositions.size());
+    const Trajectories trajectories = loadTrajectoriesFromFile(trajectoriesFilename, trajectoryType);
+    const size_t numLines = trajectories.size();
+    const size_t numImportanceCriteria = trajectories.getNumAttributes();
+
+    // Pass 1: The importance criteria are stored as unorm16 values relative to their range over all tube vertices,
+    // i.e., over all points creating a tube node in lines with at least two tube nodes. The tube nodes are counted to
+    // compute the sizes of the output arrays.
+    const size_t numCirclePoints = circlePoints2D.size();
+    std::vector<size_t> vertexOffsets(numLines + 1, 0);
+    std::vector<float> minImportanceCriteria(numImportanceCriteria, FLT_MAX);
+    std::vector<float> maxImportanceCriteria(numImportanceCriteria, -FLT_MAX);
+    #pragma omp parallel
+    {
+        std::vector<float> threadMin(numImportanceCriteria, FLT_MAX);
+        std::vector<float> threadMax(numImportanceCriteria, -FLT_MAX);
+        std::vector<int> tubeNodePoints;
+        #pragma omp for schedule(dynamic, 64)
+        for (size_t lineIdx = 0; lineIdx < numLines; lineIdx++) {
+            ArrayView<const glm::vec3> pathLineCenters = trajectories.getLinePositions(lineIdx);
+            const size_t lineOffset = trajectories.getLineOffset(lineIdx);
+            const int n = (int)pathLineCenters.size();
+            if (n < 2) {
+                continue;
             }
-            globalVertexPositions.insert(globalVertexPositions.end(), localVertices.begin(), localVertices.end());
-            globalNormals.insert(globalNormals.end(), localNormals.begin(), localNormals.end());
-            if (globalImportanceCriteria.empty()) {
-                globalImportanceCriteria.insert(globalImportanceCriteria.end(), importanceCriteriaVertex.begin(),
-                                                importanceCriteriaVertex.end());
-            } else {
-                for (size_t i = 0; i < globalImportanceCriteria.size(); i++) {
-                    globalImportanceCriteria.at(i).insert(globalImportanceCriteria.at(i).end(),
-                                                          importanceCriteriaVertex.at(i).begin(), importanceCriteriaVertex.at(i).end());
+            tubeNodePoints.clear();
+            glm::vec3 tangent;
+            for (int i = 0; i < n; i++) {
+                if (computeTubeNodeTangent(pathLineCenters, i, tangent)) {
+                    tubeNodePoints.push_back(i);
+                }
+            }
+            if (tubeNodePoints.size() <= 1) {
+                continue;
+            }
+            vertexOffsets[lineIdx + 1] = tubeNodePoints.size() * numCirclePoints;
+            for (size_t k = 0; k < numImportanceCriteria; k++) {
+                const float *values = trajectories.attributes[k].data() + lineOffset;
+                for (int i : tubeNodePoints) {
+                    threadMin[k] = std::min(threadMin[k], values[i]);
+                    threadMax[k] = std::max(threadMax[k], values[i]);
                 }
             }
         }
+        #pragma omp critical
+        {
+            for (size_t k = 0; k < numImportanceCriteria; k++) {
+                minImportanceCriteria[k] = std::min(minImportanceCriteria[k], threadMin[k]);
+                maxImportanceCriteria[k] = std::max(maxImportanceCriteria[k], threadMax[k]);
+            }
+        }
     }
 
+    size_t numIndices = 0;
+    for (size_t lineIdx = 0; lineIdx < numLines; lineIdx++) {
+        const size_t numNodes = vertexOffsets[lineIdx + 1] / numCirclePoints;
+        if (numNodes > 1) {
+            numIndices += (numNodes - 1) * numCirclePoints * 6;
+        }
+        vertexOffsets[lineIdx + 1] += vertexOffsets[lineIdx];
+    }
+    const size_t numVertices = vertexOffsets.back();
+    if (numVertices > size_t(UINT32_MAX)) {
+        Logfile::get()->writeError("Error in convertTrajectoryDataToBinaryTriangleMesh: Too many vertices.");
+        return false;
+    }
 
-    submesh.material.diffuseColor = glm::vec3(165, 220, 84) / 255.0f;
-    submesh.material.opacity = 120 / 255.0f;
-    submesh.indices = globalIndices;
-
-    const size_t numIndices = globalIndices.size();
-    const size_t numVertices = globalVertexPositions.size();
-    const size_t numNormals = globalNormals.size();
-    // free memory
-    globalIndices.clear(); globalIndices.shrink_to_fit();
-
-    BinaryMeshAttribute positionAttribute;
-    positionAttribute.name = "vertexPosition";
-    positionAttribute.attributeFormat = ATTRIB_FLOAT;
-    positionAttribute.numComponents = 3;
-    positionAttribute.data.resize(numVertices * sizeof(glm::vec3));
-    memcpy(&positionAttribute.data.front(), &globalVertexPositions.front(), numVertices * sizeof(glm::vec3));
-    submesh.attributes.push_back(positionAttribute);
-
-    // free memory
-    globalVertexPositions.clear(); globalVertexPositions.shrink_to_fit();
+    // Pass 2: Write the indices, then create the tubes of a block of lines at a time and stream them to the file.
+    // This way, only the trajectories and one block of the output mesh are held in memory. All array sizes are known
+    // from pass 1, thus the data is written directly to its final position in the file.
+    ObjMaterial material;
+    material.diffuseColor = glm::vec3(165, 220, 84) / 255.0f;
+    material.opacity = 120 / 255.0f;
 
-    BinaryMeshAttribute lineNormalsAttribute;
-    lineNormalsAttribute.name = "vertexNormal";
-    lineNormalsAttribute.attributeFormat = ATTRIB_FLOAT;
-    lineNormalsAttribute.numComponents = 3;
-    lineNormalsAttribute.data.resize(numNormals * sizeof(glm::vec3));
-    memcpy(&lineNormalsAttribute.data.front(), &globalNormals.front(), numNormals * sizeof(glm::vec3));
-    submesh.attributes.push_back(lineNormalsAttribute);
+    BinaryMeshStreamWriter writer;
+    if (!writer.open(binaryFilename)) {
+        return false;
+    }
+    writer.beginSubmesh(material, VERTEX_MODE_TRIANGLES, numIndices);
+    writer.setIndexEncoding(encodings.indexEncoding);
+    size_t positionAttributeIndex = writer.addAttribute(
+            "vertexPosition", ATTRIB_FLOAT, 3, numVertices * sizeof(glm::vec3), encodings.positionEncoding);
+    size_t normalAttributeIndex = writer.addAttribute(
+            "vertexNormal", ATTRIB_FLOAT, 3, numVertices * sizeof(glm::vec3), encodings.normalEncoding);
+    size_t firstImportanceCriterionAttributeIndex = 0;
+    for (size_t k = 0; k < numImportanceCriteria; k++) {
+        size_t attributeIndex = writer.addAttribute(
+                "vertexAttribute" + sgl::toString(k), ATTRIB_UNSIGNED_SHORT, 1, numVertices * sizeof(uint16_t));
+        if (k == 0) {
+            firstImportanceCriterionAttributeIndex = attributeIndex;
+        }
+    }
+    writeTubeIndices(writer, vertexOffsets, uint32_t(numCirclePoints));
 
-    // free memory
-    globalNormals.clear(); globalNormals.shrink_to_fit();
+    const size_t LINES_PER_BLOCK = 4096;
+    uint32_t numLineSegments = 0;
+    std::vector<glm::vec3> blockVertexPositions;
+    std::vector<glm::vec3> blockNormals;
+    std::vector<std::vector<float>> blockImportanceCriteria(numImportanceCriteria);
+    std::vector<uint16_t> blockImportanceCriterionUnorm;
+    for (size_t blockStart = 0; blockStart < numLines; blockStart += LINES_PER_BLOCK) {
+        const size_t blockEnd = std::min(blockStart + LINES_PER_BLOCK, numLines);
+        blockVertexPositions.clear();
+        blockNormals.clear();
+        for (std::vector<float> &importanceCriterion : blockImportanceCriteria) {
+            importanceCriterion.clear();
+        }
 
-    std::vector<std::vector<uint16_t>> globalImportanceCriteriaUnorm;
-    packUnorm16ArrayOfArrays(globalImportanceCriteria, globalImportanceCriteriaUnorm);
+        for (size_t i = blockStart; i < blockEnd; i++) {
+            numLineSegments += trajectories.getLineNumPoints(i) - 1;
+
+            // Create tube render data
+            std::vector<glm::vec3> localVertices;
+            std::vector<std::vector<float>> importanceCriteriaVertex;
+            std::vector<glm::vec3> localNormals;
+            std::vector<uint32_t> localIndices;
+            createTubeRenderData(trajectories, i, localVertices, localNormals, importanceCriteriaVertex, localIndices);
+
+            // The indices were already written by writeTubeIndices.
+            if (localVertices.size() > 0) {
+                blockVertexPositions.insert(blockVertexPositions.end(), localVertices.begin(), localVertices.end());
+                blockNormals.insert(blockNormals.end(), localNormals.begin(), localNormals.end());
+                for (size_t k = 0; k < numImportanceCriteria; k++) {
+                    blockImportanceCriteria.at(k).insert(blockImportanceCriteria.at(k).end(),
+                            importanceCriteriaVertex.at(k).begin(), importanceCriteriaVertex.at(k).end());
+                }
+            }
+        }
 
-    for (size_t i = 0; i < globalImportanceCriteriaUnorm.size(); i++) {
-        std::vector<uint16_t> &currentAttr = globalImportanceCriteriaUnorm.at(i);
-        BinaryMeshAttribute vertexAttribute;
-        vertexAttribute.name = "vertexAttribute" + sgl::toString(i);
-        vertexAttribute.attributeFormat = ATTRIB_UNSIGNED_SHORT;
-        vertexAttribute.numComponents = 1;
-        vertexAttribute.data.resize(currentAttr.size() * sizeof(uint16_t));
-        memcpy(&vertexAttribute.data.front(), &currentAttr.front(), currentAttr.size() * sizeof(uint16_t));
-        submesh.attributes.push_back(vertexAttribute);
+        writer.appendAttributeData(positionAttributeIndex, blockVertexPositions.data(),
+                blockVertexPositions.size() * sizeof(glm::vec3));
+        writer.appendAttributeData(normalAttributeIndex, blockNormals.data(),
+                blockNormals.size() * sizeof(glm::vec3));
+        for (size_t k = 0; k < numImportanceCriteria; k++) {
+            std::vector<float> &importanceCriterion = blockImportanceCriteria.at(k);
+            blockImportanceCriterionUnorm.resize(importanceCriterion.size());
+            packUnorm16Array(importanceCriterion.data(), importanceCriterion.size(),
+                    minImportanceCriteria.at(k), maxImportanceCriteria.at(k), blockImportanceCriterionUnorm.data());
+            writer.appendAttributeData(firstImportanceCriterionAttributeIndex + k,
+                    blockImportanceCriterionUnorm.data(), blockImportanceCriterionUnorm.size() * sizeof(uint16_t));
+        }
     }
 
-    // free memory
-    globalImportanceCriteriaUnorm.clear(); globalImportanceCriteriaUnorm.shrink_to_fit();
-
-    auto end = std::chrono::system_clock::now();
-
     Logfile::get()->writeInfo(std::string() + "Summary: "
                               + sgl::toString(numVertices) + " vertices, "
                               + sgl::toString(numIndices / 3) + " faces, "
                               + sgl::toString(numIndices) + " indices.");
     Logfile::get()->writeInfo(std::string() + "Writing binary mesh...");
-    writeMesh3D(binaryFilename, binaryMesh);
+    if (!writer.close()) {
+        return false;
+    }
+
+    auto end = std::chrono::system_clock::now();
 
     // compute size of renderable geometry;
-    float byteSize = positionAttribute.data.size() * sizeof(uint8_t) + lineNormalsAttribute.data.size() * sizeof(uint8_t)
-                     + submesh.attributes[0].data.size() * sizeof(uint8_t) + submesh.indices.size() * sizeof(uint32_t);
+    float byteSize = numVertices * sizeof(glm::vec3) * 2 + numVertices * numImportanceCriteria * sizeof(uint16_t)
+                     + numIndices * sizeof(uint32_t);
 
     float MBSize = byteSize / 1024. / 1024.;
 
@@ -501,7 +607,7 @@ void convertTrajectoryDataToBinaryTriangleMesh(
             std::chrono::duration_cast<std::chrono::milliseconds>(end - start);
     Logfile::get()->writeInfo(std::string() + "Computational time to create binmesh: "
                               + std::to_string(elapsed.count()));
-
+    return true;
 }
 
 
@@ -519,21 +625,22 @@ void computeLineNormal(const glm::vec3 &tangent, glm::vec3 &normal, const glm::v
 }
 
 /**
- * @param pathLineCenters: The (input) path line points to create a tube from.
- * @param pathLineAttributes: The (input) path line point vertex attributes (belonging to pathLineCenters).
- * @param vertices: The (output) vertex points, which are a set of oriented circles around the centers (see above).
- * @param indices: The (output) indices specifying how tube triangles are built from the circle vertices.
+ * Creates the line vertices (with tangents and normals) of the line lineIdx of the passed trajectories.
+ * @param vertices: The (output) line vertices.
+ * @param indices: The (output) indices of the line segments.
  */
-void createTangentAndNormalData(std::vector<glm::vec3> &pathLineCenters,
-                                std::vector<std::vector<float>> &importanceCriteriaIn,
+void createTangentAndNormalData(const Trajectories &trajectories,
+                                size_t lineIdx,
                                 std::vector<glm::vec3> &vertices,
                                 std::vector<std::vector<float>> &importanceCriteriaOut,
                                 std::vector<glm::vec3> &tangents,
                                 std::vector<glm::vec3> &normals,
                                 std::vector<uint32_t> &indices)
 {
+    ArrayView<const glm::vec3> pathLineCenters = trajectories.getLinePositions(lineIdx);
+    const size_t lineOffset = trajectories.getLineOffset(lineIdx);
     int n = (int)pathLineCenters.size();
-    int numImportanceCriteria = (int)importanceCriteriaIn.size();
+    int numImportanceCriteria = (int)trajectories.getNumAttributes();
     if (n < 2) {
         sgl::Logfile::get()->writeError("Error in createTube: n < 2");
         return;
@@ -551,7 +658,7 @@ void createTangentAndNormalData(std::vector<glm::vec3> &pathLineCenters,
     // First, create a list of tube nodes
     glm::vec3 lastNormal = glm::vec3(1.0f, 0.0f, 0.0f);
     for (int i = 0; i < n; i++) {
-        glm::vec3 center = pathLineCenters.at(i);
+        glm::vec3 center = pathLineCenters[i];
 
         // Remove invalid line points (used in many scientific datasets to indicate invalid lines).
         const float MAX_VAL = 1e10;
@@ -562,14 +669,14 @@ void createTangentAndNormalData(std::vector<glm::vec3> &pathLineCenters,
         glm::vec3 tangent;
         if (i == 0) {
             // First node
-            tangent = pathLineCenters.at(i+1) - pathLineCenters.at(i);
+            tangent = pathLineCenters[i+1] - pathLineCenters[i];
         } else if (i == n-1) {
             // Last node
-            tangent = pathLineCenters.at(i) - pathLineCenters.at(i-1);
+            tangent = pathLineCenters[i] - pathLineCenters[i-1];
         } else {
             // Node with two neighbors - use both normals
-            tangent = pathLineCenters.at(i+1) - pathLineCenters.at(i);
-            //normal += pathLineCenters.at(i) - pathLineCenters.at(i-1);
+            tangent = pathLineCenters[i+1] - pathLineCenters[i];
+            //normal += pathLineCenters[i] - pathLineCenters[i-1];
         }
         if (glm::length(tangent) < 0.0001f) {
             // In case the two vertices are almost identical, just skip this path line segment
@@ -581,9 +688,9 @@ void createTangentAndNormalData(std::vector<glm::vec3> &pathLineCenters,
         computeLineNormal(tangent, normal, lastNormal);
         lastNormal = normal;
 
-        vertices.push_back(pathLineCenters.at(i));
+        vertices.push_back(pathLineCenters[i]);
         for (int j = 0; j < numImportanceCriteria; j++) {
-            importanceCriteriaOut.at(j).push_back(importanceCriteriaIn.at(j).at(i));
+            importanceCriteriaOut.at(j).push_back(trajectories.attributes[j][lineOffset + i]);
         }
         tangents.push_back(tangent);
         normals.push_back(normal);
@@ -669,19 +776,20 @@ void convertTrajectoryDataToBinaryTriangleMeshGPU(
 
     Trajectories trajectories = loadTrajectoriesFromFile(trajectoriesFilename, trajectoryType);
 
+    // The flat point arrays of the trajectories can be interleaved in one parallel pass (empty lines are skipped).
+    const size_t numPointsInput = trajectories.getNumPoints();
+    inputLinePoints.resize(numPointsInput);
+    const float *inputAttributes = trajectories.attributes.empty() ? nullptr : trajectories.attributes.at(0).data();
+    trajectories.forEachPointParallel([&](size_t j) {
+        inputLinePoints[j].linePoint = trajectories.positions[j];
+        inputLinePoints[j].lineAttribute = inputAttributes ? inputAttributes[j] : 0.0f;
+    });
+
     lineOffsetsInput.push_back(0);
     for (size_t i = 0; i < trajectories.size(); i++) {
-        Trajectory &trajectory = trajectories.at(i);
-
-        InputLinePoint inputLinePoint;
-        for (int j = 0; j < trajectory.positions.size(); j++) {
-            inputLinePoint.linePoint = trajectory.positions.at(j);
-            inputLinePoint.lineAttribute = trajectory.attributes.at(0).at(j);
-            inputLinePoints.push_back(inputLinePoint);
-        }
-
-        if (trajectory.positions.size() > 0) {
-            numLinePointsInput += trajectory.positions.size();
+        const size_t lineNumPoints = trajectories.getLineNumPoints(i);
+        if (lineNumPoints > 0) {
+            numLinePointsInput += lineNumPoints;
             numLinesInput++;
         } else {
             continue;
@@ -937,7 +1045,7 @@ void convertTrajectoryDataToBinaryTriangleMeshGPU(
 
 
 
-void convertTrajectoryDataToBinaryLineMesh(
+bool convertTrajectoryDataToBinaryLineMesh(
         TrajectoryType trajectoryType,
         const std::string &trajectoriesFilename,
         const std::string &binaryFilename)
@@ -959,15 +1067,13 @@ void convertTrajectoryDataToBinaryLineMesh(
     Trajectories trajectories = loadTrajectoriesFromFile(trajectoriesFilename, trajectoryType);
 
     for (size_t i = 0; i < trajectories.size(); i++) {
-        Trajectory &trajectory = trajectories.at(i);
-
         // Create tube render data
         std::vector<glm::vec3> localVertices;
         std::vector<glm::vec3> localTangents;
         std::vector<glm::vec3> localNormals;
         std::vector<uint32_t> localIndices;
         std::vector<std::vector<float>> importanceCriteriaOut;
-        createTangentAndNormalData(trajectory.positions, trajectory.attributes, localVertices,
+        createTangentAndNormalData(trajectories, i, localVertices,
                                    importanceCriteriaOut, localTangents, localNormals, localIndices);
 
         // Local -> global
@@ -1060,12 +1166,14 @@ void convertTrajectoryDataToBinaryLineMesh(
                               + sgl::toString(numIndices / 3) + " faces, "
                               + sgl::toString(numIndices) + " indices.");
     Logfile::get()->writeInfo(std::string() + "Writing binary mesh...");
-    writeMesh3D(binaryFilename, binaryMesh);
-
+    if (!writeMesh3D(binaryFilename, binaryMesh)) {
+        return false;
+    }
 
     auto elapsed =
             std::chrono::duration_cast<std::chrono::milliseconds>(end - start);
     Logfile::get()->writeInfo(std::string() + "Computational time to create binmesh: "
                         + std::to_string(elapsed.count()));
+    return true;
 }
 
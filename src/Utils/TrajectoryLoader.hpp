@@ -12,6 +12,7 @@
 #include <glm/glm.hpp>
 
 #include "ImportanceCriteria.hpp"
+#include "MeshCompression.hpp"
 
 /**
  * @param pathLineCenters: The (input) path line points to create a tube from.
@@ -40,13 +41,53 @@ void createTubeRenderData<uint32_t>(const std::vector<glm::vec3> &pathLineCenter
                                     std::vector<uint32_t> &vertexAttributes,
                                     std::vector<uint32_t> &indices);
 
+struct Trajectories;
+
+/**
+ * Creates the line vertices (with tangents and normals) of the line lineIdx of the passed trajectories, i.e., the
+ * input of the line rendering shaders (see convertTrajectoryDataToBinaryLineMesh).
+ * @param vertices: The (output) line vertices.
+ * @param indices: The (output) indices of the line segments.
+ */
+void createTangentAndNormalData(const Trajectories &trajectories,
+                                size_t lineIdx,
+                                std::vector<glm::vec3> &vertices,
+                                std::vector<std::vector<float>> &importanceCriteriaOut,
+                                std::vector<glm::vec3> &tangents,
+                                std::vector<glm::vec3> &normals,
+                                std::vector<uint32_t> &indices);
+
+class BinaryMeshStreamWriter;
+
+/**
+ * Writes the indices of a tube with numNodes circles of numCirclePoints vertices each, starting at firstVertex. Two
+ * CCW triangles (one quad) are created for each side of each segment, i.e., (numNodes - 1) * numCirclePoints * 6
+ * indices.
+ */
+void createTubeIndices(uint32_t numNodes, uint32_t numCirclePoints, uint32_t firstVertex, uint32_t *indices);
+
+/**
+ * Appends the indices of all tubes of a tube mesh to the writer and finishes them. The indices only depend on the
+ * number of vertices of the tubes, thus they are written before the vertex data (as needed for encoded indices).
+ * @param vertexOffsets: The index of the first vertex of each tube plus the total number of vertices at the end.
+ */
+void writeTubeIndices(
+        BinaryMeshStreamWriter &writer, const std::vector<size_t> &vertexOffsets, uint32_t numCirclePoints);
+
+/// Appends numSegments points on a circle around center to points.
+void getPointsOnCircle(std::vector<glm::vec2> &points, const glm::vec2 &center, float radius, int numSegments);
 void initializeCircleData(int numSegments, float radius);
 
-void convertTrajectoryDataToBinaryTriangleMesh(
+/**
+ * @param encodings: The encodings of the tube positions, normals and indices in the binmesh file.
+ * @return False if the input couldn't be read or the output couldn't be written.
+ */
+bool convertTrajectoryDataToBinaryTriangleMesh(
         TrajectoryType trajectoryType,
         const std::string &trajectoriesFilename,
         const std::string &binaryFilename,
-        float lineRadius);
+        float lineRadius,
+        const TubeMeshEncodings &encodings = TubeMeshEncodings());
 
 void convertTrajectoryDataToBinaryTriangleMeshGPU(
         TrajectoryType trajectoryType,
@@ -54,7 +95,8 @@ void convertTrajectoryDataToBinaryTriangleMeshGPU(
         const std::string &binaryFilename,
         float lineRadius);
 
-void convertTrajectoryDataToBinaryLineMesh(
+/// @return False if the output couldn't be written.
+bool convertTrajectoryDataToBinaryLineMesh(
         TrajectoryType trajectoryType,
         const std::string &trajectoriesFilename,
         const std::string &binaryFilename);
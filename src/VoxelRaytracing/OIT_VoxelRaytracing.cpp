@@ -10,6 +10,7 @@
 
 #include <Utils/File/FileUtils.hpp>
 #include <Utils/File/Logfile.hpp>
+#include <Utils/Convert.hpp>
 #include <Graphics/Texture/TextureManager.hpp>
 #include <Graphics/Scene/Camera.hpp>
 #include <ImGui/ImGuiWrapper.hpp>
@@ -18,6 +19,7 @@
 #include "VoxelCurveDiscretizer.hpp"
 #include "OIT_VoxelRaytracing.hpp"
 #include "../OIT/BufferSizeWatch.hpp"
+#include "../Utils/AssetCache.hpp"
 
 //#define VOXEL_RAYTRACING_COMPUTE_SHADER
 
@@ -117,8 +119,6 @@ void OIT_VoxelRaytracing::fromFile(const std::string &filename, TrajectoryType t
     // Pure filename without extension (to create compressed .voxel filename)
     std::string modelFilenamePure = sgl::FileUtils::get()->removeExtension(filename);
 
-    std::string modelFilenameVoxelGrid = modelFilenamePure + ".voxel";
-
     // Can be either hair dataset or trajectory dataset
     isHairDataset = boost::starts_with(modelFilenamePure, "Data/Hair");
     bool isRings = boost::starts_with(modelFilenamePure, "Data/Rings");
@@ -164,16 +164,28 @@ void OIT_VoxelRaytracing::fromFile(const std::string &filename, TrajectoryType t
         maxNumLinesPerVoxel = 64;
     }*/
 
+    // VoxelAO uses other grid settings, so the grid parameters are part of the cache key
+    std::string modelFilenameSource = modelFilenamePure + (isHairDataset ? ".hair" : ".obj");
+    std::string voxelGridParameters = "voxelRaytracing;voxelRes=" + sgl::toString(voxelRes)
+            + ";quantizationRes=" + sgl::toString(quantizationRes)
+            + ";maxNumLinesPerVoxel=" + sgl::toString(maxNumLinesPerVoxel)
+            + ";trajectoryType=" + sgl::toString(int(trajectoryType));
+#ifdef PACK_LINES
+    voxelGridParameters += ";packLines";
+#endif
+    std::string modelFilenameVoxelGrid = AssetCache::get()->getCachedFilename(
+            modelFilenameSource, voxelGridParameters, "voxel");
+
     if (!sgl::FileUtils::get()->exists(modelFilenameVoxelGrid)) {
         VoxelCurveDiscretizer discretizer(glm::ivec3(voxelRes),
                 glm::ivec3(quantizationRes, quantizationRes, quantizationRes));
 
         if (isHairDataset) {
-            std::string modelFilenameHair = modelFilenamePure + ".hair";
+            std::string modelFilenameHair = modelFilenameSource;
             compressedData = discretizer.createFromHairDataset(modelFilenameHair, lineRadius, hairStrandColor,
                     maxNumLinesPerVoxel);
         } else {
-            std::string modelFilenameObj = modelFilenamePure + ".obj";
+            std::string modelFilenameObj = modelFilenameSource;
             compressedData = discretizer.createFromTrajectoryDataset(modelFilenameObj, trajectoryType, attributes,
                     maxVorticity, maxNumLinesPerVoxel, useGPU);
         }
@@ -200,7 +212,9 @@ void OIT_VoxelRaytracing::fromFile(const std::string &filename, TrajectoryType t
         sgl::Logfile::get()->writeInfo(std::string() + "Computational time to create voxel grid: "
                                        + std::to_string(elapsed.count()));
 
-        saveToFile(modelFilenameVoxelGrid, compressedData);
+        AssetCache::get()->convert(modelFilenameVoxelGrid, [this](const std::string &outputFilename) {
+            return saveToFile(outputFilename, compressedData);
+        });
     } else {
         loadFromFile(modelFilenameVoxelGrid, compressedData);
         if (isHairDataset) {
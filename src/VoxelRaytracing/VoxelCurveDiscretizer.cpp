@@ -202,15 +202,16 @@ VoxelGridDataCompressed VoxelCurveDiscretizer::createFromTrajectoryDataset(const
 
     Trajectories trajectories = loadTrajectoriesFromFile(filename, trajectoryType);
 
+    curves.reserve(trajectories.size());
     for (size_t i = 0; i < trajectories.size(); i++) {
-        Trajectory &trajectory = trajectories.at(i);
+        ArrayView<glm::vec3> positions = trajectories.getLinePositions(i);
+        ArrayView<float> lineAttributes = trajectories.getLineAttribute(i, 0);
 
         currentCurve = Curve();
-        for (size_t j = 0; j < trajectory.positions.size(); j++) {
-            glm::vec3 &position = trajectory.positions.at(j);
+        currentCurve.points.assign(positions.begin(), positions.end());
+        currentCurve.attributes.assign(lineAttributes.begin(), lineAttributes.end());
+        for (const glm::vec3 &position : positions) {
             linesBoundingBox.combine(position);
-            currentCurve.points.push_back(position);
-            currentCurve.attributes.push_back(trajectory.attributes.at(0).at(j));
         }
 
         currentCurve.lineID = numLines;
@@ -302,17 +303,20 @@ VoxelGridDataCompressed VoxelCurveDiscretizer::createFromHairDataset(const std::
     isHairDataset = true;
 
     // Process all strands and convert them to curves
-    for (HairStrand &strand : hairData.strands) {
+    const size_t numStrands = hairData.getNumStrands();
+    curves.reserve(numStrands);
+    for (size_t strandIdx = 0; strandIdx < numStrands; strandIdx++) {
         lineCounter++;
         if (lineCounter % 1000 == 999) {
             sgl::Logfile::get()->writeInfo(std::string() + "Parsing hair strand " + sgl::toString(lineCounter) + "...");
         }
 
-        for (glm::vec3 point : strand.points) {
-            glm::vec3 scaledPoint = point;
-            currentCurve.points.push_back(scaledPoint);
-            currentCurve.attributes.push_back(this->hairOpacity);
-            linesBoundingBox.combine(scaledPoint);
+        const glm::vec3 *strandPoints = hairData.points + hairData.strandOffsets[strandIdx];
+        const size_t strandNumPoints = hairData.getStrandNumPoints(strandIdx);
+        currentCurve.points.assign(strandPoints, strandPoints + strandNumPoints);
+        currentCurve.attributes.assign(strandNumPoints, this->hairOpacity);
+        for (size_t i = 0; i < strandNumPoints; i++) {
+            linesBoundingBox.combine(strandPoints[i]);
         }
 
         curves.push_back(currentCurve);
@@ -25,12 +25,12 @@
  */
 const uint32_t VOXEL_GRID_FORMAT_VERSION = 4u;
 
-void saveToFile(const std::string &filename, const VoxelGridDataCompressed &data)
+bool saveToFile(const std::string &filename, const VoxelGridDataCompressed &data)
 {
     std::ofstream file(filename.c_str(), std::ofstream::binary);
     if (!file.is_open()) {
         sgl::Logfile::get()->writeError(std::string() + "Error in saveToFile: File \"" + filename + "\" not found.");
-        return;
+        return false;
     }
 
     sgl::BinaryWriteStream stream;
@@ -58,6 +58,7 @@ void saveToFile(const std::string &filename, const VoxelGridDataCompressed &data
 
     file.write((const char*)stream.getBuffer(), stream.getSize());
     file.close();
+    return !file.fail();
 }
 
 void loadFromFile(const std::string &filename, VoxelGridDataCompressed &data)
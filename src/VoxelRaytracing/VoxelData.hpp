@@ -107,7 +107,8 @@ struct VoxelGridDataGPU
 };
 
 
-void saveToFile(const std::string &filename, const VoxelGridDataCompressed &data);
+/// @return False if the file couldn't be written.
+bool saveToFile(const std::string &filename, const VoxelGridDataCompressed &data);
 void loadFromFile(const std::string &filename, VoxelGridDataCompressed &data);
 void compressedToGPUData(const VoxelGridDataCompressed &compressedData, VoxelGridDataGPU &gpuData);
 std::vector<float> generateMipmapsForDensity(float *density, glm::ivec3 size);